@@ -62,14 +62,13 @@ static void MringInputPoll(void * arg) {
         }
 
         /* Allocate some extra room for the Poly1305 MAC and XChaCha20 nonce */
-        TMessage message = CreateMessage(PIPELINE_MESSAGE, sizeof(PipelineMessage) + readable + CIPHER_TAILROOM);
-        if (message != MESSAGE_INVALID) {
+        PipelineMessage message = PipelineMessage::Create(readable + CIPHER_TAILROOM);
+        if (message) {
 
-            PipelineMessage * payload = static_cast<PipelineMessage *>(GetMessagePayload(message));
             /* Encrypt the message and send to signer */
-            PipelineEncrypt(payload->Data, readBuffer, readable);
-            payload->DataLen = readable + CIPHER_TAILROOM;
-            SendMessage(message, s_receiverId);
+            PipelineEncrypt(message->Data, readBuffer, readable);
+            message->DataLen = readable + CIPHER_TAILROOM;
+            std::move(message).Send(s_receiverId);
 
         } else {
 
@@ -4,9 +4,17 @@
 #include "man_in_the_middle.hh"
 #include "verifier.hh"
 #include "ingress.hh"
+#include <menabrea/graphs.h>
 #include <menabrea/exception.h>
 
-static TWorkerId s_signerId;
+enum PipelineStage {
+    SIGNER_STAGE,
+    MALLORY_STAGE,
+    VERIFIER_STAGE,
+    PIPELINE_STAGES
+};
+
+static TGraphId s_graphId = GRAPH_ID_INVALID;
 
 APPLICATION_GLOBAL_INIT() {
 
@@ -21,18 +29,30 @@ APPLICATION_GLOBAL_INIT() {
      */
 
     AssertTrue(0 == PipelineGlobalInit());
-    TWorkerId verifierId = VerifierGlobalInit();
-    AssertTrue(verifierId != WORKER_ID_INVALID);
-    TWorkerId mitmId = ManInTheMiddleGlobalInit(verifierId);
-    AssertTrue(mitmId != WORKER_ID_INVALID);
-    s_signerId = SignerGlobalInit(mitmId);
-    AssertTrue(s_signerId != WORKER_ID_INVALID);
+    SGraphStage stages[PIPELINE_STAGES];
+    stages[SIGNER_STAGE] = SignerStage();
+    stages[MALLORY_STAGE] = ManInTheMiddleStage();
+    stages[VERIFIER_STAGE] = VerifierStage();
+    SGraphEdge edges[] = {
+        { .From = SIGNER_STAGE, .To = MALLORY_STAGE },
+        { .From = MALLORY_STAGE, .To = VERIFIER_STAGE }
+    };
+    SGraphConfig graphConfig = {
+        .Name = "Pipeline",
+        .Stages = stages,
+        .StageCount = PIPELINE_STAGES,
+        .Edges = edges,
+        .EdgeCount = sizeof(edges) / sizeof(edges[0])
+    };
+    /* Let the platform place the stages and connect them */
+    s_graphId = DeployGraph(&graphConfig);
+    AssertTrue(s_graphId != GRAPH_ID_INVALID);
     AssertTrue(0 == IngressGlobalInit());
 }
 
 APPLICATION_LOCAL_INIT(core) {
 
-    IngressLocalInit(core, s_signerId);
+    IngressLocalInit(core, GetGraphStage(s_graphId, SIGNER_STAGE));
 }
 
 APPLICATION_LOCAL_EXIT(core) {
@@ -43,8 +63,6 @@ APPLICATION_LOCAL_EXIT(core) {
 APPLICATION_GLOBAL_EXIT() {
 
     IngressGlobalExit();
-    SignerGlobalExit();
-    ManInTheMiddleGlobalExit();
-    VerifierGlobalExit();
+    (void) TerminateGraph(s_graphId, MESSAGE_INVALID, WORKER_ID_INVALID);
     PipelineGlobalExit();
 }
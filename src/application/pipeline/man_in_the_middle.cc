@@ -1,12 +1,11 @@
 #include "man_in_the_middle.hh"
 #include "pipeline.hh"
 #include <menabrea/messaging.h>
+#include <menabrea/graphs.h>
 #include <menabrea/cores.h>
 #include <menabrea/log.h>
 #include <menabrea/exception.h>
 
-static TWorkerId s_workerId = WORKER_ID_INVALID;
-
 static bool FixedPointInUnitCircle(void * entropy, u32 length) {
 
     /* This check should have already been made */
@@ -30,66 +29,57 @@ static bool FixedPointInUnitCircle(void * entropy, u32 length) {
     }
 }
 
-static int MalloryInit(void * initArg) {
-
-    SetSharedData(initArg);
-    return 0;
-}
+static void MalloryBody(TMessage raw) {
 
-static void MalloryBody(TMessage message) {
+    PipelineMessage message = PipelineMessage::Cast(raw);
+    if (unlikely(!message)) {
+        LogPrint(ELogSeverityLevel_Warning, "Unexpected message 0x%x from 0x%x", GetMessageId(raw), GetMessageSender(raw));
+        DestroyMessage(raw);
+        return;
+    }
 
-    TWorkerId nextStageId = reinterpret_cast<uintptr_t>(GetSharedData());
-    PipelineMessage * payload = static_cast<PipelineMessage *>(GetMessagePayload(message));
-    if (PipelineDecrypt(payload->Signature, payload->Signature, sizeof(payload->Signature) + payload->DataLen)) {
+    /* The message gets destroyed on every early return */
+    if (PipelineDecrypt(message->Signature, message->Signature, sizeof(message->Signature) + message->DataLen)) {
         LogPrint(ELogSeverityLevel_Warning, "Decryption failed for message from 0x%x of length %d", \
-            GetMessageSender(message), payload->DataLen);
-        DestroyMessage(message);
+            message.GetSender(), message->DataLen);
         return;
     }
-    payload->DataLen -= CIPHER_TAILROOM;
+    message->DataLen -= CIPHER_TAILROOM;
     /* Decrypted ok, verify the signature */
-    if (PipelineVerify(payload->Signature, payload->Data, payload->DataLen)) {
+    if (PipelineVerify(message->Signature, message->Data, message->DataLen)) {
         LogPrint(ELogSeverityLevel_Warning, "Signature verification failed for message from 0x%x of length %d", \
-            GetMessageSender(message), payload->DataLen);
-        DestroyMessage(message);
+            message.GetSender(), message->DataLen);
         return;
     }
 
-    if (payload->DataLen < 8) {
+    if (message->DataLen < 8) {
         LogPrint(ELogSeverityLevel_Info, "Message too short to read fixed-point numbers");
-        DestroyMessage(message);
         return;
     }
 
-    if (!FixedPointInUnitCircle(payload->Data, payload->DataLen)) {
+    if (!FixedPointInUnitCircle(message->Data, message->DataLen)) {
 
         /* Point outside the unit circle, mangle the message to have the signature fail verification */
-        payload->Data[0] += 1;
+        message->Data[0] += 1;
     }
 
     /* Reencrypt the message together with the (now possibly invalid) signature */
-    PipelineEncrypt(payload->Signature, payload->Signature, sizeof(payload->Signature) + payload->DataLen);
-    payload->DataLen += CIPHER_TAILROOM;
-    SendMessage(message, nextStageId);
+    PipelineEncrypt(message->Signature, message->Signature, sizeof(message->Signature) + message->DataLen);
+    message->DataLen += CIPHER_TAILROOM;
+    SendMessageToOutput(message.Release(), 0);
 }
 
-TWorkerId ManInTheMiddleGlobalInit(TWorkerId nextStageId) {
-
-    LogPrint(ELogSeverityLevel_Debug, "Initializing the man-in-the-middle service...");
-    SWorkerConfig workerConfig = {
-        .Name = "PipelineMallory",
-        .InitArg = reinterpret_cast<void *>(static_cast<uintptr_t>(nextStageId)),
-        .WorkerId = WORKER_ID_INVALID,
-        .CoreMask = GetAllCoresMask(),
-        .Parallel = true,
-        .UserInit = MalloryInit,
-        .WorkerBody = MalloryBody
+SGraphStage ManInTheMiddleStage(void) {
+
+    return {
+        .Worker = {
+            .Name = "PipelineMallory",
+            .WorkerId = WORKER_ID_INVALID,
+            .Parallel = true,
+            .WorkerBody = MalloryBody
+        },
+        /* Decrypt, verify and reencrypt */
+        .Cost = 3,
+        .Cores = GetCoreCount()
     };
-    s_workerId = DeployWorker(&workerConfig);
-    return s_workerId;
-}
-
-void ManInTheMiddleGlobalExit(void) {
-
-    TerminateWorker(s_workerId);
 }
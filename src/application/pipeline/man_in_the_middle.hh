@@ -2,9 +2,8 @@
 #ifndef __SRC_APPLICATION_PIPELINE_MAN_IN_THE_MIDDLE_HH
 #define __SRC_APPLICATION_PIPELINE_MAN_IN_THE_MIDDLE_HH
 
-#include <menabrea/workers.h>
+#include <menabrea/graphs.h>
 
-TWorkerId ManInTheMiddleGlobalInit(TWorkerId nextStageId);
-void ManInTheMiddleGlobalExit(void);
+SGraphStage ManInTheMiddleStage(void);
 
 #endif /* __SRC_APPLICATION_PIPELINE_MAN_IN_THE_MIDDLE_HH */
@@ -3,6 +3,7 @@
 #define __SRC_APPLICATION_PIPELINE_PIPELINE_H
 
 #include <menabrea/messaging.h>
+#include <menabrea/messages.hh>
 #include <sodium/crypto_aead_xchacha20poly1305.h>
 
 constexpr const TMessageId PIPELINE_MESSAGE = 0xFE3C;
@@ -11,12 +12,14 @@ constexpr const u32 CIPHER_TAG_SIZE = crypto_aead_xchacha20poly1305_ietf_ABYTES;
 constexpr const u32 CIPHER_NONCE_SIZE = crypto_aead_xchacha20poly1305_ietf_NPUBBYTES;
 constexpr const u32 CIPHER_TAILROOM = CIPHER_TAG_SIZE + CIPHER_NONCE_SIZE;
 
-struct PipelineMessage {
+struct PipelinePayload {
     u32 DataLen;
     u8 Signature[64];
     u8 Data[0];
 };
 
+using PipelineMessage = Messages::Message<Messages::Definition<PIPELINE_MESSAGE, PipelinePayload>>;
+
 #define __check_result __attribute__((warn_unused_result))
 
 int PipelineGlobalInit(void);
@@ -1,52 +1,56 @@
 #include "signer.hh"
 #include "pipeline.hh"
 #include <menabrea/messaging.h>
+#include <menabrea/graphs.h>
 #include <menabrea/cores.h>
 #include <menabrea/log.h>
 
-static TWorkerId s_workerId = WORKER_ID_INVALID;
+static void SignMessage(TMessage raw) {
 
-static int SignerInit(void * initArg) {
-
-    SetSharedData(initArg);
-    return 0;
-}
-
-static void SignerBody(TMessage message) {
+    PipelineMessage message = PipelineMessage::Cast(raw);
+    if (unlikely(!message)) {
+        LogPrint(ELogSeverityLevel_Warning, "Unexpected message 0x%x from 0x%x", GetMessageId(raw), GetMessageSender(raw));
+        DestroyMessage(raw);
+        return;
+    }
 
-    TWorkerId nextStageId = reinterpret_cast<uintptr_t>(GetSharedData());
-    PipelineMessage * payload = static_cast<PipelineMessage *>(GetMessagePayload(message));
-    if (PipelineDecrypt(payload->Data, payload->Data, payload->DataLen)) {
-        LogPrint(ELogSeverityLevel_Warning, "Decryption failed for message from 0x%x", GetMessageSender(message));
-        DestroyMessage(message);
+    if (PipelineDecrypt(message->Data, message->Data, message->DataLen)) {
+        LogPrint(ELogSeverityLevel_Warning, "Decryption failed for message from 0x%x", message.GetSender());
         return;
     }
-    payload->DataLen -= CIPHER_TAILROOM;
+    message->DataLen -= CIPHER_TAILROOM;
     /* Sign the plaintext */
-    PipelineSign(payload->Signature, payload->Data, payload->DataLen);
+    PipelineSign(message->Signature, message->Data, message->DataLen);
     /* Reencrypt the signature together with the data */
-    PipelineEncrypt(payload->Signature, payload->Signature, sizeof(payload->Signature) + payload->DataLen);
-    payload->DataLen += CIPHER_TAILROOM;
-    SendMessage(message, nextStageId);
+    PipelineEncrypt(message->Signature, message->Signature, sizeof(message->Signature) + message->DataLen);
+    message->DataLen += CIPHER_TAILROOM;
+    SendMessageToOutput(message.Release(), 0);
 }
 
-TWorkerId SignerGlobalInit(TWorkerId nextStageId) {
-
-    LogPrint(ELogSeverityLevel_Debug, "Initializing the signer service...");
-    SWorkerConfig workerConfig = {
-        .Name = "PipelineSigner",
-        .InitArg = reinterpret_cast<void *>(static_cast<uintptr_t>(nextStageId)),
-        .WorkerId = WORKER_ID_INVALID,
-        .CoreMask = GetAllCoresMask(),
-        .Parallel = true,
-        .UserInit = SignerInit,
-        .WorkerBody = SignerBody
-    };
-    s_workerId = DeployWorker(&workerConfig);
-    return s_workerId;
-}
+static void SignerBody(TMessage messages[], int count) {
 
-void SignerGlobalExit(void) {
+    /* Process the whole batch in one go */
+    for (int i = 0; i < count; i++) {
 
-    TerminateWorker(s_workerId);
+        SignMessage(messages[i]);
+    }
+}
+
+SGraphStage SignerStage(void) {
+
+    return {
+        .Worker = {
+            .Name = "PipelineSigner",
+            .WorkerId = WORKER_ID_INVALID,
+            .Parallel = true,
+            /* Pass the signed batch on to the next stage in bulk */
+            .CoalesceSends = true,
+            .NoEarlyExit = true,
+            .WorkerMultiBody = SignerBody,
+            .MaxBatchSize = 16
+        },
+        /* Decrypt, sign and reencrypt */
+        .Cost = 3,
+        .Cores = GetCoreCount()
+    };
 }
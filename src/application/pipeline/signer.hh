@@ -2,9 +2,8 @@
 #ifndef __SRC_APPLICATION_PIPELINE_SIGNER_HH
 #define __SRC_APPLICATION_PIPELINE_SIGNER_HH
 
-#include <menabrea/workers.h>
+#include <menabrea/graphs.h>
 
-TWorkerId SignerGlobalInit(TWorkerId nextStageId);
-void SignerGlobalExit(void);
+SGraphStage SignerStage(void);
 
 #endif /* __SRC_APPLICATION_PIPELINE_SIGNER_HH */
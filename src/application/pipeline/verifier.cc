@@ -1,19 +1,25 @@
 #include "verifier.hh"
 #include "pipeline.hh"
 #include <menabrea/messaging.h>
+#include <menabrea/graphs.h>
 #include <menabrea/cores.h>
 #include <menabrea/log.h>
 #include <menabrea/memory.h>
 #include <menabrea/exception.h>
 
-static TWorkerId s_workerId = WORKER_ID_INVALID;
-
 struct VerifierContext {
     TAtomic32 Valid;
     TAtomic32 Total;
 };
 
-static void VerifierBody(TMessage message) {
+static void VerifierBody(TMessage raw) {
+
+    PipelineMessage message = PipelineMessage::Cast(raw);
+    if (unlikely(!message)) {
+        LogPrint(ELogSeverityLevel_Warning, "Unexpected message 0x%x from 0x%x", GetMessageId(raw), GetMessageSender(raw));
+        DestroyMessage(raw);
+        return;
+    }
 
     VerifierContext * context = static_cast<VerifierContext *>(GetSharedData());
     if (unlikely(context == nullptr)) {
@@ -32,20 +38,19 @@ static void VerifierBody(TMessage message) {
     u32 totalCount = Atomic32ReturnAdd(&context->Total, 1);
     EndAtomicContext();
 
-    PipelineMessage * payload = static_cast<PipelineMessage *>(GetMessagePayload(message));
-    if (PipelineDecrypt(payload->Signature, payload->Signature, sizeof(payload->Signature) + payload->DataLen)) {
+    if (PipelineDecrypt(message->Signature, message->Signature, sizeof(message->Signature) + message->DataLen)) {
         LogPrint(ELogSeverityLevel_Warning, "Decryption failed for message from 0x%x of length %d", \
-            GetMessageSender(message), payload->DataLen);
-        DestroyMessage(message);
+            message.GetSender(), message->DataLen);
         return;
     }
-    payload->DataLen -= CIPHER_TAILROOM;
+    message->DataLen -= CIPHER_TAILROOM;
     /* Decrypted ok, verify the signature */
-    if (0 == PipelineVerify(payload->Signature, payload->Data, payload->DataLen)) {
+    if (0 == PipelineVerify(message->Signature, message->Data, message->DataLen)) {
 
         Atomic32Inc(&context->Valid);
     }
-    DestroyMessage(message);
+    /* Done with the message */
+    message.Reset();
 
     if (totalCount % 32 == 31) {
         /* Report the ratio before we made any updates */
@@ -54,14 +59,17 @@ static void VerifierBody(TMessage message) {
     }
 }
 
-TWorkerId VerifierGlobalInit(void) {
-
-    LogPrint(ELogSeverityLevel_Debug, "Initializing the verifier service...");
-    s_workerId = DeploySimpleWorker("PipelineVerifier", WORKER_ID_INVALID, GetAllCoresMask(), VerifierBody);
-    return s_workerId;
-}
-
-void VerifierGlobalExit(void) {
+SGraphStage VerifierStage(void) {
 
-    TerminateWorker(s_workerId);
+    return {
+        .Worker = {
+            .Name = "PipelineVerifier",
+            .WorkerId = WORKER_ID_INVALID,
+            .Parallel = false,
+            .WorkerBody = VerifierBody
+        },
+        /* Decrypt and verify */
+        .Cost = 2,
+        .Cores = 1
+    };
 }
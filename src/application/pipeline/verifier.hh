@@ -2,9 +2,8 @@
 #ifndef __SRC_APPLICATION_PIPELINE_VERIFIER_HH
 #define __SRC_APPLICATION_PIPELINE_VERIFIER_HH
 
-#include <menabrea/workers.h>
+#include <menabrea/graphs.h>
 
-TWorkerId VerifierGlobalInit(void);
-void VerifierGlobalExit(void);
+SGraphStage VerifierStage(void);
 
 #endif /* __SRC_APPLICATION_PIPELINE_VERIFIER_HH */
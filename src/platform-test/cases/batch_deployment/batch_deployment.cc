@@ -0,0 +1,180 @@
+#include "batch_deployment.hh"
+#include <menabrea/test/params_parser.hh>
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+#include <cstdio>
+
+static constexpr const TMessageId START_MESSAGE_ID = 0x3170;
+static constexpr const TMessageId DEPLOYED_MESSAGE_ID = 0x3171;
+static constexpr const TMessageId PING_MESSAGE_ID = 0x3172;
+static constexpr const TMessageId PONG_MESSAGE_ID = 0x3173;
+static constexpr const TMessageId TERMINATED_MESSAGE_ID = 0x3174;
+static constexpr const u32 MAX_WORKERS = 64;
+static constexpr const u32 NAME_LEN = 32;
+struct TestBatchDeploymentParams {
+    u32 Workers;
+};
+
+static TWorkerId s_coordinatorId = WORKER_ID_INVALID;
+/* Used by the coordinator only, which runs on a single core */
+static TWorkerId s_echoIds[MAX_WORKERS];
+static char s_echoNames[MAX_WORKERS][NAME_LEN];
+static u32 s_workers = 0;
+static u32 s_pongs = 0;
+
+static void CoordinatorBody(TMessage message);
+static void EchoBody(TMessage message);
+static void DeployBatch(u32 workers);
+static void SendEmptyMessage(TMessageId messageId, TWorkerId receiver);
+
+u32 TestBatchDeployment::GetParamsSize(void) {
+
+    return sizeof(TestBatchDeploymentParams);
+}
+
+int TestBatchDeployment::ParseParams(char * paramsIn, void * paramsOut) {
+
+    ParamsParser::StructLayout paramsLayout;
+    paramsLayout["workers"] = ParamsParser::StructField(offsetof(TestBatchDeploymentParams, Workers), sizeof(u32), ParamsParser::FieldType::U32);
+
+    if (ParamsParser::Parse(paramsIn, paramsOut, std::move(paramsLayout))) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to parse the parameters for test '%s'", this->GetName());
+        return -1;
+    }
+
+    TestBatchDeploymentParams * parsed = static_cast<TestBatchDeploymentParams *>(paramsOut);
+    if (parsed->Workers == 0 || parsed->Workers > MAX_WORKERS) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s: Invalid number of workers: %d", \
+            this->GetName(), parsed->Workers);
+        return -1;
+    }
+
+    return 0;
+}
+
+int TestBatchDeployment::StartTest(void * args) {
+
+    TestBatchDeploymentParams * params = static_cast<TestBatchDeploymentParams *>(args);
+
+    /* Pin the coordinator to a single core so that its state can be kept in static variables */
+    s_coordinatorId = DeploySimpleWorker("BatchCoordinator", WORKER_ID_INVALID, GetSharedCoreMask(), CoordinatorBody);
+    if (s_coordinatorId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the coordinator");
+        return -1;
+    }
+
+    TMessage message = CreateMessage(START_MESSAGE_ID, sizeof(u32));
+    if (message == MESSAGE_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to create the start message");
+        return -1;
+    }
+    *static_cast<u32 *>(GetMessagePayload(message)) = params->Workers;
+    SendMessage(message, s_coordinatorId);
+
+    return 0;
+}
+
+void TestBatchDeployment::StopTest(void) {
+
+    TerminateWorker(s_coordinatorId);
+    s_coordinatorId = WORKER_ID_INVALID;
+}
+
+static void CoordinatorBody(TMessage message) {
+
+    TMessageId messageId = GetMessageId(message);
+    u32 payload = messageId == START_MESSAGE_ID ? *static_cast<u32 *>(GetMessagePayload(message)) : 0;
+    DestroyMessage(message);
+
+    switch (messageId) {
+    case START_MESSAGE_ID:
+        DeployBatch(payload);
+        break;
+
+    case DEPLOYED_MESSAGE_ID:
+        /* All the workers must be active now - ping each of them */
+        LogPrint(ELogSeverityLevel_Info, "Batch of %d worker(s) deployed", s_workers);
+        for (u32 i = 0; i < s_workers; i++) {
+
+            SendEmptyMessage(PING_MESSAGE_ID, s_echoIds[i]);
+        }
+        break;
+
+    case PONG_MESSAGE_ID:
+        if (++s_pongs == s_workers) {
+
+            if (TerminateWorkers(s_echoIds, s_workers, CreateMessage(TERMINATED_MESSAGE_ID, 0), GetOwnWorkerId()) != static_cast<int>(s_workers)) {
+
+                TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to terminate the batch");
+            }
+        }
+        break;
+
+    case TERMINATED_MESSAGE_ID:
+        /* The workers must all be gone now */
+        for (u32 i = 0; i < s_workers; i++) {
+
+            if (FindLocalWorker(s_echoNames[i]) != WORKER_ID_INVALID) {
+
+                TestCase::ReportTestResult(TestCase::Result::Failure, \
+                    "Worker '%s' still present after batch termination", s_echoNames[i]);
+                return;
+            }
+        }
+        TestCase::ReportTestResult(TestCase::Result::Success);
+        break;
+
+    default:
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Unexpected message 0x%x", messageId);
+        break;
+    }
+}
+
+static void EchoBody(TMessage message) {
+
+    TWorkerId sender = GetMessageSender(message);
+    DestroyMessage(message);
+    SendEmptyMessage(PONG_MESSAGE_ID, sender);
+}
+
+static void DeployBatch(u32 workers) {
+
+    SWorkerConfig configs[MAX_WORKERS];
+    for (u32 i = 0; i < workers; i++) {
+
+        (void) std::snprintf(s_echoNames[i], sizeof(s_echoNames[i]), "BatchEcho%u", i);
+        configs[i] = {
+            .Name = s_echoNames[i],
+            .WorkerId = WORKER_ID_INVALID,
+            .CoreMask = GetAllCoresMask(),
+            .Parallel = false,
+            .WorkerBody = EchoBody
+        };
+    }
+
+    s_workers = workers;
+    s_pongs = 0;
+    int deployed = DeployWorkers(configs, s_echoIds, workers, CreateMessage(DEPLOYED_MESSAGE_ID, 0), GetOwnWorkerId());
+    if (deployed != static_cast<int>(workers)) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Deployed %d out of %d worker(s)", deployed, workers);
+    }
+}
+
+static void SendEmptyMessage(TMessageId messageId, TWorkerId receiver) {
+
+    TMessage message = CreateMessage(messageId, 0);
+    if (message == MESSAGE_INVALID) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create message 0x%x", messageId);
+        return;
+    }
+    SendMessage(message, receiver);
+}
@@ -0,0 +1,125 @@
+#include "batch_reception.hh"
+#include <menabrea/test/params_parser.hh>
+#include <menabrea/log.h>
+#include <menabrea/cores.h>
+#include <menabrea/messaging.h>
+
+static constexpr const TMessageId TEST_MESSAGE_ID = 0xBA7C;
+struct TestBatchReceptionParams {
+    u32 Messages;
+    u32 MaxBatchSize;
+};
+
+static TWorkerId s_workerId = WORKER_ID_INVALID;
+static u32 s_messages = 0;
+static u32 s_maxBatchSize = 0;
+static u32 s_received = 0;
+static u32 s_calls = 0;
+
+static void WorkerBody(TMessage messages[], int count);
+
+u32 TestBatchReception::GetParamsSize(void) {
+
+    return sizeof(TestBatchReceptionParams);
+}
+
+int TestBatchReception::ParseParams(char * paramsIn, void * paramsOut) {
+
+    ParamsParser::StructLayout paramsLayout;
+    paramsLayout["messages"] = ParamsParser::StructField(offsetof(TestBatchReceptionParams, Messages), sizeof(u32), ParamsParser::FieldType::U32);
+    paramsLayout["maxBatchSize"] = ParamsParser::StructField(offsetof(TestBatchReceptionParams, MaxBatchSize), sizeof(u32), ParamsParser::FieldType::U32);
+
+    return ParamsParser::Parse(paramsIn, paramsOut, std::move(paramsLayout));
+}
+
+int TestBatchReception::StartTest(void * args) {
+
+    TestBatchReceptionParams * params = static_cast<TestBatchReceptionParams *>(args);
+    s_messages = params->Messages;
+    s_maxBatchSize = params->MaxBatchSize;
+    s_received = 0;
+    s_calls = 0;
+
+    if (s_messages == 0 || s_maxBatchSize == 0) {
+
+        LogPrint(ELogSeverityLevel_Error, "Number of messages and the batch size must be positive");
+        return -1;
+    }
+
+    SWorkerConfig workerConfig = {
+        .Name = "BatchReceiver",
+        .WorkerId = WORKER_ID_INVALID,
+        .CoreMask = GetSharedCoreMask(),
+        .Parallel = false,
+        .WorkerMultiBody = WorkerBody,
+        .MaxBatchSize = static_cast<int>(s_maxBatchSize)
+    };
+    s_workerId = DeployWorker(&workerConfig);
+    if (s_workerId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the test worker");
+        return -1;
+    }
+
+    /* Send all the messages at once so that they queue up and can be received in batches. Note
+     * that the worker is still deploying, so the platform buffers at most 16 messages for it. */
+    for (u32 i = 0; i < s_messages; i++) {
+
+        TMessage message = CreateMessage(TEST_MESSAGE_ID, sizeof(u32));
+        if (message == MESSAGE_INVALID) {
+
+            LogPrint(ELogSeverityLevel_Error, "Failed to create test message %d", i);
+            return -1;
+        }
+
+        *static_cast<u32 *>(GetMessagePayload(message)) = i;
+        SendMessage(message, s_workerId);
+    }
+
+    return 0;
+}
+
+void TestBatchReception::StopTest(void) {
+
+    if (s_workerId != WORKER_ID_INVALID) {
+
+        /* Clean up after a failed test */
+        TerminateWorker(s_workerId);
+    }
+}
+
+static void WorkerBody(TMessage messages[], int count) {
+
+    s_calls++;
+    if (count <= 0 || static_cast<u32>(count) > s_maxBatchSize) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Received a batch of %d messages (maximum: %d)", count, s_maxBatchSize);
+    }
+
+    for (int i = 0; i < count; i++) {
+
+        /* The worker is atomic so the order must be preserved */
+        u32 sequenceNumber = *static_cast<u32 *>(GetMessagePayload(messages[i]));
+        if (GetMessageId(messages[i]) != TEST_MESSAGE_ID || sequenceNumber != s_received) {
+
+            TestCase::ReportTestResult(TestCase::Result::Failure, \
+                "Unexpected message 0x%x with sequence number %d (expected: %d)", \
+                GetMessageId(messages[i]), sequenceNumber, s_received);
+        }
+        s_received++;
+        DestroyMessage(messages[i]);
+    }
+
+    if (s_received == s_messages) {
+
+        LogPrint(ELogSeverityLevel_Info, "Received %d messages in %d calls", s_received, s_calls);
+        TestCase::ReportTestResult(TestCase::Result::Success);
+        /* Note that the worker is deployed only on the shared core so we do
+         * not risk a race condition where the StopTest callback tries to
+         * terminate us again by reading obsolete s_workerId */
+        s_workerId = WORKER_ID_INVALID;
+        /* Terminate self */
+        TerminateWorker(WORKER_ID_INVALID);
+    }
+}
@@ -0,0 +1,274 @@
+#include "capture_replay.hh"
+#include <menabrea/test/params_parser.hh>
+#include <menabrea/capture.h>
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+
+static constexpr const TMessageId START_MESSAGE_ID = 0x31F0;
+static constexpr const TMessageId DATA_MESSAGE_ID = 0x31F1;
+static constexpr const TMessageId CAPTURED_MESSAGE_ID = 0x31F2;
+static constexpr const TMessageId TERMINATED_MESSAGE_ID = 0x31F3;
+static constexpr const TMessageId DEPLOYED_MESSAGE_ID = 0x31F4;
+static constexpr const TMessageId REPLAYED_MESSAGE_ID = 0x31F5;
+static constexpr const TMessageId CHECK_MESSAGE_ID = 0x31F6;
+/* The capture is replayed to the same local ID, so use a static one to have the replica take over */
+static constexpr const TWorkerId TARGET_WORKER_ID = 0x430;
+static constexpr const u32 MAX_PATH_LEN = 128;
+struct TestCaptureReplayParams {
+    char File[MAX_PATH_LEN];
+    u32 Messages;
+};
+
+struct DataPayload {
+    u32 Run;
+    u32 Sequence;
+};
+
+/* All workers run on the shared core, so their state can be kept in static variables */
+static TWorkerId s_coordinatorId = WORKER_ID_INVALID;
+static TWorkerId s_targetId = WORKER_ID_INVALID;
+static TestCaptureReplayParams s_params;
+/* Records of the previous runs remain in the capture files, so tag the messages with the run number */
+static u32 s_run = 0;
+static u32 s_expected = 0;
+
+static void CoordinatorBody(TMessage message);
+static void TargetBody(TMessage message);
+static void ReplicaBody(TMessage message);
+static void SendData(void);
+static void DeployReplica(void);
+static void ReplayData(void);
+static bool AcceptData(TMessage message);
+static void SendEmptyMessage(TMessageId messageId, TWorkerId receiver);
+
+u32 TestCaptureReplay::GetParamsSize(void) {
+
+    return sizeof(TestCaptureReplayParams);
+}
+
+int TestCaptureReplay::ParseParams(char * paramsIn, void * paramsOut) {
+
+    ParamsParser::StructLayout paramsLayout;
+    paramsLayout["file"] = ParamsParser::StructField(offsetof(TestCaptureReplayParams, File), MAX_PATH_LEN, ParamsParser::FieldType::String);
+    paramsLayout["messages"] = ParamsParser::StructField(offsetof(TestCaptureReplayParams, Messages), sizeof(u32), ParamsParser::FieldType::U32);
+
+    if (ParamsParser::Parse(paramsIn, paramsOut, std::move(paramsLayout))) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to parse the parameters for test '%s'", this->GetName());
+        return -1;
+    }
+
+    TestCaptureReplayParams * parsed = static_cast<TestCaptureReplayParams *>(paramsOut);
+    if (parsed->Messages == 0) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s: Number of messages must be positive", this->GetName());
+        return -1;
+    }
+
+    return 0;
+}
+
+int TestCaptureReplay::StartTest(void * args) {
+
+    s_params = *static_cast<TestCaptureReplayParams *>(args);
+    s_run++;
+    s_expected = 0;
+
+    /* Note that the platform must be configured to capture the messages delivered to this worker */
+    s_targetId = DeploySimpleWorker("CaptureTarget", TARGET_WORKER_ID, GetSharedCoreMask(), TargetBody);
+    if (s_targetId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the capture target");
+        return -1;
+    }
+
+    s_coordinatorId = DeploySimpleWorker("CaptureCoordinator", WORKER_ID_INVALID, GetSharedCoreMask(), CoordinatorBody);
+    if (s_coordinatorId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the coordinator");
+        return -1;
+    }
+
+    TMessage message = CreateMessage(START_MESSAGE_ID, 0);
+    if (message == MESSAGE_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to create the start message");
+        return -1;
+    }
+    SendMessage(message, s_coordinatorId);
+
+    return 0;
+}
+
+void TestCaptureReplay::StopTest(void) {
+
+    if (s_targetId != WORKER_ID_INVALID) {
+
+        TerminateWorker(s_targetId);
+        s_targetId = WORKER_ID_INVALID;
+    }
+    TerminateWorker(s_coordinatorId);
+    s_coordinatorId = WORKER_ID_INVALID;
+}
+
+static void CoordinatorBody(TMessage message) {
+
+    TMessageId messageId = GetMessageId(message);
+    DestroyMessage(message);
+
+    switch (messageId) {
+    case START_MESSAGE_ID:
+        SendData();
+        break;
+
+    case CAPTURED_MESSAGE_ID:
+    {
+        /* Hand the worker ID over to a replica which is not captured itself */
+        TWorkerId targetId = s_targetId;
+        s_targetId = WORKER_ID_INVALID;
+        if (1 != TerminateWorkers(&targetId, 1, CreateMessage(TERMINATED_MESSAGE_ID, 0), GetOwnWorkerId())) {
+
+            TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to terminate the capture target");
+        }
+        break;
+    }
+
+    case TERMINATED_MESSAGE_ID:
+        DeployReplica();
+        break;
+
+    case DEPLOYED_MESSAGE_ID:
+        ReplayData();
+        break;
+
+    case REPLAYED_MESSAGE_ID:
+        /* All the messages have been enqueued, have the replica check them once it has caught up */
+        SendEmptyMessage(CHECK_MESSAGE_ID, s_targetId);
+        break;
+
+    default:
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Unexpected message 0x%x", messageId);
+        break;
+    }
+}
+
+static void TargetBody(TMessage message) {
+
+    if (!AcceptData(message)) {
+
+        return;
+    }
+
+    if (s_expected == s_params.Messages) {
+
+        /* All the messages have been delivered and captured */
+        s_expected = 0;
+        SendEmptyMessage(CAPTURED_MESSAGE_ID, s_coordinatorId);
+    }
+}
+
+static void ReplicaBody(TMessage message) {
+
+    if (GetMessageId(message) != CHECK_MESSAGE_ID) {
+
+        (void) AcceptData(message);
+        return;
+    }
+
+    DestroyMessage(message);
+    if (s_expected != s_params.Messages) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Replica received %d out of %d captured message(s)", s_expected, s_params.Messages);
+        return;
+    }
+
+    TestCase::ReportTestResult(TestCase::Result::Success);
+}
+
+static void SendData(void) {
+
+    for (u32 i = 0; i < s_params.Messages; i++) {
+
+        TMessage message = CreateMessage(DATA_MESSAGE_ID, sizeof(DataPayload));
+        if (message == MESSAGE_INVALID) {
+
+            /* The target cannot finish, let the test time out */
+            TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create data message %d", i);
+            return;
+        }
+        DataPayload * payload = static_cast<DataPayload *>(GetMessagePayload(message));
+        payload->Run = s_run;
+        payload->Sequence = i;
+        SendMessage(message, s_targetId);
+    }
+}
+
+static void DeployReplica(void) {
+
+    SWorkerConfig config = {
+        .Name = "CaptureReplica",
+        .WorkerId = TARGET_WORKER_ID,
+        .CoreMask = GetSharedCoreMask(),
+        .Parallel = false,
+        .WorkerBody = ReplicaBody
+    };
+    /* Use a batch of one to learn when the replica becomes active */
+    if (1 != DeployWorkers(&config, &s_targetId, 1, CreateMessage(DEPLOYED_MESSAGE_ID, 0), GetOwnWorkerId())) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to deploy the replica");
+    }
+}
+
+static void ReplayData(void) {
+
+    /* The target ran on this core, so its records are all in this core's buffer */
+    FlushCapture();
+    if (0 != ReplayCapture(s_params.File, 0.0, CreateMessage(REPLAYED_MESSAGE_ID, 0), GetOwnWorkerId())) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Failed to replay '%s' - is capture of 'CaptureTarget' enabled in the platform config?", s_params.File);
+    }
+}
+
+static bool AcceptData(TMessage message) {
+
+    TMessageId messageId = GetMessageId(message);
+    DataPayload payload = *static_cast<DataPayload *>(GetMessagePayload(message));
+    DestroyMessage(message);
+
+    if (messageId != DATA_MESSAGE_ID) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Unexpected message 0x%x", messageId);
+        return false;
+    }
+
+    if (payload.Run != s_run) {
+
+        /* Replayed from a previous run */
+        return false;
+    }
+
+    if (payload.Sequence != s_expected) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Got message %d (expected: %d)", payload.Sequence, s_expected);
+        return false;
+    }
+
+    s_expected++;
+    return true;
+}
+
+static void SendEmptyMessage(TMessageId messageId, TWorkerId receiver) {
+
+    TMessage message = CreateMessage(messageId, 0);
+    if (message == MESSAGE_INVALID) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create message 0x%x", messageId);
+        return;
+    }
+    SendMessage(message, receiver);
+}
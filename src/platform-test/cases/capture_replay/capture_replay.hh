@@ -0,0 +1,15 @@
+#ifndef PLATFORM_TEST_CASES_CAPTURE_REPLAY_CAPTURE_REPLAY_HH
+#define PLATFORM_TEST_CASES_CAPTURE_REPLAY_CAPTURE_REPLAY_HH
+
+#include <menabrea/test/test_case.hh>
+
+class TestCaptureReplay : public TestCase::Instance {
+public:
+    TestCaptureReplay(const char * name) : TestCase::Instance(name) {}
+    virtual u32 GetParamsSize(void) override;
+    virtual int ParseParams(char * paramsIn, void * paramsOut) override;
+    virtual int StartTest(void * args) override;
+    virtual void StopTest(void) override;
+};
+
+#endif /* PLATFORM_TEST_CASES_CAPTURE_REPLAY_CAPTURE_REPLAY_HH */
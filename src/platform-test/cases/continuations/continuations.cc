@@ -0,0 +1,169 @@
+#include "continuations.hh"
+#include <menabrea/test/params_parser.hh>
+#include <menabrea/continuations.h>
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+
+static constexpr const TMessageId START_MESSAGE_ID = 0x31B0;
+static constexpr const TMessageId PING_MESSAGE_ID = 0x31B1;
+static constexpr const TMessageId PONG_MESSAGE_ID = 0x31B2;
+static constexpr const TMessageId NEVER_SENT_MESSAGE_ID = 0x31B3;
+static constexpr const u32 COOKIE = 0xC0FFEE;
+struct TestContinuationsParams {
+    u32 Timeout;
+};
+
+struct SPongFrame {
+    u32 Cookie;
+    u32 Timeout;
+};
+
+static TWorkerId s_requesterId = WORKER_ID_INVALID;
+static TWorkerId s_echoId = WORKER_ID_INVALID;
+
+static void RequesterBody(TMessage message);
+static void EchoBody(TMessage message);
+static void OnPong(TMessage message, void * frame);
+static void OnTimeout(TMessage message, void * frame);
+
+u32 TestContinuations::GetParamsSize(void) {
+
+    return sizeof(TestContinuationsParams);
+}
+
+int TestContinuations::ParseParams(char * paramsIn, void * paramsOut) {
+
+    ParamsParser::StructLayout paramsLayout;
+    paramsLayout["timeout"] = ParamsParser::StructField(offsetof(TestContinuationsParams, Timeout), sizeof(u32), ParamsParser::FieldType::U32);
+
+    if (ParamsParser::Parse(paramsIn, paramsOut, std::move(paramsLayout))) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to parse the parameters for test '%s'", this->GetName());
+        return -1;
+    }
+
+    TestContinuationsParams * parsed = static_cast<TestContinuationsParams *>(paramsOut);
+    if (parsed->Timeout == CONTINUATION_TIMEOUT_NONE) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s: Timeout must be positive", this->GetName());
+        return -1;
+    }
+
+    return 0;
+}
+
+int TestContinuations::StartTest(void * args) {
+
+    TestContinuationsParams * params = static_cast<TestContinuationsParams *>(args);
+
+    s_echoId = DeploySimpleWorker("ContinuationEcho", WORKER_ID_INVALID, GetAllCoresMask(), EchoBody);
+    s_requesterId = DeploySimpleWorker("ContinuationRequester", WORKER_ID_INVALID, GetSharedCoreMask(), RequesterBody);
+    if (s_echoId == WORKER_ID_INVALID || s_requesterId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the test workers");
+        return -1;
+    }
+
+    TMessage message = CreateMessage(START_MESSAGE_ID, sizeof(u32));
+    if (message == MESSAGE_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to create the start message");
+        return -1;
+    }
+    *static_cast<u32 *>(GetMessagePayload(message)) = params->Timeout;
+    SendMessage(message, s_requesterId);
+
+    return 0;
+}
+
+void TestContinuations::StopTest(void) {
+
+    TerminateWorker(s_requesterId);
+    s_requesterId = WORKER_ID_INVALID;
+    TerminateWorker(s_echoId);
+    s_echoId = WORKER_ID_INVALID;
+}
+
+static void RequesterBody(TMessage message) {
+
+    TMessageId messageId = GetMessageId(message);
+    if (messageId != START_MESSAGE_ID) {
+
+        DestroyMessage(message);
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Message 0x%x passed to the body", messageId);
+        return;
+    }
+
+    u32 timeout = *static_cast<u32 *>(GetMessagePayload(message));
+    DestroyMessage(message);
+
+    /* Fill in the frame before sending the request */
+    SPongFrame * frame = static_cast<SPongFrame *>(AwaitMessage(PONG_MESSAGE_ID, s_echoId, CONTINUATION_TIMEOUT_NONE, OnPong, sizeof(SPongFrame)));
+    if (frame == nullptr) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to await the pong");
+        return;
+    }
+    frame->Cookie = COOKIE;
+    frame->Timeout = timeout;
+
+    TMessage ping = CreateMessage(PING_MESSAGE_ID, 0);
+    if (ping == MESSAGE_INVALID) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create the ping");
+        return;
+    }
+    SendMessage(ping, s_echoId);
+}
+
+static void EchoBody(TMessage message) {
+
+    TWorkerId sender = GetMessageSender(message);
+    DestroyMessage(message);
+
+    TMessage pong = CreateMessage(PONG_MESSAGE_ID, 0);
+    if (pong != MESSAGE_INVALID) {
+
+        SendMessage(pong, sender);
+    }
+}
+
+static void OnPong(TMessage message, void * frame) {
+
+    SPongFrame * pongFrame = static_cast<SPongFrame *>(frame);
+    if (message == MESSAGE_INVALID || pongFrame->Cookie != COOKIE) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Pong continuation resumed with invalid state");
+        return;
+    }
+    DestroyMessage(message);
+
+    /* Now wait for a message that never comes */
+    u64 * marker = static_cast<u64 *>(AwaitMessage(NEVER_SENT_MESSAGE_ID, WORKER_ID_INVALID, pongFrame->Timeout, OnTimeout, sizeof(u64)));
+    if (marker == nullptr) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to await with a timeout");
+        return;
+    }
+    *marker = COOKIE;
+}
+
+static void OnTimeout(TMessage message, void * frame) {
+
+    if (message != MESSAGE_INVALID) {
+
+        DestroyMessage(message);
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Timeout continuation resumed with a message");
+        return;
+    }
+
+    if (*static_cast<u64 *>(frame) != COOKIE) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Timeout continuation resumed with invalid state");
+        return;
+    }
+
+    TestCase::ReportTestResult(TestCase::Result::Success);
+}
@@ -0,0 +1,250 @@
+#include "dataflow_graphs.hh"
+#include <menabrea/test/params_parser.hh>
+#include <menabrea/graphs.h>
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+
+static constexpr const TMessageId START_MESSAGE_ID = 0x31C0;
+static constexpr const TMessageId DATA_MESSAGE_ID = 0x31C1;
+static constexpr const TMessageId DRAINED_MESSAGE_ID = 0x31C2;
+static constexpr const TMessageId TORN_DOWN_MESSAGE_ID = 0x31C3;
+struct TestDataflowGraphsParams {
+    u32 Messages;
+};
+
+struct DataPayload {
+    TWorkerId Coordinator;
+    u32 Expected;
+};
+
+/* Diamond-shaped graph: the source fans out to both branches which merge back at the sink */
+enum DiamondStage {
+    SOURCE_STAGE,
+    LEFT_STAGE,
+    RIGHT_STAGE,
+    SINK_STAGE,
+    DIAMOND_STAGES
+};
+
+/* Used by the coordinator only, which runs on the shared core */
+static TWorkerId s_coordinatorId = WORKER_ID_INVALID;
+static TGraphId s_graphId = GRAPH_ID_INVALID;
+/* Used by the sink only, which is atomic and gets placed onto a single core */
+static u32 s_sinkReceived = 0;
+
+static void CoordinatorBody(TMessage message);
+static void SourceBody(TMessage message);
+static void BranchBody(TMessage message);
+static void SinkBody(TMessage message);
+static void DeployDiamond(u32 messages);
+
+u32 TestDataflowGraphs::GetParamsSize(void) {
+
+    return sizeof(TestDataflowGraphsParams);
+}
+
+int TestDataflowGraphs::ParseParams(char * paramsIn, void * paramsOut) {
+
+    ParamsParser::StructLayout paramsLayout;
+    paramsLayout["messages"] = ParamsParser::StructField(offsetof(TestDataflowGraphsParams, Messages), sizeof(u32), ParamsParser::FieldType::U32);
+
+    if (ParamsParser::Parse(paramsIn, paramsOut, std::move(paramsLayout))) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to parse the parameters for test '%s'", this->GetName());
+        return -1;
+    }
+
+    TestDataflowGraphsParams * parsed = static_cast<TestDataflowGraphsParams *>(paramsOut);
+    if (parsed->Messages == 0) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s: Number of messages must be positive", this->GetName());
+        return -1;
+    }
+
+    return 0;
+}
+
+int TestDataflowGraphs::StartTest(void * args) {
+
+    TestDataflowGraphsParams * params = static_cast<TestDataflowGraphsParams *>(args);
+
+    s_coordinatorId = DeploySimpleWorker("GraphCoordinator", WORKER_ID_INVALID, GetSharedCoreMask(), CoordinatorBody);
+    if (s_coordinatorId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the coordinator");
+        return -1;
+    }
+
+    TMessage message = CreateMessage(START_MESSAGE_ID, sizeof(u32));
+    if (message == MESSAGE_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to create the start message");
+        return -1;
+    }
+    *static_cast<u32 *>(GetMessagePayload(message)) = params->Messages;
+    SendMessage(message, s_coordinatorId);
+
+    return 0;
+}
+
+void TestDataflowGraphs::StopTest(void) {
+
+    if (s_graphId != GRAPH_ID_INVALID) {
+
+        (void) TerminateGraph(s_graphId, MESSAGE_INVALID, WORKER_ID_INVALID);
+        s_graphId = GRAPH_ID_INVALID;
+    }
+    TerminateWorker(s_coordinatorId);
+    s_coordinatorId = WORKER_ID_INVALID;
+}
+
+static void CoordinatorBody(TMessage message) {
+
+    TMessageId messageId = GetMessageId(message);
+    u32 payload = messageId == START_MESSAGE_ID ? *static_cast<u32 *>(GetMessagePayload(message)) : 0;
+    DestroyMessage(message);
+
+    switch (messageId) {
+    case START_MESSAGE_ID:
+        DeployDiamond(payload);
+        break;
+
+    case DRAINED_MESSAGE_ID:
+        /* Tear down the whole graph at once */
+        if (1 > TerminateGraph(s_graphId, CreateMessage(TORN_DOWN_MESSAGE_ID, 0), GetOwnWorkerId())) {
+
+            TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to terminate graph %d", s_graphId);
+        }
+        s_graphId = GRAPH_ID_INVALID;
+        break;
+
+    case TORN_DOWN_MESSAGE_ID:
+        TestCase::ReportTestResult(TestCase::Result::Success);
+        break;
+
+    default:
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Unexpected message 0x%x", messageId);
+        break;
+    }
+}
+
+static void SourceBody(TMessage message) {
+
+    if (GetStageOutputCount() != 2) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Source has %d output(s) (expected: 2)", GetStageOutputCount());
+        DestroyMessage(message);
+        return;
+    }
+
+    /* Fan out to both branches */
+    TMessage copy = CopyMessage(message);
+    if (copy == MESSAGE_INVALID) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to copy a message at the source");
+        DestroyMessage(message);
+        return;
+    }
+    SendMessageToOutput(message, 0);
+    SendMessageToOutput(copy, 1);
+}
+
+static void BranchBody(TMessage message) {
+
+    if (GetStageOutputCount() != 1) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Branch 0x%x has %d output(s) (expected: 1)", GetOwnWorkerId(), GetStageOutputCount());
+        DestroyMessage(message);
+        return;
+    }
+
+    SendMessageToOutput(message, 0);
+}
+
+static void SinkBody(TMessage message) {
+
+    DataPayload * payload = static_cast<DataPayload *>(GetMessagePayload(message));
+    TWorkerId coordinator = payload->Coordinator;
+    u32 expected = payload->Expected;
+    DestroyMessage(message);
+
+    if (GetStageOutputCount() != 0) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Sink has %d output(s) (expected: 0)", GetStageOutputCount());
+        return;
+    }
+
+    /* Every message reaches the sink along both branches */
+    if (++s_sinkReceived == 2 * expected) {
+
+        /* Be ready for the next run - the counter lives on the sink's core */
+        s_sinkReceived = 0;
+        SendMessage(CreateMessage(DRAINED_MESSAGE_ID, 0), coordinator);
+    }
+}
+
+static void DeployDiamond(u32 messages) {
+
+    SGraphStage stages[DIAMOND_STAGES] = {};
+    stages[SOURCE_STAGE] = {
+        .Worker = { .Name = "GraphSource", .WorkerId = WORKER_ID_INVALID, .Parallel = true, .WorkerBody = SourceBody },
+        .Cost = 1,
+        .Cores = 2
+    };
+    stages[LEFT_STAGE] = {
+        .Worker = { .Name = "GraphLeft", .WorkerId = WORKER_ID_INVALID, .Parallel = true, .WorkerBody = BranchBody },
+        .Cost = 4,
+        .Cores = 4
+    };
+    stages[RIGHT_STAGE] = {
+        .Worker = { .Name = "GraphRight", .WorkerId = WORKER_ID_INVALID, .Parallel = true, .WorkerBody = BranchBody },
+        .Cost = 4,
+        .Cores = 4
+    };
+    stages[SINK_STAGE] = {
+        .Worker = { .Name = "GraphSink", .WorkerId = WORKER_ID_INVALID, .Parallel = false, .WorkerBody = SinkBody },
+        .Cost = 1
+    };
+    SGraphEdge edges[] = {
+        { .From = SOURCE_STAGE, .To = LEFT_STAGE },
+        { .From = LEFT_STAGE, .To = SINK_STAGE },
+        { .From = SOURCE_STAGE, .To = RIGHT_STAGE },
+        { .From = RIGHT_STAGE, .To = SINK_STAGE }
+    };
+    SGraphConfig graphConfig = {
+        .Name = "Diamond",
+        .Stages = stages,
+        .StageCount = DIAMOND_STAGES,
+        .Edges = edges,
+        .EdgeCount = sizeof(edges) / sizeof(edges[0])
+    };
+
+    s_graphId = DeployGraph(&graphConfig);
+    if (s_graphId == GRAPH_ID_INVALID) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to deploy the graph");
+        return;
+    }
+
+    /* Messages sent before the stages become active are buffered by the platform */
+    TWorkerId source = GetGraphStage(s_graphId, SOURCE_STAGE);
+    for (u32 i = 0; i < messages; i++) {
+
+        TMessage message = CreateMessage(DATA_MESSAGE_ID, sizeof(DataPayload));
+        if (message == MESSAGE_INVALID) {
+
+            /* The sink cannot drain, let the test time out */
+            TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create data message %d", i);
+            return;
+        }
+        DataPayload * payload = static_cast<DataPayload *>(GetMessagePayload(message));
+        payload->Coordinator = GetOwnWorkerId();
+        payload->Expected = messages;
+        SendMessage(message, source);
+    }
+}
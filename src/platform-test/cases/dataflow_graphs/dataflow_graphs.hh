@@ -0,0 +1,16 @@
+
+#ifndef PLATFORM_TEST_CASES_DATAFLOW_GRAPHS_DATAFLOW_GRAPHS_HH
+#define PLATFORM_TEST_CASES_DATAFLOW_GRAPHS_DATAFLOW_GRAPHS_HH
+
+#include <menabrea/test/test_case.hh>
+
+class TestDataflowGraphs : public TestCase::Instance {
+public:
+    TestDataflowGraphs(const char * name) : TestCase::Instance(name) {}
+    virtual u32 GetParamsSize(void) override;
+    virtual int ParseParams(char * paramsIn, void * paramsOut) override;
+    virtual int StartTest(void * args) override;
+    virtual void StopTest(void) override;
+};
+
+#endif /* PLATFORM_TEST_CASES_DATAFLOW_GRAPHS_DATAFLOW_GRAPHS_HH */
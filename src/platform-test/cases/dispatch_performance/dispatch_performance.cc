@@ -0,0 +1,161 @@
+#include "dispatch_performance.hh"
+#include <menabrea/test/params_parser.hh>
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+#include <chrono>
+
+static constexpr const TMessageId PING_MESSAGE_ID = 0xD15A;
+struct TestDispatchPerformanceParams {
+    u32 Rounds;
+    bool NoEarlyExit;
+};
+
+struct PingPayload {
+    TWorkerId PongId;
+    u32 Rounds;
+    u32 Remaining;
+    u64 Start;
+};
+
+static TWorkerId s_pingId = WORKER_ID_INVALID;
+static TWorkerId s_pongId = WORKER_ID_INVALID;
+
+static void PingBody(TMessage message);
+static void PongBody(TMessage message);
+static u64 GetTimestamp(void);
+
+u32 TestDispatchPerformance::GetParamsSize(void) {
+
+    return sizeof(TestDispatchPerformanceParams);
+}
+
+int TestDispatchPerformance::ParseParams(char * paramsIn, void * paramsOut) {
+
+    ParamsParser::StructLayout paramsLayout;
+    paramsLayout["rounds"] = ParamsParser::StructField(offsetof(TestDispatchPerformanceParams, Rounds), sizeof(u32), ParamsParser::FieldType::U32);
+    paramsLayout["noEarlyExit"] = ParamsParser::StructField(offsetof(TestDispatchPerformanceParams, NoEarlyExit), sizeof(bool), ParamsParser::FieldType::Boolean);
+
+    if (ParamsParser::Parse(paramsIn, paramsOut, std::move(paramsLayout))) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to parse the parameters for test '%s'", this->GetName());
+        return -1;
+    }
+
+    TestDispatchPerformanceParams * parsed = static_cast<TestDispatchPerformanceParams *>(paramsOut);
+    if (parsed->Rounds == 0) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s: Number of rounds must be positive", \
+            this->GetName());
+        return -1;
+    }
+
+    return 0;
+}
+
+int TestDispatchPerformance::StartTest(void * args) {
+
+    TestDispatchPerformanceParams * params = static_cast<TestDispatchPerformanceParams *>(args);
+
+    /* Keep both workers on a single core so that only the dispatch overhead is measured. Prefer
+     * an isolated core if available. */
+    TCoreMask isolatedCores = GetIsolatedCoresMask();
+    TCoreMask coreMask = CoreMaskIsEmpty(isolatedCores) ? GetSharedCoreMask() : CoreMaskOf(CoreMaskFirst(isolatedCores));
+
+    SWorkerConfig workerConfig = {
+        .Name = "DispatchPing",
+        .WorkerId = WORKER_ID_INVALID,
+        .CoreMask = coreMask,
+        .Parallel = false,
+        .NoEarlyExit = params->NoEarlyExit,
+        .WorkerBody = PingBody
+    };
+    s_pingId = DeployWorker(&workerConfig);
+    if (s_pingId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the ping worker in test '%s'", \
+            this->GetName());
+        return -1;
+    }
+
+    workerConfig.Name = "DispatchPong";
+    workerConfig.WorkerBody = PongBody;
+    s_pongId = DeployWorker(&workerConfig);
+    if (s_pongId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the pong worker in test '%s'", \
+            this->GetName());
+        return -1;
+    }
+
+    /* Carry the test state in the message, since the workers run in a different process */
+    TMessage message = CreateMessage(PING_MESSAGE_ID, sizeof(PingPayload));
+    if (message == MESSAGE_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to create the ping message in test '%s'", \
+            this->GetName());
+        return -1;
+    }
+
+    PingPayload * payload = static_cast<PingPayload *>(GetMessagePayload(message));
+    payload->PongId = s_pongId;
+    payload->Rounds = params->Rounds;
+    payload->Remaining = params->Rounds;
+    payload->Start = 0;
+    SendMessage(message, s_pingId);
+    return 0;
+}
+
+void TestDispatchPerformance::StopTest(void) {
+
+    if (s_pingId != WORKER_ID_INVALID) {
+
+        TerminateWorker(s_pingId);
+        s_pingId = WORKER_ID_INVALID;
+    }
+
+    if (s_pongId != WORKER_ID_INVALID) {
+
+        TerminateWorker(s_pongId);
+        s_pongId = WORKER_ID_INVALID;
+    }
+}
+
+static void PingBody(TMessage message) {
+
+    PingPayload * payload = static_cast<PingPayload *>(GetMessagePayload(message));
+
+    if (unlikely(payload->Remaining == payload->Rounds)) {
+
+        /* Start the clock on the worker's core */
+        payload->Start = GetTimestamp();
+
+    } else if (unlikely(payload->Remaining == 0)) {
+
+        u64 elapsed = GetTimestamp() - payload->Start;
+        /* Each round takes two dispatches */
+        u64 perDispatch = elapsed / (2 * static_cast<u64>(payload->Rounds));
+        LogPrint(ELogSeverityLevel_Info, "Dispatch cost: %lu ns (%u rounds in %lu ns)", \
+            perDispatch, payload->Rounds, elapsed);
+        TestCase::ReportTestResult(TestCase::Result::Success, "Dispatch cost: %lu ns", perDispatch);
+        DestroyMessage(message);
+        return;
+    }
+
+    payload->Remaining--;
+    SendMessage(message, payload->PongId);
+}
+
+static void PongBody(TMessage message) {
+
+    /* Empty body - bounce the message straight back */
+    SendMessage(message, GetMessageSender(message));
+}
+
+static u64 GetTimestamp(void) {
+
+    auto timePoint = std::chrono::time_point_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now());
+    auto sinceEpoch = timePoint.time_since_epoch();
+    return sinceEpoch.count();
+}
@@ -0,0 +1,277 @@
+#include "dynamic_ids.hh"
+#include <menabrea/test/params_parser.hh>
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+#include <menabrea/timing.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+#include <set>
+#include <vector>
+
+static constexpr const TMessageId START_MESSAGE_ID = 0x3220;
+static constexpr const TMessageId ALLOCATE_MESSAGE_ID = 0x3221;
+static constexpr const TMessageId REPORT_MESSAGE_ID = 0x3222;
+static constexpr const TMessageId TERMINATED_MESSAGE_ID = 0x3223;
+static constexpr const u32 MAX_PER_CORE = 16;
+static constexpr const int MAX_CORES = 256;
+struct TestDynamicIdsParams {
+    u32 PerCore;
+    u32 Rounds;
+};
+
+struct ReportPayload {
+    u32 Count;
+    TWorkerId WorkerIds[MAX_PER_CORE];
+    TTimerId TimerIds[MAX_PER_CORE];
+};
+
+/* Used by the coordinator only, which runs on the shared core */
+static TWorkerId s_coordinatorId = WORKER_ID_INVALID;
+static TWorkerId s_allocatorIds[MAX_CORES];
+static int s_allocators = 0;
+static int s_reported = 0;
+static u32 s_perCore = 0;
+static u32 s_roundsLeft = 0;
+static std::vector<TWorkerId> s_workerIds;
+static std::vector<TTimerId> s_timerIds;
+
+static void CoordinatorBody(TMessage message);
+static void AllocatorBody(TMessage message);
+static void DummyBody(TMessage message);
+static void StartRound(void);
+static void CollectReport(const ReportPayload * report);
+static void ReleaseTimers(void);
+
+u32 TestDynamicIds::GetParamsSize(void) {
+
+    return sizeof(TestDynamicIdsParams);
+}
+
+int TestDynamicIds::ParseParams(char * paramsIn, void * paramsOut) {
+
+    ParamsParser::StructLayout paramsLayout;
+    paramsLayout["perCore"] = ParamsParser::StructField(offsetof(TestDynamicIdsParams, PerCore), sizeof(u32), ParamsParser::FieldType::U32);
+    paramsLayout["rounds"] = ParamsParser::StructField(offsetof(TestDynamicIdsParams, Rounds), sizeof(u32), ParamsParser::FieldType::U32);
+
+    if (ParamsParser::Parse(paramsIn, paramsOut, std::move(paramsLayout))) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to parse the parameters for test '%s'", this->GetName());
+        return -1;
+    }
+
+    TestDynamicIdsParams * parsed = static_cast<TestDynamicIdsParams *>(paramsOut);
+    if (parsed->PerCore == 0 || parsed->PerCore > MAX_PER_CORE || parsed->Rounds == 0) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s: Invalid number of IDs per core (%d) or rounds (%d)", \
+            this->GetName(), parsed->PerCore, parsed->Rounds);
+        return -1;
+    }
+
+    return 0;
+}
+
+int TestDynamicIds::StartTest(void * args) {
+
+    TestDynamicIdsParams * params = static_cast<TestDynamicIdsParams *>(args);
+    s_perCore = params->PerCore;
+    s_roundsLeft = params->Rounds;
+    s_allocators = 0;
+    s_workerIds.clear();
+    s_timerIds.clear();
+
+    s_coordinatorId = DeploySimpleWorker("IdCoordinator", WORKER_ID_INVALID, GetSharedCoreMask(), CoordinatorBody);
+    if (s_coordinatorId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the coordinator");
+        return -1;
+    }
+
+    /* Allocate IDs from every core. Dynamic workers have already been deployed before
+     * the dispatchers forked (e.g. by the test runner), so all the cores start off
+     * from the same view of the ID pools. */
+    TCoreMask allCores = GetAllCoresMask();
+    for (int core = 0; core < GetCoreCount() && core < MAX_CORES; core++) {
+
+        if (!CoreMaskContains(allCores, core)) {
+
+            continue;
+        }
+
+        TWorkerId allocatorId = DeploySimpleWorker("IdAllocator", WORKER_ID_INVALID, CoreMaskOf(core), AllocatorBody);
+        if (allocatorId == WORKER_ID_INVALID) {
+
+            LogPrint(ELogSeverityLevel_Error, "Failed to deploy the allocator for core %d", core);
+            return -1;
+        }
+        s_allocatorIds[s_allocators++] = allocatorId;
+    }
+
+    TMessage message = CreateMessage(START_MESSAGE_ID, 0);
+    if (message == MESSAGE_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to create the start message");
+        return -1;
+    }
+    SendMessage(message, s_coordinatorId);
+
+    return 0;
+}
+
+void TestDynamicIds::StopTest(void) {
+
+    ReleaseTimers();
+    if (!s_workerIds.empty()) {
+
+        (void) TerminateWorkers(s_workerIds.data(), static_cast<int>(s_workerIds.size()), MESSAGE_INVALID, WORKER_ID_INVALID);
+        s_workerIds.clear();
+    }
+    for (int i = 0; i < s_allocators; i++) {
+
+        TerminateWorker(s_allocatorIds[i]);
+    }
+    s_allocators = 0;
+    TerminateWorker(s_coordinatorId);
+    s_coordinatorId = WORKER_ID_INVALID;
+}
+
+static void CoordinatorBody(TMessage message) {
+
+    TMessageId messageId = GetMessageId(message);
+    switch (messageId) {
+    case START_MESSAGE_ID:
+        StartRound();
+        break;
+
+    case REPORT_MESSAGE_ID:
+        CollectReport(static_cast<ReportPayload *>(GetMessagePayload(message)));
+        break;
+
+    case TERMINATED_MESSAGE_ID:
+        /* All the IDs of the round are back in the pools */
+        if (--s_roundsLeft == 0) {
+
+            TestCase::ReportTestResult(TestCase::Result::Success);
+
+        } else {
+
+            StartRound();
+        }
+        break;
+
+    default:
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Unexpected message 0x%x", messageId);
+        break;
+    }
+    DestroyMessage(message);
+}
+
+static void AllocatorBody(TMessage message) {
+
+    u32 perCore = *static_cast<u32 *>(GetMessagePayload(message));
+    TWorkerId coordinator = GetMessageSender(message);
+    DestroyMessage(message);
+
+    TMessage report = CreateMessage(REPORT_MESSAGE_ID, sizeof(ReportPayload));
+    if (report == MESSAGE_INVALID) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create a report on core %d", GetCurrentCore());
+        return;
+    }
+
+    /* Report whatever got allocated and let the coordinator judge */
+    ReportPayload * payload = static_cast<ReportPayload *>(GetMessagePayload(report));
+    for (payload->Count = 0; payload->Count < perCore; payload->Count++) {
+
+        payload->WorkerIds[payload->Count] = DeploySimpleWorker("IdDummy", WORKER_ID_INVALID, GetCurrentCoreMask(), DummyBody);
+        payload->TimerIds[payload->Count] = CreateTimer("IdDummy");
+    }
+    SendMessage(report, coordinator);
+}
+
+static void DummyBody(TMessage message) {
+
+    DestroyMessage(message);
+}
+
+static void StartRound(void) {
+
+    s_reported = 0;
+    for (int i = 0; i < s_allocators; i++) {
+
+        TMessage message = CreateMessage(ALLOCATE_MESSAGE_ID, sizeof(u32));
+        if (message == MESSAGE_INVALID) {
+
+            TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create an allocation request");
+            return;
+        }
+        *static_cast<u32 *>(GetMessagePayload(message)) = s_perCore;
+        SendMessage(message, s_allocatorIds[i]);
+    }
+}
+
+static void CollectReport(const ReportPayload * report) {
+
+    bool allocated = true;
+    for (u32 i = 0; i < report->Count; i++) {
+
+        /* Keep track of everything allocated for the cleanup */
+        if (report->WorkerIds[i] != WORKER_ID_INVALID) {
+
+            s_workerIds.push_back(report->WorkerIds[i]);
+
+        } else {
+
+            allocated = false;
+        }
+
+        if (report->TimerIds[i] != TIMER_ID_INVALID) {
+
+            s_timerIds.push_back(report->TimerIds[i]);
+
+        } else {
+
+            allocated = false;
+        }
+    }
+
+    if (!allocated) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to allocate %d worker and timer ID(s) on a core", \
+            report->Count);
+        return;
+    }
+
+    if (++s_reported < s_allocators) {
+
+        return;
+    }
+
+    /* IDs held at the same time by different cores must never collide */
+    std::set<TWorkerId> workerIds(s_workerIds.begin(), s_workerIds.end());
+    std::set<TTimerId> timerIds(s_timerIds.begin(), s_timerIds.end());
+    if (workerIds.size() != s_workerIds.size() || timerIds.size() != s_timerIds.size()) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Duplicate IDs handed out: %lu unique worker ID(s) of %lu, %lu unique timer ID(s) of %lu", \
+            workerIds.size(), s_workerIds.size(), timerIds.size(), s_timerIds.size());
+        return;
+    }
+
+    /* Return all the IDs and go for another round, cycling through the pools */
+    ReleaseTimers();
+    if (0 > TerminateWorkers(s_workerIds.data(), static_cast<int>(s_workerIds.size()), \
+        CreateMessage(TERMINATED_MESSAGE_ID, 0), GetOwnWorkerId())) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to terminate the dummy workers");
+    }
+    s_workerIds.clear();
+}
+
+static void ReleaseTimers(void) {
+
+    for (TTimerId timerId : s_timerIds) {
+
+        DestroyTimer(timerId);
+    }
+    s_timerIds.clear();
+}
@@ -0,0 +1,15 @@
+#ifndef PLATFORM_TEST_CASES_DYNAMIC_IDS_DYNAMIC_IDS_HH
+#define PLATFORM_TEST_CASES_DYNAMIC_IDS_DYNAMIC_IDS_HH
+
+#include <menabrea/test/test_case.hh>
+
+class TestDynamicIds : public TestCase::Instance {
+public:
+    TestDynamicIds(const char * name) : TestCase::Instance(name) {}
+    virtual u32 GetParamsSize(void) override;
+    virtual int ParseParams(char * paramsIn, void * paramsOut) override;
+    virtual int StartTest(void * args) override;
+    virtual void StopTest(void) override;
+};
+
+#endif /* PLATFORM_TEST_CASES_DYNAMIC_IDS_DYNAMIC_IDS_HH */
@@ -0,0 +1,188 @@
+#include "handler_watchdog.hh"
+#include <menabrea/test/params_parser.hh>
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+#include <chrono>
+
+static constexpr const TMessageId START_MESSAGE_ID = 0x3230;
+static constexpr const TMessageId SPIN_MESSAGE_ID = 0x3231;
+static constexpr const TMessageId DONE_MESSAGE_ID = 0x3232;
+struct TestHandlerWatchdogParams {
+    u32 Spin;
+    u32 Budget;
+};
+
+/* The coordinator runs on the shared core - the spinner gets its spin time in the message instead */
+static TWorkerId s_coordinatorId = WORKER_ID_INVALID;
+static TWorkerId s_spinnerId = WORKER_ID_INVALID;
+static u32 s_spin = 0;
+
+static void CoordinatorBody(TMessage message);
+static void SpinnerBody(TMessage message);
+static void StartSpinning(void);
+static void CheckOverruns(void);
+
+u32 TestHandlerWatchdog::GetParamsSize(void) {
+
+    return sizeof(TestHandlerWatchdogParams);
+}
+
+int TestHandlerWatchdog::ParseParams(char * paramsIn, void * paramsOut) {
+
+    ParamsParser::StructLayout paramsLayout;
+    paramsLayout["spin"] = ParamsParser::StructField(offsetof(TestHandlerWatchdogParams, Spin), sizeof(u32), ParamsParser::FieldType::U32);
+    paramsLayout["budget"] = ParamsParser::StructField(offsetof(TestHandlerWatchdogParams, Budget), sizeof(u32), ParamsParser::FieldType::U32);
+
+    if (ParamsParser::Parse(paramsIn, paramsOut, std::move(paramsLayout))) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to parse the parameters for test '%s'", this->GetName());
+        return -1;
+    }
+
+    TestHandlerWatchdogParams * parsed = static_cast<TestHandlerWatchdogParams *>(paramsOut);
+    if (parsed->Spin == 0 || parsed->Spin <= parsed->Budget) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s: Spin time (%d us) must be positive and exceed the budget (%d us)", \
+            this->GetName(), parsed->Spin, parsed->Budget);
+        return -1;
+    }
+
+    return 0;
+}
+
+int TestHandlerWatchdog::StartTest(void * args) {
+
+    TestHandlerWatchdogParams * params = static_cast<TestHandlerWatchdogParams *>(args);
+    s_spin = params->Spin;
+
+    TCoreMask isolatedCores = GetIsolatedCoresMask();
+    if (CoreMaskIsEmpty(isolatedCores)) {
+
+        /* A handler stuck on the shared core also stalls the watchdog */
+        LogPrint(ELogSeverityLevel_Error, "No isolated core to spin on");
+        return -1;
+    }
+
+    s_coordinatorId = DeploySimpleWorker("WatchdogCoordinator", WORKER_ID_INVALID, GetSharedCoreMask(), CoordinatorBody);
+    if (s_coordinatorId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the coordinator");
+        return -1;
+    }
+
+    /* Zero budget falls back to the node-wide one */
+    SWorkerConfig config = {
+        .Name = "WatchdogSpinner",
+        .WorkerId = WORKER_ID_INVALID,
+        .CoreMask = CoreMaskOf(CoreMaskFirst(isolatedCores)),
+        .Parallel = false,
+        .HandlerBudgetUs = params->Budget,
+        .WorkerBody = SpinnerBody
+    };
+    s_spinnerId = DeployWorker(&config);
+    if (s_spinnerId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the spinner");
+        return -1;
+    }
+
+    TMessage message = CreateMessage(START_MESSAGE_ID, 0);
+    if (message == MESSAGE_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to create the start message");
+        return -1;
+    }
+    SendMessage(message, s_coordinatorId);
+
+    return 0;
+}
+
+void TestHandlerWatchdog::StopTest(void) {
+
+    TWorkerId * workerIds[] = { &s_coordinatorId, &s_spinnerId };
+    for (TWorkerId * workerId : workerIds) {
+
+        if (*workerId != WORKER_ID_INVALID) {
+
+            TerminateWorker(*workerId);
+            *workerId = WORKER_ID_INVALID;
+        }
+    }
+}
+
+static void CoordinatorBody(TMessage message) {
+
+    TMessageId messageId = GetMessageId(message);
+    DestroyMessage(message);
+
+    switch (messageId) {
+    case START_MESSAGE_ID:
+        StartSpinning();
+        break;
+
+    case DONE_MESSAGE_ID:
+        CheckOverruns();
+        break;
+
+    default:
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Unexpected message 0x%x", messageId);
+        break;
+    }
+}
+
+static void SpinnerBody(TMessage message) {
+
+    u32 spin = *static_cast<u32 *>(GetMessagePayload(message));
+    TWorkerId coordinator = GetMessageSender(message);
+    DestroyMessage(message);
+
+    /* Overrun the handler budget - the watchdog polls on the shared core and reports the overrun in the meantime */
+    auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start < std::chrono::microseconds(spin)) {
+
+        ;
+    }
+
+    TMessage done = CreateMessage(DONE_MESSAGE_ID, 0);
+    if (done == MESSAGE_INVALID) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create the completion message");
+        return;
+    }
+    SendMessage(done, coordinator);
+}
+
+static void StartSpinning(void) {
+
+    TMessage message = CreateMessage(SPIN_MESSAGE_ID, sizeof(u32));
+    if (message == MESSAGE_INVALID) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create the spin message");
+        return;
+    }
+    *static_cast<u32 *>(GetMessagePayload(message)) = s_spin;
+    SendMessage(message, s_spinnerId);
+}
+
+static void CheckOverruns(void) {
+
+    SWorkerStatistics statistics;
+    if (0 != GetWorkerStatistics(s_spinnerId, &statistics)) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to get the statistics of the spinner");
+        return;
+    }
+
+    /* The spinner has been called once, so it must have been reported exactly once */
+    if (statistics.HandlerOverruns != 1) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Spinner reported %lu time(s) by the watchdog after spinning for %u us", \
+            statistics.HandlerOverruns, s_spin);
+        return;
+    }
+
+    TestCase::ReportTestResult(TestCase::Result::Success);
+}
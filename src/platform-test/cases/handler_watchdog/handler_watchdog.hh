@@ -0,0 +1,15 @@
+#ifndef PLATFORM_TEST_CASES_HANDLER_WATCHDOG_HANDLER_WATCHDOG_HH
+#define PLATFORM_TEST_CASES_HANDLER_WATCHDOG_HANDLER_WATCHDOG_HH
+
+#include <menabrea/test/test_case.hh>
+
+class TestHandlerWatchdog : public TestCase::Instance {
+public:
+    TestHandlerWatchdog(const char * name) : TestCase::Instance(name) {}
+    virtual u32 GetParamsSize(void) override;
+    virtual int ParseParams(char * paramsIn, void * paramsOut) override;
+    virtual int StartTest(void * args) override;
+    virtual void StopTest(void) override;
+};
+
+#endif /* PLATFORM_TEST_CASES_HANDLER_WATCHDOG_HANDLER_WATCHDOG_HH */
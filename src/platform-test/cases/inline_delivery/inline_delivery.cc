@@ -0,0 +1,196 @@
+#include "inline_delivery.hh"
+#include <menabrea/test/params_parser.hh>
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+#include <cstdio>
+
+static constexpr const TMessageId START_MESSAGE_ID = 0x3180;
+static constexpr const TMessageId DEPLOYED_MESSAGE_ID = 0x3181;
+static constexpr const TMessageId STAGE_MESSAGE_ID = 0x3182;
+static constexpr const TMessageId RESULT_MESSAGE_ID = 0x3183;
+static constexpr const u32 MAX_STAGES = 16;
+/* Mirrors the platform's limit on nested inline invocations */
+static constexpr const u32 MAX_INLINE_DEPTH = 4;
+static constexpr const u32 NAME_LEN = 32;
+struct TestInlineDeliveryParams {
+    u32 Stages;
+};
+
+static TWorkerId s_sourceId = WORKER_ID_INVALID;
+/* All workers run on the shared core, so their state can be kept in static variables */
+static TWorkerId s_stageIds[MAX_STAGES];
+static char s_stageNames[MAX_STAGES][NAME_LEN];
+static u32 s_stages = 0;
+static u32 s_stagesRun = 0;
+static u32 s_stagesRunInline = 0;
+static bool s_sending = false;
+
+static void SourceBody(TMessage message);
+static void StageBody(TMessage message);
+static void DeployStages(u32 stages);
+static void SendEmptyMessage(TMessageId messageId, TWorkerId receiver);
+
+u32 TestInlineDelivery::GetParamsSize(void) {
+
+    return sizeof(TestInlineDeliveryParams);
+}
+
+int TestInlineDelivery::ParseParams(char * paramsIn, void * paramsOut) {
+
+    ParamsParser::StructLayout paramsLayout;
+    paramsLayout["stages"] = ParamsParser::StructField(offsetof(TestInlineDeliveryParams, Stages), sizeof(u32), ParamsParser::FieldType::U32);
+
+    if (ParamsParser::Parse(paramsIn, paramsOut, std::move(paramsLayout))) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to parse the parameters for test '%s'", this->GetName());
+        return -1;
+    }
+
+    TestInlineDeliveryParams * parsed = static_cast<TestInlineDeliveryParams *>(paramsOut);
+    if (parsed->Stages == 0 || parsed->Stages > MAX_STAGES) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s: Invalid number of stages: %d", \
+            this->GetName(), parsed->Stages);
+        return -1;
+    }
+
+    return 0;
+}
+
+int TestInlineDelivery::StartTest(void * args) {
+
+    TestInlineDeliveryParams * params = static_cast<TestInlineDeliveryParams *>(args);
+
+    s_sourceId = DeploySimpleWorker("InlineSource", WORKER_ID_INVALID, GetSharedCoreMask(), SourceBody);
+    if (s_sourceId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the source");
+        return -1;
+    }
+
+    TMessage message = CreateMessage(START_MESSAGE_ID, sizeof(u32));
+    if (message == MESSAGE_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to create the start message");
+        return -1;
+    }
+    *static_cast<u32 *>(GetMessagePayload(message)) = params->Stages;
+    SendMessage(message, s_sourceId);
+
+    return 0;
+}
+
+void TestInlineDelivery::StopTest(void) {
+
+    (void) TerminateWorkers(s_stageIds, s_stages, MESSAGE_INVALID, WORKER_ID_INVALID);
+    s_stages = 0;
+    TerminateWorker(s_sourceId);
+    s_sourceId = WORKER_ID_INVALID;
+}
+
+static void SourceBody(TMessage message) {
+
+    TMessageId messageId = GetMessageId(message);
+    u32 payload = messageId == START_MESSAGE_ID ? *static_cast<u32 *>(GetMessagePayload(message)) : 0;
+    DestroyMessage(message);
+
+    switch (messageId) {
+    case START_MESSAGE_ID:
+        DeployStages(payload);
+        break;
+
+    case DEPLOYED_MESSAGE_ID:
+        /* Stages within the depth limit must run before SendMessage returns */
+        s_sending = true;
+        SendEmptyMessage(STAGE_MESSAGE_ID, s_stageIds[0]);
+        s_sending = false;
+        break;
+
+    case RESULT_MESSAGE_ID:
+    {
+        u32 expectedInline = s_stages < MAX_INLINE_DEPTH ? s_stages : MAX_INLINE_DEPTH;
+        if (s_stagesRun != s_stages || s_stagesRunInline != expectedInline) {
+
+            TestCase::ReportTestResult(TestCase::Result::Failure, \
+                "%d out of %d stage(s) run, %d inline (expected: %d)", \
+                s_stagesRun, s_stages, s_stagesRunInline, expectedInline);
+            return;
+        }
+        TestCase::ReportTestResult(TestCase::Result::Success);
+        break;
+    }
+
+    default:
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Unexpected message 0x%x", messageId);
+        break;
+    }
+}
+
+static void StageBody(TMessage message) {
+
+    DestroyMessage(message);
+
+    u32 stage = s_stagesRun++;
+    if (s_stageIds[stage] != GetOwnWorkerId()) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Stage %d run by worker 0x%x instead of 0x%x", stage, GetOwnWorkerId(), s_stageIds[stage]);
+        return;
+    }
+
+    if (s_sending) {
+
+        /* Still on the source's stack */
+        s_stagesRunInline++;
+    }
+
+    if (stage + 1 < s_stages) {
+
+        SendEmptyMessage(STAGE_MESSAGE_ID, s_stageIds[stage + 1]);
+
+    } else {
+
+        /* The source does not accept inline delivery - the result is enqueued */
+        SendEmptyMessage(RESULT_MESSAGE_ID, s_sourceId);
+    }
+}
+
+static void DeployStages(u32 stages) {
+
+    SWorkerConfig configs[MAX_STAGES];
+    for (u32 i = 0; i < stages; i++) {
+
+        (void) std::snprintf(s_stageNames[i], sizeof(s_stageNames[i]), "InlineStage%u", i);
+        configs[i] = {
+            .Name = s_stageNames[i],
+            .WorkerId = WORKER_ID_INVALID,
+            .CoreMask = GetSharedCoreMask(),
+            .Parallel = false,
+            .InlineDelivery = true,
+            .WorkerBody = StageBody
+        };
+    }
+
+    s_stages = stages;
+    s_stagesRun = 0;
+    s_stagesRunInline = 0;
+    int deployed = DeployWorkers(configs, s_stageIds, stages, CreateMessage(DEPLOYED_MESSAGE_ID, 0), GetOwnWorkerId());
+    if (deployed != static_cast<int>(stages)) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Deployed %d out of %d stage(s)", deployed, stages);
+    }
+}
+
+static void SendEmptyMessage(TMessageId messageId, TWorkerId receiver) {
+
+    TMessage message = CreateMessage(messageId, 0);
+    if (message == MESSAGE_INVALID) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create message 0x%x", messageId);
+        return;
+    }
+    SendMessage(message, receiver);
+}
@@ -0,0 +1,140 @@
+#include "message_attachments.hh"
+#include <menabrea/test/params_parser.hh>
+#include <menabrea/log.h>
+#include <menabrea/cores.h>
+#include <menabrea/memory.h>
+#include <menabrea/messaging.h>
+
+static constexpr const TMessageId TEST_MESSAGE_ID = 0xA77A;
+struct TestMessageAttachmentsParams {
+    u32 BufferSize;
+};
+
+static TWorkerId s_workerId = WORKER_ID_INVALID;
+/* Buffer attached to the message - the test keeps a reference of its own to
+ * check that the receiver gets the very same memory */
+static u8 * s_buffer = nullptr;
+static u32 s_bufferSize = 0;
+
+static void WorkerBody(TMessage message);
+
+u32 TestMessageAttachments::GetParamsSize(void) {
+
+    return sizeof(TestMessageAttachmentsParams);
+}
+
+int TestMessageAttachments::ParseParams(char * paramsIn, void * paramsOut) {
+
+    ParamsParser::StructLayout paramsLayout;
+    paramsLayout["bufferSize"] = ParamsParser::StructField(offsetof(TestMessageAttachmentsParams, BufferSize), sizeof(u32), ParamsParser::FieldType::U32);
+
+    return ParamsParser::Parse(paramsIn, paramsOut, std::move(paramsLayout));
+}
+
+int TestMessageAttachments::StartTest(void * args) {
+
+    TestMessageAttachmentsParams * params = static_cast<TestMessageAttachmentsParams *>(args);
+    s_bufferSize = params->BufferSize;
+
+    s_workerId = DeploySimpleWorker("AttachmentReceiver", WORKER_ID_INVALID, GetSharedCoreMask(), WorkerBody);
+    if (s_workerId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the test worker");
+        return -1;
+    }
+
+    s_buffer = static_cast<u8 *>(GetRuntimeMemory(s_bufferSize));
+    if (s_buffer == nullptr) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to allocate %d bytes of runtime memory", s_bufferSize);
+        return -1;
+    }
+
+    for (u32 i = 0; i < s_bufferSize; i++) {
+
+        s_buffer[i] = static_cast<u8>(i);
+    }
+
+    TMessage message = CreateMessage(TEST_MESSAGE_ID, 0);
+    if (message == MESSAGE_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to create the test message");
+        PutRuntimeMemory(s_buffer);
+        s_buffer = nullptr;
+        return -1;
+    }
+
+    /* Keep a reference for ourselves, the initial one goes with the message */
+    if (0 != AttachRuntimeMemory(message, RefRuntimeMemory(s_buffer))) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to attach the buffer to the test message");
+        PutRuntimeMemory(s_buffer);
+        PutRuntimeMemory(s_buffer);
+        s_buffer = nullptr;
+        DestroyMessage(message);
+        return -1;
+    }
+
+    SendMessage(message, s_workerId);
+    return 0;
+}
+
+void TestMessageAttachments::StopTest(void) {
+
+    if (s_workerId != WORKER_ID_INVALID) {
+
+        /* Clean up after a failed test */
+        TerminateWorker(s_workerId);
+    }
+
+    if (s_buffer != nullptr) {
+
+        PutRuntimeMemory(s_buffer);
+        s_buffer = nullptr;
+    }
+}
+
+static void WorkerBody(TMessage message) {
+
+    if (unlikely(GetMessageId(message) != TEST_MESSAGE_ID)) {
+
+        LogPrint(ELogSeverityLevel_Warning, "Worker 0x%x received unexpected message 0x%x from 0x%x", \
+            GetOwnWorkerId(), GetMessageId(message), GetMessageSender(message));
+        DestroyMessage(message);
+        return;
+    }
+
+    u32 attachments = GetMessageAttachmentCount(message);
+    u8 * buffer = static_cast<u8 *>(GetMessageAttachment(message, 0));
+    if (attachments != 1 || buffer != s_buffer) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Unexpected attachments: %d, buffer: %p (expected: %p)", attachments, buffer, s_buffer);
+
+    } else {
+
+        bool contentValid = true;
+        for (u32 i = 0; i < s_bufferSize && contentValid; i++) {
+
+            contentValid = buffer[i] == static_cast<u8>(i);
+        }
+
+        if (contentValid) {
+
+            TestCase::ReportTestResult(TestCase::Result::Success);
+
+        } else {
+
+            TestCase::ReportTestResult(TestCase::Result::Failure, "Invalid content of the attached buffer");
+        }
+    }
+
+    /* Releases the message's reference, the test still holds its own */
+    DestroyMessage(message);
+    /* Note that the worker is deployed only on the shared core so we do
+     * not risk a race condition where the StopTest callback tries to
+     * terminate us again by reading obsolete s_workerId */
+    s_workerId = WORKER_ID_INVALID;
+    /* Terminate self */
+    TerminateWorker(WORKER_ID_INVALID);
+}
@@ -0,0 +1,223 @@
+#include "message_deadlines.hh"
+#include <menabrea/test/params_parser.hh>
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+
+static constexpr const TMessageId START_MESSAGE_ID = 0x31E0;
+static constexpr const TMessageId STALE_MESSAGE_ID = 0x31E1;
+static constexpr const TMessageId FRESH_MESSAGE_ID = 0x31E2;
+static constexpr const TMessageId LAST_MESSAGE_ID = 0x31E3;
+static constexpr const u32 MAX_MESSAGES = 64;
+/* Short enough to elapse while the sender is still running, yet long enough to be set before it does */
+static constexpr const u32 SHORT_TIME_TO_LIVE = 100;
+/* Long enough never to elapse during the test */
+static constexpr const u32 LONG_TIME_TO_LIVE = 10000000;
+struct TestMessageDeadlinesParams {
+    u32 Stale;
+    u32 Fresh;
+};
+
+/* Both workers run on the shared core, so their state can be kept in static variables */
+static TWorkerId s_senderId = WORKER_ID_INVALID;
+static TWorkerId s_receiverId = WORKER_ID_INVALID;
+static TestMessageDeadlinesParams s_params;
+static u32 s_received = 0;
+
+static void SenderBody(TMessage message);
+static void ReceiverBody(TMessage message);
+static void SendMessages(void);
+static bool CreateMessages(TMessage messages[], u32 count, TMessageId messageId, u32 ttl);
+static void CheckExpiredMessages(void);
+
+u32 TestMessageDeadlines::GetParamsSize(void) {
+
+    return sizeof(TestMessageDeadlinesParams);
+}
+
+int TestMessageDeadlines::ParseParams(char * paramsIn, void * paramsOut) {
+
+    ParamsParser::StructLayout paramsLayout;
+    paramsLayout["stale"] = ParamsParser::StructField(offsetof(TestMessageDeadlinesParams, Stale), sizeof(u32), ParamsParser::FieldType::U32);
+    paramsLayout["fresh"] = ParamsParser::StructField(offsetof(TestMessageDeadlinesParams, Fresh), sizeof(u32), ParamsParser::FieldType::U32);
+
+    if (ParamsParser::Parse(paramsIn, paramsOut, std::move(paramsLayout))) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to parse the parameters for test '%s'", this->GetName());
+        return -1;
+    }
+
+    TestMessageDeadlinesParams * parsed = static_cast<TestMessageDeadlinesParams *>(paramsOut);
+    if (parsed->Stale == 0 || parsed->Stale > MAX_MESSAGES || parsed->Fresh > MAX_MESSAGES) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s: Invalid number of messages: %d stale, %d fresh", \
+            this->GetName(), parsed->Stale, parsed->Fresh);
+        return -1;
+    }
+
+    return 0;
+}
+
+int TestMessageDeadlines::StartTest(void * args) {
+
+    s_params = *static_cast<TestMessageDeadlinesParams *>(args);
+    s_received = 0;
+
+    s_receiverId = DeploySimpleWorker("DeadlineReceiver", WORKER_ID_INVALID, GetSharedCoreMask(), ReceiverBody);
+    if (s_receiverId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the receiver");
+        return -1;
+    }
+
+    s_senderId = DeploySimpleWorker("DeadlineSender", WORKER_ID_INVALID, GetSharedCoreMask(), SenderBody);
+    if (s_senderId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the sender");
+        return -1;
+    }
+
+    TMessage message = CreateMessage(START_MESSAGE_ID, 0);
+    if (message == MESSAGE_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to create the start message");
+        return -1;
+    }
+    SendMessage(message, s_senderId);
+
+    return 0;
+}
+
+void TestMessageDeadlines::StopTest(void) {
+
+    TerminateWorker(s_senderId);
+    s_senderId = WORKER_ID_INVALID;
+    TerminateWorker(s_receiverId);
+    s_receiverId = WORKER_ID_INVALID;
+}
+
+static void SenderBody(TMessage message) {
+
+    TMessageId messageId = GetMessageId(message);
+    DestroyMessage(message);
+
+    if (messageId != START_MESSAGE_ID) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Unexpected message 0x%x", messageId);
+        return;
+    }
+
+    SendMessages();
+}
+
+static void ReceiverBody(TMessage message) {
+
+    TMessageId messageId = GetMessageId(message);
+    DestroyMessage(message);
+
+    switch (messageId) {
+    case FRESH_MESSAGE_ID:
+        s_received++;
+        break;
+
+    case LAST_MESSAGE_ID:
+        /* Sent last and without a deadline, so everything else has been either delivered or dropped by now */
+        CheckExpiredMessages();
+        break;
+
+    default:
+        /* Stale messages must never reach the worker body */
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Unexpected message 0x%x", messageId);
+        break;
+    }
+}
+
+static void SendMessages(void) {
+
+    TMessage stale[MAX_MESSAGES];
+    TMessage fresh[MAX_MESSAGES];
+    if (!CreateMessages(stale, s_params.Stale, STALE_MESSAGE_ID, SHORT_TIME_TO_LIVE)) {
+
+        return;
+    }
+    if (!CreateMessages(fresh, s_params.Fresh, FRESH_MESSAGE_ID, LONG_TIME_TO_LIVE)) {
+
+        for (u32 i = 0; i < s_params.Stale; i++) {
+
+            DestroyMessage(stale[i]);
+        }
+        return;
+    }
+
+    /* The deadlines are set in order, so once the last message has expired, all the others have too */
+    while (!IsMessageExpired(stale[s_params.Stale - 1])) {
+
+        ;
+    }
+    if (IsMessageExpired(fresh[0])) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Message expired ahead of its deadline");
+    }
+
+    /* Interleave the stale messages with the fresh ones */
+    for (u32 i = 0; i < s_params.Stale || i < s_params.Fresh; i++) {
+
+        if (i < s_params.Stale) {
+
+            SendMessage(stale[i], s_receiverId);
+        }
+        if (i < s_params.Fresh) {
+
+            SendMessage(fresh[i], s_receiverId);
+        }
+    }
+
+    TMessage last = CreateMessage(LAST_MESSAGE_ID, 0);
+    if (last == MESSAGE_INVALID) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create the last message");
+        return;
+    }
+    SendMessage(last, s_receiverId);
+}
+
+static bool CreateMessages(TMessage messages[], u32 count, TMessageId messageId, u32 ttl) {
+
+    for (u32 i = 0; i < count; i++) {
+
+        messages[i] = CreateMessage(messageId, 0);
+        if (messages[i] == MESSAGE_INVALID) {
+
+            TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create message %d", i);
+            for (u32 j = 0; j < i; j++) {
+
+                DestroyMessage(messages[j]);
+            }
+            return false;
+        }
+        SetMessageTimeToLive(messages[i], ttl);
+    }
+
+    return true;
+}
+
+static void CheckExpiredMessages(void) {
+
+    SWorkerStatistics statistics;
+    if (0 != GetWorkerStatistics(s_receiverId, &statistics)) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to get the receiver's statistics");
+        return;
+    }
+
+    if (s_received != s_params.Fresh || statistics.MessagesExpired != s_params.Stale) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Receiver got %d message(s) with %lu expired (expected: %d and %d)", \
+            s_received, statistics.MessagesExpired, s_params.Fresh, s_params.Stale);
+        return;
+    }
+
+    TestCase::ReportTestResult(TestCase::Result::Success);
+}
@@ -0,0 +1,15 @@
+#ifndef PLATFORM_TEST_CASES_MESSAGE_DEADLINES_MESSAGE_DEADLINES_HH
+#define PLATFORM_TEST_CASES_MESSAGE_DEADLINES_MESSAGE_DEADLINES_HH
+
+#include <menabrea/test/test_case.hh>
+
+class TestMessageDeadlines : public TestCase::Instance {
+public:
+    TestMessageDeadlines(const char * name) : TestCase::Instance(name) {}
+    virtual u32 GetParamsSize(void) override;
+    virtual int ParseParams(char * paramsIn, void * paramsOut) override;
+    virtual int StartTest(void * args) override;
+    virtual void StopTest(void) override;
+};
+
+#endif /* PLATFORM_TEST_CASES_MESSAGE_DEADLINES_MESSAGE_DEADLINES_HH */
@@ -0,0 +1,209 @@
+#include "message_groups.hh"
+#include <menabrea/test/params_parser.hh>
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+#include <menabrea/memory.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+#include <cstdio>
+
+static constexpr const TMessageId START_MESSAGE_ID = 0x3190;
+static constexpr const TMessageId DEPLOYED_MESSAGE_ID = 0x3191;
+static constexpr const TMessageId SCATTER_MESSAGE_ID = 0x3192;
+static constexpr const TMessageId GATHERED_MESSAGE_ID = 0x3193;
+static constexpr const u32 MAX_WORKERS = 64;
+static constexpr const u32 NAME_LEN = 32;
+struct TestMessageGroupsParams {
+    u32 Workers;
+    u32 Rounds;
+};
+
+static TWorkerId s_coordinatorId = WORKER_ID_INVALID;
+/* Used by the coordinator only, which runs on a single core */
+static TWorkerId s_scatterIds[MAX_WORKERS];
+static char s_scatterNames[MAX_WORKERS][NAME_LEN];
+static u32 s_workers = 0;
+static u32 s_rounds = 0;
+static u32 s_round = 0;
+/* Counter in runtime memory, incremented by the workers on any core */
+static TAtomic32 * s_processed = nullptr;
+
+static void CoordinatorBody(TMessage message);
+static void ScatterBody(TMessage message);
+static void DeployScatterWorkers(u32 workers);
+static void ScatterRound(void);
+
+u32 TestMessageGroups::GetParamsSize(void) {
+
+    return sizeof(TestMessageGroupsParams);
+}
+
+int TestMessageGroups::ParseParams(char * paramsIn, void * paramsOut) {
+
+    ParamsParser::StructLayout paramsLayout;
+    paramsLayout["workers"] = ParamsParser::StructField(offsetof(TestMessageGroupsParams, Workers), sizeof(u32), ParamsParser::FieldType::U32);
+    paramsLayout["rounds"] = ParamsParser::StructField(offsetof(TestMessageGroupsParams, Rounds), sizeof(u32), ParamsParser::FieldType::U32);
+
+    if (ParamsParser::Parse(paramsIn, paramsOut, std::move(paramsLayout))) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to parse the parameters for test '%s'", this->GetName());
+        return -1;
+    }
+
+    TestMessageGroupsParams * parsed = static_cast<TestMessageGroupsParams *>(paramsOut);
+    if (parsed->Workers == 0 || parsed->Workers > MAX_WORKERS || parsed->Rounds == 0) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s: Invalid parameters (workers: %d, rounds: %d)", \
+            this->GetName(), parsed->Workers, parsed->Rounds);
+        return -1;
+    }
+
+    return 0;
+}
+
+int TestMessageGroups::StartTest(void * args) {
+
+    TestMessageGroupsParams * params = static_cast<TestMessageGroupsParams *>(args);
+
+    s_processed = static_cast<TAtomic32 *>(GetRuntimeMemory(sizeof(TAtomic32)));
+    if (s_processed == nullptr) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to allocate the shared counter");
+        return -1;
+    }
+    Atomic32Init(s_processed);
+    s_rounds = params->Rounds;
+    s_round = 0;
+
+    /* Pin the coordinator to a single core so that its state can be kept in static variables */
+    s_coordinatorId = DeploySimpleWorker("GroupCoordinator", WORKER_ID_INVALID, GetSharedCoreMask(), CoordinatorBody);
+    if (s_coordinatorId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the coordinator");
+        PutRuntimeMemory(s_processed);
+        s_processed = nullptr;
+        return -1;
+    }
+
+    TMessage message = CreateMessage(START_MESSAGE_ID, sizeof(u32));
+    if (message == MESSAGE_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to create the start message");
+        return -1;
+    }
+    *static_cast<u32 *>(GetMessagePayload(message)) = params->Workers;
+    SendMessage(message, s_coordinatorId);
+
+    return 0;
+}
+
+void TestMessageGroups::StopTest(void) {
+
+    (void) TerminateWorkers(s_scatterIds, s_workers, MESSAGE_INVALID, WORKER_ID_INVALID);
+    s_workers = 0;
+    TerminateWorker(s_coordinatorId);
+    s_coordinatorId = WORKER_ID_INVALID;
+    if (s_processed != nullptr) {
+
+        PutRuntimeMemory(s_processed);
+        s_processed = nullptr;
+    }
+}
+
+static void CoordinatorBody(TMessage message) {
+
+    TMessageId messageId = GetMessageId(message);
+    u32 payload = messageId == START_MESSAGE_ID ? *static_cast<u32 *>(GetMessagePayload(message)) : 0;
+    DestroyMessage(message);
+
+    switch (messageId) {
+    case START_MESSAGE_ID:
+        DeployScatterWorkers(payload);
+        break;
+
+    case DEPLOYED_MESSAGE_ID:
+        ScatterRound();
+        break;
+
+    case GATHERED_MESSAGE_ID:
+    {
+        /* Every worker must have returned from its body by now */
+        u32 processed = Atomic32Get(s_processed);
+        if (processed != s_workers * s_round) {
+
+            TestCase::ReportTestResult(TestCase::Result::Failure, \
+                "Round %d completed with %d message(s) processed (expected: %d)", \
+                s_round, processed, s_workers * s_round);
+            return;
+        }
+
+        if (s_round == s_rounds) {
+
+            TestCase::ReportTestResult(TestCase::Result::Success);
+
+        } else {
+
+            ScatterRound();
+        }
+        break;
+    }
+
+    default:
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Unexpected message 0x%x", messageId);
+        break;
+    }
+}
+
+static void ScatterBody(TMessage message) {
+
+    TAtomic32 * processed = static_cast<TAtomic32 *>(GetMessageAttachment(message, 0));
+    Atomic32Inc(processed);
+    DestroyMessage(message);
+}
+
+static void DeployScatterWorkers(u32 workers) {
+
+    SWorkerConfig configs[MAX_WORKERS];
+    for (u32 i = 0; i < workers; i++) {
+
+        (void) std::snprintf(s_scatterNames[i], sizeof(s_scatterNames[i]), "GroupScatter%u", i);
+        configs[i] = {
+            .Name = s_scatterNames[i],
+            .WorkerId = WORKER_ID_INVALID,
+            .CoreMask = GetAllCoresMask(),
+            .Parallel = true,
+            .WorkerBody = ScatterBody
+        };
+    }
+
+    s_workers = workers;
+    int deployed = DeployWorkers(configs, s_scatterIds, workers, CreateMessage(DEPLOYED_MESSAGE_ID, 0), GetOwnWorkerId());
+    if (deployed != static_cast<int>(workers)) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Deployed %d out of %d worker(s)", deployed, workers);
+    }
+}
+
+static void ScatterRound(void) {
+
+    s_round++;
+    TMessageGroup group = CreateMessageGroup(s_workers, CreateMessage(GATHERED_MESSAGE_ID, 0), GetOwnWorkerId());
+    if (group == MESSAGE_GROUP_INVALID) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create a message group");
+        return;
+    }
+
+    for (u32 i = 0; i < s_workers; i++) {
+
+        TMessage message = CreateMessage(SCATTER_MESSAGE_ID, 0);
+        if (message == MESSAGE_INVALID || 0 != AttachRuntimeMemory(message, RefRuntimeMemory(s_processed))) {
+
+            /* The group cannot complete, let the test time out */
+            TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create scatter message %d", i);
+            return;
+        }
+        SendMessageInGroup(message, s_scatterIds[i], group);
+    }
+}
@@ -0,0 +1,141 @@
+#include "peer_learning.hh"
+#include <menabrea/test/params_parser.hh>
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+
+static constexpr const TMessageId START_MESSAGE_ID = 0x3200;
+static constexpr const TMessageId PING_MESSAGE_ID = 0x3201;
+struct TestPeerLearningParams {
+    u32 Messages;
+    TWorkerId EchoId;
+};
+
+/* Used by the pinger only, which runs on the shared core */
+static TWorkerId s_pingerId = WORKER_ID_INVALID;
+static TWorkerId s_echoId = WORKER_ID_INVALID;
+static u32 s_messages = 0;
+static u32 s_received = 0;
+
+static void PingerBody(TMessage message);
+static void SendPing(u32 sequence);
+
+u32 TestPeerLearning::GetParamsSize(void) {
+
+    return sizeof(TestPeerLearningParams);
+}
+
+int TestPeerLearning::ParseParams(char * paramsIn, void * paramsOut) {
+
+    ParamsParser::StructLayout paramsLayout;
+    paramsLayout["echoId"] = ParamsParser::StructField(offsetof(TestPeerLearningParams, EchoId), sizeof(TWorkerId), ParamsParser::FieldType::U16);
+    paramsLayout["messages"] = ParamsParser::StructField(offsetof(TestPeerLearningParams, Messages), sizeof(u32), ParamsParser::FieldType::U32);
+
+    if (ParamsParser::Parse(paramsIn, paramsOut, std::move(paramsLayout))) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to parse the parameters for test '%s'", this->GetName());
+        return -1;
+    }
+
+    TestPeerLearningParams * parsed = static_cast<TestPeerLearningParams *>(paramsOut);
+    if (parsed->Messages < 2) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s: At least two messages are needed to exercise a learnt address", \
+            this->GetName());
+        return -1;
+    }
+
+    return 0;
+}
+
+int TestPeerLearning::StartTest(void * args) {
+
+    TestPeerLearningParams * params = static_cast<TestPeerLearningParams *>(args);
+
+    if (WorkerIdGetNode(params->EchoId) == GetOwnNodeId()) {
+
+        LogPrint(ELogSeverityLevel_Error, "Echo worker 0x%x is not on a remote node", params->EchoId);
+        return -1;
+    }
+
+    s_echoId = params->EchoId;
+    s_messages = params->Messages;
+    s_received = 0;
+    s_pingerId = DeploySimpleWorker("PeerPinger", WORKER_ID_INVALID, GetSharedCoreMask(), PingerBody);
+    if (s_pingerId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the pinger");
+        return -1;
+    }
+
+    TMessage message = CreateMessage(START_MESSAGE_ID, 0);
+    if (message == MESSAGE_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to create the start message");
+        return -1;
+    }
+    /* Have the pinger send the pings so that the echoes find their way back */
+    SendMessage(message, s_pingerId);
+
+    return 0;
+}
+
+void TestPeerLearning::StopTest(void) {
+
+    TerminateWorker(s_pingerId);
+    s_pingerId = WORKER_ID_INVALID;
+}
+
+static void PingerBody(TMessage message) {
+
+    TMessageId messageId = GetMessageId(message);
+    TWorkerId sender = GetMessageSender(message);
+    if (messageId == START_MESSAGE_ID) {
+
+        DestroyMessage(message);
+        /* Ping-pong one message at a time - with native addressing the first ping is broadcast
+         * and the following ones go to the address learnt from the echo */
+        SendPing(0);
+        return;
+    }
+
+    if (messageId != PING_MESSAGE_ID || sender != s_echoId) {
+
+        DestroyMessage(message);
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Unexpected message 0x%x from 0x%x", messageId, sender);
+        return;
+    }
+
+    u32 sequence = *static_cast<u32 *>(GetMessagePayload(message));
+    DestroyMessage(message);
+
+    if (sequence != s_received) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Echo %d returned out of order (expected: %d)", sequence, s_received);
+        return;
+    }
+
+    if (++s_received == s_messages) {
+
+        TestCase::ReportTestResult(TestCase::Result::Success);
+        return;
+    }
+
+    SendPing(s_received);
+}
+
+static void SendPing(u32 sequence) {
+
+    TMessage message = CreateMessage(PING_MESSAGE_ID, sizeof(u32));
+    if (message == MESSAGE_INVALID) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create ping %d", sequence);
+        return;
+    }
+
+    *static_cast<u32 *>(GetMessagePayload(message)) = sequence;
+    SendMessage(message, s_echoId);
+}
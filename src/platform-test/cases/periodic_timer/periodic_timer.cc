@@ -72,7 +72,7 @@ int TestPeriodicTimer::StartTest(void * args) {
         .Name = "PeriodicTimerTester",
         .InitArg = shmem,
         .WorkerId = WORKER_ID_INVALID,
-        .CoreMask = 0b10,
+        .CoreMask = CoreMaskOf(1),
         .UserInit = ReceiverInit,
         .UserExit = ReceiverExit,
         .WorkerBody = ReceiverBody
@@ -0,0 +1,164 @@
+#include "rate_limiting.hh"
+#include <menabrea/test/params_parser.hh>
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+
+static constexpr const TMessageId START_MESSAGE_ID = 0x31A0;
+static constexpr const TMessageId DEPLOYED_MESSAGE_ID = 0x31A1;
+static constexpr const TMessageId BURST_MESSAGE_ID = 0x31A2;
+static constexpr const TMessageId COMPLETED_MESSAGE_ID = 0x31A3;
+/* Low enough for the bucket not to refill noticeably while the burst is being sent */
+static constexpr const u32 RATE_LIMIT = 1;
+struct TestRateLimitingParams {
+    u32 Burst;
+    u32 Excess;
+};
+
+/* Both workers run on the shared core, so their state can be kept in static variables */
+static TWorkerId s_senderId = WORKER_ID_INVALID;
+static TWorkerId s_limitedId = WORKER_ID_INVALID;
+static TestRateLimitingParams s_params;
+static u32 s_received = 0;
+
+static void SenderBody(TMessage message);
+static void LimitedBody(TMessage message);
+static void SendBurst(void);
+
+u32 TestRateLimiting::GetParamsSize(void) {
+
+    return sizeof(TestRateLimitingParams);
+}
+
+int TestRateLimiting::ParseParams(char * paramsIn, void * paramsOut) {
+
+    ParamsParser::StructLayout paramsLayout;
+    paramsLayout["burst"] = ParamsParser::StructField(offsetof(TestRateLimitingParams, Burst), sizeof(u32), ParamsParser::FieldType::U32);
+    paramsLayout["excess"] = ParamsParser::StructField(offsetof(TestRateLimitingParams, Excess), sizeof(u32), ParamsParser::FieldType::U32);
+
+    if (ParamsParser::Parse(paramsIn, paramsOut, std::move(paramsLayout))) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to parse the parameters for test '%s'", this->GetName());
+        return -1;
+    }
+
+    TestRateLimitingParams * parsed = static_cast<TestRateLimitingParams *>(paramsOut);
+    if (parsed->Burst == 0) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s: Burst size must be positive", this->GetName());
+        return -1;
+    }
+
+    return 0;
+}
+
+int TestRateLimiting::StartTest(void * args) {
+
+    s_params = *static_cast<TestRateLimitingParams *>(args);
+    s_received = 0;
+
+    s_senderId = DeploySimpleWorker("RateSender", WORKER_ID_INVALID, GetSharedCoreMask(), SenderBody);
+    if (s_senderId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the sender");
+        return -1;
+    }
+
+    TMessage message = CreateMessage(START_MESSAGE_ID, 0);
+    if (message == MESSAGE_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to create the start message");
+        return -1;
+    }
+    SendMessage(message, s_senderId);
+
+    return 0;
+}
+
+void TestRateLimiting::StopTest(void) {
+
+    if (s_limitedId != WORKER_ID_INVALID) {
+
+        TerminateWorker(s_limitedId);
+        s_limitedId = WORKER_ID_INVALID;
+    }
+    TerminateWorker(s_senderId);
+    s_senderId = WORKER_ID_INVALID;
+}
+
+static void SenderBody(TMessage message) {
+
+    TMessageId messageId = GetMessageId(message);
+    DestroyMessage(message);
+
+    switch (messageId) {
+    case START_MESSAGE_ID:
+    {
+        SWorkerConfig config = {
+            .Name = "RateLimited",
+            .WorkerId = WORKER_ID_INVALID,
+            .CoreMask = GetSharedCoreMask(),
+            .Parallel = false,
+            .RateLimit = RATE_LIMIT,
+            .RateBurst = s_params.Burst,
+            .WorkerBody = LimitedBody
+        };
+        /* Use a batch of one to learn when the worker becomes active */
+        if (1 != DeployWorkers(&config, &s_limitedId, 1, CreateMessage(DEPLOYED_MESSAGE_ID, 0), GetOwnWorkerId())) {
+
+            TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to deploy the rate-limited worker");
+        }
+        break;
+    }
+
+    case DEPLOYED_MESSAGE_ID:
+        SendBurst();
+        break;
+
+    case COMPLETED_MESSAGE_ID:
+        /* Messages dropped count towards the group as soon as they are sent */
+        if (s_received != s_params.Burst) {
+
+            TestCase::ReportTestResult(TestCase::Result::Failure, \
+                "Worker received %d out of %d message(s) (expected: %d)", \
+                s_received, s_params.Burst + s_params.Excess, s_params.Burst);
+            return;
+        }
+        TestCase::ReportTestResult(TestCase::Result::Success);
+        break;
+
+    default:
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Unexpected message 0x%x", messageId);
+        break;
+    }
+}
+
+static void LimitedBody(TMessage message) {
+
+    DestroyMessage(message);
+    s_received++;
+}
+
+static void SendBurst(void) {
+
+    u32 total = s_params.Burst + s_params.Excess;
+    TMessageGroup group = CreateMessageGroup(total, CreateMessage(COMPLETED_MESSAGE_ID, 0), GetOwnWorkerId());
+    if (group == MESSAGE_GROUP_INVALID) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create a message group");
+        return;
+    }
+
+    for (u32 i = 0; i < total; i++) {
+
+        TMessage message = CreateMessage(BURST_MESSAGE_ID, 0);
+        if (message == MESSAGE_INVALID) {
+
+            /* The group cannot complete, let the test time out */
+            TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create burst message %d", i);
+            return;
+        }
+        SendMessageInGroup(message, s_limitedId, group);
+    }
+}
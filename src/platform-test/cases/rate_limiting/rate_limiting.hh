@@ -0,0 +1,16 @@
+
+#ifndef PLATFORM_TEST_CASES_RATE_LIMITING_RATE_LIMITING_HH
+#define PLATFORM_TEST_CASES_RATE_LIMITING_RATE_LIMITING_HH
+
+#include <menabrea/test/test_case.hh>
+
+class TestRateLimiting : public TestCase::Instance {
+public:
+    TestRateLimiting(const char * name) : TestCase::Instance(name) {}
+    virtual u32 GetParamsSize(void) override;
+    virtual int ParseParams(char * paramsIn, void * paramsOut) override;
+    virtual int StartTest(void * args) override;
+    virtual void StopTest(void) override;
+};
+
+#endif /* PLATFORM_TEST_CASES_RATE_LIMITING_RATE_LIMITING_HH */
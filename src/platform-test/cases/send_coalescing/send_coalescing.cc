@@ -0,0 +1,175 @@
+#include "send_coalescing.hh"
+#include <menabrea/test/params_parser.hh>
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+
+static constexpr const TMessageId START_MESSAGE_ID = 0x31D0;
+static constexpr const TMessageId SEQUENCE_MESSAGE_ID = 0x31D1;
+static constexpr const TMessageId DONE_MESSAGE_ID = 0x31D2;
+static constexpr const u32 RECEIVERS = 2;
+struct TestSendCoalescingParams {
+    u32 Messages;
+};
+
+/* All workers run on the shared core, so their state can be kept in static variables */
+static TWorkerId s_senderId = WORKER_ID_INVALID;
+static TWorkerId s_receiverIds[RECEIVERS] = { WORKER_ID_INVALID, WORKER_ID_INVALID };
+static u32 s_expected[RECEIVERS];
+static u32 s_messages = 0;
+static u32 s_done = 0;
+
+static void SenderBody(TMessage message);
+static void ReceiverBody(TMessage message);
+static void SendSequence(void);
+
+u32 TestSendCoalescing::GetParamsSize(void) {
+
+    return sizeof(TestSendCoalescingParams);
+}
+
+int TestSendCoalescing::ParseParams(char * paramsIn, void * paramsOut) {
+
+    ParamsParser::StructLayout paramsLayout;
+    paramsLayout["messages"] = ParamsParser::StructField(offsetof(TestSendCoalescingParams, Messages), sizeof(u32), ParamsParser::FieldType::U32);
+
+    if (ParamsParser::Parse(paramsIn, paramsOut, std::move(paramsLayout))) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to parse the parameters for test '%s'", this->GetName());
+        return -1;
+    }
+
+    TestSendCoalescingParams * parsed = static_cast<TestSendCoalescingParams *>(paramsOut);
+    if (parsed->Messages < RECEIVERS) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s: At least %d messages are needed", this->GetName(), RECEIVERS);
+        return -1;
+    }
+
+    return 0;
+}
+
+int TestSendCoalescing::StartTest(void * args) {
+
+    s_messages = static_cast<TestSendCoalescingParams *>(args)->Messages;
+    s_done = 0;
+
+    for (u32 i = 0; i < RECEIVERS; i++) {
+
+        /* Messages are dealt out to the receivers in turns */
+        s_expected[i] = i;
+        s_receiverIds[i] = DeploySimpleWorker("CoalescingReceiver", WORKER_ID_INVALID, GetSharedCoreMask(), ReceiverBody);
+        if (s_receiverIds[i] == WORKER_ID_INVALID) {
+
+            LogPrint(ELogSeverityLevel_Error, "Failed to deploy receiver %d", i);
+            return -1;
+        }
+    }
+
+    SWorkerConfig config = {
+        .Name = "CoalescingSender",
+        .WorkerId = WORKER_ID_INVALID,
+        .CoreMask = GetSharedCoreMask(),
+        .Parallel = false,
+        .CoalesceSends = true,
+        .WorkerBody = SenderBody
+    };
+    s_senderId = DeployWorker(&config);
+    if (s_senderId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the sender");
+        return -1;
+    }
+
+    TMessage message = CreateMessage(START_MESSAGE_ID, 0);
+    if (message == MESSAGE_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to create the start message");
+        return -1;
+    }
+    SendMessage(message, s_senderId);
+
+    return 0;
+}
+
+void TestSendCoalescing::StopTest(void) {
+
+    TerminateWorker(s_senderId);
+    s_senderId = WORKER_ID_INVALID;
+    for (u32 i = 0; i < RECEIVERS; i++) {
+
+        if (s_receiverIds[i] != WORKER_ID_INVALID) {
+
+            TerminateWorker(s_receiverIds[i]);
+            s_receiverIds[i] = WORKER_ID_INVALID;
+        }
+    }
+}
+
+static void SenderBody(TMessage message) {
+
+    TMessageId messageId = GetMessageId(message);
+    DestroyMessage(message);
+
+    switch (messageId) {
+    case START_MESSAGE_ID:
+        SendSequence();
+        break;
+
+    case DONE_MESSAGE_ID:
+        if (++s_done == RECEIVERS) {
+
+            TestCase::ReportTestResult(TestCase::Result::Success);
+        }
+        break;
+
+    default:
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Unexpected message 0x%x", messageId);
+        break;
+    }
+}
+
+static void ReceiverBody(TMessage message) {
+
+    u32 receiver = GetOwnWorkerId() == s_receiverIds[0] ? 0 : 1;
+    u32 sequence = *static_cast<u32 *>(GetMessagePayload(message));
+    DestroyMessage(message);
+
+    /* Messages to the same receiver must arrive in the order sent, also across early flushes */
+    if (sequence != s_expected[receiver]) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Receiver %d got message %d (expected: %d)", receiver, sequence, s_expected[receiver]);
+        return;
+    }
+    s_expected[receiver] += RECEIVERS;
+
+    if (s_expected[receiver] >= s_messages) {
+
+        TMessage done = CreateMessage(DONE_MESSAGE_ID, 0);
+        if (done == MESSAGE_INVALID) {
+
+            TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create the done message");
+            return;
+        }
+        SendMessage(done, s_senderId);
+    }
+}
+
+static void SendSequence(void) {
+
+    /* Interleave the receivers so that every flush routes to more than one destination */
+    for (u32 i = 0; i < s_messages; i++) {
+
+        TMessage message = CreateMessage(SEQUENCE_MESSAGE_ID, sizeof(u32));
+        if (message == MESSAGE_INVALID) {
+
+            /* The receivers cannot finish, let the test time out */
+            TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create message %d", i);
+            return;
+        }
+        *static_cast<u32 *>(GetMessagePayload(message)) = i;
+        SendMessage(message, s_receiverIds[i % RECEIVERS]);
+    }
+}
@@ -0,0 +1,301 @@
+#include "traffic_shedding.hh"
+#include <menabrea/test/params_parser.hh>
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+#include <menabrea/overload.h>
+#include <menabrea/timing.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+#include <chrono>
+
+static constexpr const TMessageId START_MESSAGE_ID = 0x3210;
+static constexpr const TMessageId LOAD_MESSAGE_ID = 0x3211;
+static constexpr const TMessageId CHECK_MESSAGE_ID = 0x3212;
+static constexpr const TMessageId DATA_MESSAGE_ID = 0x3213;
+static constexpr const TMessageId DONE_MESSAGE_ID = 0x3214;
+/* Poll the load level every millisecond for at most a second */
+static constexpr const u64 CHECK_PERIOD = 1000;
+static constexpr const u32 MAX_CHECKS = 1000;
+struct TestTrafficSheddingParams {
+    u32 Backlog;
+    u32 Spin;
+    u32 Messages;
+};
+
+/* All workers but the sink run on the shared core, so their state can be kept in static variables -
+ * the sink gets its spin time in the messages instead */
+static TWorkerId s_coordinatorId = WORKER_ID_INVALID;
+static TWorkerId s_sinkId = WORKER_ID_INVALID;
+static TWorkerId s_sheddableId = WORKER_ID_INVALID;
+static TWorkerId s_essentialId = WORKER_ID_INVALID;
+static TTimerId s_timerId = TIMER_ID_INVALID;
+static TestTrafficSheddingParams s_params;
+static u32 s_checks = 0;
+static bool s_checking = false;
+static u32 s_essentialReceived = 0;
+
+static void CoordinatorBody(TMessage message);
+static void SinkBody(TMessage message);
+static void SheddableBody(TMessage message);
+static void EssentialBody(TMessage message);
+static void LoadNode(void);
+static void CheckLoadLevel(void);
+static void CheckShedding(void);
+static void SendData(TWorkerId receiver, u32 count, u32 spin);
+
+u32 TestTrafficShedding::GetParamsSize(void) {
+
+    return sizeof(TestTrafficSheddingParams);
+}
+
+int TestTrafficShedding::ParseParams(char * paramsIn, void * paramsOut) {
+
+    ParamsParser::StructLayout paramsLayout;
+    paramsLayout["backlog"] = ParamsParser::StructField(offsetof(TestTrafficSheddingParams, Backlog), sizeof(u32), ParamsParser::FieldType::U32);
+    paramsLayout["spin"] = ParamsParser::StructField(offsetof(TestTrafficSheddingParams, Spin), sizeof(u32), ParamsParser::FieldType::U32);
+    paramsLayout["messages"] = ParamsParser::StructField(offsetof(TestTrafficSheddingParams, Messages), sizeof(u32), ParamsParser::FieldType::U32);
+
+    if (ParamsParser::Parse(paramsIn, paramsOut, std::move(paramsLayout))) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to parse the parameters for test '%s'", this->GetName());
+        return -1;
+    }
+
+    TestTrafficSheddingParams * parsed = static_cast<TestTrafficSheddingParams *>(paramsOut);
+    if (parsed->Backlog == 0 || parsed->Spin == 0 || parsed->Messages == 0) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s: Backlog, spin time and number of messages must be positive", \
+            this->GetName());
+        return -1;
+    }
+
+    return 0;
+}
+
+int TestTrafficShedding::StartTest(void * args) {
+
+    s_params = *static_cast<TestTrafficSheddingParams *>(args);
+    s_checks = 0;
+    s_checking = false;
+    s_essentialReceived = 0;
+
+    TCoreMask isolatedCores = GetIsolatedCoresMask();
+    if (CoreMaskIsEmpty(isolatedCores)) {
+
+        /* A busy shared core would also stall the overload manager */
+        LogPrint(ELogSeverityLevel_Error, "No isolated core to load");
+        return -1;
+    }
+
+    s_coordinatorId = DeploySimpleWorker("SheddingCoordinator", WORKER_ID_INVALID, GetSharedCoreMask(), CoordinatorBody);
+    if (s_coordinatorId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the coordinator");
+        return -1;
+    }
+
+    s_sinkId = DeploySimpleWorker("SheddingSink", WORKER_ID_INVALID, CoreMaskOf(CoreMaskFirst(isolatedCores)), SinkBody);
+    if (s_sinkId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the sink");
+        return -1;
+    }
+
+    SWorkerConfig config = {
+        .Name = "SheddableWorker",
+        .WorkerId = WORKER_ID_INVALID,
+        .CoreMask = GetSharedCoreMask(),
+        .Parallel = false,
+        .SheddingLevel = EOverloadLevel_Elevated,
+        .WorkerBody = SheddableBody
+    };
+    s_sheddableId = DeployWorker(&config);
+    if (s_sheddableId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the sheddable worker");
+        return -1;
+    }
+
+    /* Never shed traffic to this one */
+    s_essentialId = DeploySimpleWorker("EssentialWorker", WORKER_ID_INVALID, GetSharedCoreMask(), EssentialBody);
+    if (s_essentialId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the essential worker");
+        return -1;
+    }
+
+    s_timerId = CreateTimer("SheddingTimer");
+    if (s_timerId == TIMER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to create the timer");
+        return -1;
+    }
+
+    TMessage message = CreateMessage(START_MESSAGE_ID, 0);
+    if (message == MESSAGE_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to create the start message");
+        return -1;
+    }
+    SendMessage(message, s_coordinatorId);
+
+    return 0;
+}
+
+void TestTrafficShedding::StopTest(void) {
+
+    if (s_timerId != TIMER_ID_INVALID) {
+
+        (void) DisarmTimer(s_timerId);
+        DestroyTimer(s_timerId);
+        s_timerId = TIMER_ID_INVALID;
+    }
+
+    /* Any backlog left at the sink is dropped along with it */
+    TWorkerId * workerIds[] = { &s_coordinatorId, &s_sinkId, &s_sheddableId, &s_essentialId };
+    for (TWorkerId * workerId : workerIds) {
+
+        if (*workerId != WORKER_ID_INVALID) {
+
+            TerminateWorker(*workerId);
+            *workerId = WORKER_ID_INVALID;
+        }
+    }
+}
+
+static void CoordinatorBody(TMessage message) {
+
+    TMessageId messageId = GetMessageId(message);
+    DestroyMessage(message);
+
+    switch (messageId) {
+    case START_MESSAGE_ID:
+        LoadNode();
+        break;
+
+    case CHECK_MESSAGE_ID:
+        CheckLoadLevel();
+        break;
+
+    case DONE_MESSAGE_ID:
+        TestCase::ReportTestResult(TestCase::Result::Success);
+        break;
+
+    default:
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Unexpected message 0x%x", messageId);
+        break;
+    }
+}
+
+static void SinkBody(TMessage message) {
+
+    u32 spin = *static_cast<u32 *>(GetMessagePayload(message));
+    DestroyMessage(message);
+
+    /* Keep the core busy so that both the utilisation and the backlog build up */
+    auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start < std::chrono::microseconds(spin)) {
+
+        ;
+    }
+}
+
+static void SheddableBody(TMessage message) {
+
+    /* Should never get here - report at the coordinator */
+    DestroyMessage(message);
+    TestCase::ReportTestResult(TestCase::Result::Failure, \
+        "Sheddable worker received a message at load level %d", GetOverloadLevel());
+}
+
+static void EssentialBody(TMessage message) {
+
+    DestroyMessage(message);
+
+    if (++s_essentialReceived == s_params.Messages) {
+
+        SendMessage(CreateMessage(DONE_MESSAGE_ID, 0), s_coordinatorId);
+    }
+}
+
+static void LoadNode(void) {
+
+    SendData(s_sinkId, s_params.Backlog, s_params.Spin);
+
+    TMessage message = CreateMessage(CHECK_MESSAGE_ID, 0);
+    if (message == MESSAGE_INVALID) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create the check message");
+        return;
+    }
+
+    s_checking = true;
+    if (s_timerId != ArmTimer(s_timerId, CHECK_PERIOD, CHECK_PERIOD, message, s_coordinatorId)) {
+
+        DestroyMessage(message);
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to arm the timer");
+    }
+}
+
+static void CheckLoadLevel(void) {
+
+    if (!s_checking) {
+
+        /* Tick already in flight when the timer got disarmed */
+        return;
+    }
+
+    if (GetOverloadLevel() >= EOverloadLevel_Elevated) {
+
+        s_checking = false;
+        (void) DisarmTimer(s_timerId);
+        CheckShedding();
+        return;
+    }
+
+    if (++s_checks == MAX_CHECKS) {
+
+        s_checking = false;
+        (void) DisarmTimer(s_timerId);
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Load level did not rise with %d message(s) queued up - is the overload manager enabled?", \
+            s_params.Backlog);
+    }
+}
+
+static void CheckShedding(void) {
+
+    /* The level only drops after a cooldown, well after the sends below */
+    SendData(s_sheddableId, s_params.Messages, 0);
+    SendData(s_essentialId, s_params.Messages, 0);
+
+    /* Messages are shed in the send call */
+    SWorkerStatistics statistics;
+    if (0 != GetWorkerStatistics(s_sheddableId, &statistics)) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to get statistics of the sheddable worker");
+        return;
+    }
+
+    if (statistics.MessagesShed != s_params.Messages) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Shed %lu message(s) to the sheddable worker (expected: %d)", statistics.MessagesShed, s_params.Messages);
+    }
+    /* Otherwise wait for all the messages to reach the essential worker */
+}
+
+static void SendData(TWorkerId receiver, u32 count, u32 spin) {
+
+    for (u32 i = 0; i < count; i++) {
+
+        TMessage message = CreateMessage(DATA_MESSAGE_ID, sizeof(u32));
+        if (message == MESSAGE_INVALID) {
+
+            TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create data message %d", i);
+            return;
+        }
+        *static_cast<u32 *>(GetMessagePayload(message)) = spin;
+        SendMessage(message, receiver);
+    }
+}
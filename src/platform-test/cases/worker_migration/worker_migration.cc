@@ -0,0 +1,168 @@
+#include "worker_migration.hh"
+#include <menabrea/test/params_parser.hh>
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+#include <menabrea/memory.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+
+static constexpr const TMessageId TEST_MESSAGE_ID = 0x3161;
+struct TestWorkerMigrationParams {
+    u32 Messages;
+};
+
+/* The worker changes cores, i.e. processes, midway - keep its state in shared memory */
+struct TestWorkerData {
+    TCoreMask TargetMask;
+    u32 Messages;
+    u32 Received;
+};
+
+static TWorkerId s_workerId = WORKER_ID_INVALID;
+
+static int WorkerInit(void * arg);
+static void WorkerExit(void);
+static void WorkerBody(TMessage message);
+static int SendSequenceNumber(TWorkerId workerId, u32 sequenceNumber);
+
+u32 TestWorkerMigration::GetParamsSize(void) {
+
+    return sizeof(TestWorkerMigrationParams);
+}
+
+int TestWorkerMigration::ParseParams(char * paramsIn, void * paramsOut) {
+
+    ParamsParser::StructLayout paramsLayout;
+    paramsLayout["messages"] = ParamsParser::StructField(offsetof(TestWorkerMigrationParams, Messages), sizeof(u32), ParamsParser::FieldType::U32);
+
+    return ParamsParser::Parse(paramsIn, paramsOut, std::move(paramsLayout));
+}
+
+int TestWorkerMigration::StartTest(void * args) {
+
+    TestWorkerMigrationParams * params = static_cast<TestWorkerMigrationParams *>(args);
+    if (params->Messages < 2) {
+
+        LogPrint(ELogSeverityLevel_Error, "At least two messages are needed to migrate the worker midway");
+        return -1;
+    }
+
+    TestWorkerData * workerData = static_cast<TestWorkerData *>(GetRuntimeMemory(sizeof(TestWorkerData)));
+    if (workerData == nullptr) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to allocate the shared memory for test '%s'", \
+            this->GetName());
+        return -1;
+    }
+
+    /* Start on the shared core and move to an isolated one if there is any - otherwise
+     * the migration is a no-op and only the order of the messages is verified */
+    TCoreMask isolatedCores = GetIsolatedCoresMask();
+    workerData->TargetMask = CoreMaskIsEmpty(isolatedCores) ? GetSharedCoreMask() : CoreMaskOf(CoreMaskFirst(isolatedCores));
+    workerData->Messages = params->Messages;
+    workerData->Received = 0;
+
+    SWorkerConfig workerConfig = {
+        .Name = "MigratingWorker",
+        .InitArg = workerData,
+        .WorkerId = WORKER_ID_INVALID,
+        .CoreMask = GetSharedCoreMask(),
+        .Parallel = false,
+        .UserInit = WorkerInit,
+        .UserExit = WorkerExit,
+        .WorkerBody = WorkerBody
+    };
+    s_workerId = DeployWorker(&workerConfig);
+    if (s_workerId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the test worker");
+        PutRuntimeMemory(workerData);
+        return -1;
+    }
+
+    /* Kick off the test - the worker sends the rest of the messages to itself */
+    return SendSequenceNumber(s_workerId, 0);
+}
+
+void TestWorkerMigration::StopTest(void) {
+
+    /* The worker may be running elsewhere by now, so it never terminates itself - always
+     * terminate it here (termination is deferred if the migration is still in progress) */
+    TerminateWorker(s_workerId);
+    s_workerId = WORKER_ID_INVALID;
+}
+
+static int WorkerInit(void * arg) {
+
+    SetSharedData(arg);
+    return 0;
+}
+
+static void WorkerExit(void) {
+
+    PutRuntimeMemory(GetSharedData());
+}
+
+static void WorkerBody(TMessage message) {
+
+    TestWorkerData * workerData = static_cast<TestWorkerData *>(GetSharedData());
+    u32 sequenceNumber = *static_cast<u32 *>(GetMessagePayload(message));
+    DestroyMessage(message);
+    if (sequenceNumber != workerData->Received) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Received sequence number %d (expected: %d)", sequenceNumber, workerData->Received);
+        return;
+    }
+    workerData->Received++;
+
+    if (sequenceNumber == 0) {
+
+        /* Queue up the remaining messages and move the worker midway so that some are still in
+         * the old queue and some are sent while the migration is in progress */
+        for (u32 i = 1; i < workerData->Messages; i++) {
+
+            if (i == workerData->Messages / 2 && 0 != SetWorkerCoreMask(GetOwnWorkerId(), workerData->TargetMask)) {
+
+                TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to migrate the worker");
+                return;
+            }
+
+            if (0 != SendSequenceNumber(GetOwnWorkerId(), i)) {
+
+                TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to send message %d", i);
+                return;
+            }
+        }
+
+    } else if (workerData->Received == workerData->Messages) {
+
+        /* The last message was sent after the migration had started, so it must have been
+         * received on the new core */
+        int core = GetCurrentCore();
+        if (!CoreMaskContains(workerData->TargetMask, core)) {
+
+            TestCase::ReportTestResult(TestCase::Result::Failure, \
+                "Received the last message on core %d after the migration", core);
+
+        } else {
+
+            LogPrint(ELogSeverityLevel_Info, "Received %d messages in order, last one on core %d", \
+                workerData->Received, core);
+            TestCase::ReportTestResult(TestCase::Result::Success);
+        }
+    }
+}
+
+static int SendSequenceNumber(TWorkerId workerId, u32 sequenceNumber) {
+
+    TMessage message = CreateMessage(TEST_MESSAGE_ID, sizeof(u32));
+    if (message == MESSAGE_INVALID) {
+
+        return -1;
+    }
+
+    *static_cast<u32 *>(GetMessagePayload(message)) = sequenceNumber;
+    SendMessage(message, workerId);
+    return 0;
+}
@@ -0,0 +1,235 @@
+#include "worker_pools.hh"
+#include <menabrea/test/params_parser.hh>
+#include <menabrea/pools.h>
+#include <menabrea/messaging.h>
+#include <menabrea/memory.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+
+static constexpr const TMessageId TEST_MESSAGE_ID = 0x9001;
+/* Only one message per key is in flight at a time - keep the total within the buffer of a deploying shard */
+static constexpr const u32 MAX_KEYS = 16;
+struct TestWorkerPoolsParams {
+    u32 Shards;
+    u32 Keys;
+    u32 Rounds;
+};
+
+struct TestMessagePayload {
+    u32 Key;
+    u32 Round;
+};
+
+/* Shared between the shards running on different cores */
+struct TestSharedData {
+    TWorkerPoolId PoolId;
+    u32 Shards;
+    u32 Keys;
+    u32 Rounds;
+    TAtomic32 References;
+    TAtomic32 KeysRemaining;
+    TAtomic32 Owners[MAX_KEYS];
+    bool Resized;
+};
+
+static TestSharedData * s_sharedData = nullptr;
+
+static int ShardInit(void * arg);
+static void ShardExit(void);
+static void ShardBody(TMessage message);
+static int SendRound(TestSharedData * sharedData, u32 key, u32 round);
+static void ReleaseSharedData(TestSharedData * sharedData);
+
+u32 TestWorkerPools::GetParamsSize(void) {
+
+    return sizeof(TestWorkerPoolsParams);
+}
+
+int TestWorkerPools::ParseParams(char * paramsIn, void * paramsOut) {
+
+    ParamsParser::StructLayout paramsLayout;
+    paramsLayout["shards"] = ParamsParser::StructField(offsetof(TestWorkerPoolsParams, Shards), sizeof(u32), ParamsParser::FieldType::U32);
+    paramsLayout["keys"] = ParamsParser::StructField(offsetof(TestWorkerPoolsParams, Keys), sizeof(u32), ParamsParser::FieldType::U32);
+    paramsLayout["rounds"] = ParamsParser::StructField(offsetof(TestWorkerPoolsParams, Rounds), sizeof(u32), ParamsParser::FieldType::U32);
+
+    if (ParamsParser::Parse(paramsIn, paramsOut, std::move(paramsLayout))) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to parse the parameters for test '%s'", this->GetName());
+        return -1;
+    }
+
+    TestWorkerPoolsParams * parsed = static_cast<TestWorkerPoolsParams *>(paramsOut);
+    if (parsed->Shards == 0 || parsed->Shards >= MAX_WORKER_POOL_SHARDS || parsed->Keys == 0 || parsed->Keys > MAX_KEYS || parsed->Rounds < 2) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s: Invalid parameters (shards: %d, keys: %d, rounds: %d)", \
+            this->GetName(), parsed->Shards, parsed->Keys, parsed->Rounds);
+        return -1;
+    }
+
+    return 0;
+}
+
+int TestWorkerPools::StartTest(void * args) {
+
+    TestWorkerPoolsParams * params = static_cast<TestWorkerPoolsParams *>(args);
+
+    s_sharedData = static_cast<TestSharedData *>(GetRuntimeMemory(sizeof(TestSharedData)));
+    if (s_sharedData == nullptr) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to allocate the shared memory for test '%s'", \
+            this->GetName());
+        return -1;
+    }
+
+    s_sharedData->Shards = params->Shards;
+    s_sharedData->Keys = params->Keys;
+    s_sharedData->Rounds = params->Rounds;
+    s_sharedData->Resized = false;
+    /* The test holds one reference and each shard one more */
+    Atomic32Init(&s_sharedData->References);
+    Atomic32Set(&s_sharedData->References, 1);
+    Atomic32Init(&s_sharedData->KeysRemaining);
+    Atomic32Set(&s_sharedData->KeysRemaining, params->Keys);
+    for (u32 i = 0; i < MAX_KEYS; i++) {
+
+        Atomic32Init(&s_sharedData->Owners[i]);
+        Atomic32Set(&s_sharedData->Owners[i], WORKER_ID_INVALID);
+    }
+
+    SWorkerPoolConfig poolConfig = {
+        .Shard = {
+            .Name = "TestPool",
+            .InitArg = s_sharedData,
+            .WorkerId = WORKER_ID_INVALID,
+            .CoreMask = GetAllCoresMask(),
+            .Parallel = false,
+            .UserInit = ShardInit,
+            .UserExit = ShardExit,
+            .WorkerBody = ShardBody
+        },
+        .Shards = static_cast<int>(params->Shards)
+    };
+    s_sharedData->PoolId = DeployWorkerPool(&poolConfig);
+    if (s_sharedData->PoolId == WORKER_POOL_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the worker pool");
+        ReleaseSharedData(s_sharedData);
+        s_sharedData = nullptr;
+        return -1;
+    }
+
+    /* Start one chain of messages per key - each shard forwards the next round to the pool */
+    for (u32 key = 0; key < params->Keys; key++) {
+
+        if (0 != SendRound(s_sharedData, key, 0)) {
+
+            LogPrint(ELogSeverityLevel_Error, "Failed to send the first message for key %d", key);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void TestWorkerPools::StopTest(void) {
+
+    if (s_sharedData != nullptr) {
+
+        TerminateWorkerPool(s_sharedData->PoolId);
+        ReleaseSharedData(s_sharedData);
+        s_sharedData = nullptr;
+    }
+}
+
+static int ShardInit(void * arg) {
+
+    TestSharedData * sharedData = static_cast<TestSharedData *>(arg);
+    Atomic32Inc(&sharedData->References);
+    SetSharedData(sharedData);
+    return 0;
+}
+
+static void ShardExit(void) {
+
+    ReleaseSharedData(static_cast<TestSharedData *>(GetSharedData()));
+}
+
+static void ShardBody(TMessage message) {
+
+    TestSharedData * sharedData = static_cast<TestSharedData *>(GetSharedData());
+    TestMessagePayload payload = *static_cast<TestMessagePayload *>(GetMessagePayload(message));
+    DestroyMessage(message);
+
+    /* The first shard to receive a key claims it - it may only move to the shard added on resize */
+    TWorkerId owner = GetOwnWorkerId();
+    TAtomic32 * keyOwner = &sharedData->Owners[payload.Key];
+    if (!Atomic32CmpSet(keyOwner, WORKER_ID_INVALID, owner) && Atomic32Get(keyOwner) != owner) {
+
+        TWorkerId addedShard = GetWorkerPoolShard(sharedData->PoolId, static_cast<int>(sharedData->Shards));
+        if (owner != addedShard) {
+
+            TestCase::ReportTestResult(TestCase::Result::Failure, \
+                "Key %d received by shard 0x%x, previously by 0x%x (added shard: 0x%x)", \
+                payload.Key, owner, Atomic32Get(keyOwner), addedShard);
+            return;
+        }
+        Atomic32Set(keyOwner, owner);
+    }
+
+    if (payload.Key == 0 && payload.Round == sharedData->Rounds / 2 && !sharedData->Resized) {
+
+        /* Grow the pool midway - only key 0's shard gets here, so no need for atomics */
+        sharedData->Resized = true;
+        if (0 != ResizeWorkerPool(sharedData->PoolId, static_cast<int>(sharedData->Shards) + 1)) {
+
+            TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to resize the worker pool");
+            return;
+        }
+    }
+
+    if (payload.Round + 1 < sharedData->Rounds) {
+
+        if (0 != SendRound(sharedData, payload.Key, payload.Round + 1)) {
+
+            TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to send round %d for key %d", \
+                payload.Round + 1, payload.Key);
+        }
+
+    } else if (0 == Atomic32SubReturn(&sharedData->KeysRemaining, 1)) {
+
+        /* Report the load of each shard */
+        for (int shard = 0; shard < GetWorkerPoolSize(sharedData->PoolId); shard++) {
+
+            SWorkerStatistics statistics;
+            if (0 == GetWorkerPoolStatistics(sharedData->PoolId, shard, &statistics)) {
+
+                LogPrint(ELogSeverityLevel_Info, "Shard %d received %lu message(s)", \
+                    shard, statistics.MessagesReceived);
+            }
+        }
+        TestCase::ReportTestResult(TestCase::Result::Success);
+    }
+}
+
+static int SendRound(TestSharedData * sharedData, u32 key, u32 round) {
+
+    TMessage message = CreateMessage(TEST_MESSAGE_ID, sizeof(TestMessagePayload));
+    if (message == MESSAGE_INVALID) {
+
+        return -1;
+    }
+
+    TestMessagePayload * payload = static_cast<TestMessagePayload *>(GetMessagePayload(message));
+    payload->Key = key;
+    payload->Round = round;
+    SendMessageKeyed(message, sharedData->PoolId, key);
+    return 0;
+}
+
+static void ReleaseSharedData(TestSharedData * sharedData) {
+
+    if (0 == Atomic32SubReturn(&sharedData->References, 1)) {
+
+        PutRuntimeMemory(sharedData);
+    }
+}
@@ -0,0 +1,16 @@
+
+#ifndef PLATFORM_TEST_CASES_WORKER_POOLS_WORKER_POOLS_HH
+#define PLATFORM_TEST_CASES_WORKER_POOLS_WORKER_POOLS_HH
+
+#include <menabrea/test/test_case.hh>
+
+class TestWorkerPools : public TestCase::Instance {
+public:
+    TestWorkerPools(const char * name) : TestCase::Instance(name) {}
+    virtual u32 GetParamsSize(void) override;
+    virtual int ParseParams(char * paramsIn, void * paramsOut) override;
+    virtual int StartTest(void * args) override;
+    virtual void StopTest(void) override;
+};
+
+#endif /* PLATFORM_TEST_CASES_WORKER_POOLS_WORKER_POOLS_HH */
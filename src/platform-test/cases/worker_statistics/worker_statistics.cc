@@ -0,0 +1,160 @@
+#include "worker_statistics.hh"
+#include <menabrea/test/params_parser.hh>
+#include <menabrea/log.h>
+#include <menabrea/cores.h>
+#include <menabrea/messaging.h>
+
+static constexpr const TMessageId TRIGGER_MESSAGE_ID = 0x57A7;
+static constexpr const TMessageId TEST_MESSAGE_ID = 0x57A8;
+struct TestWorkerStatisticsParams {
+    u32 Messages;
+    u32 PayloadSize;
+};
+
+static TWorkerId s_senderId = WORKER_ID_INVALID;
+static TWorkerId s_receiverId = WORKER_ID_INVALID;
+static u32 s_messages = 0;
+static u32 s_payloadSize = 0;
+
+static void SenderBody(TMessage message);
+static void ReceiverBody(TMessage message);
+static bool CheckStatistics(void);
+
+u32 TestWorkerStatistics::GetParamsSize(void) {
+
+    return sizeof(TestWorkerStatisticsParams);
+}
+
+int TestWorkerStatistics::ParseParams(char * paramsIn, void * paramsOut) {
+
+    ParamsParser::StructLayout paramsLayout;
+    paramsLayout["messages"] = ParamsParser::StructField(offsetof(TestWorkerStatisticsParams, Messages), sizeof(u32), ParamsParser::FieldType::U32);
+    paramsLayout["payloadSize"] = ParamsParser::StructField(offsetof(TestWorkerStatisticsParams, PayloadSize), sizeof(u32), ParamsParser::FieldType::U32);
+
+    return ParamsParser::Parse(paramsIn, paramsOut, std::move(paramsLayout));
+}
+
+int TestWorkerStatistics::StartTest(void * args) {
+
+    TestWorkerStatisticsParams * params = static_cast<TestWorkerStatisticsParams *>(args);
+    s_messages = params->Messages;
+    s_payloadSize = params->PayloadSize;
+
+    if (s_messages == 0) {
+
+        LogPrint(ELogSeverityLevel_Error, "Number of messages must be positive");
+        return -1;
+    }
+
+    /* Deploy both workers on the shared core so that the sender's body completes
+     * (and its statistics are updated) before the receiver runs */
+    s_receiverId = DeploySimpleWorker("StatisticsReceiver", WORKER_ID_INVALID, GetSharedCoreMask(), ReceiverBody);
+    if (s_receiverId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the receiver");
+        return -1;
+    }
+
+    s_senderId = DeploySimpleWorker("StatisticsSender", WORKER_ID_INVALID, GetSharedCoreMask(), SenderBody);
+    if (s_senderId == WORKER_ID_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to deploy the sender");
+        return -1;
+    }
+
+    TMessage trigger = CreateMessage(TRIGGER_MESSAGE_ID, 0);
+    if (trigger == MESSAGE_INVALID) {
+
+        LogPrint(ELogSeverityLevel_Error, "Failed to create the trigger message");
+        return -1;
+    }
+
+    SendMessage(trigger, s_senderId);
+    return 0;
+}
+
+void TestWorkerStatistics::StopTest(void) {
+
+    if (s_senderId != WORKER_ID_INVALID) {
+
+        TerminateWorker(s_senderId);
+        s_senderId = WORKER_ID_INVALID;
+    }
+
+    if (s_receiverId != WORKER_ID_INVALID) {
+
+        TerminateWorker(s_receiverId);
+        s_receiverId = WORKER_ID_INVALID;
+    }
+}
+
+static void SenderBody(TMessage message) {
+
+    DestroyMessage(message);
+
+    for (u32 i = 0; i < s_messages; i++) {
+
+        TMessage testMessage = CreateMessage(TEST_MESSAGE_ID, s_payloadSize);
+        if (testMessage == MESSAGE_INVALID) {
+
+            TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to create test message %d", i);
+            return;
+        }
+        SendMessage(testMessage, s_receiverId);
+    }
+}
+
+static void ReceiverBody(TMessage message) {
+
+    static u32 received = 0;
+
+    DestroyMessage(message);
+    if (++received < s_messages) {
+
+        return;
+    }
+
+    received = 0;
+    DumpWorkerStatistics();
+    if (CheckStatistics()) {
+
+        TestCase::ReportTestResult(TestCase::Result::Success);
+    }
+}
+
+static bool CheckStatistics(void) {
+
+    SWorkerStatistics sender;
+    SWorkerStatistics receiver;
+    if (0 != GetWorkerStatistics(s_senderId, &sender) || 0 != GetWorkerStatistics(s_receiverId, &receiver)) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Failed to read the worker statistics");
+        return false;
+    }
+
+    u64 bytes = static_cast<u64>(s_messages) * s_payloadSize;
+    if (sender.MessagesReceived != 1 || sender.HandlerInvocations != 1 || sender.MessagesSent != s_messages || sender.BytesSent != bytes) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Unexpected sender statistics - received: %lu, calls: %lu, sent: %lu (%lu B)", \
+            sender.MessagesReceived, sender.HandlerInvocations, sender.MessagesSent, sender.BytesSent);
+        return false;
+    }
+
+    /* The current call to the receiver body is not accounted for yet */
+    if (receiver.MessagesReceived != s_messages || receiver.BytesReceived != bytes || receiver.HandlerInvocations != s_messages - 1 || receiver.MessagesSent != 0) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, \
+            "Unexpected receiver statistics - received: %lu (%lu B), calls: %lu, sent: %lu", \
+            receiver.MessagesReceived, receiver.BytesReceived, receiver.HandlerInvocations, receiver.MessagesSent);
+        return false;
+    }
+
+    if (sender.MaxHandlerTimeNs > sender.HandlerTimeNs || receiver.MaxHandlerTimeNs > receiver.HandlerTimeNs) {
+
+        TestCase::ReportTestResult(TestCase::Result::Failure, "Inconsistent handler times");
+        return false;
+    }
+
+    return true;
+}
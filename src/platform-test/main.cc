@@ -1,22 +1,60 @@
 #include <cases/basic_timing/basic_timing.hh>
 #include <cases/basic_workers/basic_workers.hh>
+#include <cases/batch_deployment/batch_deployment.hh>
+#include <cases/batch_reception/batch_reception.hh>
+#include <cases/capture_replay/capture_replay.hh>
+#include <cases/continuations/continuations.hh>
+#include <cases/dataflow_graphs/dataflow_graphs.hh>
+#include <cases/dispatch_performance/dispatch_performance.hh>
+#include <cases/dynamic_ids/dynamic_ids.hh>
+#include <cases/handler_watchdog/handler_watchdog.hh>
+#include <cases/inline_delivery/inline_delivery.hh>
+#include <cases/message_attachments/message_attachments.hh>
 #include <cases/message_buffering/message_buffering.hh>
+#include <cases/message_deadlines/message_deadlines.hh>
+#include <cases/message_groups/message_groups.hh>
 #include <cases/messaging_performance/messaging_performance.hh>
 #include <cases/oneshot_timer/oneshot_timer.hh>
 #include <cases/parallelism/parallelism.hh>
+#include <cases/peer_learning/peer_learning.hh>
 #include <cases/periodic_timer/periodic_timer.hh>
+#include <cases/rate_limiting/rate_limiting.hh>
+#include <cases/send_coalescing/send_coalescing.hh>
 #include <cases/shared_memory/shared_memory.hh>
+#include <cases/traffic_shedding/traffic_shedding.hh>
+#include <cases/worker_migration/worker_migration.hh>
+#include <cases/worker_pools/worker_pools.hh>
+#include <cases/worker_statistics/worker_statistics.hh>
 
 APPLICATION_GLOBAL_INIT() {
 
     TestCase::Register(new TestBasicTiming("TestBasicTiming"));
     TestCase::Register(new TestBasicWorkers("TestBasicWorkers"));
+    TestCase::Register(new TestBatchDeployment("TestBatchDeployment"));
+    TestCase::Register(new TestBatchReception("TestBatchReception"));
+    TestCase::Register(new TestCaptureReplay("TestCaptureReplay"));
+    TestCase::Register(new TestContinuations("TestContinuations"));
+    TestCase::Register(new TestDataflowGraphs("TestDataflowGraphs"));
+    TestCase::Register(new TestDispatchPerformance("TestDispatchPerformance"));
+    TestCase::Register(new TestDynamicIds("TestDynamicIds"));
+    TestCase::Register(new TestHandlerWatchdog("TestHandlerWatchdog"));
+    TestCase::Register(new TestInlineDelivery("TestInlineDelivery"));
+    TestCase::Register(new TestMessageAttachments("TestMessageAttachments"));
     TestCase::Register(new TestMessageBuffering("TestMessageBuffering"));
+    TestCase::Register(new TestMessageDeadlines("TestMessageDeadlines"));
+    TestCase::Register(new TestMessageGroups("TestMessageGroups"));
     TestCase::Register(new TestMessagingPerformance("TestMessagingPerformance"));
     TestCase::Register(new TestOneshotTimer("TestOneshotTimer"));
     TestCase::Register(new TestParallelism("TestParallelism"));
+    TestCase::Register(new TestPeerLearning("TestPeerLearning"));
     TestCase::Register(new TestPeriodicTimer("TestPeriodicTimer"));
+    TestCase::Register(new TestRateLimiting("TestRateLimiting"));
+    TestCase::Register(new TestSendCoalescing("TestSendCoalescing"));
     TestCase::Register(new TestSharedMemory("TestSharedMemory"));
+    TestCase::Register(new TestTrafficShedding("TestTrafficShedding"));
+    TestCase::Register(new TestWorkerMigration("TestWorkerMigration"));
+    TestCase::Register(new TestWorkerPools("TestWorkerPools"));
+    TestCase::Register(new TestWorkerStatistics("TestWorkerStatistics"));
 }
 
 APPLICATION_LOCAL_INIT(core) {
@@ -35,10 +73,29 @@ APPLICATION_GLOBAL_EXIT() {
 
     delete TestCase::Deregister("TestBasicTiming");
     delete TestCase::Deregister("TestBasicWorkers");
+    delete TestCase::Deregister("TestBatchDeployment");
+    delete TestCase::Deregister("TestBatchReception");
+    delete TestCase::Deregister("TestCaptureReplay");
+    delete TestCase::Deregister("TestContinuations");
+    delete TestCase::Deregister("TestDataflowGraphs");
+    delete TestCase::Deregister("TestDispatchPerformance");
+    delete TestCase::Deregister("TestDynamicIds");
+    delete TestCase::Deregister("TestHandlerWatchdog");
+    delete TestCase::Deregister("TestInlineDelivery");
+    delete TestCase::Deregister("TestMessageAttachments");
     delete TestCase::Deregister("TestMessagingPerformance");
     delete TestCase::Deregister("TestMessageBuffering");
+    delete TestCase::Deregister("TestMessageDeadlines");
+    delete TestCase::Deregister("TestMessageGroups");
     delete TestCase::Deregister("TestOneshotTimer");
     delete TestCase::Deregister("TestParallelism");
+    delete TestCase::Deregister("TestPeerLearning");
     delete TestCase::Deregister("TestPeriodicTimer");
+    delete TestCase::Deregister("TestRateLimiting");
+    delete TestCase::Deregister("TestSendCoalescing");
     delete TestCase::Deregister("TestSharedMemory");
+    delete TestCase::Deregister("TestTrafficShedding");
+    delete TestCase::Deregister("TestWorkerMigration");
+    delete TestCase::Deregister("TestWorkerPools");
+    delete TestCase::Deregister("TestWorkerStatistics");
 }
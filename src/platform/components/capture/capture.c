@@ -0,0 +1,197 @@
+#include <capture/capture.h>
+#include <capture/format.h>
+#include <menabrea/capture.h>
+#include <messaging/message.h>
+#include <workers/worker_table.h>
+#include <menabrea/input.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+#include <menabrea/exception.h>
+#include <odp_api.h>
+#include <linux/limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CAPTURE_BUFFER_SIZE      (1024 * 1024)
+#define CAPTURE_FLUSH_THRESHOLD  (CAPTURE_BUFFER_SIZE / 2)
+#define MAX_CAPTURED_WORKERS     16
+
+static void CaptureFlushPoll(void * arg);
+static void FlushCaptureBuffer(void);
+
+/* Configuration set in global init and inherited by all dispatchers */
+static bool s_captureEnabled = false;
+static char s_capturePath[PATH_MAX];
+static TWorkerId s_nodeId = WORKER_ID_INVALID;
+static char s_capturedWorkers[MAX_CAPTURED_WORKERS][MAX_WORKER_NAME_LEN];
+static int s_capturedWorkersCount = 0;
+
+/* State private to each core */
+static int s_captureFd = -1;
+static u8 * s_captureBuffer = NULL;
+static u32 s_bufferedBytes = 0;
+static u64 s_capturedMessages = 0;
+static u64 s_droppedRecords = 0;
+
+void CaptureRecordingInit(const char * path, const char * workers, TWorkerId nodeId) {
+
+    (void) strncpy(s_capturePath, path, sizeof(s_capturePath) - 1);
+    s_capturePath[sizeof(s_capturePath) - 1] = '\0';
+    s_nodeId = nodeId;
+
+    /* Make a copy of the workers list on the heap to safely tokenize */
+    char * copy = strdup(workers);
+    AssertTrue(copy != NULL);
+    char * saveptr = NULL;
+    for (char * token = strtok_r(copy, ",", &saveptr); token != NULL; token = strtok_r(NULL, ",", &saveptr)) {
+
+        if (s_capturedWorkersCount == MAX_CAPTURED_WORKERS) {
+
+            LogPrint(ELogSeverityLevel_Warning, "%s(): Cannot capture worker '%s'. Upper limit of %d workers reached", \
+                __FUNCTION__, token, MAX_CAPTURED_WORKERS);
+            continue;
+        }
+
+        /* Copy the name and ensure proper NULL-termination (see strncpy manpage) */
+        (void) strncpy(s_capturedWorkers[s_capturedWorkersCount], token, MAX_WORKER_NAME_LEN - 1);
+        s_capturedWorkers[s_capturedWorkersCount][MAX_WORKER_NAME_LEN - 1] = '\0';
+        s_capturedWorkersCount++;
+    }
+    free(copy);
+
+    LogPrint(ELogSeverityLevel_Info, "Capturing messages delivered to %d worker(s) into %s.<core>...", \
+        s_capturedWorkersCount, s_capturePath);
+    s_captureEnabled = true;
+
+    /* Write the buffers out from the input poll, i.e. never from within a worker body */
+    RegisterInputPolling(CaptureFlushPoll, NULL, GetAllCoresMask());
+}
+
+void CaptureRecordingLocalInit(void) {
+
+    if (!s_captureEnabled) {
+
+        return;
+    }
+
+    int core = em_core_id();
+    char path[PATH_MAX + 16];
+    (void) snprintf(path, sizeof(path), "%s.%d", s_capturePath, core);
+    s_captureFd = open(path, O_WRONLY | O_TRUNC | O_CREAT, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (unlikely(s_captureFd == -1)) {
+
+        /* Leave the buffer unallocated - all records on this core will be dropped */
+        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to open capture file %s: %s (%d)", \
+            __FUNCTION__, path, strerror(errno), errno);
+        return;
+    }
+
+    s_captureBuffer = malloc(CAPTURE_BUFFER_SIZE);
+    AssertTrue(s_captureBuffer != NULL);
+
+    SCaptureFileHeader * fileHeader = (SCaptureFileHeader *) s_captureBuffer;
+    fileHeader->Magic = CAPTURE_FILE_MAGIC;
+    fileHeader->Version = CAPTURE_FILE_VERSION;
+    fileHeader->NodeId = s_nodeId;
+    fileHeader->Core = core;
+    fileHeader->Reserved = 0;
+    s_bufferedBytes = sizeof(SCaptureFileHeader);
+}
+
+void CaptureRecordingLocalExit(void) {
+
+    if (s_captureBuffer == NULL) {
+
+        return;
+    }
+
+    FlushCaptureBuffer();
+    AssertTrue(0 == close(s_captureFd));
+    s_captureFd = -1;
+    free(s_captureBuffer);
+    s_captureBuffer = NULL;
+
+    LogPrint(ELogSeverityLevel_Info, "Captured %lu message(s) on core %d (%lu dropped due to a full buffer)", \
+        s_capturedMessages, em_core_id(), s_droppedRecords);
+}
+
+void FlushCapture(void) {
+
+    if (s_captureBuffer != NULL) {
+
+        FlushCaptureBuffer();
+    }
+}
+
+bool IsWorkerCaptured(const char * name) {
+
+    for (int i = 0; i < s_capturedWorkersCount; i++) {
+
+        if (0 == strcmp(name, s_capturedWorkers[i])) {
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void CaptureMessage(TMessage message) {
+
+    SMessage * msgData = GetMessageData(message);
+    u32 length = MESSAGE_HEADER_LEN + msgData->Header.PayloadSize;
+    u32 recordSize = CAPTURE_RECORD_SIZE(length);
+
+    if (unlikely(s_captureBuffer == NULL || s_bufferedBytes + recordSize > CAPTURE_BUFFER_SIZE)) {
+
+        /* Never write to the file here, drop the record instead */
+        s_droppedRecords++;
+        return;
+    }
+
+    SCaptureRecordHeader * record = (SCaptureRecordHeader *) (s_captureBuffer + s_bufferedBytes);
+    record->Timestamp = odp_time_to_ns(odp_time_global());
+    record->Length = length;
+    record->Reserved = 0;
+    (void) memcpy(record + 1, msgData, length);
+    s_bufferedBytes += recordSize;
+    s_capturedMessages++;
+}
+
+static void CaptureFlushPoll(void * arg) {
+
+    (void) arg;
+
+    /* Batch the writes to limit the number of system calls */
+    if (s_bufferedBytes >= CAPTURE_FLUSH_THRESHOLD) {
+
+        FlushCaptureBuffer();
+    }
+}
+
+static void FlushCaptureBuffer(void) {
+
+    u32 written = 0;
+    while (written < s_bufferedBytes) {
+
+        ssize_t ret = write(s_captureFd, s_captureBuffer + written, s_bufferedBytes - written);
+        if (unlikely(ret < 0)) {
+
+            if (errno == EINTR) {
+
+                continue;
+            }
+
+            LogPrint(ELogSeverityLevel_Error, "%s(): Failed to write %d bytes of capture data: %s (%d)", \
+                __FUNCTION__, s_bufferedBytes - written, strerror(errno), errno);
+            break;
+        }
+        written += ret;
+    }
+
+    s_bufferedBytes = 0;
+}
@@ -0,0 +1,25 @@
+
+#ifndef PLATFORM_COMPONENTS_CAPTURE_CAPTURE_H
+#define PLATFORM_COMPONENTS_CAPTURE_CAPTURE_H
+
+#include <menabrea/messaging.h>
+
+void CaptureRecordingInit(const char * path, const char * workers, TWorkerId nodeId);
+void CaptureRecordingLocalInit(void);
+void CaptureRecordingLocalExit(void);
+
+/**
+ * @brief Check if messages delivered to a worker should be captured
+ * @param name Worker name
+ * @return True if the worker was selected for capture, false otherwise
+ */
+bool IsWorkerCaptured(const char * name);
+
+/**
+ * @brief Record a message in the current core's capture buffer
+ * @param message Message being delivered
+ * @note The buffer is written out to the file from the input poll, never in this call
+ */
+void CaptureMessage(TMessage message);
+
+#endif /* PLATFORM_COMPONENTS_CAPTURE_CAPTURE_H */
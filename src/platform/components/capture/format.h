@@ -0,0 +1,37 @@
+
+#ifndef PLATFORM_COMPONENTS_CAPTURE_FORMAT_H
+#define PLATFORM_COMPONENTS_CAPTURE_FORMAT_H
+
+#include <menabrea/common.h>
+
+#define CAPTURE_FILE_MAGIC          ( (u32) 0x4D434150 )  /* "PACM" in a little-endian dump */
+#define CAPTURE_FILE_VERSION        ( (u16) 1 )
+#define CAPTURE_FILE_HEADER_LEN     16
+#define CAPTURE_RECORD_HEADER_LEN   16
+#define CAPTURE_RECORD_ALIGNMENT    8
+#define CAPTURE_RECORD_SIZE(len)    ( (CAPTURE_RECORD_HEADER_LEN + (len) + CAPTURE_RECORD_ALIGNMENT - 1) & ~(CAPTURE_RECORD_ALIGNMENT - 1) )
+
+/* Capture files are written one per core, at <path>.<core>, and consist of a file header
+ * followed by records, each holding a timestamp and a complete message (header and payload).
+ * Each record is padded to a multiple of CAPTURE_RECORD_ALIGNMENT bytes. */
+
+typedef struct SCaptureFileHeader {
+    u32 Magic;
+    u16 Version;
+    u16 NodeId;
+    u32 Core;
+    u32 Reserved;
+} SCaptureFileHeader;
+
+typedef struct SCaptureRecordHeader {
+    u64 Timestamp;  /* Global ODP time in nanoseconds at delivery to the worker */
+    u32 Length;     /* Length of the message data that follows */
+    u32 Reserved;
+} SCaptureRecordHeader;
+
+ODP_STATIC_ASSERT(sizeof(SCaptureFileHeader) == CAPTURE_FILE_HEADER_LEN, \
+    "Capture file header size inconsistent");
+ODP_STATIC_ASSERT(sizeof(SCaptureRecordHeader) == CAPTURE_RECORD_HEADER_LEN, \
+    "Capture record header size inconsistent");
+
+#endif /* PLATFORM_COMPONENTS_CAPTURE_FORMAT_H */
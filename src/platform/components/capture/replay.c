@@ -0,0 +1,328 @@
+#include <capture/replay.h>
+#include <capture/format.h>
+#include <menabrea/capture.h>
+#include <messaging/message.h>
+#include <messaging/setup.h>
+#include <messaging/local/router.h>
+#include <menabrea/input.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+#include <menabrea/exception.h>
+#include <odp_api.h>
+#include <linux/limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_REPLAY_STREAMS  64
+#define REPLAY_BURST        32
+
+typedef struct SReplayStream {
+    FILE * File;
+    SCaptureRecordHeader Record;  /* Header of the pending record */
+    u8 * Data;                    /* Data of the pending record */
+    u32 DataCapacity;
+    bool Exhausted;
+} SReplayStream;
+
+static bool OpenReplayStream(SReplayStream * stream, const char * path);
+static void ReadNextRecord(SReplayStream * stream);
+static u32 GetMaxMessageLength(void);
+static SReplayStream * GetEarliestStream(void);
+static void InjectRecord(SReplayStream * stream);
+static void ReplayInputPoll(void * arg);
+static void FinishReplay(void);
+static void CloseReplayStreams(void);
+static void DestroyCompletionMessage(TMessage completion);
+
+/* The streams are opened either before the fork or at runtime, but only ever accessed on the shared core */
+static SReplayStream s_streams[MAX_REPLAY_STREAMS];
+static int s_streamCount = 0;
+static double s_replaySpeed;
+static bool s_replayStarted = false;
+static u64 s_replayStartTime;
+static u64 s_firstTimestamp;
+static u32 s_maxRecordLength;
+static u64 s_replayedMessages = 0;
+static u64 s_droppedRecords = 0;
+static TMessage s_completion = MESSAGE_INVALID;
+static TWorkerId s_completionReceiver = WORKER_ID_INVALID;
+
+void ReplayInit(void) {
+
+    /* Always poll on the shared core so that replays can also be started at runtime */
+    RegisterInputPolling(ReplayInputPoll, NULL, GetSharedCoreMask());
+}
+
+void ReplayTeardown(void) {
+
+    CloseReplayStreams();
+}
+
+int ReplayCapture(const char * path, double speed, TMessage completion, TWorkerId receiver) {
+
+    if (unlikely(!CoreMaskContains(GetSharedCoreMask(), GetCurrentCore()))) {
+
+        RaiseException(EExceptionFatality_NonFatal, "Capture replay requested on core %d outside the shared core", \
+            GetCurrentCore());
+        DestroyCompletionMessage(completion);
+        return -1;
+    }
+
+    return StartReplay(path, speed, completion, receiver);
+}
+
+int StartReplay(const char * path, double speed, TMessage completion, TWorkerId receiver) {
+
+    if (unlikely(s_streamCount > 0 || speed < 0.0)) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s(): Cannot replay %s.<core> at speed %.2f%s", \
+            __FUNCTION__, path, speed, s_streamCount > 0 ? " - another replay in progress" : "");
+        DestroyCompletionMessage(completion);
+        return -1;
+    }
+
+    /* No message larger than the largest buffer in the pool could have been captured */
+    s_maxRecordLength = GetMaxMessageLength();
+    /* Merge the per-core capture files - probe consecutive core indices */
+    for (int core = 0; core < MAX_REPLAY_STREAMS; core++) {
+
+        char streamPath[PATH_MAX + 16];
+        (void) snprintf(streamPath, sizeof(streamPath), "%s.%d", path, core);
+        if (!OpenReplayStream(&s_streams[s_streamCount], streamPath)) {
+
+            break;
+        }
+        s_streamCount++;
+    }
+
+    if (s_streamCount == 0) {
+
+        LogPrint(ELogSeverityLevel_Warning, "%s(): No capture files found at %s.<core>", \
+            __FUNCTION__, path);
+        DestroyCompletionMessage(completion);
+        return -1;
+    }
+
+    s_replaySpeed = speed;
+    s_replayStarted = false;
+    s_replayedMessages = 0;
+    s_droppedRecords = 0;
+    s_completion = completion;
+    s_completionReceiver = receiver;
+
+    if (s_replaySpeed > 0.0) {
+
+        LogPrint(ELogSeverityLevel_Info, "Replaying %d capture file(s) from %s.<core> at %.2fx the original speed...", \
+            s_streamCount, path, s_replaySpeed);
+
+    } else {
+
+        LogPrint(ELogSeverityLevel_Info, "Replaying %d capture file(s) from %s.<core> at maximum speed...", \
+            s_streamCount, path);
+    }
+
+    return 0;
+}
+
+static bool OpenReplayStream(SReplayStream * stream, const char * path) {
+
+    stream->File = fopen(path, "rb");
+    if (stream->File == NULL) {
+
+        return false;
+    }
+
+    SCaptureFileHeader fileHeader;
+    if (1 != fread(&fileHeader, sizeof(fileHeader), 1, stream->File) || \
+        fileHeader.Magic != CAPTURE_FILE_MAGIC || fileHeader.Version != CAPTURE_FILE_VERSION) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s(): Invalid capture file: %s", \
+            __FUNCTION__, path);
+        (void) fclose(stream->File);
+        return false;
+    }
+
+    stream->Data = NULL;
+    stream->DataCapacity = 0;
+    stream->Exhausted = false;
+    /* Read in the first record */
+    ReadNextRecord(stream);
+    return true;
+}
+
+static void ReadNextRecord(SReplayStream * stream) {
+
+    if (1 != fread(&stream->Record, sizeof(stream->Record), 1, stream->File)) {
+
+        /* End of file */
+        stream->Exhausted = true;
+        return;
+    }
+
+    /* Do not let a corrupt file dictate the allocation size (or overflow the record size) */
+    u32 length = stream->Record.Length;
+    if (unlikely(length > s_maxRecordLength)) {
+
+        LogPrint(ELogSeverityLevel_Warning, "%s(): Record of %u B exceeds the maximum message size (%u B) - capture file corrupt", \
+            __FUNCTION__, length, s_maxRecordLength);
+        stream->Exhausted = true;
+        return;
+    }
+
+    if (length > stream->DataCapacity) {
+
+        u8 * data = realloc(stream->Data, length);
+        if (unlikely(data == NULL)) {
+
+            LogPrint(ELogSeverityLevel_Error, "%s(): Failed to allocate %u B for a record", \
+                __FUNCTION__, length);
+            stream->Exhausted = true;
+            return;
+        }
+        stream->Data = data;
+        stream->DataCapacity = length;
+    }
+
+    u32 padding = CAPTURE_RECORD_SIZE(length) - CAPTURE_RECORD_HEADER_LEN - length;
+    if (1 != fread(stream->Data, length, 1, stream->File) || 0 != fseek(stream->File, padding, SEEK_CUR)) {
+
+        LogPrint(ELogSeverityLevel_Warning, "%s(): Capture file truncated", __FUNCTION__);
+        stream->Exhausted = true;
+    }
+}
+
+static u32 GetMaxMessageLength(void) {
+
+    em_pool_info_t poolInfo;
+    if (unlikely(EM_OK != em_pool_info(MESSAGING_EVENT_POOL, &poolInfo))) {
+
+        return 0;
+    }
+
+    /* Messages are allocated with their headers, so the buffer size bounds the whole record */
+    u32 maxLength = 0;
+    for (int i = 0; i < poolInfo.num_subpools; i++) {
+
+        maxLength = poolInfo.subpool[i].size > maxLength ? poolInfo.subpool[i].size : maxLength;
+    }
+    return maxLength;
+}
+
+static SReplayStream * GetEarliestStream(void) {
+
+    SReplayStream * earliest = NULL;
+    for (int i = 0; i < s_streamCount; i++) {
+
+        SReplayStream * stream = &s_streams[i];
+        if (!stream->Exhausted && (earliest == NULL || stream->Record.Timestamp < earliest->Record.Timestamp)) {
+
+            earliest = stream;
+        }
+    }
+
+    return earliest;
+}
+
+static void InjectRecord(SReplayStream * stream) {
+
+    u32 length = stream->Record.Length;
+    SMessage * recorded = (SMessage *) stream->Data;
+    if (unlikely(length < MESSAGE_HEADER_LEN || recorded->Header.Magic != MESSAGE_HEADER_MAGIC || \
+        length < MESSAGE_HEADER_LEN + recorded->Header.PayloadSize)) {
+
+        s_droppedRecords++;
+        return;
+    }
+
+    TMessage message = CreateMessageFromBuffer(recorded);
+    if (unlikely(message == MESSAGE_INVALID)) {
+
+        s_droppedRecords++;
+        return;
+    }
+
+    SMessage * msgData = GetMessageData(message);
+    /* Replay is done on a single node - retarget the message to the local worker */
+    msgData->Header.Receiver = MakeWorkerId(GetOwnNodeId(), WorkerIdGetLocal(msgData->Header.Receiver));
+    /* Captured deadlines are long past */
+    msgData->Header.Deadline = MESSAGE_DEADLINE_NONE;
+    RouteIntranodeMessage(message);
+    s_replayedMessages++;
+}
+
+static void ReplayInputPoll(void * arg) {
+
+    (void) arg;
+
+    if (likely(s_streamCount == 0)) {
+
+        /* No replay in progress */
+        return;
+    }
+
+    u64 now = odp_time_to_ns(odp_time_global());
+    if (unlikely(!s_replayStarted)) {
+
+        /* Anchor the recorded timeline at the first poll */
+        s_replayStarted = true;
+        s_replayStartTime = now;
+        SReplayStream * first = GetEarliestStream();
+        s_firstTimestamp = first ? first->Record.Timestamp : 0;
+    }
+
+    for (int i = 0; i < REPLAY_BURST; i++) {
+
+        SReplayStream * stream = GetEarliestStream();
+        if (stream == NULL) {
+
+            FinishReplay();
+            return;
+        }
+
+        if (s_replaySpeed > 0.0) {
+
+            /* Preserve the (scaled) spacing between the recorded messages */
+            u64 due = s_replayStartTime + (u64) ((stream->Record.Timestamp - s_firstTimestamp) / s_replaySpeed);
+            if (now < due) {
+
+                return;
+            }
+        }
+
+        InjectRecord(stream);
+        ReadNextRecord(stream);
+    }
+}
+
+static void FinishReplay(void) {
+
+    LogPrint(ELogSeverityLevel_Info, "Replay complete - %lu message(s) injected, %lu dropped", \
+        s_replayedMessages, s_droppedRecords);
+    CloseReplayStreams();
+
+    if (s_completion != MESSAGE_INVALID) {
+
+        /* Injected messages have been enqueued ahead of the completion message */
+        SendMessage(s_completion, s_completionReceiver);
+        s_completion = MESSAGE_INVALID;
+    }
+}
+
+static void CloseReplayStreams(void) {
+
+    for (int i = 0; i < s_streamCount; i++) {
+
+        (void) fclose(s_streams[i].File);
+        free(s_streams[i].Data);
+    }
+    s_streamCount = 0;
+}
+
+static void DestroyCompletionMessage(TMessage completion) {
+
+    if (completion != MESSAGE_INVALID) {
+
+        DestroyMessage(completion);
+    }
+}
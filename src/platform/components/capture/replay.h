@@ -0,0 +1,12 @@
+
+#ifndef PLATFORM_COMPONENTS_CAPTURE_REPLAY_H
+#define PLATFORM_COMPONENTS_CAPTURE_REPLAY_H
+
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+
+void ReplayInit(void);
+void ReplayTeardown(void);
+int StartReplay(const char * path, double speed, TMessage completion, TWorkerId receiver);
+
+#endif /* PLATFORM_COMPONENTS_CAPTURE_REPLAY_H */
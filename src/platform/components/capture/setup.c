@@ -0,0 +1,33 @@
+#include <capture/setup.h>
+#include <capture/capture.h>
+#include <capture/replay.h>
+
+void CaptureInit(SCaptureConfig * config) {
+
+    if (config->CaptureFile[0] != '\0') {
+
+        CaptureRecordingInit(config->CaptureFile, config->CapturedWorkers, config->NodeId);
+    }
+
+    ReplayInit();
+    if (config->ReplayFile[0] != '\0') {
+
+        /* Failure already reported, carry on without the replay */
+        (void) StartReplay(config->ReplayFile, config->ReplaySpeed, MESSAGE_INVALID, WORKER_ID_INVALID);
+    }
+}
+
+void CaptureLocalInit(void) {
+
+    CaptureRecordingLocalInit();
+}
+
+void CaptureLocalExit(void) {
+
+    CaptureRecordingLocalExit();
+}
+
+void CaptureTeardown(void) {
+
+    ReplayTeardown();
+}
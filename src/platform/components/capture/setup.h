@@ -0,0 +1,23 @@
+
+#ifndef PLATFORM_COMPONENTS_CAPTURE_SETUP_H
+#define PLATFORM_COMPONENTS_CAPTURE_SETUP_H
+
+#include <menabrea/workers.h>
+#include <linux/limits.h>
+
+#define MAX_CAPTURED_WORKERS_LIST_LEN  512
+
+typedef struct SCaptureConfig {
+    TWorkerId NodeId;
+    char CaptureFile[PATH_MAX];                           /* Empty string if capture disabled */
+    char CapturedWorkers[MAX_CAPTURED_WORKERS_LIST_LEN];  /* Comma-separated list of worker names */
+    char ReplayFile[PATH_MAX];                            /* Empty string if replay disabled */
+    double ReplaySpeed;                                   /* Zero to replay at maximum speed */
+} SCaptureConfig;
+
+void CaptureInit(SCaptureConfig * config);
+void CaptureLocalInit(void);
+void CaptureLocalExit(void);
+void CaptureTeardown(void);
+
+#endif /* PLATFORM_COMPONENTS_CAPTURE_SETUP_H */
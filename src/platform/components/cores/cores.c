@@ -11,26 +11,24 @@ int GetCurrentCore(void) {
     return em_core_id();
 }
 
-int GetCurrentCoreMask(void) {
+TCoreMask GetCurrentCoreMask(void) {
 
-    return (1 << em_core_id());
+    return CoreMaskOf(em_core_id());
 }
 
-int GetSharedCoreMask(void) {
+TCoreMask GetSharedCoreMask(void) {
 
     /* Core 0 is always shared */
-    return 0b1;
+    return CoreMaskOf(0);
 }
 
-int GetIsolatedCoresMask(void) {
-
-    int cores = em_core_count();
-    /* Start with all bits set and shift them left by the number
-     * of cores in the system. This will result in 'cores' rightmost
-     * bits being zero. */
-    int invertedMask = (-1) << cores;
-    /* Add the LSB to the inverted mask */
-    invertedMask |= 0b1;
-    /* Invert the mask to be left only with the isolated cores */
-    return ~invertedMask;
+TCoreMask GetIsolatedCoresMask(void) {
+
+    TCoreMask mask;
+    em_core_mask_zero(&mask);
+    /* Start with all the cores in the system set */
+    em_core_mask_set_count(em_core_count(), &mask);
+    /* Remove the shared core */
+    em_core_mask_clr(0, &mask);
+    return mask;
 }
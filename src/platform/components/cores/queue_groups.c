@@ -1,65 +1,192 @@
 
 #include <cores/queue_groups.h>
+#include <menabrea/cores.h>
 #include <menabrea/log.h>
 #include <menabrea/exception.h>
-#include <stdio.h>
-#include <stdlib.h>
+#include <menabrea/common.h>
 
-typedef struct SCoreGroups {
-    int Count;
-    em_queue_group_t Groups[0];
-} SCoreGroups;
+typedef struct SQueueGroupEntry {
+    TCoreMask CoreMask;  /* Empty if the entry is unused */
+    int RefCount;
+    em_queue_group_t Group;
+} SQueueGroupEntry;
 
-static SCoreGroups * s_coreGroups = NULL;
+typedef struct SQueueGroupCache {
+    TSpinlock Lock;
+    SQueueGroupEntry Entries[MAX_QUEUE_GROUPS];
+} SQueueGroupCache;
+
+static SQueueGroupEntry * FindEntry(TCoreMask coreMask);
+static SQueueGroupEntry * ReclaimIdleEntry(void);
+static bool TryDeleteQueueGroup(SQueueGroupEntry * entry);
+static em_queue_group_t CreateQueueGroup(TCoreMask coreMask);
+
+static SQueueGroupCache * s_cache = NULL;
 
 void SetUpQueueGroups(void) {
 
-    int cores = em_core_count();
-    /* Get the number of subsets of cores. Exclude the empty set as there
-     * is no point in creating a queue group for no cores. */
-    int groupCount = (1 << cores) - 1;
-    LogPrint(ELogSeverityLevel_Info, "Setting up %d queue groups...", groupCount);
-    s_coreGroups = malloc(sizeof(SCoreGroups) + groupCount * sizeof(em_queue_group_t));
-    AssertTrue(s_coreGroups != NULL);
+    LogPrint(ELogSeverityLevel_Info, "Setting up queue group cache for up to %d core masks...", \
+        MAX_QUEUE_GROUPS);
+
+    /* Place the cache in shared memory as workers can be deployed from any core */
+    s_cache = (SQueueGroupCache *) env_shared_malloc(sizeof(SQueueGroupCache));
+    AssertTrue(s_cache != NULL);
+    SpinlockInit(&s_cache->Lock);
+    for (int i = 0; i < MAX_QUEUE_GROUPS; i++) {
+
+        s_cache->Entries[i].CoreMask = CoreMaskEmpty();
+        s_cache->Entries[i].RefCount = 0;
+        s_cache->Entries[i].Group = EM_QUEUE_GROUP_UNDEF;
+    }
+}
+
+em_queue_group_t AcquireQueueGroup(TCoreMask coreMask) {
+
+    if (unlikely(CoreMaskIsEmpty(coreMask) || !CoreMaskIsSubset(coreMask, GetAllCoresMask()))) {
+
+        char maskString[CORE_MASK_STRING_LEN];
+        char allCoresString[CORE_MASK_STRING_LEN];
+        LogPrint(ELogSeverityLevel_Error, "%s(): Invalid core mask %s (available cores: %s)", \
+            __FUNCTION__, CoreMaskToString(coreMask, maskString, sizeof(maskString)), \
+            CoreMaskToString(GetAllCoresMask(), allCoresString, sizeof(allCoresString)));
+        return EM_QUEUE_GROUP_UNDEF;
+    }
+
+    SpinlockAcquire(&s_cache->Lock);
+    SQueueGroupEntry * entry = FindEntry(coreMask);
+    if (entry == NULL) {
+
+        /* First use of the mask - find a free slot */
+        entry = FindEntry(CoreMaskEmpty());
+        if (unlikely(entry == NULL)) {
 
-    s_coreGroups->Count = groupCount;
+            /* Retry deleting the groups left over by earlier releases */
+            entry = ReclaimIdleEntry();
+        }
+
+        if (unlikely(entry == NULL)) {
 
-    for (int i = 0; i < groupCount; i++) {
+            SpinlockRelease(&s_cache->Lock);
+            LogPrint(ELogSeverityLevel_Error, "%s(): Too many distinct core masks in use (max: %d)", \
+                __FUNCTION__, MAX_QUEUE_GROUPS);
+            return EM_QUEUE_GROUP_UNDEF;
+        }
 
-        char maskString[16];
-        /* The index encodes the core mask */
-        (void) snprintf(maskString, sizeof(maskString), "0x%x", i + 1);
+        em_queue_group_t group = CreateQueueGroup(coreMask);
+        if (unlikely(group == EM_QUEUE_GROUP_UNDEF)) {
 
-        em_core_mask_t coreMask;
-        em_core_mask_zero(&coreMask);
-        em_core_mask_set_str(maskString, &coreMask);
+            SpinlockRelease(&s_cache->Lock);
+            char maskString[CORE_MASK_STRING_LEN];
+            LogPrint(ELogSeverityLevel_Error, "%s(): Failed to create queue group for core mask %s", \
+                __FUNCTION__, CoreMaskToString(coreMask, maskString, sizeof(maskString)));
+            return EM_QUEUE_GROUP_UNDEF;
+        }
 
-        /* Use a hashmap - core mask indexes the array (up to an offset of one) */
-        s_coreGroups->Groups[i] = em_queue_group_create(NULL, &coreMask, 0, NULL);
-        AssertTrue(s_coreGroups->Groups[i] != EM_QUEUE_GROUP_UNDEF);
+        entry->CoreMask = coreMask;
+        entry->RefCount = 0;
+        entry->Group = group;
     }
+
+    entry->RefCount++;
+    em_queue_group_t group = entry->Group;
+    SpinlockRelease(&s_cache->Lock);
+    return group;
 }
 
-em_queue_group_t MapCoreMaskToQueueGroup(int coreMask) {
+void ReleaseQueueGroup(TCoreMask coreMask) {
+
+    SpinlockAcquire(&s_cache->Lock);
+    SQueueGroupEntry * entry = FindEntry(coreMask);
+    /* Assert the caller holds a reference */
+    AssertTrue(entry != NULL && entry->RefCount > 0);
+    if (--entry->RefCount == 0) {
 
-    /* Subtract one from the coreMask to get an index into the groups array */
-    int index = coreMask - 1;
-    AssertTrue(index >= 0 && index < s_coreGroups->Count);
-    return s_coreGroups->Groups[index];
+        /* Last queue in the group gone - free the slot for other masks */
+        (void) TryDeleteQueueGroup(entry);
+    }
+    SpinlockRelease(&s_cache->Lock);
 }
 
 void TearDownQueueGroups(void) {
 
     /* Use idempotent implementation and allow calling this function
      * early on before initialization completed */
-    if (s_coreGroups) {
+    if (s_cache) {
+
+        for (int i = 0; i < MAX_QUEUE_GROUPS; i++) {
+
+            /* Platform daemons do not bother releasing their groups as they
+             * live until shutdown, and idle groups may still be pending deletion */
+            if (!CoreMaskIsEmpty(s_cache->Entries[i].CoreMask)) {
+
+                AssertTrue(EM_OK == em_queue_group_delete(s_cache->Entries[i].Group, 0, NULL));
+            }
+        }
+
+        env_shared_free(s_cache);
+        s_cache = NULL;
+    }
+}
+
+static SQueueGroupEntry * FindEntry(TCoreMask coreMask) {
+
+    /* Caller must ensure synchronization */
+
+    /* The number of masks in use is small and lookups only happen on deployment, so
+     * a linear search will do */
+    for (int i = 0; i < MAX_QUEUE_GROUPS; i++) {
+
+        if (CoreMaskEqual(s_cache->Entries[i].CoreMask, coreMask)) {
+
+            return &s_cache->Entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+static SQueueGroupEntry * ReclaimIdleEntry(void) {
 
-        for (int i = 0; i < s_coreGroups->Count; i++) {
+    /* Caller must ensure synchronization */
 
-            AssertTrue(EM_OK == em_queue_group_delete(s_coreGroups->Groups[i], 0, NULL));
+    for (int i = 0; i < MAX_QUEUE_GROUPS; i++) {
+
+        SQueueGroupEntry * entry = &s_cache->Entries[i];
+        if (!CoreMaskIsEmpty(entry->CoreMask) && entry->RefCount == 0 && TryDeleteQueueGroup(entry)) {
+
+            return entry;
         }
+    }
+
+    return NULL;
+}
+
+static bool TryDeleteQueueGroup(SQueueGroupEntry * entry) {
 
-        free(s_coreGroups);
-        s_coreGroups = NULL;
+    /* Caller must ensure synchronization */
+
+    /* Deletion fails if the asynchronous creation of the group has not completed yet, e.g. when
+     * a deployment gets rolled back right away - keep the group cached then (it can still be
+     * reused for the same mask) and retry when the slot is needed */
+    if (unlikely(EM_OK != em_queue_group_delete(entry->Group, 0, NULL))) {
+
+        char maskString[CORE_MASK_STRING_LEN];
+        LogPrint(ELogSeverityLevel_Debug, "%s(): Deferred deletion of queue group for core mask %s", \
+            __FUNCTION__, CoreMaskToString(entry->CoreMask, maskString, sizeof(maskString)));
+        return false;
     }
+
+    entry->CoreMask = CoreMaskEmpty();
+    entry->Group = EM_QUEUE_GROUP_UNDEF;
+    return true;
+}
+
+static em_queue_group_t CreateQueueGroup(TCoreMask coreMask) {
+
+    char maskString[CORE_MASK_STRING_LEN];
+    LogPrint(ELogSeverityLevel_Debug, "Creating queue group for core mask %s...", \
+        CoreMaskToString(coreMask, maskString, sizeof(maskString)));
+    /* The group is created asynchronously, but queues can be added to it right away - their
+     * events get scheduled on each core as soon as the core joins the group */
+    return em_queue_group_create(NULL, &coreMask, 0, NULL);
 }
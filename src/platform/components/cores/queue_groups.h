@@ -2,20 +2,38 @@
 #ifndef PLATFORM_COMPONENTS_CORES_QUEUE_GROUPS_H
 #define PLATFORM_COMPONENTS_CORES_QUEUE_GROUPS_H
 
+#include <menabrea/cores.h>
 #include <event_machine.h>
 
+#define MAX_QUEUE_GROUPS  64  /**< Maximum number of distinct core masks in use at a time */
+
 /**
- * @brief Set up queue groups for each core combination in shared memory for quick lookup
+ * @brief Set up the queue group cache in shared memory
+ * @note Queue groups themselves are created on demand by AcquireQueueGroup
  */
 void SetUpQueueGroups(void);
 
 /**
- * @brief Map a core mask
+ * @brief Get the queue group for a core mask, creating it on first use
+ * @param coreMask Core mask
+ * @return Queue group handle or EM_QUEUE_GROUP_UNDEF on failure
+ * @note Each successful call must be paired with a call to ReleaseQueueGroup once the queues
+ *       in the group have been deleted
+ * @see ReleaseQueueGroup
+ */
+em_queue_group_t AcquireQueueGroup(TCoreMask coreMask);
+
+/**
+ * @brief Drop a reference to the queue group for a core mask, deleting the group when it is no longer used
+ * @param coreMask Core mask
+ * @note If the group cannot be deleted yet (its creation is still in progress), it stays cached for
+ *       reuse and its deletion is retried once the slot is needed or at teardown
+ * @see AcquireQueueGroup
  */
-em_queue_group_t MapCoreMaskToQueueGroup(int coreMask);
+void ReleaseQueueGroup(TCoreMask coreMask);
 
 /**
- * @brief Tear down queue groups previously set with a call to SetUpQueueGroups
+ * @brief Delete the remaining queue groups and the cache previously set up with a call to SetUpQueueGroups
  * @see SetUpQueueGroups
  */
 void TearDownQueueGroups(void);
@@ -27,3 +27,24 @@ void PrintCallstack(void) {
         }
     }
 }
+
+void PrepareCallstack(void) {
+
+    void * callstack[1];
+    /* The first call to backtrace() loads the unwinder, which allocates memory - get it
+     * out of the way before WriteCallstack() gets called in a signal handler */
+    (void) backtrace(callstack, 1);
+}
+
+void WriteCallstack(int fd) {
+
+    void * callstack[MAX_CALLSTACK_DEPTH];
+
+    int depth = backtrace(callstack, MAX_CALLSTACK_DEPTH);
+    if (depth > 0) {
+
+        /* Unlike backtrace_symbols(), this neither allocates memory nor goes through stdio,
+         * which makes it usable in signal handlers */
+        backtrace_symbols_fd(callstack, depth, fd);
+    }
+}
@@ -3,5 +3,7 @@
 #define PLATFORM_COMPONENTS_EXCEPTION_CALLSTACK_H
 
 void PrintCallstack(void);
+void PrepareCallstack(void);
+void WriteCallstack(int fd);
 
 #endif /* PLATFORM_COMPONENTS_EXCEPTION_CALLSTACK_H */
@@ -33,6 +33,7 @@ static void SigchldHandler(siginfo_t * siginfo);
 static void SigtermHandler(siginfo_t * siginfo);
 static void SigintHandler(siginfo_t * siginfo);
 static void SigquitHandler(siginfo_t * siginfo);
+static void Sigusr2Handler(siginfo_t * siginfo);
 static const char * GetOffendingInstruction(ucontext_t * ucontext, char * buffer, size_t size);
 static void PrintProcessInfo(void);
 static bool RestoreDefaultHandlerAndRaise(int signo, const siginfo_t * siginfo);
@@ -52,6 +53,7 @@ void InstallSignalHandlers(void) {
     AssertTrue(0 == sigaction(SIGCHLD, &act, NULL));
     AssertTrue(0 == sigaction(SIGTERM, &act, NULL));
     AssertTrue(0 == sigaction(SIGINT, &act, NULL));
+    AssertTrue(0 == sigaction(SIGUSR2, &act, NULL));
 
     /* Ignore the SIGPIPE signal */
     struct sigaction ign = {
@@ -117,6 +119,10 @@ static void CommonHandler(int signo, siginfo_t * siginfo, void * ucontext) {
         SigquitHandler(siginfo);
         break;
 
+    case SIGUSR2:
+        Sigusr2Handler(siginfo);
+        break;
+
     default:
         /* Should never get here */
         LogPrint(ELogSeverityLevel_Warning, "Signal %d missing a handler in %s", \
@@ -375,6 +381,14 @@ static void SigquitHandler(siginfo_t * siginfo) {
         __FUNCTION__, siginfo->si_code == SI_USER ? siginfo->si_pid : -1);  /* Use -1 to indicate kernel */
 }
 
+static void Sigusr2Handler(siginfo_t * siginfo) {
+
+    /* Nothing to do here - used by the handler watchdog to request the call stack */
+
+    LogPrint(ELogSeverityLevel_Debug, "%s(): Received SIGUSR2 from %d", \
+        __FUNCTION__, siginfo->si_code == SI_USER ? siginfo->si_pid : -1);  /* Use -1 to indicate kernel */
+}
+
 static const char * GetOffendingInstruction(ucontext_t * ucontext, char * buffer, size_t size) {
 
     int status;
@@ -1,5 +1,6 @@
 #include <input/input.h>
 #include <menabrea/input.h>
+#include <menabrea/cores.h>
 #include <menabrea/common.h>
 #include <menabrea/log.h>
 #include <menabrea/exception.h>
@@ -9,7 +10,7 @@
 typedef struct SInputPollCallback {
     TInputPollCallback Callback;
     void * Argument;
-    int CoreMask;
+    TCoreMask CoreMask;
 } SInputPollCallback;
 
 static SInputPollCallback s_inputPollCallbacks[MAX_INPUT_CALLBACKS];
@@ -21,7 +22,7 @@ static bool s_pollingEnabled = false;
 static bool s_inInputPollCallback = false;
 static int s_totalEventsEnqueued = 0;
 
-void RegisterInputPolling(TInputPollCallback callback, void * callbackArgument, int coreMask) {
+void RegisterInputPolling(TInputPollCallback callback, void * callbackArgument, TCoreMask coreMask) {
 
     if (unlikely(callback == NULL)) {
 
@@ -29,7 +30,7 @@ void RegisterInputPolling(TInputPollCallback callback, void * callbackArgument,
         return;
     }
 
-    if (unlikely(coreMask == 0)) {
+    if (unlikely(CoreMaskIsEmpty(coreMask))) {
 
         RaiseException(EExceptionFatality_NonFatal, "Empty core mask for callback %p", callback);
         return;
@@ -41,8 +42,9 @@ void RegisterInputPolling(TInputPollCallback callback, void * callbackArgument,
         s_inputPollCallbacks[s_numOfCallbacks].Argument = callbackArgument;
         s_inputPollCallbacks[s_numOfCallbacks].CoreMask = coreMask;
         s_numOfCallbacks++;
-        LogPrint(ELogSeverityLevel_Debug, "%s(): Registered input poll callback at %p on cores 0x%x", \
-            __FUNCTION__, callback, coreMask);
+        char maskString[CORE_MASK_STRING_LEN];
+        LogPrint(ELogSeverityLevel_Debug, "%s(): Registered input poll callback at %p on cores %s", \
+            __FUNCTION__, callback, CoreMaskToString(coreMask, maskString, sizeof(maskString)));
 
     } else {
 
@@ -61,7 +63,7 @@ int EmInputPollFunction(void) {
         int core = em_core_id();
         for (u32 i = 0; i < s_numOfCallbacks; i++) {
 
-            if (s_inputPollCallbacks[i].CoreMask & (1 << core)) {
+            if (CoreMaskContains(s_inputPollCallbacks[i].CoreMask, core)) {
 
                 void * arg = s_inputPollCallbacks[i].Argument;
                 s_inputPollCallbacks[i].Callback(arg);
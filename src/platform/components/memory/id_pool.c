@@ -0,0 +1,115 @@
+#include <memory/id_pool.h>
+#include <menabrea/common.h>
+#include <menabrea/exception.h>
+
+/* Bounded multi-producer, multi-consumer ring. Each slot carries a sequence number telling
+ * whether it is free to be written (equal to the position of the writer) or holds an ID
+ * (equal to the position of the reader plus one), which lets producers and consumers claim
+ * positions with a single compare-and-set and without ever taking a lock. */
+
+typedef struct SIdPoolSlot {
+    TAtomic32 Sequence;
+    u32 Id;
+} SIdPoolSlot;
+
+struct SIdPool {
+    /* Keep the producers and the consumers off each other's cache line */
+    TAtomic32 Tail;
+    void * _pad1[0] ENV_CACHE_LINE_ALIGNED;
+    TAtomic32 Head;
+    void * _pad2[0] ENV_CACHE_LINE_ALIGNED;
+    u32 Mask;
+    SIdPoolSlot Slots[0];
+};
+
+static inline u32 RoundUpToPowerOfTwo(u32 value);
+
+size_t IdPoolFootprint(u32 capacity) {
+
+    return ENV_CACHE_LINE_SIZE_ROUNDUP(sizeof(SIdPool) + RoundUpToPowerOfTwo(capacity) * sizeof(SIdPoolSlot));
+}
+
+SIdPool * IdPoolInit(void * memory, u32 capacity) {
+
+    SIdPool * pool = (SIdPool *) memory;
+    u32 slots = RoundUpToPowerOfTwo(capacity);
+    pool->Mask = slots - 1;
+    Atomic32Init(&pool->Tail);
+    Atomic32Init(&pool->Head);
+    for (u32 i = 0; i < slots; i++) {
+
+        /* Free to be written at position i */
+        Atomic32Init(&pool->Slots[i].Sequence);
+        Atomic32Set(&pool->Slots[i].Sequence, i);
+        pool->Slots[i].Id = 0;
+    }
+    return pool;
+}
+
+void IdPoolPut(SIdPool * pool, u32 id) {
+
+    u32 position = Atomic32Get(&pool->Tail);
+    for (;;) {
+
+        SIdPoolSlot * slot = &pool->Slots[position & pool->Mask];
+        i32 difference = (i32) (Atomic32Get(&slot->Sequence) - position);
+        if (difference == 0) {
+
+            if (Atomic32CmpSet(&pool->Tail, position, position + 1)) {
+
+                slot->Id = id;
+                /* Publish the ID to the consumers */
+                Atomic32Set(&slot->Sequence, position + 1);
+                return;
+            }
+            position = Atomic32Get(&pool->Tail);
+
+        } else {
+
+            /* The pool is sized for all the IDs, so it can never be full */
+            AssertTrue(difference > 0);
+            position = Atomic32Get(&pool->Tail);
+        }
+    }
+}
+
+bool IdPoolTake(SIdPool * pool, u32 * id) {
+
+    u32 position = Atomic32Get(&pool->Head);
+    for (;;) {
+
+        SIdPoolSlot * slot = &pool->Slots[position & pool->Mask];
+        i32 difference = (i32) (Atomic32Get(&slot->Sequence) - (position + 1));
+        if (difference == 0) {
+
+            if (Atomic32CmpSet(&pool->Head, position, position + 1)) {
+
+                *id = slot->Id;
+                /* Hand the slot back to the producers for the next lap */
+                Atomic32Set(&slot->Sequence, position + pool->Mask + 1);
+                return true;
+            }
+            position = Atomic32Get(&pool->Head);
+
+        } else if (difference < 0) {
+
+            /* Pool empty */
+            return false;
+
+        } else {
+
+            /* Another consumer got ahead of us */
+            position = Atomic32Get(&pool->Head);
+        }
+    }
+}
+
+static inline u32 RoundUpToPowerOfTwo(u32 value) {
+
+    u32 result = 1;
+    while (result < value) {
+
+        result <<= 1;
+    }
+    return result;
+}
@@ -0,0 +1,16 @@
+
+#ifndef PLATFORM_COMPONENTS_MEMORY_ID_POOL_H
+#define PLATFORM_COMPONENTS_MEMORY_ID_POOL_H
+
+#include <menabrea/common.h>
+#include <stddef.h>
+
+/* Lock-free pool of free IDs in shared memory, recycled in FIFO order */
+typedef struct SIdPool SIdPool;
+
+size_t IdPoolFootprint(u32 capacity);
+SIdPool * IdPoolInit(void * memory, u32 capacity);
+void IdPoolPut(SIdPool * pool, u32 id);
+bool IdPoolTake(SIdPool * pool, u32 * id);
+
+#endif /* PLATFORM_COMPONENTS_MEMORY_ID_POOL_H */
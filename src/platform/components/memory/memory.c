@@ -1,5 +1,6 @@
 #include <menabrea/memory.h>
 #include <memory/setup.h>
+#include <memory/memory.h>
 #include <menabrea/common.h>
 #include <menabrea/exception.h>
 #include <menabrea/log.h>
@@ -122,3 +123,10 @@ void PutRuntimeMemory(void * ptr) {
         em_free(hdr->Event);
     }
 }
+
+bool IsRuntimeMemory(void * ptr) {
+
+    /* Utility function for internal use */
+
+    return ptr != NULL && ((SRuntimeMemoryHeader *) ptr - 1)->Magic == RUNTIME_SHM_MAGIC;
+}
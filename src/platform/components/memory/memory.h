@@ -2,7 +2,10 @@
 #ifndef PLATFORM_COMPONENTS_MEMORY_MEMORY_H
 #define PLATFORM_COMPONENTS_MEMORY_MEMORY_H
 
+#include <menabrea/common.h>
+
 void DisableInitMemoryAllocation(void);
 void ReleaseInitMemory(void);
+bool IsRuntimeMemory(void * ptr);
 
 #endif /* PLATFORM_COMPONENTS_MEMORY_MEMORY_H */
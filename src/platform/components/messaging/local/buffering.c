@@ -1,6 +1,7 @@
 #include <messaging/local/buffering.h>
 #include <messaging/message.h>
 #include <workers/worker_table.h>
+#include <workers/fusion.h>
 #include <menabrea/exception.h>
 
 int BufferMessage(TMessage message) {
@@ -10,7 +11,7 @@ int BufferMessage(TMessage message) {
     TWorkerId receiver = GetMessageReceiver(message);
     SWorkerContext * receiverContext = FetchWorkerContext(receiver);
     /* Assert function called in the correct context */
-    AssertTrue(receiverContext->State == EWorkerState_Deploying);
+    AssertTrue(FetchWorkerRoute(receiver)->State == EWorkerState_Deploying);
 
     /* Search the worker's event buffer for a free slot */
     for (int i = 0; i < MESSAGE_BUFFER_LENGTH; i++) {
@@ -34,15 +35,18 @@ int FlushBufferedMessages(TWorkerId workerId) {
 
     int dropped = 0;
     SWorkerContext * context = FetchWorkerContext(workerId);
+    SWorkerRoute * route = FetchWorkerRoute(workerId);
     /* Assert this function only gets called when the worker is
      * starting up */
-    AssertTrue(context->State == EWorkerState_Deploying);
+    AssertTrue(route->State == EWorkerState_Deploying);
 
     for (int i = 0; i < MESSAGE_BUFFER_LENGTH && context->MessageBuffer[i] != MESSAGE_INVALID; i++) {
 
         TMessage message = context->MessageBuffer[i];
-        if (unlikely(EM_OK != em_send(message, context->Queue))) {
+        NoteMessagesQueued(route, 1);
+        if (unlikely(EM_OK != em_send(message, route->Queue))) {
 
+            NoteMessagesQueued(route, -1);
             DestroyMessage(message);
             dropped++;
         }
@@ -60,7 +64,7 @@ int DropBufferedMessages(TWorkerId workerId) {
     SWorkerContext * context = FetchWorkerContext(workerId);
     /* Assert this function only gets called when the worker is
      * starting up */
-    AssertTrue(context->State == EWorkerState_Deploying);
+    AssertTrue(FetchWorkerRoute(workerId)->State == EWorkerState_Deploying);
 
     for (int i = 0; i < MESSAGE_BUFFER_LENGTH && context->MessageBuffer[i] != MESSAGE_INVALID; i++) {
 
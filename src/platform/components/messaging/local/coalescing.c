@@ -0,0 +1,46 @@
+#include <messaging/local/coalescing.h>
+#include <messaging/local/router.h>
+#include <menabrea/exception.h>
+
+static inline void FlushStagedMessages(void);
+
+/* Each core runs in its own process, so this state is private to the core */
+static bool s_coalescingActive = false;
+static TMessage s_stagedMessages[MAX_STAGED_MESSAGES];
+static int s_stagedCount = 0;
+
+void BeginSendCoalescing(void) {
+
+    AssertTrue(s_stagedCount == 0);
+    s_coalescingActive = true;
+}
+
+void EndSendCoalescing(void) {
+
+    s_coalescingActive = false;
+    FlushStagedMessages();
+}
+
+bool IsSendCoalescingActive(void) {
+
+    return s_coalescingActive;
+}
+
+void StageMessage(TMessage message) {
+
+    if (unlikely(s_stagedCount == MAX_STAGED_MESSAGES)) {
+
+        /* Staging area full, flush early */
+        FlushStagedMessages();
+    }
+
+    s_stagedMessages[s_stagedCount++] = message;
+}
+
+static inline void FlushStagedMessages(void) {
+
+    /* Route the messages grouped by receiver - this preserves the order
+     * of messages addressed to the same worker */
+    RouteIntranodeMessages(s_stagedMessages, s_stagedCount);
+    s_stagedCount = 0;
+}
@@ -0,0 +1,31 @@
+
+#ifndef PLATFORM_COMPONENTS_MESSAGING_LOCAL_COALESCING_H
+#define PLATFORM_COMPONENTS_MESSAGING_LOCAL_COALESCING_H
+
+#include <menabrea/messaging.h>
+
+#define MAX_STAGED_MESSAGES  32  /**< Maximum number of messages staged on a core before an early flush */
+
+/**
+ * @brief Start staging local messages sent on the current core instead of routing them immediately
+ */
+void BeginSendCoalescing(void);
+
+/**
+ * @brief Route all messages staged on the current core and stop staging
+ */
+void EndSendCoalescing(void);
+
+/**
+ * @brief Check if messages sent on the current core are being staged
+ * @return True if send coalescing is active, false otherwise
+ */
+bool IsSendCoalescingActive(void);
+
+/**
+ * @brief Stage a local message to be routed when coalescing ends
+ * @param message Message addressed to a worker on the current node
+ */
+void StageMessage(TMessage message);
+
+#endif /* PLATFORM_COMPONENTS_MESSAGING_LOCAL_COALESCING_H */
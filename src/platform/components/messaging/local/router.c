@@ -3,50 +3,178 @@
 #include <messaging/message.h>
 #include <menabrea/log.h>
 #include <workers/worker_table.h>
+#include <workers/fusion.h>
+#include <workers/completion_daemon.h>
+#include <overload/overload.h>
+
+static void DeliverToReceiver(TWorkerId receiver, TMessage messages[], int count);
+static void SortByReceiver(TMessage messages[], int count);
 
 void RouteIntranodeMessage(TMessage message) {
 
     TWorkerId receiver = GetMessageReceiver(message);
+    if (TryDeliverInline(receiver, message)) {
+
+        /* Receiver invoked directly on the current core, bypassing the queue */
+        return;
+    }
+
+    DeliverToReceiver(receiver, &message, 1);
+}
+
+void RouteIntranodeMessages(TMessage messages[], int count) {
+
+    /* Group the messages by receiver so that each worker table entry
+     * only gets locked once and each queue gets a single em_send_multi() */
+    SortByReceiver(messages, count);
+
+    int i = 0;
+    while (i < count) {
+
+        TWorkerId receiver = GetMessageReceiver(messages[i]);
+        int groupSize = 1;
+        while (i + groupSize < count && GetMessageReceiver(messages[i + groupSize]) == receiver) {
+
+            groupSize++;
+        }
+
+        DeliverToReceiver(receiver, &messages[i], groupSize);
+        i += groupSize;
+    }
+}
+
+void RouteIntranodeMessageInGroup(TMessage message, TMessageGroup group) {
+
+    TWorkerId receiver = GetMessageReceiver(message);
+    SWorkerRoute * route = FetchWorkerRoute(receiver);
+    if (likely(!ShouldShedTraffic(route->SheddingLevel))) {
+
+        LockWorkerTableEntry(receiver);
+        /* Staging queues of migrating workers are unscheduled and cannot carry event groups */
+        if (likely(route->State == EWorkerState_Active && !route->Context->Migration.InProgress \
+            && (likely(!route->RateLimited) || 1 == RateLimiterAdmit(&route->Context->RateLimiter, 1)))) {
+
+            NoteMessagesQueued(route, 1);
+            if (likely(EM_OK == em_send_group(message, route->Queue, group))) {
+
+                UnlockWorkerTableEntry(receiver);
+                NoteMessagesDelivered(1);
+                return;
+            }
+            NoteMessagesQueued(route, -1);
+        }
+        UnlockWorkerTableEntry(receiver);
+    }
+
+    /* Message cannot be tracked until consumed - deliver it (or drop it) as usual
+     * and count it towards the group's completion right away */
+    DeliverToReceiver(receiver, &message, 1);
+    if (unlikely(0 != CountTowardsCompletion(group))) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to account for a message sent to 0x%x - group will not complete", \
+            __FUNCTION__, receiver);
+    }
+}
 
-    /* Lock the entry to ensure the queue is still valid when em_send() gets called */
+static void DeliverToReceiver(TWorkerId receiver, TMessage messages[], int count) {
+
+    /* Only the routing entry is needed unless the messages get dropped or buffered */
+    SWorkerRoute * route = FetchWorkerRoute(receiver);
+    if (unlikely(ShouldShedTraffic(route->SheddingLevel))) {
+
+        /* Node overloaded - drop the low-priority traffic before it gets queued up */
+        Atomic32Add(&FetchWorkerContext(receiver)->ShedMessages, count);
+        for (int i = 0; i < count; i++) {
+
+            DestroyMessage(messages[i]);
+        }
+        return;
+    }
+
+    /* Lock the entry to ensure the queue is still valid when em_send_multi() gets called */
     LockWorkerTableEntry(receiver);
-    SWorkerContext * receiverContext = FetchWorkerContext(receiver);
-    EWorkerState state = receiverContext->State;
+    EWorkerState state = route->State;
+    int delivered = 0;
+    int admitted = 0;
     switch (state) {
     case EWorkerState_Active:
-        /* Worker active - push the message to the EM queue */
-        if (unlikely(EM_OK != em_send(message, receiverContext->Queue))) {
+        /* Worker active - push as many messages to the EM queue as its rate limit allows,
+         * only reaching for the limiter in the context if there is one */
+        admitted = count;
+        if (unlikely(route->RateLimited)) {
+
+            admitted = RateLimiterAdmit(&route->Context->RateLimiter, count);
+            if (admitted < count) {
+
+                Atomic32Add(&route->Context->ThrottledMessages, count - admitted);
+            }
+        }
+        /* Count the messages in before they can be dequeued */
+        NoteMessagesQueued(route, admitted);
+        delivered = likely(admitted > 0) ? em_send_multi(messages, admitted, route->Queue) : 0;
+        delivered = delivered > 0 ? delivered : 0;
+        NoteMessagesQueued(route, delivered - admitted);
+        UnlockWorkerTableEntry(receiver);
+        NoteMessagesDelivered(delivered);
+        for (int i = delivered; i < admitted; i++) {
 
-            UnlockWorkerTableEntry(receiver);
             LogPrint(ELogSeverityLevel_Error, "Failed to send message 0x%x (sender: 0x%x, receiver: 0x%x)", \
-                GetMessageId(message), GetMessageSender(message), GetMessageReceiver(message));
+                GetMessageId(messages[i]), GetMessageSender(messages[i]), receiver);
             /* We are still the owners of the message and must return it to the system */
-            DestroyMessage(message);
-            return;
+            DestroyMessage(messages[i]);
+        }
+        for (int i = admitted; i < count; i++) {
+
+            /* Over the rate limit - drop the message (accounted for above) */
+            DestroyMessage(messages[i]);
         }
-        UnlockWorkerTableEntry(receiver);
         break;
 
     case EWorkerState_Deploying:
-        /* Worker still starting up - buffer the message */
-        if (unlikely(BufferMessage(message))) {
+        /* Worker still starting up - buffer the messages */
+        while (delivered < count && 0 == BufferMessage(messages[delivered])) {
+
+            delivered++;
+        }
+        UnlockWorkerTableEntry(receiver);
+        /* Buffered messages will reach the worker once deployed */
+        NoteMessagesDelivered(delivered);
+        for (int i = delivered; i < count; i++) {
 
             /* Failed to find a free slot, drop the message */
-            UnlockWorkerTableEntry(receiver);
             LogPrint(ELogSeverityLevel_Warning, "Failed to send message 0x%x (sender: 0x%x, receiver: 0x%x)" \
                 " - deployment not yet complete and the message buffer is full", \
-                GetMessageId(message), GetMessageSender(message), GetMessageReceiver(message));
-            DestroyMessage(message);
-            return;
+                GetMessageId(messages[i]), GetMessageSender(messages[i]), receiver);
+            DestroyMessage(messages[i]);
         }
-        UnlockWorkerTableEntry(receiver);
         break;
 
     default:
         UnlockWorkerTableEntry(receiver);
-        LogPrint(ELogSeverityLevel_Warning, "Failed to send message 0x%x (sender: 0x%x, receiver: 0x%x) - invalid receiver state: %d", \
-            GetMessageId(message), GetMessageSender(message), GetMessageReceiver(message), state);
-        DestroyMessage(message);
+        for (int i = 0; i < count; i++) {
+
+            LogPrint(ELogSeverityLevel_Warning, "Failed to send message 0x%x (sender: 0x%x, receiver: 0x%x) - invalid receiver state: %d", \
+                GetMessageId(messages[i]), GetMessageSender(messages[i]), receiver, state);
+            DestroyMessage(messages[i]);
+        }
         break;
     }
 }
+
+static void SortByReceiver(TMessage messages[], int count) {
+
+    /* Bursts are short, use a stable insertion sort to preserve the
+     * relative order of messages sent to the same receiver */
+    for (int i = 1; i < count; i++) {
+
+        TMessage message = messages[i];
+        TWorkerId receiver = GetMessageReceiver(message);
+        int j = i - 1;
+        while (j >= 0 && GetMessageReceiver(messages[j]) > receiver) {
+
+            messages[j + 1] = messages[j];
+            j--;
+        }
+        messages[j + 1] = message;
+    }
+}
@@ -10,4 +10,21 @@
  */
 void RouteIntranodeMessage(TMessage message);
 
+/**
+ * @brief Route a burst of messages locally, grouping them by receiver
+ * @param messages Array of messages
+ * @param count Number of messages in the array
+ * @note The array gets reordered, but the relative order of messages addressed to the same receiver is preserved
+ */
+void RouteIntranodeMessages(TMessage messages[], int count);
+
+/**
+ * @brief Route a message locally as part of a message group
+ * @param message Message
+ * @param group Message group
+ * @note Messages that cannot be enqueued in the group are routed as usual and counted towards the group's
+ *       completion immediately
+ */
+void RouteIntranodeMessageInGroup(TMessage message, TMessageGroup group);
+
 #endif /* PLATFORM_COMPONENTS_MESSAGING_LOCAL_ROUTER_H */
@@ -1,5 +1,8 @@
 #include <messaging/message.h>
 #include <messaging/setup.h>
+#include <memory/memory.h>
+#include <menabrea/memory.h>
+#include <menabrea/exception.h>
 
 TMessage CreateMessage(TMessageId msgId, u32 payloadSize) {
 
@@ -14,7 +17,9 @@ TMessage CreateMessage(TMessageId msgId, u32 payloadSize) {
         msgData->Header.Sender = WORKER_ID_INVALID;
         msgData->Header.Receiver = WORKER_ID_INVALID;
         msgData->Header.Magic = MESSAGE_HEADER_MAGIC;
-        msgData->Header.Unused = 0;
+        msgData->Header.Deadline = MESSAGE_DEADLINE_NONE;
+        /* User area is not initialized by EM */
+        GetMessageAttachments(event)->Count = 0;
     }
 
     return event;
@@ -22,7 +27,20 @@ TMessage CreateMessage(TMessageId msgId, u32 payloadSize) {
 
 TMessage CopyMessage(TMessage message) {
 
-    return em_event_clone(message, EM_POOL_UNDEF);
+    TMessage copy = em_event_clone(message, EM_POOL_UNDEF);
+    if (likely(copy != MESSAGE_INVALID)) {
+
+        /* The copy holds references of its own */
+        SMessageAttachments * attachments = GetMessageAttachments(message);
+        SMessageAttachments * copyAttachments = GetMessageAttachments(copy);
+        copyAttachments->Count = attachments->Count;
+        for (u32 i = 0; i < attachments->Count; i++) {
+
+            copyAttachments->Buffers[i] = RefRuntimeMemory(attachments->Buffers[i]);
+        }
+    }
+
+    return copy;
 }
 
 void * GetMessagePayload(TMessage message) {
@@ -49,8 +67,88 @@ TWorkerId GetMessageSender(TMessage message) {
     return msgData->Header.Sender;
 }
 
+void SetMessageTimeToLive(TMessage message, u32 ttl) {
+
+    if (unlikely(ttl > MAX_MESSAGE_TIME_TO_LIVE)) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Time-to-live of message 0x%x too long: %u (max: %u)", \
+            GetMessageId(message), ttl, MAX_MESSAGE_TIME_TO_LIVE);
+        return;
+    }
+
+    SMessage * msgData = (SMessage *) em_event_pointer(message);
+    if (ttl == 0) {
+
+        /* Clear the deadline */
+        msgData->Header.Deadline = MESSAGE_DEADLINE_NONE;
+        return;
+    }
+
+    u32 deadline = GetDeadlineClock() + ttl;
+    /* Zero is reserved to denote no deadline, so in the unlikely event the clock wraps
+     * around exactly to zero, extend the time-to-live by a microsecond */
+    msgData->Header.Deadline = (deadline != MESSAGE_DEADLINE_NONE) ? deadline : 1;
+}
+
+bool IsMessageExpired(TMessage message) {
+
+    SMessage * msgData = (SMessage *) em_event_pointer(message);
+    return IsDeadlineExpired(msgData->Header.Deadline);
+}
+
+int AttachRuntimeMemory(TMessage message, void * ptr) {
+
+    if (unlikely(!IsRuntimeMemory(ptr))) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Tried attaching %p to message 0x%x, but it was not obtained from GetRuntimeMemory()", \
+            ptr, GetMessageId(message));
+        return -1;
+    }
+
+    SMessageAttachments * attachments = GetMessageAttachments(message);
+    if (unlikely(attachments->Count == MAX_MESSAGE_ATTACHMENTS)) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Message 0x%x already has the maximum of %d attachments", \
+            GetMessageId(message), MAX_MESSAGE_ATTACHMENTS);
+        return -1;
+    }
+
+    /* Take over the caller's reference */
+    attachments->Buffers[attachments->Count++] = ptr;
+    return 0;
+}
+
+u32 GetMessageAttachmentCount(TMessage message) {
+
+    return GetMessageAttachments(message)->Count;
+}
+
+void * GetMessageAttachment(TMessage message, u32 index) {
+
+    SMessageAttachments * attachments = GetMessageAttachments(message);
+    if (unlikely(index >= attachments->Count)) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Invalid attachment index %u of message 0x%x (attachments: %u)", \
+            index, GetMessageId(message), attachments->Count);
+        return NULL;
+    }
+
+    return attachments->Buffers[index];
+}
+
 void DestroyMessage(TMessage message) {
 
+    /* Release the references held by the message */
+    SMessageAttachments * attachments = GetMessageAttachments(message);
+    for (u32 i = 0; i < attachments->Count; i++) {
+
+        PutRuntimeMemory(attachments->Buffers[i]);
+    }
+
     em_free(message);
 }
 
@@ -119,7 +217,46 @@ TMessage CreateMessageFromBuffer(void * buffer) {
         SMessage * dstData = (SMessage *) em_event_pointer(message);
         dstData->Header = srcData->Header;
         (void) memcpy(dstData->UserPayload, srcData->UserPayload, payloadSize);
+        /* Attachments never leave the node */
+        GetMessageAttachments(message)->Count = 0;
     }
 
     return message;
 }
+
+int CreateMessagesFromBuffers(void * buffers[], int count, TMessage messages[]) {
+
+    /* The caller must ensure all buffers are valid, e.g. by calling IsValidMessage(buffer, ...) */
+
+    int created = 0;
+    int i = 0;
+    while (i < count) {
+
+        /* Find a run of equally-sized messages that can be allocated with a single call */
+        u32 payloadSize = ((SMessage *) buffers[i])->Header.PayloadSize;
+        int runLength = 1;
+        while (i + runLength < count && ((SMessage *) buffers[i + runLength])->Header.PayloadSize == payloadSize) {
+
+            runLength++;
+        }
+
+        int allocated = em_alloc_multi(&messages[created], runLength, MESSAGE_HEADER_LEN + payloadSize, \
+            EM_EVENT_TYPE_SW, MESSAGING_EVENT_POOL);
+        allocated = allocated > 0 ? allocated : 0;
+        for (int j = 0; j < allocated; j++) {
+
+            SMessage * srcData = (SMessage *) buffers[i + j];
+            SMessage * dstData = (SMessage *) em_event_pointer(messages[created + j]);
+            dstData->Header = srcData->Header;
+            (void) memcpy(dstData->UserPayload, srcData->UserPayload, payloadSize);
+            /* Attachments never leave the node */
+            GetMessageAttachments(messages[created + j])->Count = 0;
+        }
+
+        created += allocated;
+        /* Skip the entire run - the caller can tell how many messages were dropped from the return value */
+        i += runLength;
+    }
+
+    return created;
+}
@@ -3,9 +3,11 @@
 #define PLATFORM_COMPONENTS_MESSAGING_MESSAGE_H
 
 #include <menabrea/messaging.h>
+#include <time.h>
 
-#define MESSAGE_HEADER_MAGIC  ( (u16) 0xF321 )
-#define MESSAGE_HEADER_LEN    16
+#define MESSAGE_HEADER_MAGIC    ( (u16) 0xF321 )
+#define MESSAGE_HEADER_LEN      16
+#define MESSAGE_DEADLINE_NONE   ( (u32) 0 )
 
 typedef struct SMessageHeader {
     u32 PayloadSize;
@@ -13,7 +15,7 @@ typedef struct SMessageHeader {
     TWorkerId Receiver;
     TMessageId MessageId;
     u16 Magic;
-    u32 Unused;  /* Pad to have the size be a multiple of 64 bits */
+    u32 Deadline;  /* Expiry time in microseconds of wall-clock time (truncated to 32 bits) or MESSAGE_DEADLINE_NONE */
 } SMessageHeader;
 
 typedef struct SMessage {
@@ -21,12 +23,39 @@ typedef struct SMessage {
     u8 UserPayload[0];
 } SMessage;
 
+/* Kept in the event user area so as not to affect the message layout on the wire */
+typedef struct SMessageAttachments {
+    u32 Count;
+    void * Buffers[MAX_MESSAGE_ATTACHMENTS];
+} SMessageAttachments;
+
 ODP_STATIC_ASSERT(sizeof(SMessageHeader) == MESSAGE_HEADER_LEN, \
     "Message header length inconsistent");
 
+static inline u32 GetDeadlineClock(void) {
+
+    /* Use wall-clock time so that deadlines remain meaningful across nodes */
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_REALTIME, &ts);
+    return (u32) ((u64) ts.tv_sec * 1000000 + (u64) ts.tv_nsec / 1000);
+}
+
+static inline bool IsDeadlineExpired(u32 deadline) {
+
+    /* Only read the clock if a deadline has been set. Compare the difference
+     * as a signed value to handle the clock wrapping around. */
+    return unlikely(deadline != MESSAGE_DEADLINE_NONE) && (i32) (GetDeadlineClock() - deadline) > 0;
+}
+
+static inline SMessageAttachments * GetMessageAttachments(TMessage message) {
+
+    return (SMessageAttachments *) em_event_uarea_get(message, NULL);
+}
+
 SMessage * GetMessageData(TMessage message);
 TWorkerId GetMessageReceiver(TMessage message);
 bool IsValidMessage(void * buffer, u32 size);
 TMessage CreateMessageFromBuffer(void * buffer);
+int CreateMessagesFromBuffers(void * buffers[], int count, TMessage messages[]);
 
 #endif /* PLATFORM_COMPONENTS_MESSAGING_MESSAGE_H */
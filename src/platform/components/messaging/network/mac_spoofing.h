@@ -11,6 +11,9 @@
 #define MAC_ADDR_COMMON_BASE_BYTE_2  ( (u8) 0xBE )
 #define MAC_ADDR_COMMON_BASE_BYTE_3  ( (u8) 0xEF )
 #define MAC_ADDR_COMMON_BASE_BYTE_4  ( (u8) 0x42 )
+/* Byte 4 distinguishes between the interfaces of a node - interface i of each node is
+ * expected to be connected to the same network segment as interface i of every other node */
+#define MAC_ADDR_INTERFACE_BYTE_4(ifIndex)  ( (u8) (MAC_ADDR_COMMON_BASE_BYTE_4 + (ifIndex)) )
 
 void SetMacAddress(const char * ifName, const u8 * mac);
 void GetMacAddress(const char * ifName, u8 * mac);
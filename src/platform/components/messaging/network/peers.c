@@ -0,0 +1,222 @@
+#include <messaging/network/peers.h>
+#include <messaging/network/mac_spoofing.h>
+#include <messaging/network/translation.h>
+#include <messaging/network/pktio.h>
+#include <menabrea/input.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+#include <menabrea/exception.h>
+#include <event_machine.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Peer table entries hold the MAC address in the lower six bytes and a validity flag
+ * in the most significant bit so that they can be read and written atomically */
+#define PEER_ENTRY_VALID              ( 1ULL << 63 )
+#define ANNOUNCEMENT_PERIOD_NS        ODP_TIME_SEC_IN_NS
+
+typedef env_atomic64_t TPeerTable[MAX_NETWORK_INTERFACES][MAX_NODE_ID + 1];
+
+static void LoadPeerTable(const char * path);
+static void AnnouncementPoll(void * arg);
+static inline u64 MacToPeerEntry(const u8 * mac);
+static inline void PeerEntryToMac(u64 entry, u8 * mac);
+
+static bool s_nativeAddressing = false;
+static u8 s_ownMacAddrs[MAX_NETWORK_INTERFACES][MAC_ADDR_LEN];
+static int s_ifCount = 0;
+static TPeerTable * s_peerTable = NULL;
+static u64 s_lastAnnouncement = 0;
+
+void PeersInit(const SNetworkingConfig * config) {
+
+    s_nativeAddressing = config->Addressing == ENetworkAddressing_Native;
+    s_ifCount = config->DeviceCount;
+    if (!s_nativeAddressing) {
+
+        /* Peers are addressed implicitly based on their node IDs */
+        return;
+    }
+
+    LogPrint(ELogSeverityLevel_Info, "Using native MAC addresses, peers will be resolved at runtime");
+
+    for (int i = 0; i < s_ifCount; i++) {
+
+        /* Keep the address assigned to the interface */
+        GetMacAddress(config->DeviceNames[i], s_ownMacAddrs[i]);
+        LogPrint(ELogSeverityLevel_Info, "Interface '%s' has address %02x:%02x:%02x:%02x:%02x:%02x", \
+            config->DeviceNames[i], s_ownMacAddrs[i][0], s_ownMacAddrs[i][1], s_ownMacAddrs[i][2], \
+            s_ownMacAddrs[i][3], s_ownMacAddrs[i][4], s_ownMacAddrs[i][5]);
+    }
+
+    /* Place the table in shared memory so that what one core learns is seen by all */
+    s_peerTable = (TPeerTable *) env_shared_malloc(sizeof(TPeerTable));
+    AssertTrue(s_peerTable != NULL);
+    for (int i = 0; i < MAX_NETWORK_INTERFACES; i++) {
+
+        for (int j = 0; j <= MAX_NODE_ID; j++) {
+
+            env_atomic64_init(&(*s_peerTable)[i][j]);
+        }
+    }
+
+    if (config->PeerTable[0] != '\0') {
+
+        /* Prepopulate the table - the entries may still be updated by announcements */
+        LoadPeerTable(config->PeerTable);
+    }
+
+    /* Announce ourselves periodically for the peers to learn our addresses */
+    RegisterInputPolling(AnnouncementPoll, NULL, GetSharedCoreMask());
+}
+
+void PeersTeardown(void) {
+
+    if (s_peerTable != NULL) {
+
+        env_shared_free(s_peerTable);
+        s_peerTable = NULL;
+    }
+    s_nativeAddressing = false;
+    s_ifCount = 0;
+}
+
+bool IsNativeAddressingUsed(void) {
+
+    return s_nativeAddressing;
+}
+
+const u8 * GetOwnMacAddress(int ifIndex) {
+
+    return s_ownMacAddrs[ifIndex];
+}
+
+bool ResolvePeerMacAddress(int ifIndex, TWorkerId nodeId, u8 * mac) {
+
+    if (unlikely(nodeId < MIN_NODE_ID || nodeId > MAX_NODE_ID)) {
+
+        return false;
+    }
+
+    u64 entry = env_atomic64_get(&(*s_peerTable)[ifIndex][nodeId]);
+    if (unlikely(!(entry & PEER_ENTRY_VALID))) {
+
+        return false;
+    }
+
+    PeerEntryToMac(entry, mac);
+    return true;
+}
+
+void LearnPeerMacAddress(int ifIndex, TWorkerId nodeId, const u8 * mac) {
+
+    if (unlikely(nodeId < MIN_NODE_ID || nodeId > MAX_NODE_ID || nodeId == GetOwnNodeId())) {
+
+        return;
+    }
+
+    u64 entry = MacToPeerEntry(mac);
+    env_atomic64_t * slot = &(*s_peerTable)[ifIndex][nodeId];
+    /* Only write on change so as not to bounce the cache line between the cores */
+    u64 previous = env_atomic64_get(slot);
+    if (unlikely(previous != entry)) {
+
+        env_atomic64_set(slot, entry);
+        LogPrint(ELogSeverityLevel_Info, \
+            "Node %d reachable via interface %d at %02x:%02x:%02x:%02x:%02x:%02x", \
+            nodeId, ifIndex, mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    }
+}
+
+static void LoadPeerTable(const char * path) {
+
+    /* Peer table format: one entry per line - <node ID> <interface index> <MAC address>,
+     * empty lines and lines starting with '#' are ignored */
+
+    LogPrint(ELogSeverityLevel_Info, "Loading the peer table from '%s'...", path);
+
+    FILE * file = fopen(path, "r");
+    if (file == NULL) {
+
+        RaiseException(EExceptionFatality_Fatal, "Failed to open the peer table '%s'", path);
+    }
+
+    char line[128];
+    int lineNumber = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+
+        lineNumber++;
+        int nodeId;
+        int ifIndex;
+        u8 mac[MAC_ADDR_LEN];
+        char first;
+        if (1 != sscanf(line, " %c", &first) || first == '#') {
+
+            /* Skip empty lines and comments */
+            continue;
+        }
+
+        if (8 != sscanf(line, "%d %d %hhx:%hhx:%hhx:%hhx:%hhx:%hhx", &nodeId, &ifIndex, \
+            &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5])) {
+
+            RaiseException(EExceptionFatality_Fatal, "Malformed peer table entry at %s:%d", \
+                path, lineNumber);
+        }
+
+        if (ifIndex < 0 || ifIndex >= s_ifCount) {
+
+            LogPrint(ELogSeverityLevel_Warning, "%s(): Ignoring entry for unused interface %d at %s:%d", \
+                __FUNCTION__, ifIndex, path, lineNumber);
+            continue;
+        }
+
+        LearnPeerMacAddress(ifIndex, nodeId, mac);
+    }
+
+    AssertTrue(0 == fclose(file));
+}
+
+static void AnnouncementPoll(void * arg) {
+
+    (void) arg;
+
+    u64 now = odp_time_to_ns(odp_time_global());
+    if (likely(now - s_lastAnnouncement < ANNOUNCEMENT_PERIOD_NS)) {
+
+        return;
+    }
+    s_lastAnnouncement = now;
+
+    for (int i = 0; i < s_ifCount; i++) {
+
+        odp_packet_t packet = CreateAnnouncementPacket(i);
+        if (unlikely(packet == ODP_PACKET_INVALID)) {
+
+            /* Try again next period */
+            continue;
+        }
+
+        if (unlikely(0 != odp_queue_enq(GetPktoutQueue(i), odp_packet_to_event(packet)))) {
+
+            odp_packet_free(packet);
+        }
+    }
+}
+
+static inline u64 MacToPeerEntry(const u8 * mac) {
+
+    u64 entry = PEER_ENTRY_VALID;
+    for (int i = 0; i < MAC_ADDR_LEN; i++) {
+
+        entry |= (u64) mac[i] << (8 * i);
+    }
+    return entry;
+}
+
+static inline void PeerEntryToMac(u64 entry, u8 * mac) {
+
+    for (int i = 0; i < MAC_ADDR_LEN; i++) {
+
+        mac[i] = (u8) (entry >> (8 * i));
+    }
+}
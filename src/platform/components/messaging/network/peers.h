@@ -0,0 +1,17 @@
+
+#ifndef PLATFORM_COMPONENTS_MESSAGING_NETWORK_PEERS_H
+#define PLATFORM_COMPONENTS_MESSAGING_NETWORK_PEERS_H
+
+#include <messaging/network/setup.h>
+#include <menabrea/common.h>
+#include <menabrea/workers.h>
+#include <net/if.h>
+
+void PeersInit(const SNetworkingConfig * config);
+void PeersTeardown(void);
+bool IsNativeAddressingUsed(void);
+const u8 * GetOwnMacAddress(int ifIndex);
+bool ResolvePeerMacAddress(int ifIndex, TWorkerId nodeId, u8 * mac);
+void LearnPeerMacAddress(int ifIndex, TWorkerId nodeId, const u8 * mac);
+
+#endif /* PLATFORM_COMPONENTS_MESSAGING_NETWORK_PEERS_H */
@@ -5,56 +5,121 @@
 #include <event_machine.h>
 #include <event_machine/platform/event_machine_odp_ext.h>
 
+typedef struct SPktioDevice {
+    odp_pktio_t Pktio;
+    odp_pktin_queue_t PktinQueue;
+    odp_queue_t PktoutQueues[EM_MAX_CORES];
+    int PktoutQueueCount;
+} SPktioDevice;
+
 static em_pool_t CreatePacketPool(u32 bufCount);
 static odp_pktio_t CreatePktioDevice(const char * ifName, odp_pool_t odpPool);
-static void CreatePktioQueues(odp_pktio_t pktio);
+static void CreatePktioQueues(SPktioDevice * device);
+
+static SPktioDevice s_devices[MAX_NETWORK_INTERFACES];
+static int s_deviceCount = 0;
+/* Link status as last seen by the current core */
+static u32 s_linkUpMask = 0;
+static u64 s_lastLinkCheck = 0;
 
-static odp_pktio_t s_pktio;
-static odp_pktin_queue_t s_pktinQueue;
-static odp_queue_t s_pktoutQueue;
+#define PKTIO_POOL_BUF_SIZE      MAX_ETH_PACKET_SIZE
+#define LINK_CHECK_PERIOD_NS     (100 * ODP_TIME_MSEC_IN_NS)
 
-#define PKTIO_POOL_BUF_SIZE   MAX_ETH_PACKET_SIZE
+void PktioInit(const char ifNames[][IFNAMSIZ], int ifCount, u32 bufCount) {
 
-void PktioInit(const char * ifName, u32 bufCount) {
+    AssertTrue(ifCount > 0 && ifCount <= MAX_NETWORK_INTERFACES);
 
-    /* Create a packet pool */
+    /* Create a packet pool shared by all the devices */
     em_pool_t emPool = CreatePacketPool(bufCount);
 
     /* Convert to ODP pool */
     odp_pool_t odpPool;
     AssertTrue(1 == em_odp_pool2odp(emPool, &odpPool, 1));
 
-    /* Create a pktio device */
-    s_pktio = CreatePktioDevice(ifName, odpPool);
+    for (int i = 0; i < ifCount; i++) {
 
-    /* Create input and output queues */
-    CreatePktioQueues(s_pktio);
+        SPktioDevice * device = &s_devices[i];
+
+        /* Create a pktio device */
+        device->Pktio = CreatePktioDevice(ifNames[i], odpPool);
+
+        /* Create input and output queues */
+        CreatePktioQueues(device);
+
+        /* Start the PKTIO */
+        AssertTrue(0 == odp_pktio_start(device->Pktio));
 
-    /* Start the PKTIO */
-    AssertTrue(0 == odp_pktio_start(s_pktio));
+        /* Print out configuration */
+        odp_pktio_print(device->Pktio);
+    }
+    s_deviceCount = ifCount;
 
-    /* Print out configuration */
-    odp_pktio_print(s_pktio);
+    /* Assume all links up until the first check */
+    s_linkUpMask = (1 << ifCount) - 1;
 }
 
 void PktioTeardown(void) {
 
-    /* Stop the pktio device */
-    AssertTrue(0 == odp_pktio_stop(s_pktio));
-    AssertTrue(0 == odp_pktio_close(s_pktio));
+    for (int i = 0; i < s_deviceCount; i++) {
+
+        /* Stop the pktio device */
+        AssertTrue(0 == odp_pktio_stop(s_devices[i].Pktio));
+        AssertTrue(0 == odp_pktio_close(s_devices[i].Pktio));
+    }
+    s_deviceCount = 0;
 
     /* Delete the packet pool */
     AssertTrue(EM_OK == em_pool_delete(NETWORKING_PACKET_POOL));
 }
 
-odp_queue_t GetPktoutQueue(void) {
+int GetPktioCount(void) {
+
+    return s_deviceCount;
+}
+
+odp_queue_t GetPktoutQueue(int ifIndex) {
+
+    /* Bind each core to its own output queue if enough were available */
+    SPktioDevice * device = &s_devices[ifIndex];
+    return device->PktoutQueues[em_core_id() % device->PktoutQueueCount];
+}
+
+odp_pktin_queue_t GetPktinQueue(int ifIndex) {
 
-    return s_pktoutQueue;
+    return s_devices[ifIndex].PktinQueue;
 }
 
-odp_pktin_queue_t GetPktinQueue(void) {
+void RefreshLinkStatus(void) {
+
+    /* Querying the link status may involve a system call, so only
+     * do it periodically and cache the result on the current core */
+    u64 now = odp_time_to_ns(odp_time_global());
+    if (likely(now - s_lastLinkCheck < LINK_CHECK_PERIOD_NS)) {
+
+        return;
+    }
+    s_lastLinkCheck = now;
+
+    u32 linkUpMask = 0;
+    for (int i = 0; i < s_deviceCount; i++) {
+
+        if (odp_pktio_link_status(s_devices[i].Pktio) != ODP_PKTIO_LINK_STATUS_DOWN) {
+
+            linkUpMask |= (1 << i);
+        }
+    }
+
+    if (unlikely(linkUpMask != s_linkUpMask)) {
 
-    return s_pktinQueue;
+        LogPrint(ELogSeverityLevel_Warning, "Link status changed on core %d: 0x%x -> 0x%x", \
+            em_core_id(), s_linkUpMask, linkUpMask);
+        s_linkUpMask = linkUpMask;
+    }
+}
+
+u32 GetLinkUpMask(void) {
+
+    return s_linkUpMask;
 }
 
 static em_pool_t CreatePacketPool(u32 bufCount) {
@@ -114,7 +179,9 @@ static odp_pktio_t CreatePktioDevice(const char * ifName, odp_pool_t odpPool) {
     return pktio;
 }
 
-static void CreatePktioQueues(odp_pktio_t pktio) {
+static void CreatePktioQueues(SPktioDevice * device) {
+
+    odp_pktio_t pktio = device->Pktio;
 
     /* Configure input and output queues */
     odp_pktin_queue_param_t pktinQueueParams;
@@ -123,13 +190,25 @@ static void CreatePktioQueues(odp_pktio_t pktio) {
     pktinQueueParams.op_mode = ODP_PKTIO_OP_MT;
     AssertTrue(0 == odp_pktin_queue_config(pktio, &pktinQueueParams));
 
+    /* Try to give each core an output queue of its own */
+    odp_pktio_capability_t pktioCapa;
+    AssertTrue(0 == odp_pktio_capability(pktio, &pktioCapa));
+    int cores = em_core_count();
+    int pktoutQueueCount = (int) pktioCapa.max_output_queues < cores ? (int) pktioCapa.max_output_queues : cores;
+    AssertTrue(pktoutQueueCount > 0);
+
     odp_pktout_queue_param_t pktoutQueueParams;
     odp_pktout_queue_param_init(&pktoutQueueParams);
-    pktoutQueueParams.num_queues = 1;
-    pktoutQueueParams.op_mode = ODP_PKTIO_OP_MT;
+    pktoutQueueParams.num_queues = pktoutQueueCount;
+    /* Queues need not be thread-safe if not shared between cores */
+    pktoutQueueParams.op_mode = (pktoutQueueCount == cores) ? ODP_PKTIO_OP_MT_UNSAFE : ODP_PKTIO_OP_MT;
     AssertTrue(0 == odp_pktout_queue_config(pktio, &pktoutQueueParams));
 
+    LogPrint(ELogSeverityLevel_Debug, "Configured %d output queue(s) for pktio device %" PRIu64, \
+        pktoutQueueCount, odp_pktio_to_u64(pktio));
+
     /* Create input and output queues */
-    AssertTrue(1 == odp_pktin_queue(pktio, &s_pktinQueue, 1));
-    AssertTrue(1 == odp_pktout_event_queue(pktio, &s_pktoutQueue, 1));
+    AssertTrue(1 == odp_pktin_queue(pktio, &device->PktinQueue, 1));
+    AssertTrue(pktoutQueueCount == odp_pktout_event_queue(pktio, device->PktoutQueues, pktoutQueueCount));
+    device->PktoutQueueCount = pktoutQueueCount;
 }
@@ -2,15 +2,20 @@
 #ifndef PLATFORM_COMPONENTS_MESSAGING_NETWORK_PKTIO_H
 #define PLATFORM_COMPONENTS_MESSAGING_NETWORK_PKTIO_H
 
+#include <messaging/network/setup.h>
 #include <odp_api.h>
 #include <event_machine.h>
 #include <menabrea/common.h>
+#include <net/if.h>
 
 #define NETWORKING_PACKET_POOL  ( (em_pool_t) 11 )
 
-void PktioInit(const char * ifName, u32 bufCount);
+void PktioInit(const char ifNames[][IFNAMSIZ], int ifCount, u32 bufCount);
 void PktioTeardown(void);
-odp_queue_t GetPktoutQueue(void);
-odp_pktin_queue_t GetPktinQueue(void);
+int GetPktioCount(void);
+odp_queue_t GetPktoutQueue(int ifIndex);
+odp_pktin_queue_t GetPktinQueue(int ifIndex);
+void RefreshLinkStatus(void);
+u32 GetLinkUpMask(void);
 
 #endif /* PLATFORM_COMPONENTS_MESSAGING_NETWORK_PKTIO_H */
@@ -7,10 +7,16 @@
 #include <menabrea/messaging.h>
 
 static int EmOutputFunction(const em_event_t events[], const unsigned int num, const em_queue_t outputQueue, void *outputFnArgs);
+static inline int SelectInterface(TMessage message);
 
 static em_queue_t s_outputQueue = EM_QUEUE_UNDEF;
+static ENetworkPolicy s_policy = ENetworkPolicy_Failover;
 
-void RouterInit(void) {
+void RouterInit(ENetworkPolicy policy) {
+
+    s_policy = policy;
+    LogPrint(ELogSeverityLevel_Info, "Routing internode traffic over %d interface(s) using the %s policy", \
+        GetPktioCount(), policy == ENetworkPolicy_Stripe ? "striping" : "failover");
 
     LogPrint(ELogSeverityLevel_Info, "Creating the output queue...");
 
@@ -58,8 +64,10 @@ static int EmOutputFunction(const em_event_t events[], const unsigned int num, c
     /* em_send_multi() not used by the platform at the moment, use a simpler implementation */
     AssertTrue(1 == num);
 
+    /* Pick the path to the peer */
+    int ifIndex = SelectInterface(events[0]);
     /* Create ODP packet based on the event */
-    odp_packet_t packet = CreatePacketFromMessage(events[0]);
+    odp_packet_t packet = CreatePacketFromMessage(events[0], ifIndex);
     if (unlikely(packet == ODP_PACKET_INVALID)) {
 
         /* Failed to create the packet, it is the caller's responsibility
@@ -69,7 +77,7 @@ static int EmOutputFunction(const em_event_t events[], const unsigned int num, c
 
     AssertTrue(odp_packet_is_valid(packet));
     /* Send the event out an ODP queue */
-    if (unlikely(0 != odp_queue_enq(GetPktoutQueue(), odp_packet_to_event(packet)))) {
+    if (unlikely(0 != odp_queue_enq(GetPktoutQueue(ifIndex), odp_packet_to_event(packet)))) {
 
         LogPrint(ELogSeverityLevel_Error, "Failed to enqueue ODP packet");
         odp_packet_print(packet);
@@ -84,3 +92,31 @@ static int EmOutputFunction(const em_event_t events[], const unsigned int num, c
     em_free(events[0]);
     return 1;
 }
+
+static inline int SelectInterface(TMessage message) {
+
+    u32 linkUpMask = GetLinkUpMask();
+    if (unlikely(linkUpMask == 0)) {
+
+        /* All links down - keep trying the primary interface */
+        return 0;
+    }
+
+    if (s_policy == ENetworkPolicy_Failover) {
+
+        /* Use the first interface with its link up */
+        return __builtin_ctz(linkUpMask);
+    }
+
+    /* Hash the flow (sender-receiver pair) to preserve ordering within it */
+    u32 flow = ((u32) GetMessageSender(message) << 16) | GetMessageReceiver(message);
+    u32 hash = (flow * 0x9E3779B1) >> 16;
+    /* Pick the n-th interface with its link up */
+    int n = hash % __builtin_popcount(linkUpMask);
+    for (int i = 0; i < n; i++) {
+
+        /* Clear the lowest set bit */
+        linkUpMask &= linkUpMask - 1;
+    }
+    return __builtin_ctz(linkUpMask);
+}
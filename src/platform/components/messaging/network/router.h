@@ -4,7 +4,9 @@
 
 #include <menabrea/messaging.h>
 
-void RouterInit(void);
+#include <messaging/network/setup.h>
+
+void RouterInit(ENetworkPolicy policy);
 void RouterTeardown(void);
 void RouteInternodeMessage(TMessage message);
 
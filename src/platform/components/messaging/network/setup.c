@@ -1,9 +1,10 @@
 #include <messaging/network/mac_spoofing.h>
+#include <messaging/network/peers.h>
 #include <messaging/network/pktio.h>
 #include <messaging/network/router.h>
 #include <messaging/network/setup.h>
 #include <messaging/network/translation.h>
-#include <messaging/router.h>
+#include <messaging/local/router.h>
 #include <menabrea/input.h>
 #include <menabrea/cores.h>
 #include <menabrea/exception.h>
@@ -11,49 +12,40 @@
 #include <fcntl.h>
 #include <stdio.h>
 
-#define MAX_RX_BURST  32
-#define ORIGINAL_MAC_PATH  "/tmp/.original_mac"
+#define MAX_RX_BURST  MAX_TRANSLATION_BURST
+#define ORIGINAL_MAC_PATH_FORMAT  "/tmp/.original_mac_%s"
 
+static void SpoofMacAddress(const char * ifName, int ifIndex, TWorkerId nodeId);
 static void SaveMacInFile(const char * filename, const u8 * mac);
 static void NetworkInputPoll(void * arg);
 
-static u8 s_originalMacAddr[MAC_ADDR_LEN];
-static char s_ifName[IFNAMSIZ];
+static u8 s_originalMacAddrs[MAX_NETWORK_INTERFACES][MAC_ADDR_LEN];
+static char s_ifNames[MAX_NETWORK_INTERFACES][IFNAMSIZ];
+static int s_ifCount = 0;
+static bool s_spoofed = false;
 
 void MessagingNetworkInit(SNetworkingConfig * config) {
 
-    /* Store original MAC address and interface name (ensure proper NULL-termination) */
-    GetMacAddress(config->DeviceName, s_originalMacAddr);
-    (void) strncpy(s_ifName, config->DeviceName, sizeof(s_ifName) - 1);
-    s_ifName[sizeof(s_ifName) - 1] = '\0';
+    AssertTrue(config->DeviceCount > 0 && config->DeviceCount <= MAX_NETWORK_INTERFACES);
 
-    /* For emergency recovery purposes, store the MAC in a file as well */
-    SaveMacInFile(ORIGINAL_MAC_PATH, s_originalMacAddr);
-    /* On disgraceful shutdown restore the original MAC from the file... */
-    OnDisgracefulShutdown("ifconfig %s down", config->DeviceName);
-    OnDisgracefulShutdown("xargs ifconfig %s hw ether < %s", config->DeviceName, ORIGINAL_MAC_PATH);
-    OnDisgracefulShutdown("ifconfig %s up", config->DeviceName);
-    /* ...and clean up the file (if we crashed before registering this
-     * the file would linger, but we do not care, it is overwritten each
-     * time anyway) */
-    OnDisgracefulShutdown("rm %s", ORIGINAL_MAC_PATH);
+    s_ifCount = config->DeviceCount;
+    s_spoofed = config->Addressing == ENetworkAddressing_Spoofed;
+    if (s_spoofed) {
 
-    /* Set new address*/
-    u8 macAddr[MAC_ADDR_LEN] = {
-        MAC_ADDR_COMMON_BASE_BYTE_0,
-        MAC_ADDR_COMMON_BASE_BYTE_1,
-        MAC_ADDR_COMMON_BASE_BYTE_2,
-        MAC_ADDR_COMMON_BASE_BYTE_3,
-        MAC_ADDR_COMMON_BASE_BYTE_4,
-        (u8)(config->NodeId & 0xFF)
-    };
-    SetMacAddress(config->DeviceName, macAddr);
+        for (int i = 0; i < config->DeviceCount; i++) {
+
+            SpoofMacAddress(config->DeviceNames[i], i, config->NodeId);
+        }
+    }
+
+    /* Set up peer address resolution (if required) */
+    PeersInit(config);
 
     /* Initialize pktio */
-    PktioInit(config->DeviceName, config->PktioBufs);
+    PktioInit((const char (*)[IFNAMSIZ]) config->DeviceNames, config->DeviceCount, config->PktioBufs);
 
     /* Initialize the TX path */
-    RouterInit();
+    RouterInit(config->Policy);
 
     /* Register an input poll callback */
     RegisterInputPolling(NetworkInputPoll, NULL, GetAllCoresMask());
@@ -63,16 +55,57 @@ void MessagingNetworkTeardown(void) {
 
     RouterTeardown();
     PktioTeardown();
-    /* Restore original MAC address */
-    SetMacAddress(s_ifName, s_originalMacAddr);
-    /* Remove the file storing it in case of disgraceful shutdown */
-    AssertTrue(0 == unlink(ORIGINAL_MAC_PATH));
+    PeersTeardown();
+
+    /* Nothing to restore if the native addresses were used */
+    for (int i = 0; s_spoofed && i < s_ifCount; i++) {
+
+        /* Restore original MAC address */
+        SetMacAddress(s_ifNames[i], s_originalMacAddrs[i]);
+        /* Remove the file storing it in case of disgraceful shutdown */
+        char path[sizeof(ORIGINAL_MAC_PATH_FORMAT) + IFNAMSIZ];
+        (void) snprintf(path, sizeof(path), ORIGINAL_MAC_PATH_FORMAT, s_ifNames[i]);
+        AssertTrue(0 == unlink(path));
+    }
+    s_ifCount = 0;
+}
+
+static void SpoofMacAddress(const char * ifName, int ifIndex, TWorkerId nodeId) {
+
+    /* Store original MAC address and interface name (ensure proper NULL-termination) */
+    GetMacAddress(ifName, s_originalMacAddrs[ifIndex]);
+    (void) strncpy(s_ifNames[ifIndex], ifName, IFNAMSIZ - 1);
+    s_ifNames[ifIndex][IFNAMSIZ - 1] = '\0';
+
+    /* For emergency recovery purposes, store the MAC in a file as well */
+    char path[sizeof(ORIGINAL_MAC_PATH_FORMAT) + IFNAMSIZ];
+    (void) snprintf(path, sizeof(path), ORIGINAL_MAC_PATH_FORMAT, ifName);
+    SaveMacInFile(path, s_originalMacAddrs[ifIndex]);
+    /* On disgraceful shutdown restore the original MAC from the file... */
+    OnDisgracefulShutdown("ifconfig %s down", ifName);
+    OnDisgracefulShutdown("xargs ifconfig %s hw ether < %s", ifName, path);
+    OnDisgracefulShutdown("ifconfig %s up", ifName);
+    /* ...and clean up the file (if we crashed before registering this
+     * the file would linger, but we do not care, it is overwritten each
+     * time anyway) */
+    OnDisgracefulShutdown("rm %s", path);
+
+    /* Set new address*/
+    u8 macAddr[MAC_ADDR_LEN] = {
+        MAC_ADDR_COMMON_BASE_BYTE_0,
+        MAC_ADDR_COMMON_BASE_BYTE_1,
+        MAC_ADDR_COMMON_BASE_BYTE_2,
+        MAC_ADDR_COMMON_BASE_BYTE_3,
+        MAC_ADDR_INTERFACE_BYTE_4(ifIndex),
+        (u8)(nodeId & 0xFF)
+    };
+    SetMacAddress(ifName, macAddr);
 }
 
 static void SaveMacInFile(const char * filename, const u8 * mac) {
 
     /* Open the file using open instead of fopen to have strict control over permissions */
-    int fd = open(ORIGINAL_MAC_PATH, O_WRONLY | O_TRUNC | O_CREAT, S_IRWXU);
+    int fd = open(filename, O_WRONLY | O_TRUNC | O_CREAT, S_IRWXU);
     AssertTrue(fd != -1);
     /* Write the MAC address to it */
     int charsWritten = dprintf(fd, "%02x:%02x:%02x:%02x:%02x:%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
@@ -85,18 +118,26 @@ static void NetworkInputPoll(void * arg) {
 
     (void) arg;
 
-    odp_packet_t packets[MAX_RX_BURST];
-    int packetsReceived = odp_pktin_recv(GetPktinQueue(), packets, MAX_RX_BURST);
-    for (int i = 0; i < packetsReceived; i++) {
+    /* Keep track of the links to steer the TX path away from the ones that are down */
+    RefreshLinkStatus();
+
+    /* Poll all the interfaces */
+    for (int i = 0; i < s_ifCount; i++) {
 
-        odp_packet_t packet = packets[i];
-        TMessage message = CreateMessageFromPacket(packet);
-        if (likely(message != MESSAGE_INVALID)) {
+        odp_packet_t packets[MAX_RX_BURST];
+        TMessage messages[MAX_RX_BURST];
+        int packetsReceived = odp_pktin_recv(GetPktinQueue(i), packets, MAX_RX_BURST);
+        if (packetsReceived <= 0) {
 
-            /* Route the event/message locally */
-            RouteMessage(message);
+            continue;
         }
 
-        odp_packet_free(packet);
+        /* Validate and translate the entire burst at once */
+        int messagesCreated = CreateMessagesFromPackets(packets, packetsReceived, messages, i);
+        /* The data has been copied, release the packets */
+        odp_packet_free_multi(packets, packetsReceived);
+        /* Only messages addressed to this node pass validation - route them
+         * locally, grouped by receiver */
+        RouteIntranodeMessages(messages, messagesCreated);
     }
 }
@@ -5,11 +5,28 @@
 #include <menabrea/workers.h>
 #include <event_machine.h>
 #include <net/if.h>
+#include <limits.h>
+
+#define MAX_NETWORK_INTERFACES  4
+
+typedef enum ENetworkPolicy {
+    ENetworkPolicy_Failover = 0,  /* Use the first interface with its link up */
+    ENetworkPolicy_Stripe         /* Spread flows across all interfaces with their links up */
+} ENetworkPolicy;
+
+typedef enum ENetworkAddressing {
+    ENetworkAddressing_Spoofed = 0,  /* Rewrite the interface MACs to encode the node ID */
+    ENetworkAddressing_Native        /* Keep the native MACs and resolve the peers at runtime */
+} ENetworkAddressing;
 
 typedef struct SNetworkingConfig {
     u32 PktioBufs;
     TWorkerId NodeId;
-    char DeviceName[IFNAMSIZ];
+    int DeviceCount;
+    char DeviceNames[MAX_NETWORK_INTERFACES][IFNAMSIZ];
+    ENetworkPolicy Policy;
+    ENetworkAddressing Addressing;
+    char PeerTable[PATH_MAX];
 } SNetworkingConfig;
 
 void MessagingNetworkInit(SNetworkingConfig * config);
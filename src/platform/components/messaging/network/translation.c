@@ -1,7 +1,10 @@
 #include <messaging/network/translation.h>
 #include <messaging/network/mac_spoofing.h>
 #include <messaging/network/pktio.h>
+#include <messaging/network/peers.h>
 #include <messaging/message.h>
+#include <workers/worker_table.h>
+#include <overload/overload.h>
 #include <menabrea/workers.h>
 #include <menabrea/messaging.h>
 #include <menabrea/log.h>
@@ -9,7 +12,11 @@
 #include <odp/helper/odph_api.h>
 #include <event_machine/platform/event_machine_odp_ext.h>
 
-#define LLC_HEADER_LEN  4
+#define LLC_HEADER_LEN             4
+/* Reuse the (otherwise unused) LLC control field to tell announcements apart from messages */
+#define LLC_CONTROL_MESSAGE        0
+#define LLC_CONTROL_ANNOUNCEMENT   1
+#define ANNOUNCEMENT_MAGIC         0x414E4E43
 
 typedef struct SLlcHeader {
     u8 Dsap;
@@ -20,13 +27,22 @@ typedef struct SLlcHeader {
 ODP_STATIC_ASSERT(sizeof(SLlcHeader) == LLC_HEADER_LEN, \
     "Logical Link Control header size inconsistent");
 
-static inline void FillInEthHeader(odp_packet_t packet, TWorkerId messageReceiver);
-static inline void FillInLlcHeader(odp_packet_t packet);
+typedef struct SAnnouncement {
+    u32 Magic;
+    TWorkerId NodeId;
+    u16 Reserved;
+} SAnnouncement;
+
+static inline void FillInEthHeader(odp_packet_t packet, TWorkerId messageReceiver, int ifIndex);
+static inline void FillInLlcHeader(odp_packet_t packet, u16 control);
 static inline void CopyMessageData(odp_packet_t packet, TMessage message);
 static inline bool IsValidEthHeader(odp_packet_t packet);
+static inline bool IsValidNativeEthHeader(odp_packet_t packet, int ifIndex);
 static inline bool IsValidLlcHeader(odp_packet_t packet);
+static inline bool IsAnnouncement(odp_packet_t packet);
+static void HandleAnnouncement(odp_packet_t packet, int ifIndex);
 
-odp_packet_t CreatePacketFromMessage(TMessage message) {
+odp_packet_t CreatePacketFromMessage(TMessage message, int ifIndex) {
 
     /* Calculate total size of the message */
     u32 messageSize = GetMessagePayloadSize(message) + MESSAGE_HEADER_LEN;
@@ -47,67 +63,149 @@ odp_packet_t CreatePacketFromMessage(TMessage message) {
     /* Convert EM event to ODP packet */
     odp_packet_t packet = odp_packet_from_event(em_odp_event2odp(packetEvent));
     /* Fill in the Ethernet and LLC headers */
-    FillInEthHeader(packet, GetMessageReceiver(message));
-    FillInLlcHeader(packet);
+    FillInEthHeader(packet, GetMessageReceiver(message), ifIndex);
+    FillInLlcHeader(packet, LLC_CONTROL_MESSAGE);
     /* Copy the message */
     CopyMessageData(packet, message);
 
     return packet;
 }
 
-TMessage CreateMessageFromPacket(odp_packet_t packet) {
-
-    /* Get length of the packet */
-    u32 packetLen = odp_packet_len(packet);
-    /* The packet shouldn't have got here without a valid Ethernet header */
-    AssertTrue(packetLen >= ODPH_ETHHDR_LEN);
+odp_packet_t CreateAnnouncementPacket(int ifIndex) {
 
-    /* Validate the headers */
-    if (unlikely(!IsValidEthHeader(packet) || !IsValidLlcHeader(packet))) {
+    u32 packetSize = ODPH_ETHHDR_LEN + LLC_HEADER_LEN + sizeof(SAnnouncement);
+    em_event_t packetEvent = em_alloc(packetSize, EM_EVENT_TYPE_PACKET, NETWORKING_PACKET_POOL);
+    if (unlikely(packetEvent == EM_EVENT_UNDEF)) {
 
-        /* Invalid header(s) */
-        return MESSAGE_INVALID;
+        LogPrint(ELogSeverityLevel_Warning, "%s(): Failed to allocate ODP packet for an announcement on interface %d", \
+            __FUNCTION__, ifIndex);
+        return ODP_PACKET_INVALID;
     }
 
-    /* Strip Ethernet and LLC headers */
-    u32 dataLen = packetLen - ODPH_ETHHDR_LEN - LLC_HEADER_LEN;
-    odph_ethhdr_t * ethHeader = odp_packet_data(packet);
-    SLlcHeader * llcHeader = (SLlcHeader *)(ethHeader + 1);
-    SMessage * messageData = (SMessage *)(llcHeader + 1);
-    /* Validate the message */
-    if (unlikely(!IsValidMessage(messageData, dataLen))) {
-
-        LogPrint(ELogSeverityLevel_Warning, \
-            "Malformed ODP packet from %02x:%02x:%02x:%02x:%02x:%02x - data len (no LLC): %d", \
-            ethHeader->src.addr[0], ethHeader->src.addr[1], ethHeader->src.addr[2], \
-            ethHeader->src.addr[3], ethHeader->src.addr[4], ethHeader->src.addr[5], \
-            dataLen);
-        return MESSAGE_INVALID;
+    odp_packet_t packet = odp_packet_from_event(em_odp_event2odp(packetEvent));
+    odph_ethhdr_t * eth = odp_packet_data(packet);
+    /* Broadcast the announcement on the segment */
+    (void) memset(eth->dst.addr, 0xFF, MAC_ADDR_LEN);
+    (void) memcpy(eth->src.addr, GetOwnMacAddress(ifIndex), MAC_ADDR_LEN);
+    eth->type = odp_cpu_to_be_16(packetSize - ODPH_ETHHDR_LEN);
+    FillInLlcHeader(packet, LLC_CONTROL_ANNOUNCEMENT);
+
+    SAnnouncement * announcement = (SAnnouncement *)((u8 *)(eth + 1) + LLC_HEADER_LEN);
+    announcement->Magic = ANNOUNCEMENT_MAGIC;
+    announcement->NodeId = GetOwnNodeId();
+    announcement->Reserved = 0;
+
+    return packet;
+}
+
+int CreateMessagesFromPackets(const odp_packet_t packets[], int count, TMessage messages[], int ifIndex) {
+
+    AssertTrue(count <= MAX_TRANSLATION_BURST);
+
+    void * buffers[MAX_TRANSLATION_BURST];
+    int validCount = 0;
+
+    /* First pass - validate the headers of the entire burst */
+    for (int i = 0; i < count; i++) {
+
+        odp_packet_t packet = packets[i];
+        /* Get length of the packet */
+        u32 packetLen = odp_packet_len(packet);
+        /* The packet shouldn't have got here without a valid Ethernet header */
+        AssertTrue(packetLen >= ODPH_ETHHDR_LEN);
+
+        if (unlikely(IsAnnouncement(packet))) {
+
+            /* Not a message, but a peer advertising its address */
+            HandleAnnouncement(packet, ifIndex);
+            continue;
+        }
+
+        /* Validate the headers */
+        bool validEthHeader = IsNativeAddressingUsed() ? \
+            IsValidNativeEthHeader(packet, ifIndex) : IsValidEthHeader(packet);
+        if (unlikely(!validEthHeader || !IsValidLlcHeader(packet))) {
+
+            /* Invalid header(s) */
+            continue;
+        }
+
+        /* Strip Ethernet and LLC headers */
+        u32 dataLen = packetLen - ODPH_ETHHDR_LEN - LLC_HEADER_LEN;
+        odph_ethhdr_t * ethHeader = odp_packet_data(packet);
+        SLlcHeader * llcHeader = (SLlcHeader *)(ethHeader + 1);
+        SMessage * messageData = (SMessage *)(llcHeader + 1);
+        /* Validate the message */
+        if (unlikely(!IsValidMessage(messageData, dataLen))) {
+
+            LogPrint(ELogSeverityLevel_Warning, \
+                "Malformed ODP packet from %02x:%02x:%02x:%02x:%02x:%02x - data len (no LLC): %d", \
+                ethHeader->src.addr[0], ethHeader->src.addr[1], ethHeader->src.addr[2], \
+                ethHeader->src.addr[3], ethHeader->src.addr[4], ethHeader->src.addr[5], \
+                dataLen);
+            continue;
+        }
+
+        if (IsNativeAddressingUsed()) {
+
+            /* Learn the sender's address from the traffic itself */
+            LearnPeerMacAddress(ifIndex, WorkerIdGetNode(messageData->Header.Sender), ethHeader->src.addr);
+        }
+
+        SWorkerContext * receiverContext = FetchWorkerContext(messageData->Header.Receiver);
+        if (IsDeadlineExpired(messageData->Header.Deadline)) {
+
+            /* Message expired in flight, drop it before allocating any local resources */
+            Atomic32Inc(&receiverContext->ExpiredMessages);
+            continue;
+        }
+
+        if (unlikely(ShouldShedTraffic(FetchWorkerRoute(messageData->Header.Receiver)->SheddingLevel))) {
+
+            /* Node overloaded - shed the traffic at ingress, before allocating any local resources */
+            Atomic32Inc(&receiverContext->ShedMessages);
+            continue;
+        }
+
+        buffers[validCount++] = messageData;
     }
 
-    TMessage message = CreateMessageFromBuffer(messageData);
-    if (unlikely(message == MESSAGE_INVALID)) {
+    /* Second pass - allocate local events in bulk and copy the messages */
+    int created = CreateMessagesFromBuffers(buffers, validCount, messages);
+    if (unlikely(created < validCount)) {
 
         LogPrint(ELogSeverityLevel_Error, \
-            "Failed to allocate a local event for inbound packet (message ID: 0x%x, sender: 0x%x, receiver: 0x%x)", \
-            messageData->Header.MessageId, messageData->Header.Sender, messageData->Header.Receiver);
-
-        /* Fall through and return MESSAGE_INVALID */
+            "Failed to allocate local events for %d out of %d inbound packets", \
+            validCount - created, validCount);
     }
 
-    return message;
+    return created;
 }
 
-static inline void FillInEthHeader(odp_packet_t packet, TWorkerId messageReceiver) {
+static inline void FillInEthHeader(odp_packet_t packet, TWorkerId messageReceiver, int ifIndex) {
 
     odph_ethhdr_t * eth = odp_packet_data(packet);
 
+    if (IsNativeAddressingUsed()) {
+
+        (void) memcpy(eth->src.addr, GetOwnMacAddress(ifIndex), MAC_ADDR_LEN);
+        if (unlikely(!ResolvePeerMacAddress(ifIndex, WorkerIdGetNode(messageReceiver), eth->dst.addr))) {
+
+            /* Peer not known yet - broadcast the frame, the receiver node
+             * is validated on the receiving side anyway */
+            (void) memset(eth->dst.addr, 0xFF, MAC_ADDR_LEN);
+        }
+        /* Set the payload length in network endianness */
+        eth->type = odp_cpu_to_be_16(odp_packet_len(packet) - ODPH_ETHHDR_LEN);
+        return;
+    }
+
     /* Set the destination MAC address */
     eth->dst.addr[0] = MAC_ADDR_COMMON_BASE_BYTE_0;
     eth->dst.addr[1] = MAC_ADDR_COMMON_BASE_BYTE_1;
     eth->dst.addr[2] = MAC_ADDR_COMMON_BASE_BYTE_2;
     eth->dst.addr[3] = MAC_ADDR_COMMON_BASE_BYTE_3;
-    eth->dst.addr[4] = MAC_ADDR_COMMON_BASE_BYTE_4;
+    eth->dst.addr[4] = MAC_ADDR_INTERFACE_BYTE_4(ifIndex);
     eth->dst.addr[5] = (u8) (WorkerIdGetNode(messageReceiver) & 0xFF);
 
     /* Set the source MAC address */
@@ -115,22 +213,22 @@ static inline void FillInEthHeader(odp_packet_t packet, TWorkerId messageReceive
     eth->src.addr[1] = MAC_ADDR_COMMON_BASE_BYTE_1;
     eth->src.addr[2] = MAC_ADDR_COMMON_BASE_BYTE_2;
     eth->src.addr[3] = MAC_ADDR_COMMON_BASE_BYTE_3;
-    eth->src.addr[4] = MAC_ADDR_COMMON_BASE_BYTE_4;
+    eth->src.addr[4] = MAC_ADDR_INTERFACE_BYTE_4(ifIndex);
     eth->src.addr[5] = (u8) (GetOwnNodeId() & 0xFF);
 
     /* Set the payload length in network endianness */
     eth->type = odp_cpu_to_be_16(odp_packet_len(packet) - ODPH_ETHHDR_LEN);
 }
 
-static inline void FillInLlcHeader(odp_packet_t packet) {
+static inline void FillInLlcHeader(odp_packet_t packet, u16 control) {
 
     odph_ethhdr_t * eth = odp_packet_data(packet);
     SLlcHeader * llc = (SLlcHeader *)(eth + 1);
 
-    /* NULL DSAP, SSAP, and control fields */
+    /* NULL DSAP and SSAP fields */
     llc->Dsap = 0;
     llc->Ssap = 0;
-    llc->Control = 0;
+    llc->Control = control;
 }
 
 static inline void CopyMessageData(odp_packet_t packet, TMessage message) {
@@ -154,22 +252,65 @@ static inline bool IsValidEthHeader(odp_packet_t packet) {
         eth->src.addr[1] == MAC_ADDR_COMMON_BASE_BYTE_1 && \
         eth->src.addr[2] == MAC_ADDR_COMMON_BASE_BYTE_2 && \
         eth->src.addr[3] == MAC_ADDR_COMMON_BASE_BYTE_3 && \
-        eth->src.addr[4] == MAC_ADDR_COMMON_BASE_BYTE_4 && \
+        eth->src.addr[4] >= MAC_ADDR_INTERFACE_BYTE_4(0) && \
+        eth->src.addr[4] < MAC_ADDR_INTERFACE_BYTE_4(MAX_NETWORK_INTERFACES) && \
         eth->src.addr[5] >= MIN_NODE_ID && eth->src.addr[5] <= MAX_NODE_ID && \
         /* Drop broadcast packets etc. */
         eth->dst.addr[0] == MAC_ADDR_COMMON_BASE_BYTE_0 && \
         eth->dst.addr[1] == MAC_ADDR_COMMON_BASE_BYTE_1 && \
         eth->dst.addr[2] == MAC_ADDR_COMMON_BASE_BYTE_2 && \
         eth->dst.addr[3] == MAC_ADDR_COMMON_BASE_BYTE_3 && \
-        eth->dst.addr[4] == MAC_ADDR_COMMON_BASE_BYTE_4 && \
+        /* Frames are always exchanged between interfaces with the same index */
+        eth->dst.addr[4] == eth->src.addr[4] && \
         eth->dst.addr[5] == (u8) (GetOwnNodeId() & 0xFF);
 }
 
+static inline bool IsValidNativeEthHeader(odp_packet_t packet, int ifIndex) {
+
+    static const u8 broadcast[MAC_ADDR_LEN] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+    odph_ethhdr_t * eth = odp_packet_data(packet);
+    /* Peers cannot be told apart by their addresses here - accept frames addressed to
+     * this interface or broadcast (from peers not having learnt our address yet) and
+     * rely on the LLC and message header validation to filter out foreign traffic */
+    return 0 == memcmp(eth->dst.addr, GetOwnMacAddress(ifIndex), MAC_ADDR_LEN) || \
+        0 == memcmp(eth->dst.addr, broadcast, MAC_ADDR_LEN);
+}
+
 static inline bool IsValidLlcHeader(odp_packet_t packet) {
 
     odph_ethhdr_t * eth = odp_packet_data(packet);
     SLlcHeader * llc = (SLlcHeader *)(eth + 1);
     /* Make sure packet is long enough before accessing the LLC header */
     return odp_packet_len(packet) >= ODPH_ETHHDR_LEN + LLC_HEADER_LEN && \
-        llc->Dsap == 0 && llc->Ssap == 0 && llc->Control == 0;
+        llc->Dsap == 0 && llc->Ssap == 0 && llc->Control == LLC_CONTROL_MESSAGE;
+}
+
+static inline bool IsAnnouncement(odp_packet_t packet) {
+
+    odph_ethhdr_t * eth = odp_packet_data(packet);
+    SLlcHeader * llc = (SLlcHeader *)(eth + 1);
+    /* Make sure packet is long enough before accessing the LLC header */
+    return odp_packet_len(packet) >= ODPH_ETHHDR_LEN + LLC_HEADER_LEN && \
+        llc->Dsap == 0 && llc->Ssap == 0 && llc->Control == LLC_CONTROL_ANNOUNCEMENT;
+}
+
+static void HandleAnnouncement(odp_packet_t packet, int ifIndex) {
+
+    if (!IsNativeAddressingUsed()) {
+
+        /* Peers are addressed implicitly, nothing to learn */
+        return;
+    }
+
+    if (unlikely(odp_packet_len(packet) < ODPH_ETHHDR_LEN + LLC_HEADER_LEN + sizeof(SAnnouncement))) {
+
+        return;
+    }
+
+    odph_ethhdr_t * eth = odp_packet_data(packet);
+    SAnnouncement * announcement = (SAnnouncement *)((u8 *)(eth + 1) + LLC_HEADER_LEN);
+    if (likely(announcement->Magic == ANNOUNCEMENT_MAGIC)) {
+
+        LearnPeerMacAddress(ifIndex, announcement->NodeId, eth->src.addr);
+    }
 }
@@ -5,9 +5,11 @@
 #include <menabrea/messaging.h>
 #include <odp_api.h>
 
-#define MAX_ETH_PACKET_SIZE  1500
+#define MAX_ETH_PACKET_SIZE    1500
+#define MAX_TRANSLATION_BURST  32
 
-odp_packet_t CreatePacketFromMessage(TMessage message);
-TMessage CreateMessageFromPacket(odp_packet_t packet);
+odp_packet_t CreatePacketFromMessage(TMessage message, int ifIndex);
+odp_packet_t CreateAnnouncementPacket(int ifIndex);
+int CreateMessagesFromPackets(const odp_packet_t packets[], int count, TMessage messages[], int ifIndex);
 
 #endif /* PLATFORM_COMPONENTS_MESSAGING_NETWORK_TRANSLATION_H */
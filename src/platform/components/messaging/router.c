@@ -1,53 +1,90 @@
 #include <messaging/router.h>
 #include <messaging/local/router.h>
+#include <messaging/local/coalescing.h>
 #include <messaging/network/router.h>
 #include <messaging/message.h>
 #include <workers/worker_table.h>
+#include <workers/completion_daemon.h>
 #include <menabrea/exception.h>
 #include <menabrea/log.h>
 #include <event_machine.h>
 
+static bool StampMessage(TMessage message, TWorkerId receiver);
+
 void SendMessage(TMessage message, TWorkerId receiver) {
 
-    if (unlikely(message == MESSAGE_INVALID)) {
+    if (likely(StampMessage(message, receiver))) {
+
+        RouteMessage(message);
+    }
+}
+
+TMessageGroup CreateMessageGroup(int count, TMessage completion, TWorkerId receiver) {
+
+    if (unlikely(completion == MESSAGE_INVALID || count < 0)) {
 
         RaiseException(EExceptionFatality_NonFatal, \
-            "Tried sending MESSAGE_INVALID to 0x%x", \
-            receiver);
-        return;
+            "Invalid message group of %d message(s) or no completion message given", \
+            count);
+        if (completion != MESSAGE_INVALID) {
+
+            DestroyMessage(completion);
+        }
+        return MESSAGE_GROUP_INVALID;
     }
 
-    if (unlikely(receiver == WORKER_ID_INVALID || WorkerIdGetLocal(receiver) >= MAX_WORKER_COUNT || WorkerIdGetNode(receiver) < MIN_NODE_ID || WorkerIdGetNode(receiver) > MAX_NODE_ID)) {
+    em_event_group_t eventGroup = CreateCompletionGroup(count, completion, receiver);
+    if (unlikely(eventGroup == EM_EVENT_GROUP_UNDEF)) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to create a group of %d message(s)", \
+            __FUNCTION__, count);
+        DestroyMessage(completion);
+        return MESSAGE_GROUP_INVALID;
+    }
+
+    return eventGroup;
+}
+
+void SendMessageInGroup(TMessage message, TWorkerId receiver, TMessageGroup group) {
+
+    if (unlikely(group == MESSAGE_GROUP_INVALID)) {
 
         RaiseException(EExceptionFatality_NonFatal, \
-            "Invalid receiver 0x%x of message 0x%x. Message not sent!", \
-            receiver, GetMessageId(message));
-        DestroyMessage(message);
+            "Tried sending a message to 0x%x in an invalid group", \
+            receiver);
+        if (message != MESSAGE_INVALID) {
+
+            DestroyMessage(message);
+        }
         return;
     }
 
-    em_eo_t self = em_eo_current();
+    if (unlikely(!StampMessage(message, receiver))) {
 
-    /* Access the message based on the descriptor (event) */
-    SMessage * msgData = (SMessage *) em_event_pointer(message);
+        /* Message not sent, but it still counts towards the group's completion */
+        if (unlikely(0 != CountTowardsCompletion(group))) {
 
-    if (self != EM_EO_UNDEF && NULL != em_eo_get_context(self)) {
+            LogPrint(ELogSeverityLevel_Error, "%s(): Failed to account for a message not sent to 0x%x - group will not complete", \
+                __FUNCTION__, receiver);
+        }
+        return;
+    }
 
-        /* Sending a message from a worker context */
+    if (WorkerIdGetNode(receiver) == GetOwnNodeId()) {
 
-        SWorkerContext * context = (SWorkerContext *) em_eo_get_context(self);
-        /* Set the sender based on the current context */
-        msgData->Header.Sender = context->WorkerId;
+        /* Skip coalescing - the message must be sent in the group */
+        RouteIntranodeMessageInGroup(message, group);
 
     } else {
 
-        /* Allow sending a message from a non-EO context or from a raw EO
-         * not associated with a worker context (used by platform internally) */
-        msgData->Header.Sender = WORKER_ID_INVALID;
-    }
-    msgData->Header.Receiver = receiver;
+        /* Consumption by a remote worker cannot be tracked - count the message as soon as it is sent */
+        RouteMessage(message);
+        if (unlikely(0 != CountTowardsCompletion(group))) {
 
-    RouteMessage(message);
+            LogPrint(ELogSeverityLevel_Error, "%s(): Failed to account for a message sent to remote worker 0x%x - group will not complete", \
+                __FUNCTION__, receiver);
+        }
+    }
 }
 
 void RouteMessage(TMessage message) {
@@ -59,12 +96,76 @@ void RouteMessage(TMessage message) {
 
         /* Worker local to the current node - enqueue the message via EM */
 
-        RouteIntranodeMessage(message);
+        if (IsSendCoalescingActive()) {
+
+            /* Sending from a worker body with coalescing enabled - defer
+             * the enqueue until the body returns */
+            StageMessage(message);
+
+        } else {
+
+            RouteIntranodeMessage(message);
+        }
 
     } else {
 
         /* Remote worker - push the message out a network interface */
 
+        if (unlikely(GetMessageAttachments(message)->Count > 0)) {
+
+            /* Runtime memory is local to the node and cannot be passed by reference */
+            RaiseException(EExceptionFatality_NonFatal, \
+                "Message 0x%x to remote worker 0x%x has runtime memory attached. Message not sent!", \
+                msgData->Header.MessageId, receiver);
+            DestroyMessage(message);
+            return;
+        }
+
         RouteInternodeMessage(message);
     }
 }
+
+static bool StampMessage(TMessage message, TWorkerId receiver) {
+
+    if (unlikely(message == MESSAGE_INVALID)) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Tried sending MESSAGE_INVALID to 0x%x", \
+            receiver);
+        return false;
+    }
+
+    if (unlikely(receiver == WORKER_ID_INVALID || WorkerIdGetLocal(receiver) >= MAX_WORKER_COUNT || WorkerIdGetNode(receiver) < MIN_NODE_ID || WorkerIdGetNode(receiver) > MAX_NODE_ID)) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Invalid receiver 0x%x of message 0x%x. Message not sent!", \
+            receiver, GetMessageId(message));
+        DestroyMessage(message);
+        return false;
+    }
+
+    /* Access the message based on the descriptor (event) */
+    SMessage * msgData = (SMessage *) em_event_pointer(message);
+
+    SWorkerContext * context = GetCurrentWorkerContext();
+    if (context != NULL) {
+
+        /* Sending a message from a worker context */
+
+        /* Set the sender based on the current context */
+        msgData->Header.Sender = context->WorkerId;
+        /* Each core only ever updates its own statistics entry */
+        SWorkerStatistics * statistics = &context->Statistics[em_core_id()].Counters;
+        statistics->MessagesSent++;
+        statistics->BytesSent += msgData->Header.PayloadSize;
+
+    } else {
+
+        /* Allow sending a message from a non-EO context or from a raw EO
+         * not associated with a worker context (used by platform internally) */
+        msgData->Header.Sender = WORKER_ID_INVALID;
+    }
+    msgData->Header.Receiver = receiver;
+
+    return true;
+}
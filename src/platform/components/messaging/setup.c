@@ -1,9 +1,13 @@
 #include <messaging/setup.h>
+#include <messaging/message.h>
 #include <menabrea/exception.h>
 #include <menabrea/log.h>
 
 void MessagingInit(SMessagingConfig * config) {
 
+    /* Reserve event user area for the runtime memory attached to messages */
+    config->PoolConfig.user_area.in_use = true;
+    config->PoolConfig.user_area.size = sizeof(SMessageAttachments);
     /* Create custom event pool */
     AssertTrue(MESSAGING_EVENT_POOL == em_pool_create("messaging_pool", MESSAGING_EVENT_POOL, &config->PoolConfig));
     LogPrint(ELogSeverityLevel_Info, "Successfully created event pool %" PRI_POOL " for messaging framework's use", \
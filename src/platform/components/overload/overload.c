@@ -0,0 +1,285 @@
+#include <overload/overload.h>
+#include <overload/setup.h>
+#include <messaging/setup.h>
+#include <messaging/network/pktio.h>
+#include <memory/setup.h>
+#include <menabrea/input.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+#include <menabrea/exception.h>
+#include <event_machine.h>
+#include <odp_api.h>
+#include <string.h>
+
+#define EVALUATION_PERIOD_NS  (10 * ODP_TIME_MSEC_IN_NS)
+/* Number of consecutive evaluations below the current level before it is lowered */
+#define COOLDOWN_PERIODS      10
+
+typedef struct SCoreLoad {
+    /* Each core only ever writes its own entry */
+    TAtomic64 Delivered;
+    TAtomic64 Consumed;
+    TAtomic32 Utilisation;
+    /* Pad size to a multiple of cache line size */
+    void * _pad[0] ENV_CACHE_LINE_ALIGNED;
+} SCoreLoad;
+
+typedef struct SOverloadSharedMemory {
+    TAtomic32 Level;
+    /* Keep the frequently read level away from the per-core entries */
+    void * _pad[0] ENV_CACHE_LINE_ALIGNED;
+    SCoreLoad Cores[0];
+} SOverloadSharedMemory;
+
+static void DispatchEnterCallback(em_eo_t eo, void ** eoCtx, em_event_t events[], int num, em_queue_t * queue, void ** qCtx);
+static void DispatchExitCallback(em_eo_t eo);
+static void LoadPoll(void * arg);
+static void EvaluateLoadLevel(void);
+static u32 GetPoolFillLevel(em_pool_t pool);
+
+static const em_pool_t s_monitoredPools[] = {
+    MESSAGING_EVENT_POOL,
+    NETWORKING_PACKET_POOL,
+    RUNTIME_SHMEM_EVENT_POOL
+};
+static const char * s_metricNames[EOverloadMetric_Count] = { "cpu", "pool", "backlog" };
+
+static bool s_enabled = false;
+static bool s_shedding = false;
+static u32 s_thresholds[EOverloadMetric_Count][OVERLOAD_THRESHOLDS];
+static SOverloadSharedMemory * s_shmem = NULL;
+/* Private (per core) variables used to measure the time spent in EO callbacks */
+static u64 s_dispatchEnterTime = 0;
+static u64 s_busyNs = 0;
+static u64 s_busyNsAtLastEvaluation = 0;
+static u64 s_lastEvaluation = 0;
+/* Used on the shared core only */
+static int s_cooldown = 0;
+
+void OverloadInit(SOverloadConfig * config) {
+
+    if (!config->Enabled) {
+
+        return;
+    }
+
+    int cores = em_core_count();
+    s_shmem = (SOverloadSharedMemory *) env_shared_malloc(sizeof(SOverloadSharedMemory) + cores * sizeof(SCoreLoad));
+    AssertTrue(s_shmem != NULL);
+    Atomic32Init(&s_shmem->Level);
+    for (int i = 0; i < cores; i++) {
+
+        Atomic64Init(&s_shmem->Cores[i].Delivered);
+        Atomic64Init(&s_shmem->Cores[i].Consumed);
+        Atomic32Init(&s_shmem->Cores[i].Utilisation);
+    }
+
+    (void) memcpy(s_thresholds, config->Thresholds, sizeof(s_thresholds));
+    for (int i = 0; i < EOverloadMetric_Count; i++) {
+
+        LogPrint(ELogSeverityLevel_Info, "Overload thresholds for %s: %u, %u, %u", \
+            s_metricNames[i], s_thresholds[i][0], s_thresholds[i][1], s_thresholds[i][2]);
+    }
+    s_shedding = config->Shedding;
+    LogPrint(ELogSeverityLevel_Info, "Overload manager enabled, traffic shedding %s", \
+        s_shedding ? "enabled" : "disabled");
+
+    /* Measure the time spent in EO callbacks to estimate core utilisation */
+    AssertTrue(EM_OK == em_dispatch_register_enter_cb(DispatchEnterCallback));
+    AssertTrue(EM_OK == em_dispatch_register_exit_cb(DispatchExitCallback));
+    RegisterInputPolling(LoadPoll, NULL, GetAllCoresMask());
+
+    s_enabled = true;
+}
+
+void OverloadTeardown(void) {
+
+    if (!s_enabled) {
+
+        return;
+    }
+
+    AssertTrue(EM_OK == em_dispatch_unregister_enter_cb(DispatchEnterCallback));
+    AssertTrue(EM_OK == em_dispatch_unregister_exit_cb(DispatchExitCallback));
+    s_enabled = false;
+    env_shared_free(s_shmem);
+    s_shmem = NULL;
+}
+
+bool IsOverloadManagerEnabled(void) {
+
+    return s_enabled;
+}
+
+EOverloadLevel GetOverloadLevel(void) {
+
+    if (!s_enabled) {
+
+        return EOverloadLevel_Normal;
+    }
+
+    return (EOverloadLevel) Atomic32Get(&s_shmem->Level);
+}
+
+void NoteMessagesDelivered(int count) {
+
+    if (s_enabled) {
+
+        /* Single writer - no need for an atomic read-modify-write */
+        TAtomic64 * delivered = &s_shmem->Cores[em_core_id()].Delivered;
+        Atomic64Set(delivered, Atomic64Get(delivered) + count);
+    }
+}
+
+void NoteMessagesConsumed(int count) {
+
+    if (s_enabled) {
+
+        /* Single writer - no need for an atomic read-modify-write */
+        TAtomic64 * consumed = &s_shmem->Cores[em_core_id()].Consumed;
+        Atomic64Set(consumed, Atomic64Get(consumed) + count);
+    }
+}
+
+bool ShouldShedTraffic(EOverloadLevel sheddingLevel) {
+
+    return s_shedding && sheddingLevel != EOverloadLevel_Normal && GetOverloadLevel() >= sheddingLevel;
+}
+
+u32 GetCoreUtilisation(int core) {
+
+    if (!s_enabled) {
+
+        return 0;
+    }
+
+    return Atomic32Get(&s_shmem->Cores[core].Utilisation);
+}
+
+static void DispatchEnterCallback(em_eo_t eo, void ** eoCtx, em_event_t events[], int num, em_queue_t * queue, void ** qCtx) {
+
+    (void) eo;
+    (void) eoCtx;
+    (void) events;
+    (void) num;
+    (void) queue;
+    (void) qCtx;
+
+    s_dispatchEnterTime = odp_time_local_ns();
+}
+
+static void DispatchExitCallback(em_eo_t eo) {
+
+    (void) eo;
+
+    s_busyNs += odp_time_local_ns() - s_dispatchEnterTime;
+}
+
+static void LoadPoll(void * arg) {
+
+    (void) arg;
+
+    u64 now = odp_time_local_ns();
+    u64 elapsed = now - s_lastEvaluation;
+    if (likely(elapsed < EVALUATION_PERIOD_NS)) {
+
+        return;
+    }
+
+    /* Publish the utilisation of the current core over the last period */
+    u64 busy = s_busyNs - s_busyNsAtLastEvaluation;
+    u32 utilisation = busy >= elapsed ? 100 : (u32) (busy * 100 / elapsed);
+    Atomic32Set(&s_shmem->Cores[em_core_id()].Utilisation, utilisation);
+    s_lastEvaluation = now;
+    s_busyNsAtLastEvaluation = s_busyNs;
+
+    if (CoreMaskContains(GetSharedCoreMask(), GetCurrentCore())) {
+
+        /* Aggregate the metrics on a single core */
+        EvaluateLoadLevel();
+    }
+}
+
+static void EvaluateLoadLevel(void) {
+
+    u32 metrics[EOverloadMetric_Count] = { 0 };
+
+    u64 delivered = 0;
+    u64 consumed = 0;
+    for (int i = 0; i < em_core_count(); i++) {
+
+        u32 utilisation = Atomic32Get(&s_shmem->Cores[i].Utilisation);
+        metrics[EOverloadMetric_Cpu] = utilisation > metrics[EOverloadMetric_Cpu] ? utilisation : metrics[EOverloadMetric_Cpu];
+        delivered += Atomic64Get(&s_shmem->Cores[i].Delivered);
+        consumed += Atomic64Get(&s_shmem->Cores[i].Consumed);
+    }
+    /* Counters are read without synchronization, so allow for consumed overtaking delivered */
+    u64 backlog = delivered > consumed ? delivered - consumed : 0;
+    metrics[EOverloadMetric_Backlog] = backlog > UINT32_MAX ? UINT32_MAX : (u32) backlog;
+
+    for (u32 i = 0; i < sizeof(s_monitoredPools) / sizeof(s_monitoredPools[0]); i++) {
+
+        u32 fillLevel = GetPoolFillLevel(s_monitoredPools[i]);
+        metrics[EOverloadMetric_Pool] = fillLevel > metrics[EOverloadMetric_Pool] ? fillLevel : metrics[EOverloadMetric_Pool];
+    }
+
+    /* The node is as loaded as its most loaded resource */
+    EOverloadLevel level = EOverloadLevel_Normal;
+    for (int metric = 0; metric < EOverloadMetric_Count; metric++) {
+
+        for (int i = 0; i < OVERLOAD_THRESHOLDS; i++) {
+
+            u32 threshold = s_thresholds[metric][i];
+            if (threshold > 0 && metrics[metric] >= threshold && (EOverloadLevel) (i + 1) > level) {
+
+                level = (EOverloadLevel) (i + 1);
+            }
+        }
+    }
+
+    EOverloadLevel current = (EOverloadLevel) Atomic32Get(&s_shmem->Level);
+    if (level > current) {
+
+        /* Escalate immediately */
+        s_cooldown = 0;
+        Atomic32Set(&s_shmem->Level, level);
+        LogPrint(ELogSeverityLevel_Warning, "Node load level raised %d -> %d (cpu: %u%%, pool: %u%%, backlog: %u)", \
+            current, level, metrics[EOverloadMetric_Cpu], metrics[EOverloadMetric_Pool], metrics[EOverloadMetric_Backlog]);
+
+    } else if (level < current) {
+
+        /* Only deescalate once the load has stayed low for a while to avoid flapping */
+        if (++s_cooldown >= COOLDOWN_PERIODS) {
+
+            s_cooldown = 0;
+            Atomic32Set(&s_shmem->Level, current - 1);
+            LogPrint(ELogSeverityLevel_Info, "Node load level lowered %d -> %d", current, current - 1);
+        }
+
+    } else {
+
+        s_cooldown = 0;
+    }
+}
+
+static u32 GetPoolFillLevel(em_pool_t pool) {
+
+    em_pool_info_t poolInfo;
+    if (unlikely(EM_OK != em_pool_info(pool, &poolInfo))) {
+
+        /* Pool may not have been created (yet) */
+        return 0;
+    }
+
+    /* Note that the 'used' counters are only maintained if pool statistics are enabled in the EM config */
+    u32 fillLevel = 0;
+    for (int i = 0; i < poolInfo.num_subpools; i++) {
+
+        if (poolInfo.subpool[i].num > 0) {
+
+            u32 subpoolFillLevel = (u32) ((u64) poolInfo.subpool[i].used * 100 / poolInfo.subpool[i].num);
+            fillLevel = subpoolFillLevel > fillLevel ? subpoolFillLevel : fillLevel;
+        }
+    }
+    return fillLevel;
+}
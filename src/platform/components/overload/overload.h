@@ -0,0 +1,40 @@
+
+#ifndef PLATFORM_COMPONENTS_OVERLOAD_OVERLOAD_H
+#define PLATFORM_COMPONENTS_OVERLOAD_OVERLOAD_H
+
+#include <menabrea/common.h>
+#include <menabrea/overload.h>
+
+/**
+ * @brief Check if the overload manager has been enabled in the platform config
+ * @return True if the node load is being monitored
+ */
+bool IsOverloadManagerEnabled(void);
+
+/**
+ * @brief Account for messages handed over to a worker's queue
+ * @param count Number of messages
+ */
+void NoteMessagesDelivered(int count);
+
+/**
+ * @brief Account for messages passed to a worker body (or dropped right before)
+ * @param count Number of messages
+ */
+void NoteMessagesConsumed(int count);
+
+/**
+ * @brief Check if traffic to a worker should be dropped at the current load level
+ * @param sheddingLevel Shedding level of the receiving worker
+ * @return True if shedding is enabled and the node is loaded at or above the worker's shedding level
+ */
+bool ShouldShedTraffic(EOverloadLevel sheddingLevel);
+
+/**
+ * @brief Get the utilisation of a core over the last evaluation period
+ * @param core Core index
+ * @return Utilisation in percent or zero if the overload manager is disabled
+ */
+u32 GetCoreUtilisation(int core);
+
+#endif /* PLATFORM_COMPONENTS_OVERLOAD_OVERLOAD_H */
@@ -0,0 +1,26 @@
+
+#ifndef PLATFORM_COMPONENTS_OVERLOAD_SETUP_H
+#define PLATFORM_COMPONENTS_OVERLOAD_SETUP_H
+
+#include <menabrea/common.h>
+#include <menabrea/overload.h>
+
+#define OVERLOAD_THRESHOLDS  ( EOverloadLevel_Count - 1 )
+
+typedef enum EOverloadMetric {
+    EOverloadMetric_Cpu = 0,  /* Utilisation of the busiest core in percent */
+    EOverloadMetric_Pool,     /* Fill level of the fullest event subpool in percent */
+    EOverloadMetric_Backlog,  /* Number of messages queued up for the workers */
+    EOverloadMetric_Count
+} EOverloadMetric;
+
+typedef struct SOverloadConfig {
+    bool Enabled;
+    bool Shedding;                                                /* Drop traffic to workers at or above their shedding levels */
+    u32 Thresholds[EOverloadMetric_Count][OVERLOAD_THRESHOLDS];  /* Entry i is the threshold of level i + 1, zero to ignore */
+} SOverloadConfig;
+
+void OverloadInit(SOverloadConfig * config);
+void OverloadTeardown(void);
+
+#endif /* PLATFORM_COMPONENTS_OVERLOAD_SETUP_H */
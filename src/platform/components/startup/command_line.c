@@ -10,6 +10,8 @@ static void SetDefaultPoolConfig(SPoolConfig * poolConfig);
 static void ParsePoolConfig(const char * optarg, SPoolConfig * config);
 static void ParseSubpoolConfig(const char * token, SSubpoolConfig * config);
 static void PrintPoolConfig(const SPoolConfig * config);
+static void ParseNetworkInterfaces(const char * optarg, SStartupParams * params);
+static void ParseOverloadThresholds(const char * optarg, SOverloadConfig * config);
 
 SStartupParams * ParseCommandLine(int argc, char **argv) {
 
@@ -25,6 +27,19 @@ SStartupParams * ParseCommandLine(int argc, char **argv) {
         { "nodeId", required_argument, NULL, 0 },
         { "netIf", required_argument, NULL, 0 },
         { "pktioBufs", required_argument, NULL, 0 },
+        { "captureFile", required_argument, NULL, 0 },
+        { "captureWorkers", required_argument, NULL, 0 },
+        { "replayFile", required_argument, NULL, 0 },
+        { "replaySpeed", required_argument, NULL, 0 },
+        { "netPolicy", required_argument, NULL, 0 },
+        { "netAddressing", required_argument, NULL, 0 },
+        { "peerTable", required_argument, NULL, 0 },
+        { "overloadThresholds", required_argument, NULL, 0 },
+        { "overloadShedding", no_argument, NULL, 0 },
+        { "rebalanceWorkers", no_argument, NULL, 0 },
+        { "maxWorkers", required_argument, NULL, 0 },
+        { "watchdogBudget", required_argument, NULL, 0 },
+        { "watchdogAction", required_argument, NULL, 0 },
         { 0, 0, 0, 0 }
     };
     int optionIndex;
@@ -78,12 +93,8 @@ SStartupParams * ParseCommandLine(int argc, char **argv) {
 
         case 4:
             AssertTrue(0 == strcmp("netIf", longOptions[optionIndex].name));
-            LogPrint(ELogSeverityLevel_Debug, "Parsing network interface...");
-            /* Copy the name and ensure proper NULL-termination (see strncpy manpage) */
-            (void) strncpy(params->NetworkInterface, optarg, sizeof(params->NetworkInterface) - 1);
-            params->NetworkInterface[sizeof(params->NetworkInterface) - 1] = '\0';
-            LogPrint(ELogSeverityLevel_Debug, "Network interface set to '%s'", \
-                params->NetworkInterface);
+            LogPrint(ELogSeverityLevel_Debug, "Parsing network interfaces...");
+            ParseNetworkInterfaces(optarg, params);
             break;
 
         case 5:
@@ -96,6 +107,160 @@ SStartupParams * ParseCommandLine(int argc, char **argv) {
                 params->PktioBufferCount);
             break;
 
+        case 6:
+            AssertTrue(0 == strcmp("captureFile", longOptions[optionIndex].name));
+            LogPrint(ELogSeverityLevel_Debug, "Parsing capture file path...");
+            /* Copy the path and ensure proper NULL-termination (see strncpy manpage) */
+            (void) strncpy(params->CaptureFile, optarg, sizeof(params->CaptureFile) - 1);
+            params->CaptureFile[sizeof(params->CaptureFile) - 1] = '\0';
+            LogPrint(ELogSeverityLevel_Debug, "Capture file set to '%s'", \
+                params->CaptureFile);
+            break;
+
+        case 7:
+            AssertTrue(0 == strcmp("captureWorkers", longOptions[optionIndex].name));
+            LogPrint(ELogSeverityLevel_Debug, "Parsing captured workers...");
+            /* Assert the list fits in the buffer */
+            AssertTrue(strlen(optarg) < sizeof(params->CapturedWorkers));
+            (void) strcpy(params->CapturedWorkers, optarg);
+            LogPrint(ELogSeverityLevel_Debug, "Captured workers set to '%s'", \
+                params->CapturedWorkers);
+            break;
+
+        case 8:
+            AssertTrue(0 == strcmp("replayFile", longOptions[optionIndex].name));
+            LogPrint(ELogSeverityLevel_Debug, "Parsing replay file path...");
+            /* Copy the path and ensure proper NULL-termination (see strncpy manpage) */
+            (void) strncpy(params->ReplayFile, optarg, sizeof(params->ReplayFile) - 1);
+            params->ReplayFile[sizeof(params->ReplayFile) - 1] = '\0';
+            LogPrint(ELogSeverityLevel_Debug, "Replay file set to '%s'", \
+                params->ReplayFile);
+            break;
+
+        case 9:
+            AssertTrue(0 == strcmp("replaySpeed", longOptions[optionIndex].name));
+            LogPrint(ELogSeverityLevel_Debug, "Parsing replay speed...");
+            params->ReplaySpeed = strtod(optarg, &endptr);
+            /* Assert a number was parsed */
+            AssertTrue(endptr != optarg);
+            AssertTrue(params->ReplaySpeed >= 0.0);
+            LogPrint(ELogSeverityLevel_Debug, "Replay speed set to %.2f", \
+                params->ReplaySpeed);
+            break;
+
+        case 10:
+            AssertTrue(0 == strcmp("netPolicy", longOptions[optionIndex].name));
+            LogPrint(ELogSeverityLevel_Debug, "Parsing network policy...");
+            if (0 == strcmp(optarg, "failover")) {
+
+                params->NetworkPolicy = ENetworkPolicy_Failover;
+
+            } else if (0 == strcmp(optarg, "stripe")) {
+
+                params->NetworkPolicy = ENetworkPolicy_Stripe;
+
+            } else {
+
+                RaiseException(EExceptionFatality_Fatal, \
+                    "Invalid network policy: '%s'", optarg);
+            }
+            LogPrint(ELogSeverityLevel_Debug, "Network policy set to '%s'", optarg);
+            break;
+
+        case 11:
+            AssertTrue(0 == strcmp("netAddressing", longOptions[optionIndex].name));
+            LogPrint(ELogSeverityLevel_Debug, "Parsing network addressing...");
+            if (0 == strcmp(optarg, "spoofed")) {
+
+                params->NetworkAddressing = ENetworkAddressing_Spoofed;
+
+            } else if (0 == strcmp(optarg, "native")) {
+
+                params->NetworkAddressing = ENetworkAddressing_Native;
+
+            } else {
+
+                RaiseException(EExceptionFatality_Fatal, \
+                    "Invalid network addressing: '%s'", optarg);
+            }
+            LogPrint(ELogSeverityLevel_Debug, "Network addressing set to '%s'", optarg);
+            break;
+
+        case 12:
+            AssertTrue(0 == strcmp("peerTable", longOptions[optionIndex].name));
+            LogPrint(ELogSeverityLevel_Debug, "Parsing peer table path...");
+            /* Copy the path and ensure proper NULL-termination (see strncpy manpage) */
+            (void) strncpy(params->PeerTable, optarg, sizeof(params->PeerTable) - 1);
+            params->PeerTable[sizeof(params->PeerTable) - 1] = '\0';
+            LogPrint(ELogSeverityLevel_Debug, "Peer table set to '%s'", \
+                params->PeerTable);
+            break;
+
+        case 13:
+            AssertTrue(0 == strcmp("overloadThresholds", longOptions[optionIndex].name));
+            LogPrint(ELogSeverityLevel_Debug, "Parsing overload thresholds...");
+            ParseOverloadThresholds(optarg, &params->OverloadConfig);
+            /* Providing the thresholds enables the overload manager */
+            params->OverloadConfig.Enabled = true;
+            break;
+
+        case 14:
+            AssertTrue(0 == strcmp("overloadShedding", longOptions[optionIndex].name));
+            params->OverloadConfig.Shedding = true;
+            LogPrint(ELogSeverityLevel_Debug, "Traffic shedding under overload enabled");
+            break;
+
+        case 15:
+            AssertTrue(0 == strcmp("rebalanceWorkers", longOptions[optionIndex].name));
+            params->RebalanceWorkers = true;
+            LogPrint(ELogSeverityLevel_Debug, "Worker rebalancing enabled");
+            break;
+
+        case 16:
+            AssertTrue(0 == strcmp("maxWorkers", longOptions[optionIndex].name));
+            LogPrint(ELogSeverityLevel_Debug, "Parsing maximum worker count...");
+            params->MaxWorkers = strtol(optarg, &endptr, 0);
+            /* Assert a number was parsed */
+            AssertTrue(endptr != optarg);
+            AssertTrue(params->MaxWorkers > 0);
+            AssertTrue(params->MaxWorkers <= MAX_WORKER_COUNT);
+            LogPrint(ELogSeverityLevel_Debug, "Maximum worker count set to %u", \
+                params->MaxWorkers);
+            break;
+
+        case 17:
+            AssertTrue(0 == strcmp("watchdogBudget", longOptions[optionIndex].name));
+            LogPrint(ELogSeverityLevel_Debug, "Parsing handler watchdog budget...");
+            params->WatchdogBudgetUs = strtoul(optarg, &endptr, 0);
+            /* Assert a number was parsed */
+            AssertTrue(endptr != optarg);
+            LogPrint(ELogSeverityLevel_Debug, "Handler watchdog budget set to %u us", \
+                params->WatchdogBudgetUs);
+            break;
+
+        case 18:
+            AssertTrue(0 == strcmp("watchdogAction", longOptions[optionIndex].name));
+            LogPrint(ELogSeverityLevel_Debug, "Parsing handler watchdog action...");
+            if (0 == strcmp(optarg, "log")) {
+
+                params->WatchdogAction = EWatchdogAction_Log;
+
+            } else if (0 == strcmp(optarg, "exception")) {
+
+                params->WatchdogAction = EWatchdogAction_Exception;
+
+            } else if (0 == strcmp(optarg, "callstack")) {
+
+                params->WatchdogAction = EWatchdogAction_Callstack;
+
+            } else {
+
+                RaiseException(EExceptionFatality_Fatal, \
+                    "Invalid handler watchdog action: '%s'", optarg);
+            }
+            LogPrint(ELogSeverityLevel_Debug, "Handler watchdog action set to '%s'", optarg);
+            break;
+
         default:
             /* Should never get here - sanity-check ourselves */
             RaiseException(EExceptionFatality_Fatal, \
@@ -108,6 +273,13 @@ SStartupParams * ParseCommandLine(int argc, char **argv) {
      * any defaults here */
     AssertTrue(params->NodeId != WORKER_ID_INVALID);
 
+    if (params->RebalanceWorkers && !params->OverloadConfig.Enabled) {
+
+        /* The rebalancer follows the core utilisation measured by the overload manager */
+        RaiseException(EExceptionFatality_Fatal, \
+            "Worker rebalancing requires the overload manager to be enabled");
+    }
+
     return params;
 }
 
@@ -126,7 +298,46 @@ static void SetDefaults(SStartupParams * params) {
     params->NodeId = WORKER_ID_INVALID;
     params->PktioBufferCount = 10;
 
-    (void) strcpy(params->NetworkInterface, "eth0");
+    (void) strcpy(params->NetworkInterfaces[0], "eth0");
+    params->NetworkInterfaceCount = 1;
+    params->NetworkPolicy = ENetworkPolicy_Failover;
+
+    /* Capture and replay disabled by default */
+    params->CaptureFile[0] = '\0';
+    params->CapturedWorkers[0] = '\0';
+    params->ReplayFile[0] = '\0';
+    /* Replay at the original speed by default */
+    params->ReplaySpeed = 1.0;
+
+    /* Spoof the MAC addresses by default, no static peer table */
+    params->NetworkAddressing = ENetworkAddressing_Spoofed;
+    params->PeerTable[0] = '\0';
+
+    /* Overload manager disabled by default */
+    params->OverloadConfig.Enabled = false;
+    params->OverloadConfig.Shedding = false;
+    /* Default thresholds in percent of the busiest core's utilisation... */
+    params->OverloadConfig.Thresholds[EOverloadMetric_Cpu][0] = 70;
+    params->OverloadConfig.Thresholds[EOverloadMetric_Cpu][1] = 85;
+    params->OverloadConfig.Thresholds[EOverloadMetric_Cpu][2] = 95;
+    /* ...and of the fullest subpool's capacity */
+    params->OverloadConfig.Thresholds[EOverloadMetric_Pool][0] = 60;
+    params->OverloadConfig.Thresholds[EOverloadMetric_Pool][1] = 80;
+    params->OverloadConfig.Thresholds[EOverloadMetric_Pool][2] = 90;
+    /* Sensible backlog depends on the application, ignore it unless configured */
+    params->OverloadConfig.Thresholds[EOverloadMetric_Backlog][0] = 0;
+    params->OverloadConfig.Thresholds[EOverloadMetric_Backlog][1] = 0;
+    params->OverloadConfig.Thresholds[EOverloadMetric_Backlog][2] = 0;
+
+    /* Keep the workers where deployed by default */
+    params->RebalanceWorkers = false;
+
+    /* Size the worker table for the whole worker ID space by default */
+    params->MaxWorkers = MAX_WORKER_COUNT;
+
+    /* Handler watchdog disabled by default, only logging when enabled */
+    params->WatchdogBudgetUs = 0;
+    params->WatchdogAction = EWatchdogAction_Log;
 }
 
 static void SetDefaultPoolConfig(SPoolConfig * poolConfig) {
@@ -243,3 +454,81 @@ static void PrintPoolConfig(const SPoolConfig * config) {
         LogPrint(ELogSeverityLevel_Debug, "        cache_size: %d", config->Subpools[i].CacheSize);
     }
 }
+
+static void ParseNetworkInterfaces(const char * optarg, SStartupParams * params) {
+
+    /* Network interfaces command-line parameter should have the
+     * format: <if0>,<if1>,... */
+
+    size_t optargLen = strlen(optarg);
+    /* Make a copy of the optarg string on the heap to safely tokenize */
+    char * copy = malloc(optargLen + 1);
+    AssertTrue(copy != NULL);
+    (void) strcpy(copy, optarg);
+
+    char * saveptr = NULL;
+    params->NetworkInterfaceCount = 0;
+    for (char * token = strtok_r(copy, ",", &saveptr); token != NULL; token = strtok_r(NULL, ",", &saveptr)) {
+
+        AssertTrue(params->NetworkInterfaceCount < MAX_NETWORK_INTERFACES);
+        /* Assert the name fits */
+        AssertTrue(strlen(token) < IFNAMSIZ);
+        (void) strcpy(params->NetworkInterfaces[params->NetworkInterfaceCount], token);
+        LogPrint(ELogSeverityLevel_Debug, "Network interface %d set to '%s'", \
+            params->NetworkInterfaceCount, token);
+        params->NetworkInterfaceCount++;
+    }
+    /* Assert at least one interface was provided */
+    AssertTrue(params->NetworkInterfaceCount > 0);
+
+    free(copy);
+}
+
+static void ParseOverloadThresholds(const char * optarg, SOverloadConfig * config) {
+
+    /* Overload thresholds command-line parameter should have the
+     * format: <metric>=<elevated>:<high>:<critical>,<metric>=... where
+     * metric is one of 'cpu', 'pool', or 'backlog' - metrics not listed
+     * keep their defaults */
+
+    static const char * metricNames[EOverloadMetric_Count] = { "cpu", "pool", "backlog" };
+
+    size_t optargLen = strlen(optarg);
+    /* Make a copy of the optarg string on the heap to safely tokenize */
+    char * copy = malloc(optargLen + 1);
+    AssertTrue(copy != NULL);
+    (void) strcpy(copy, optarg);
+
+    char * saveptr = NULL;
+    for (char * token = strtok_r(copy, ",", &saveptr); token != NULL; token = strtok_r(NULL, ",", &saveptr)) {
+
+        char * values = strchr(token, '=');
+        AssertTrue(values != NULL);
+        *values++ = '\0';
+
+        int metric = 0;
+        while (metric < EOverloadMetric_Count && 0 != strcmp(token, metricNames[metric])) {
+
+            metric++;
+        }
+        if (metric == EOverloadMetric_Count) {
+
+            RaiseException(EExceptionFatality_Fatal, "Invalid overload metric: '%s'", token);
+        }
+
+        u32 * thresholds = config->Thresholds[metric];
+        char * endptr;
+        for (int i = 0; i < OVERLOAD_THRESHOLDS; i++) {
+
+            /* Enforce base 10 and at each step make an assertion about the format */
+            thresholds[i] = strtoul(values, &endptr, 10);
+            AssertTrue(endptr != values);
+            AssertTrue(*endptr == (i == OVERLOAD_THRESHOLDS - 1 ? '\0' : ':'));
+            values = endptr + 1;
+        }
+        LogPrint(ELogSeverityLevel_Debug, "Overload thresholds for %s set to %u, %u, %u", \
+            token, thresholds[0], thresholds[1], thresholds[2]);
+    }
+
+    free(copy);
+}
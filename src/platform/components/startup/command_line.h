@@ -5,6 +5,10 @@
 #include <menabrea/common.h>
 #include <menabrea/workers.h>
 #include <event_machine.h>
+#include <capture/setup.h>
+#include <messaging/network/setup.h>
+#include <overload/setup.h>
+#include <workers/watchdog.h>
 #include <net/if.h>
 
 /* Use own structures for pool config so that no one tries to
@@ -28,7 +32,20 @@ typedef struct SStartupParams {
     SPoolConfig MemoryPoolConfig;
     u32 PktioBufferCount;
     TWorkerId NodeId;
-    char NetworkInterface[IFNAMSIZ];
+    char NetworkInterfaces[MAX_NETWORK_INTERFACES][IFNAMSIZ];
+    int NetworkInterfaceCount;
+    ENetworkPolicy NetworkPolicy;
+    ENetworkAddressing NetworkAddressing;
+    char PeerTable[PATH_MAX];
+    SOverloadConfig OverloadConfig;
+    bool RebalanceWorkers;
+    u32 MaxWorkers;
+    u32 WatchdogBudgetUs;
+    EWatchdogAction WatchdogAction;
+    char CaptureFile[PATH_MAX];
+    char CapturedWorkers[MAX_CAPTURED_WORKERS_LIST_LEN];
+    char ReplayFile[PATH_MAX];
+    double ReplaySpeed;
 } SStartupParams;
 
 SStartupParams * ParseCommandLine(int argc, char **argv);
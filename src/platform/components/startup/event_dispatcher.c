@@ -10,6 +10,7 @@
 #include <timing/setup.h>
 #include <timing/timer_table.h>
 #include <workers/worker_table.h>
+#include <workers/watchdog.h>
 #include <menabrea/exception.h>
 #include <menabrea/log.h>
 #include <menabrea/common.h>
@@ -67,6 +68,10 @@ typedef struct SStartupConfig {
     SMessagingConfig MessagingConfig;
     /* Memory subsystem configuration */
     SMemoryConfig MemoryConfig;
+    /* Traffic capture and replay configuration */
+    SCaptureConfig CaptureConfig;
+    /* Overload manager configuration */
+    SOverloadConfig OverloadConfig;
 } SStartupConfig;
 
 typedef struct SStartupSharedMemory {
@@ -97,6 +102,8 @@ void RunEventDispatchers(SEventDispatcherConfig * config) {
     s_platformConfig.MemoryConfig = config->MemoryConfig;
     s_platformConfig.MessagingConfig = config->MessagingConfig;
     s_platformConfig.WorkersConfig = config->WorkersConfig;
+    s_platformConfig.CaptureConfig = config->CaptureConfig;
+    s_platformConfig.OverloadConfig = config->OverloadConfig;
 
     /* Set up shared memory */
     s_platformShmem = CreatePlatformSharedMemory(config);
@@ -248,6 +255,8 @@ static inline void RunPlatformGlobalInit(void) {
 
     /* Set up queue groups used by platform EOs and application 'workers' */
     SetUpQueueGroups();
+    /* Start monitoring the node load if requested (ahead of the worker rebalancer relying on it) */
+    OverloadInit(&s_platformConfig.OverloadConfig);
     /* Initialize the workers component (application abstraction on top of EOs) */
     WorkersInit(&s_platformConfig.WorkersConfig);
     /* Initialize the internal communications component */
@@ -256,6 +265,8 @@ static inline void RunPlatformGlobalInit(void) {
     TimingInit();
     /* Initialize the memory pool for application use */
     MemorySetup(&s_platformConfig.MemoryConfig);
+    /* Set up traffic capture and replay if requested */
+    CaptureInit(&s_platformConfig.CaptureConfig);
     /* Register an em_send() hook exposed by the input component */
     AssertTrue(EM_OK == em_hooks_register_send(EmApiHookSend));
 }
@@ -271,9 +282,12 @@ static inline void RunPlatformGlobalTeardown(void) {
     ActiveSync(&s_platformShmem->WaitForWorkersTeardownCounter);
 
     /* Close up shop */
+    CaptureTeardown();
     TimingTeardown();
     MessagingTeardown();
     WorkersTeardown();
+    /* No workers left to deliver to, safe to stop monitoring */
+    OverloadTeardown();
     TearDownQueueGroups();
 
     /* Dispatch lingering events and exit */
@@ -303,6 +317,8 @@ static inline void DispatcherEntryPoint(void) {
     LogPrint(ELogSeverityLevel_Info, \
         "Dispatcher %d enabling input polling and entering the main dispatch loop...", \
         core);
+    CaptureLocalInit();
+    WatchdogLocalInit();
     EnableInputPolling();
 
     RunDispatchLoops();
@@ -311,6 +327,8 @@ static inline void DispatcherEntryPoint(void) {
         "Dispatcher %d exited the main dispatch loop. Disabling input polling...", \
         core);
     DisableInputPolling();
+    /* Write out any messages captured on this core */
+    CaptureLocalExit();
 
     /* Prevent applications from allocating extra resources in shutdown code */
     DisableTimerAllocation();
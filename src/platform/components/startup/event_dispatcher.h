@@ -3,9 +3,11 @@
 #define PLATFORM_COMPONENTS_STARTUP_EVENT_DISPATCHER_H
 
 #include <startup/load_applications.h>
+#include <capture/setup.h>
 #include <workers/setup.h>
 #include <messaging/setup.h>
 #include <memory/setup.h>
+#include <overload/setup.h>
 #include <odp_api.h>
 #include <event_machine.h>
 
@@ -16,6 +18,8 @@ typedef struct SEventDispatcherConfig {
     SWorkersConfig WorkersConfig;
     SMessagingConfig MessagingConfig;
     SMemoryConfig MemoryConfig;
+    SCaptureConfig CaptureConfig;
+    SOverloadConfig OverloadConfig;
 } SEventDispatcherConfig;
 
 void RunEventDispatchers(SEventDispatcherConfig * config);
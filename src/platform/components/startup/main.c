@@ -53,20 +53,39 @@ int main(int argc, char **argv) {
         .OdpInstance = odpInstance,
         .AppLibs = appLibs,
         .WorkersConfig = {
-            .NodeId = startupParams->NodeId
+            .NodeId = startupParams->NodeId,
+            .Rebalancing = startupParams->RebalanceWorkers,
+            .MaxWorkers = startupParams->MaxWorkers,
+            .WatchdogBudgetUs = startupParams->WatchdogBudgetUs,
+            .WatchdogAction = startupParams->WatchdogAction
         },
         .MessagingConfig = {
             .PoolConfig = TranslateToEmPoolConfig(&startupParams->MessagePoolConfig, EM_EVENT_TYPE_SW),
             .NetworkingConfig = {
                 .NodeId = startupParams->NodeId,
-                .PktioBufs = startupParams->PktioBufferCount
+                .PktioBufs = startupParams->PktioBufferCount,
+                .DeviceCount = startupParams->NetworkInterfaceCount,
+                .Policy = startupParams->NetworkPolicy,
+                .Addressing = startupParams->NetworkAddressing
             }
         },
         .MemoryConfig = {
             .PoolConfig = TranslateToEmPoolConfig(&startupParams->MemoryPoolConfig, EM_EVENT_TYPE_SW)
-        }
+        },
+        .CaptureConfig = {
+            .NodeId = startupParams->NodeId,
+            .ReplaySpeed = startupParams->ReplaySpeed
+        },
+        .OverloadConfig = startupParams->OverloadConfig
     };
-    (void) strcpy(dispatcherConfig.MessagingConfig.NetworkingConfig.DeviceName, startupParams->NetworkInterface);
+    for (int i = 0; i < startupParams->NetworkInterfaceCount; i++) {
+
+        (void) strcpy(dispatcherConfig.MessagingConfig.NetworkingConfig.DeviceNames[i], startupParams->NetworkInterfaces[i]);
+    }
+    (void) strcpy(dispatcherConfig.MessagingConfig.NetworkingConfig.PeerTable, startupParams->PeerTable);
+    (void) strcpy(dispatcherConfig.CaptureConfig.CaptureFile, startupParams->CaptureFile);
+    (void) strcpy(dispatcherConfig.CaptureConfig.CapturedWorkers, startupParams->CapturedWorkers);
+    (void) strcpy(dispatcherConfig.CaptureConfig.ReplayFile, startupParams->ReplayFile);
     /* Release the startup params as not needed anymore */
     ReleaseStartupParams(startupParams);
 
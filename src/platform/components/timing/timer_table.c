@@ -1,4 +1,5 @@
 #include <timing/timer_table.h>
+#include <memory/id_pool.h>
 #include <menabrea/log.h>
 #include <menabrea/exception.h>
 #include <menabrea/common.h>
@@ -8,15 +9,7 @@ static void ResetContext(STimerContext * context);
 static inline TTimerId AllocateTimerId(void);
 static inline void ReleaseTimerId(TTimerId timerId);
 
-typedef struct STimerIdFifo {
-    TSpinlock Lock;
-    u32 GetIndex;
-    u32 PutIndex;
-    u32 FreeIds;
-    TTimerId IdPool[MAX_TIMER_COUNT];
-} STimerIdFifo;
-
-static STimerIdFifo * s_idFifo;
+static SIdPool * s_idPool;
 static STimerContext * s_timerTable;
 static bool s_allowAllocations;
 
@@ -26,29 +19,24 @@ void TimerTableInit(void) {
     AssertTrue(sizeof(STimerContext) == ENV_CACHE_LINE_SIZE_ROUNDUP(sizeof(STimerContext)));
     size_t entrySize = sizeof(STimerContext);
     size_t tableSize = entrySize * MAX_TIMER_COUNT;
-    /* Align the FIFO descriptor with cache line */
-    size_t idFifoSize = ENV_CACHE_LINE_SIZE_ROUNDUP(sizeof(STimerIdFifo));
-    size_t totalAllocationSize = idFifoSize + tableSize;
+    size_t idPoolSize = IdPoolFootprint(MAX_TIMER_COUNT);
+    size_t totalAllocationSize = idPoolSize + tableSize;
     LogPrint(ELogSeverityLevel_Info, \
-        "Creating timer table in shared memory - max timers: %d, entry size: %ld, table size: %ld, ID fifo size: %ld, total: %ld", \
-        MAX_TIMER_COUNT, entrySize, tableSize, idFifoSize, totalAllocationSize);
+        "Creating timer table in shared memory - max timers: %d, entry size: %ld, table size: %ld, ID pool size: %ld, total: %ld", \
+        MAX_TIMER_COUNT, entrySize, tableSize, idPoolSize, totalAllocationSize);
 
     /* Do one big allocation and then set up the pointers to reference parts of it */
     void * startAddr = env_shared_malloc(totalAllocationSize);
     AssertTrue(startAddr != NULL);
 
-    /* Initialize the timer ID FIFO */
-    s_idFifo = (STimerIdFifo *) startAddr;
-    s_idFifo->GetIndex = 0;
-    s_idFifo->PutIndex = 0;
-    s_idFifo->FreeIds = MAX_TIMER_COUNT;
-    SpinlockInit(&s_idFifo->Lock);
-    for (TWorkerId i = 0; i < MAX_TIMER_COUNT; i++) {
+    /* Initialize the timer ID pool */
+    s_idPool = IdPoolInit(startAddr, MAX_TIMER_COUNT);
+    for (TTimerId i = 0; i < MAX_TIMER_COUNT; i++) {
 
-        s_idFifo->IdPool[i] = i;
+        IdPoolPut(s_idPool, i);
     }
 
-    void * tableBase = (u8 *) startAddr + idFifoSize;
+    void * tableBase = (u8 *) startAddr + idPoolSize;
     s_timerTable = tableBase;
     /* Initialize the table entries */
     for (TTimerId i = 0; i < MAX_TIMER_COUNT; i++) {
@@ -66,7 +54,7 @@ void TimerTableInit(void) {
 void TimerTableTeardown(void) {
 
     /* Recover the start address of the shared memory */
-    void * startAddr = s_idFifo;
+    void * startAddr = s_idPool;
     /* Free the shared memory */
     env_shared_free(startAddr);
 }
@@ -89,7 +77,7 @@ STimerContext * ReserveTimerContext(void) {
     }
 
     LockTimerTableEntry(id);
-    /* Assert consistency between the timer table and the timer ID FIFO */
+    /* Assert consistency between the timer table and the timer ID pool */
     AssertTrue(s_timerTable[id].State == ETimerState_Invalid);
     s_timerTable[id].State = ETimerState_Idle;
     UnlockTimerTableEntry(id);
@@ -145,28 +133,18 @@ static void ResetContext(STimerContext * context) {
 
 static inline TTimerId AllocateTimerId(void) {
 
-    TTimerId id = TIMER_ID_INVALID;
-    SpinlockAcquire(&s_idFifo->Lock);
-    if (s_idFifo->FreeIds > 0) {
-
-        AssertTrue(s_idFifo->IdPool[s_idFifo->GetIndex] != TIMER_ID_INVALID);
-        id = s_idFifo->IdPool[s_idFifo->GetIndex];
-        /* Explicitly poison the allocated entry to detect any errors */
-        s_idFifo->IdPool[s_idFifo->GetIndex] = TIMER_ID_INVALID;
-        /* Move the allocation index */
-        s_idFifo->GetIndex = (s_idFifo->GetIndex + 1) % MAX_TIMER_COUNT;
-        s_idFifo->FreeIds--;
+    u32 id;
+    if (unlikely(!IdPoolTake(s_idPool, &id))) {
+
+        return TIMER_ID_INVALID;
     }
-    SpinlockRelease(&s_idFifo->Lock);
-    return id;
+
+    AssertTrue(id < MAX_TIMER_COUNT);
+    return (TTimerId) id;
 }
 
 static inline void ReleaseTimerId(TTimerId timerId) {
 
-    SpinlockAcquire(&s_idFifo->Lock);
-    AssertTrue(s_idFifo->IdPool[s_idFifo->PutIndex] == TIMER_ID_INVALID);
-    s_idFifo->IdPool[s_idFifo->PutIndex] = timerId;
-    s_idFifo->PutIndex = (s_idFifo->PutIndex + 1) % MAX_TIMER_COUNT;
-    s_idFifo->FreeIds++;
-    SpinlockRelease(&s_idFifo->Lock);
+    /* IDs are recycled in FIFO order so that they are reused as late as possible */
+    IdPoolPut(s_idPool, timerId);
 }
@@ -48,7 +48,7 @@ void DeployTimingDaemon(void) {
          * handlers */
         EM_QUEUE_PRIO_NORMAL,
         /* Run the timing daemon on isolated cores only */
-        MapCoreMaskToQueueGroup(GetIsolatedCoresMask()),
+        AcquireQueueGroup(GetIsolatedCoresMask()),
         NULL
     );
 
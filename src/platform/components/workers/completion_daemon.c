@@ -1,9 +1,11 @@
 #include <workers/completion_daemon.h>
 #include <workers/worker_table.h>
+#include <workers/migration.h>
 #include <messaging/local/buffering.h>
 #include <cores/queue_groups.h>
 #include <menabrea/cores.h>
 #include <menabrea/workers.h>
+#include <menabrea/messaging.h>
 #include <menabrea/log.h>
 #include <menabrea/exception.h>
 
@@ -11,6 +13,7 @@ static em_status_t DaemonEoStart(void * eoCtx, em_eo_t eo, const em_eo_conf_t *
 static em_status_t DaemonEoStop(void * eoCtx, em_eo_t eo);
 static void DaemonEoReceive(void * eoCtx, em_event_t event, em_event_type_t type, em_queue_t queue, void * qCtx);
 static inline void CompleteWorkerDeployment(TWorkerId workerId);
+static inline void CompleteBatch(const SDaemonNotification * notification);
 
 static em_eo_t s_daemonEo = EM_EO_UNDEF;
 static em_queue_t s_daemonQueue = EM_QUEUE_UNDEF;
@@ -44,7 +47,7 @@ void DeployCompletionDaemon(void) {
         /* Give the completion daemon the highest priority - it will not handle
          * events often and should always be given priority. */
         EM_QUEUE_PRIO_HIGHEST,
-        MapCoreMaskToQueueGroup(GetAllCoresMask()),
+        AcquireQueueGroup(GetAllCoresMask()),
         NULL
     );
 
@@ -80,6 +83,82 @@ void CompletionDaemonTeardown(void) {
     s_daemonQueue = EM_QUEUE_UNDEF;
 }
 
+em_event_group_t CreateCompletionGroup(int count, TMessage completion, TWorkerId receiver) {
+
+    if (completion == MESSAGE_INVALID) {
+
+        /* No one to notify */
+        return EM_EVENT_GROUP_UNDEF;
+    }
+
+    em_event_t completionEvent = em_alloc(sizeof(SDaemonNotification), EM_EVENT_TYPE_SW, EM_POOL_DEFAULT);
+    if (unlikely(completionEvent == EM_EVENT_UNDEF)) {
+
+        return EM_EVENT_GROUP_UNDEF;
+    }
+
+    em_event_group_t eventGroup = em_event_group_create();
+    if (unlikely(eventGroup == EM_EVENT_GROUP_UNDEF)) {
+
+        em_free(completionEvent);
+        return EM_EVENT_GROUP_UNDEF;
+    }
+
+    SDaemonNotification * notifPayload = (SDaemonNotification *) em_event_pointer(completionEvent);
+    notifPayload->Request = EDaemonRequest_CompleteBatch;
+    notifPayload->WorkerId = receiver;
+    notifPayload->EventGroup = eventGroup;
+    notifPayload->Message = completion;
+
+    em_notif_t notif = {
+        .event = completionEvent,
+        .queue = GetCompletionDaemonQueue(),
+        .egroup = EM_EVENT_GROUP_UNDEF
+    };
+
+    if (count == 0) {
+
+        /* Nothing will ever be sent in the group - notify the daemon directly */
+        if (unlikely(EM_OK != em_send(completionEvent, notif.queue))) {
+
+            em_free(completionEvent);
+            AssertTrue(EM_OK == em_event_group_delete(eventGroup));
+            return EM_EVENT_GROUP_UNDEF;
+        }
+        return eventGroup;
+    }
+
+    /* The daemon is notified once the given number of events sent in the group have been processed */
+    if (unlikely(EM_OK != em_event_group_apply(eventGroup, count, 1, &notif))) {
+
+        em_free(completionEvent);
+        AssertTrue(EM_OK == em_event_group_delete(eventGroup));
+        return EM_EVENT_GROUP_UNDEF;
+    }
+
+    return eventGroup;
+}
+
+int CountTowardsCompletion(em_event_group_t eventGroup) {
+
+    em_event_t event = em_alloc(sizeof(SDaemonNotification), EM_EVENT_TYPE_SW, EM_POOL_DEFAULT);
+    if (unlikely(event == EM_EVENT_UNDEF)) {
+
+        return -1;
+    }
+
+    /* The group counts the event once the daemon has processed it */
+    SDaemonNotification * notifPayload = (SDaemonNotification *) em_event_pointer(event);
+    notifPayload->Request = EDaemonRequest_None;
+    if (unlikely(EM_OK != em_send_group(event, s_daemonQueue, eventGroup))) {
+
+        em_free(event);
+        return -1;
+    }
+
+    return 0;
+}
+
 static em_status_t DaemonEoStart(void * eoCtx, em_eo_t eo, const em_eo_conf_t * conf) {
 
     /* Nothing to do */
@@ -106,11 +185,34 @@ static void DaemonEoReceive(void * eoCtx, em_event_t event, em_event_type_t type
     (void) queue;
     (void) qCtx;
 
-    /* Run the "bottom-half" of worker deployment */
-    TWorkerId workerId = *(TWorkerId *) em_event_pointer(event);
+    SDaemonNotification notification = *(SDaemonNotification *) em_event_pointer(event);
     /* Free the notification event as soon as possible, we don't need it anymore */
     em_free(event);
-    CompleteWorkerDeployment(workerId);
+
+    switch (notification.Request) {
+    case EDaemonRequest_CompleteDeployment:
+        /* Run the "bottom-half" of worker deployment */
+        CompleteWorkerDeployment(notification.WorkerId);
+        break;
+
+    case EDaemonRequest_CompleteMigration:
+        /* Source queue of a migrated worker detached from its EO */
+        CompleteWorkerMigration(notification.WorkerId);
+        break;
+
+    case EDaemonRequest_CompleteBatch:
+        /* All events of a batch or message group processed */
+        CompleteBatch(&notification);
+        break;
+
+    case EDaemonRequest_None:
+        /* Nothing to do - the event group counts the event once we return */
+        break;
+
+    default:
+        RaiseException(EExceptionFatality_Fatal, "Unexpected daemon request: %d", notification.Request);
+        break;
+    }
 }
 
 static inline void CompleteWorkerDeployment(TWorkerId workerId) {
@@ -121,7 +223,7 @@ static inline void CompleteWorkerDeployment(TWorkerId workerId) {
     LockWorkerTableEntry(workerId);
     SWorkerContext * context = FetchWorkerContext(workerId);
     em_eo_t eo = context->Eo;
-    em_queue_t queue = context->Queue;
+    em_queue_t queue = FetchWorkerRoute(workerId)->Queue;
 
     /* Note that the EO cannot have been terminated yet as
      * `TerminateWorker` checks the state of the worker and the
@@ -174,7 +276,8 @@ static inline void CompleteWorkerDeployment(TWorkerId workerId) {
         MarkTeardownInProgress(workerId);
         /* Stop the EO - context will be released in the EO stop
          * callback */
-        AssertTrue(EM_OK == em_eo_stop(eo, 0, NULL));
+        em_notif_t * notif = &context->TerminationNotif;
+        AssertTrue(EM_OK == em_eo_stop(eo, notif->event != EM_EVENT_UNDEF ? 1 : 0, notif));
 
         UnlockWorkerTableEntry(workerId);
 
@@ -183,3 +286,14 @@ static inline void CompleteWorkerDeployment(TWorkerId workerId) {
             workerName, workerId, messagesDropped);
     }
 }
+
+static inline void CompleteBatch(const SDaemonNotification * notification) {
+
+    /* The group's notification has been sent, so the group is no longer in use */
+    AssertTrue(EM_OK == em_event_group_delete(notification->EventGroup));
+
+    LogPrint(ELogSeverityLevel_Debug, "Daemon completing batch, notifying worker 0x%x", \
+        notification->WorkerId);
+
+    SendMessage(notification->Message, notification->WorkerId);
+}
@@ -2,10 +2,44 @@
 #ifndef PLATFORM_COMPONENTS_WORKERS_COMPLETION_DAEMON_H
 #define PLATFORM_COMPONENTS_WORKERS_COMPLETION_DAEMON_H
 
+#include <menabrea/workers.h>
 #include <event_machine.h>
 
+typedef enum EDaemonRequest {
+    EDaemonRequest_CompleteDeployment = 0,
+    EDaemonRequest_CompleteMigration,
+    EDaemonRequest_CompleteBatch,
+    /* Counts towards the completion of a batch only */
+    EDaemonRequest_None
+} EDaemonRequest;
+
+/* Payload of the notification events sent to the daemon */
+typedef struct SDaemonNotification {
+    EDaemonRequest Request;
+    TWorkerId WorkerId;              /* Receiver of the completion message for EDaemonRequest_CompleteBatch */
+    em_event_group_t EventGroup;     /* Used by EDaemonRequest_CompleteBatch only */
+    TMessage Message;                /* Used by EDaemonRequest_CompleteBatch only */
+} SDaemonNotification;
+
 void DeployCompletionDaemon(void);
 em_queue_t GetCompletionDaemonQueue(void);
 void CompletionDaemonTeardown(void);
 
+/**
+ * @brief Create an event group whose completion is reported to a worker via the daemon
+ * @param count Number of events that will be sent in the group
+ * @param completion Message sent to the receiver once all the events have been processed
+ * @param receiver Recipient of the completion message
+ * @return Event group or EM_EVENT_GROUP_UNDEF if completion is MESSAGE_INVALID or on failure
+ * @note The daemon deletes the group once it has sent the completion message
+ */
+em_event_group_t CreateCompletionGroup(int count, TMessage completion, TWorkerId receiver);
+
+/**
+ * @brief Count an event towards the completion of a group without sending it anywhere
+ * @param eventGroup Event group
+ * @return 0 on success, -1 on failure
+ */
+int CountTowardsCompletion(em_event_group_t eventGroup);
+
 #endif /* PLATFORM_COMPONENTS_WORKERS_COMPLETION_DAEMON_H */
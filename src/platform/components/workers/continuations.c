@@ -0,0 +1,178 @@
+#include <workers/continuations.h>
+#include <menabrea/continuations.h>
+#include <menabrea/memory.h>
+#include <menabrea/timing.h>
+#include <menabrea/exception.h>
+#include <menabrea/log.h>
+#include <event_machine.h>
+
+static bool UnlinkContinuation(SWorkerContext * context, SContinuation * continuation);
+
+/* Private (per core) counter used to tell the timeouts apart */
+static u32 s_tokenCounter = 0;
+
+void * AwaitMessage(TMessageId messageId, TWorkerId sender, u32 timeout, TContinuation continuation, u32 frameSize) {
+
+    SWorkerContext * context = GetCurrentWorkerContext();
+    if (unlikely(context == NULL)) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Tried awaiting message 0x%x outside of a worker context", \
+            messageId);
+        return NULL;
+    }
+
+    if (unlikely(continuation == NULL || messageId == CONTINUATION_TIMEOUT_MESSAGE_ID)) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Worker 0x%x passed invalid continuation %p for message 0x%x", \
+            context->WorkerId, continuation, messageId);
+        return NULL;
+    }
+
+    SContinuation * record = (SContinuation *) GetRuntimeMemory(sizeof(SContinuation) + frameSize);
+    if (unlikely(record == NULL)) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to allocate a frame of %d bytes for worker 0x%x", \
+            __FUNCTION__, frameSize, context->WorkerId);
+        return NULL;
+    }
+    record->Next = NULL;
+    record->Callback = continuation;
+    record->Sender = sender;
+    record->MessageId = messageId;
+    record->TimerId = TIMER_ID_INVALID;
+    /* Unique across cores until the per-core counter wraps */
+    record->Token = ((u32) em_core_id() << 24) | (s_tokenCounter++ & 0xFFFFFF);
+
+    TMessage timeoutMessage = MESSAGE_INVALID;
+    if (timeout != CONTINUATION_TIMEOUT_NONE) {
+
+        timeoutMessage = CreateMessage(CONTINUATION_TIMEOUT_MESSAGE_ID, sizeof(u32));
+        record->TimerId = timeoutMessage != MESSAGE_INVALID ? CreateTimer(context->Name) : TIMER_ID_INVALID;
+        if (unlikely(record->TimerId == TIMER_ID_INVALID)) {
+
+            LogPrint(ELogSeverityLevel_Error, "%s(): Failed to set up a timeout for worker 0x%x", \
+                __FUNCTION__, context->WorkerId);
+            if (timeoutMessage != MESSAGE_INVALID) {
+
+                DestroyMessage(timeoutMessage);
+            }
+            PutRuntimeMemory(record);
+            return NULL;
+        }
+        *(u32 *) GetMessagePayload(timeoutMessage) = record->Token;
+    }
+
+    /* Append the continuation before arming the timer so that the timeout finds it */
+    SpinlockAcquire(&context->ContinuationLock);
+    SContinuation ** tail = &context->Continuations;
+    while (*tail != NULL) {
+
+        tail = &(*tail)->Next;
+    }
+    *tail = record;
+    SpinlockRelease(&context->ContinuationLock);
+
+    if (timeoutMessage != MESSAGE_INVALID \
+        && unlikely(TIMER_ID_INVALID == ArmTimer(record->TimerId, timeout, 0, timeoutMessage, context->WorkerId))) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to arm the timeout for worker 0x%x", \
+            __FUNCTION__, context->WorkerId);
+        DestroyMessage(timeoutMessage);
+        /* The request has not been sent yet, so the continuation cannot have been resumed */
+        AssertTrue(UnlinkContinuation(context, record));
+        ReleaseContinuation(record);
+        return NULL;
+    }
+
+    return record->Frame;
+}
+
+SContinuation * TakeContinuation(SWorkerContext * context, TMessage * message) {
+
+    TMessageId messageId = GetMessageId(*message);
+    TWorkerId sender = GetMessageSender(*message);
+    /* Timeouts are sent by the platform on behalf of no worker */
+    bool isTimeout = messageId == CONTINUATION_TIMEOUT_MESSAGE_ID && sender == WORKER_ID_INVALID;
+    u32 token = isTimeout ? *(u32 *) GetMessagePayload(*message) : 0;
+
+    SContinuation * continuation = NULL;
+    SpinlockAcquire(&context->ContinuationLock);
+    for (SContinuation ** link = &context->Continuations; *link != NULL; link = &(*link)->Next) {
+
+        SContinuation * candidate = *link;
+        if (isTimeout ? candidate->Token == token : (candidate->MessageId == messageId \
+            && (candidate->Sender == WORKER_ID_INVALID || candidate->Sender == sender))) {
+
+            *link = candidate->Next;
+            continuation = candidate;
+            break;
+        }
+    }
+    SpinlockRelease(&context->ContinuationLock);
+
+    if (isTimeout) {
+
+        /* The timeout message itself is of no interest to the worker. If no continuation
+         * matched, the awaited message won the race and the timeout is stale. */
+        DestroyMessage(*message);
+        *message = MESSAGE_INVALID;
+        if (continuation != NULL) {
+
+            /* The one-shot timer has expired, no need to disarm it */
+            DestroyTimer(continuation->TimerId);
+            continuation->TimerId = TIMER_ID_INVALID;
+        }
+    }
+
+    return continuation;
+}
+
+void ReleaseContinuation(SContinuation * continuation) {
+
+    if (continuation->TimerId != TIMER_ID_INVALID) {
+
+        /* Cancel the pending timeout - if already in flight, it will be found stale */
+        (void) DisarmTimer(continuation->TimerId);
+        DestroyTimer(continuation->TimerId);
+    }
+    PutRuntimeMemory(continuation);
+}
+
+int CancelContinuations(SWorkerContext * context) {
+
+    SpinlockAcquire(&context->ContinuationLock);
+    SContinuation * continuation = context->Continuations;
+    context->Continuations = NULL;
+    SpinlockRelease(&context->ContinuationLock);
+
+    int cancelled = 0;
+    while (continuation != NULL) {
+
+        SContinuation * next = continuation->Next;
+        ReleaseContinuation(continuation);
+        continuation = next;
+        cancelled++;
+    }
+
+    return cancelled;
+}
+
+static bool UnlinkContinuation(SWorkerContext * context, SContinuation * continuation) {
+
+    bool found = false;
+    SpinlockAcquire(&context->ContinuationLock);
+    for (SContinuation ** link = &context->Continuations; *link != NULL; link = &(*link)->Next) {
+
+        if (*link == continuation) {
+
+            *link = continuation->Next;
+            found = true;
+            break;
+        }
+    }
+    SpinlockRelease(&context->ContinuationLock);
+
+    return found;
+}
@@ -0,0 +1,53 @@
+
+#ifndef PLATFORM_COMPONENTS_WORKERS_CONTINUATIONS_H
+#define PLATFORM_COMPONENTS_WORKERS_CONTINUATIONS_H
+
+#include <workers/worker_table.h>
+#include <menabrea/continuations.h>
+#include <menabrea/timing.h>
+#include <menabrea/common.h>
+
+/* Header of a frame in runtime memory - the user's state follows */
+typedef struct SContinuation {
+    struct SContinuation * Next;
+    TContinuation Callback;
+    TWorkerId Sender;
+    TMessageId MessageId;
+    TTimerId TimerId;  /* TIMER_ID_INVALID if waiting indefinitely */
+    u32 Token;         /* Carried by the timeout message */
+    max_align_t Frame[0];  /* Suitably aligned for any type */
+} SContinuation;
+
+/**
+ * @brief Check if a worker has any continuations pending
+ * @param context Worker context
+ * @return True if any message may need to be passed to a continuation
+ */
+static inline bool HasPendingContinuations(const SWorkerContext * context) {
+
+    /* Racy read, but continuations are only ever added by the worker itself */
+    return unlikely(context->Continuations != NULL);
+}
+
+/**
+ * @brief Find and unlink the continuation a message received by a worker is meant for
+ * @param context Worker context
+ * @param message Message received, replaced with MESSAGE_INVALID if it has been consumed (timeouts)
+ * @return Continuation to be resumed or NULL if the message is for the worker body (or has been consumed)
+ */
+SContinuation * TakeContinuation(SWorkerContext * context, TMessage * message);
+
+/**
+ * @brief Release a continuation once it has been resumed
+ * @param continuation Continuation returned from TakeContinuation
+ */
+void ReleaseContinuation(SContinuation * continuation);
+
+/**
+ * @brief Discard all continuations pending when a worker terminates
+ * @param context Worker context
+ * @return Number of continuations discarded
+ */
+int CancelContinuations(SWorkerContext * context);
+
+#endif /* PLATFORM_COMPONENTS_WORKERS_CONTINUATIONS_H */
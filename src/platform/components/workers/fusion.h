@@ -0,0 +1,31 @@
+
+#ifndef PLATFORM_COMPONENTS_WORKERS_FUSION_H
+#define PLATFORM_COMPONENTS_WORKERS_FUSION_H
+
+#include <workers/worker_table.h>
+#include <menabrea/common.h>
+
+#define MAX_INLINE_DEPTH  4  /**< Maximum number of worker bodies invoked inline on top of each other */
+
+/**
+ * @brief Invoke the receiver's body directly from the sender's body if the receiver allows it
+ * @param receiver Worker ID of the receiver
+ * @param message Message to deliver
+ * @return True if the message has been delivered, false if it must be enqueued as usual
+ */
+bool TryDeliverInline(TWorkerId receiver, TMessage message);
+
+/**
+ * @brief Account for messages enqueued to a worker, which inline delivery must not overtake
+ * @param route Routing entry of the receiver (locked by the caller)
+ * @param count Number of messages
+ */
+static inline void NoteMessagesQueued(SWorkerRoute * route, int count) {
+
+    if (unlikely(route->InlineDelivery)) {
+
+        Atomic32Add(&route->Context->QueuedMessages, count);
+    }
+}
+
+#endif /* PLATFORM_COMPONENTS_WORKERS_FUSION_H */
@@ -0,0 +1,503 @@
+#include <workers/graphs.h>
+#include <workers/worker_table.h>
+#include <menabrea/graphs.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+#include <menabrea/exception.h>
+#include <menabrea/common.h>
+#include <event_machine.h>
+#include <string.h>
+
+#define STAGE_NONE  ( (u16) 0xFFFF )
+
+typedef struct SGraph {
+    /* Lock guarding the graph's state and stage IDs - not held by the stages looking up their outputs */
+    TSpinlock Lock;
+    bool InUse;
+    bool Terminating;
+    int StageCount;
+    TWorkerId StageIds[MAX_GRAPH_STAGES];
+    /* Outputs of stage i are Outputs[OutputOffsets[i]] to Outputs[OutputOffsets[i + 1] - 1] */
+    u16 OutputOffsets[MAX_GRAPH_STAGES + 1];
+    TWorkerId Outputs[MAX_GRAPH_EDGES];
+    char Name[MAX_WORKER_NAME_LEN];
+    /* Pad size to a multiple of cache line size */
+    void * _pad[0] ENV_CACHE_LINE_ALIGNED;
+} SGraph;
+
+typedef struct SGraphTable {
+    /* Lock serializing graph deployment and termination */
+    TSpinlock Lock;
+    void * _pad[0] ENV_CACHE_LINE_ALIGNED;
+    SGraph Graphs[MAX_GRAPH_COUNT];
+    /* Graph and stage index of each local worker (graph in the upper byte) or STAGE_NONE */
+    u16 StageOf[MAX_WORKER_COUNT];
+} SGraphTable;
+
+static bool IsGraphConfigValid(const SGraphConfig * config);
+static void PlaceStages(const SGraphConfig * config, SWorkerConfig workerConfigs[]);
+static void ResolveEdges(SGraph * graph, const SGraphConfig * config);
+static bool IsStageActive(TWorkerId workerId);
+static void DisconnectStage(SGraph * graph, int stage);
+static inline SGraph * FetchGraph(TGraphId graphId);
+static inline const SGraph * FetchCurrentStage(int * stage);
+static void DestroyCompletionMessage(TMessage completion);
+
+static SGraphTable * s_graphTable = NULL;
+
+void GraphsInit(void) {
+
+    s_graphTable = (SGraphTable *) env_shared_malloc(sizeof(SGraphTable));
+    AssertTrue(s_graphTable != NULL);
+    SpinlockInit(&s_graphTable->Lock);
+    for (TGraphId i = 0; i < MAX_GRAPH_COUNT; i++) {
+
+        SGraph * graph = &s_graphTable->Graphs[i];
+        SpinlockInit(&graph->Lock);
+        graph->InUse = false;
+        graph->Terminating = false;
+        graph->StageCount = 0;
+    }
+    for (int i = 0; i < MAX_WORKER_COUNT; i++) {
+
+        s_graphTable->StageOf[i] = STAGE_NONE;
+    }
+}
+
+void GraphsTeardown(void) {
+
+    /* Any stages left behind are terminated along with the other workers */
+    env_shared_free(s_graphTable);
+    s_graphTable = NULL;
+}
+
+void NoteStageTerminated(TWorkerId workerId) {
+
+    if (unlikely(s_graphTable == NULL)) {
+
+        return;
+    }
+
+    u16 stageOf = s_graphTable->StageOf[WorkerIdGetLocal(workerId)];
+    if (likely(stageOf == STAGE_NONE)) {
+
+        /* Not a stage or already disconnected by TerminateGraph */
+        return;
+    }
+
+    SGraph * graph = &s_graphTable->Graphs[stageOf >> 8];
+    int stage = stageOf & 0xFF;
+    SpinlockAcquire(&graph->Lock);
+    /* Recheck under the lock in case the graph is being terminated concurrently */
+    if (s_graphTable->StageOf[WorkerIdGetLocal(workerId)] == stageOf && graph->StageIds[stage] == workerId) {
+
+        /* Stage terminated outside of the graph's control (e.g. by itself) - disconnect it before
+         * its ID can be reused, so that messages along the edges into it get dropped instead */
+        DisconnectStage(graph, stage);
+    }
+    SpinlockRelease(&graph->Lock);
+}
+
+TGraphId DeployGraph(const SGraphConfig * config) {
+
+    if (unlikely(!IsGraphConfigValid(config))) {
+
+        return GRAPH_ID_INVALID;
+    }
+
+    /* Find a free slot */
+    SpinlockAcquire(&s_graphTable->Lock);
+    TGraphId graphId = 0;
+    while (graphId < MAX_GRAPH_COUNT && s_graphTable->Graphs[graphId].InUse) {
+
+        graphId++;
+    }
+
+    if (unlikely(graphId == MAX_GRAPH_COUNT)) {
+
+        SpinlockRelease(&s_graphTable->Lock);
+        LogPrint(ELogSeverityLevel_Error, "%s(): No free slot for graph '%s'", \
+            __FUNCTION__, config->Name);
+        return GRAPH_ID_INVALID;
+    }
+
+    SGraph * graph = &s_graphTable->Graphs[graphId];
+    graph->InUse = true;
+    /* Keep the graph to ourselves until all the stages are connected */
+    graph->Terminating = true;
+    graph->StageCount = 0;
+    /* Copy the name and ensure proper NULL-termination (see strncpy manpage) */
+    (void) strncpy(graph->Name, config->Name, sizeof(graph->Name) - 1);
+    graph->Name[sizeof(graph->Name) - 1] = '\0';
+    SpinlockRelease(&s_graphTable->Lock);
+
+    SWorkerConfig workerConfigs[MAX_GRAPH_STAGES];
+    PlaceStages(config, workerConfigs);
+
+    /* Deploy the stages without holding any locks - user init code is run synchronously. Messages
+     * sent to the stages before their deployment completes are buffered by the platform. */
+    int deployed = DeployWorkers(workerConfigs, graph->StageIds, config->StageCount, MESSAGE_INVALID, WORKER_ID_INVALID);
+    if (unlikely(deployed != config->StageCount)) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s(): Deployed %d out of %d stage(s) of graph '%s'", \
+            __FUNCTION__, deployed > 0 ? deployed : 0, config->StageCount, graph->Name);
+        if (deployed > 0) {
+
+            /* Tear down the stages whose deployment has started */
+            int started = 0;
+            for (int i = 0; i < config->StageCount; i++) {
+
+                if (graph->StageIds[i] != WORKER_ID_INVALID) {
+
+                    graph->StageIds[started++] = graph->StageIds[i];
+                }
+            }
+            (void) TerminateWorkers(graph->StageIds, started, MESSAGE_INVALID, WORKER_ID_INVALID);
+        }
+        SpinlockAcquire(&s_graphTable->Lock);
+        graph->Terminating = false;
+        graph->InUse = false;
+        SpinlockRelease(&s_graphTable->Lock);
+        return GRAPH_ID_INVALID;
+    }
+
+    /* Connect and publish the stages under the lock, so that each stage terminating from now on
+     * gets disconnected by NoteStageTerminated */
+    SpinlockAcquire(&graph->Lock);
+    graph->StageCount = config->StageCount;
+    ResolveEdges(graph, config);
+    for (int i = 0; i < graph->StageCount; i++) {
+
+        s_graphTable->StageOf[WorkerIdGetLocal(graph->StageIds[i])] = (u16) ((graphId << 8) | i);
+    }
+    /* The stages may have run ahead of the publication, and some may have terminated in the
+     * meantime unnoticed - disconnect them now instead of handing out their IDs */
+    for (int i = 0; i < graph->StageCount; i++) {
+
+        if (unlikely(!IsStageActive(graph->StageIds[i]))) {
+
+            DisconnectStage(graph, i);
+        }
+    }
+    graph->Terminating = false;
+    SpinlockRelease(&graph->Lock);
+
+    LogPrint(ELogSeverityLevel_Info, "Deployed graph '%s' (id: %d) with %d stage(s) and %d edge(s)", \
+        graph->Name, graphId, config->StageCount, config->EdgeCount);
+    return graphId;
+}
+
+int TerminateGraph(TGraphId graphId, TMessage completion, TWorkerId receiver) {
+
+    SGraph * graph = FetchGraph(graphId);
+    if (unlikely(graph == NULL)) {
+
+        RaiseException(EExceptionFatality_NonFatal, "Attempted to terminate invalid graph %d", graphId);
+        DestroyCompletionMessage(completion);
+        return -1;
+    }
+
+    SpinlockAcquire(&graph->Lock);
+    if (unlikely(graph->Terminating)) {
+
+        SpinlockRelease(&graph->Lock);
+        LogPrint(ELogSeverityLevel_Warning, "%s(): Graph %d is being deployed or terminated", \
+            __FUNCTION__, graphId);
+        DestroyCompletionMessage(completion);
+        return -1;
+    }
+    graph->Terminating = true;
+    SpinlockRelease(&graph->Lock);
+
+    LogPrint(ELogSeverityLevel_Info, "Terminating graph '%s' (id: %d)...", graph->Name, graphId);
+
+    /* Disconnect all the stages first so that no stage sends to a worker already torn down,
+     * skipping the ones that have terminated on their own */
+    TWorkerId stageIds[MAX_GRAPH_STAGES];
+    int stages = 0;
+    SpinlockAcquire(&graph->Lock);
+    for (int i = 0; i < graph->StageCount; i++) {
+
+        if (graph->StageIds[i] != WORKER_ID_INVALID) {
+
+            s_graphTable->StageOf[WorkerIdGetLocal(graph->StageIds[i])] = STAGE_NONE;
+            stageIds[stages++] = graph->StageIds[i];
+        }
+    }
+    SpinlockRelease(&graph->Lock);
+
+    int terminated = 0;
+    if (stages > 0) {
+
+        terminated = TerminateWorkers(stageIds, stages, completion, receiver);
+
+    } else if (completion != MESSAGE_INVALID) {
+
+        /* Nothing left to tear down */
+        SendMessage(completion, receiver);
+    }
+
+    SpinlockAcquire(&s_graphTable->Lock);
+    graph->StageCount = 0;
+    graph->Terminating = false;
+    graph->InUse = false;
+    SpinlockRelease(&s_graphTable->Lock);
+
+    return terminated;
+}
+
+TWorkerId GetGraphStage(TGraphId graphId, int stage) {
+
+    SGraph * graph = FetchGraph(graphId);
+    /* Do not hand out the stages before they are connected */
+    if (unlikely(graph == NULL || graph->Terminating || stage < 0 || stage >= graph->StageCount)) {
+
+        return WORKER_ID_INVALID;
+    }
+
+    return graph->StageIds[stage];
+}
+
+int GetStageOutputCount(void) {
+
+    int stage;
+    const SGraph * graph = FetchCurrentStage(&stage);
+    if (unlikely(graph == NULL)) {
+
+        return -1;
+    }
+
+    return graph->OutputOffsets[stage + 1] - graph->OutputOffsets[stage];
+}
+
+TWorkerId GetStageOutput(int output) {
+
+    int stage;
+    const SGraph * graph = FetchCurrentStage(&stage);
+    if (unlikely(graph == NULL || output < 0 \
+        || output >= graph->OutputOffsets[stage + 1] - graph->OutputOffsets[stage])) {
+
+        return WORKER_ID_INVALID;
+    }
+
+    return graph->Outputs[graph->OutputOffsets[stage] + output];
+}
+
+void SendMessageToOutput(TMessage message, int output) {
+
+    TWorkerId receiver = GetStageOutput(output);
+    if (unlikely(receiver == WORKER_ID_INVALID)) {
+
+        LogPrint(ELogSeverityLevel_Warning, "Failed to send message 0x%x along output %d - output not connected", \
+            GetMessageId(message), output);
+        DestroyMessage(message);
+        return;
+    }
+
+    SendMessage(message, receiver);
+}
+
+static bool IsGraphConfigValid(const SGraphConfig * config) {
+
+    if (unlikely(config == NULL || config->Name == NULL || config->Stages == NULL)) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Passed NULL pointer for graph config, name or stages");
+        return false;
+    }
+
+    if (unlikely(config->StageCount <= 0 || config->StageCount > MAX_GRAPH_STAGES \
+        || config->EdgeCount < 0 || config->EdgeCount > MAX_GRAPH_EDGES \
+        || (config->EdgeCount > 0 && config->Edges == NULL))) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Invalid number of stages (%d) or edges (%d) of graph '%s' (maximum: %d and %d)", \
+            config->StageCount, config->EdgeCount, config->Name, MAX_GRAPH_STAGES, MAX_GRAPH_EDGES);
+        return false;
+    }
+
+    for (int i = 0; i < config->StageCount; i++) {
+
+        if (unlikely(config->Stages[i].Cores < 0)) {
+
+            RaiseException(EExceptionFatality_NonFatal, \
+                "Invalid number of cores %d for stage %d of graph '%s'", \
+                config->Stages[i].Cores, i, config->Name);
+            return false;
+        }
+    }
+
+    for (int i = 0; i < config->EdgeCount; i++) {
+
+        const SGraphEdge * edge = &config->Edges[i];
+        if (unlikely(edge->From < 0 || edge->From >= config->StageCount \
+            || edge->To < 0 || edge->To >= config->StageCount)) {
+
+            RaiseException(EExceptionFatality_NonFatal, \
+                "Edge %d (%d -> %d) of graph '%s' refers to a nonexistent stage", \
+                i, edge->From, edge->To, config->Name);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void PlaceStages(const SGraphConfig * config, SWorkerConfig workerConfigs[]) {
+
+    /* Greedy placement (longest processing time first): visit the stages from the most costly one
+     * and put each onto the cores with the least cost assigned so far. This evens out the load of
+     * the cores, bounding the busiest one to within 4/3 of the optimum. */
+    u64 load[EM_MAX_CORES];
+    int unplaced[MAX_GRAPH_STAGES];
+    int unplacedCount = 0;
+    int coreCount = GetCoreCount() < EM_MAX_CORES ? GetCoreCount() : EM_MAX_CORES;
+    TCoreMask allCores = GetAllCoresMask();
+
+    for (int core = 0; core < coreCount; core++) {
+
+        load[core] = 0;
+    }
+
+    for (int i = 0; i < config->StageCount; i++) {
+
+        const SGraphStage * stage = &config->Stages[i];
+        workerConfigs[i] = stage->Worker;
+        if (CoreMaskIsEmpty(stage->Worker.CoreMask)) {
+
+            /* Keep the unplaced stages sorted by cost in descending order */
+            int j = unplacedCount++;
+            while (j > 0 && config->Stages[unplaced[j - 1]].Cost < stage->Cost) {
+
+                unplaced[j] = unplaced[j - 1];
+                j--;
+            }
+            unplaced[j] = i;
+
+        } else {
+
+            /* Account for the stages placed by the user */
+            u32 cost = stage->Cost ? stage->Cost : 1;
+            int cores = CoreMaskCount(stage->Worker.CoreMask);
+            for (int core = 0; core < coreCount; core++) {
+
+                if (CoreMaskContains(stage->Worker.CoreMask, core)) {
+
+                    load[core] += cost / cores;
+                }
+            }
+        }
+    }
+
+    char maskString[CORE_MASK_STRING_LEN];
+    for (int i = 0; i < unplacedCount; i++) {
+
+        const SGraphStage * stage = &config->Stages[unplaced[i]];
+        u32 cost = stage->Cost ? stage->Cost : 1;
+        int cores = stage->Worker.Parallel && stage->Cores > 1 ? stage->Cores : 1;
+        cores = cores < CoreMaskCount(allCores) ? cores : CoreMaskCount(allCores);
+
+        TCoreMask coreMask = CoreMaskEmpty();
+        for (int n = 0; n < cores; n++) {
+
+            /* Pick the least loaded core not yet taken by the stage */
+            int best = -1;
+            for (int core = 0; core < coreCount; core++) {
+
+                if (CoreMaskContains(allCores, core) && !CoreMaskContains(coreMask, core) \
+                    && (best < 0 || load[core] < load[best])) {
+
+                    best = core;
+                }
+            }
+            coreMask = CoreMaskAdd(coreMask, best);
+            load[best] += cost / cores;
+        }
+
+        workerConfigs[unplaced[i]].CoreMask = coreMask;
+        LogPrint(ELogSeverityLevel_Debug, "%s(): Placed stage %d of graph '%s' onto cores %s", \
+            __FUNCTION__, unplaced[i], config->Name, CoreMaskToString(coreMask, maskString, sizeof(maskString)));
+    }
+}
+
+static void ResolveEdges(SGraph * graph, const SGraphConfig * config) {
+
+    /* Group the edges by their source stage, keeping their relative order */
+    int edge = 0;
+    for (int stage = 0; stage < config->StageCount; stage++) {
+
+        graph->OutputOffsets[stage] = (u16) edge;
+        for (int i = 0; i < config->EdgeCount; i++) {
+
+            if (config->Edges[i].From == stage) {
+
+                graph->Outputs[edge++] = graph->StageIds[config->Edges[i].To];
+            }
+        }
+    }
+    graph->OutputOffsets[config->StageCount] = (u16) edge;
+}
+
+static inline SGraph * FetchGraph(TGraphId graphId) {
+
+    if (unlikely(graphId >= MAX_GRAPH_COUNT || !s_graphTable->Graphs[graphId].InUse)) {
+
+        return NULL;
+    }
+
+    return &s_graphTable->Graphs[graphId];
+}
+
+static bool IsStageActive(TWorkerId workerId) {
+
+    /* Dynamic IDs are recycled in FIFO order, so a stage's ID cannot have been
+     * taken by another worker in the short window before the stages got published */
+    LockWorkerTableEntry(workerId);
+    bool active = FetchWorkerRoute(workerId)->State == EWorkerState_Active \
+        && FetchWorkerContext(workerId)->WorkerId == workerId;
+    UnlockWorkerTableEntry(workerId);
+    return active;
+}
+
+static void DisconnectStage(SGraph * graph, int stage) {
+
+    /* Graph lock held by the caller */
+    TWorkerId workerId = graph->StageIds[stage];
+    s_graphTable->StageOf[WorkerIdGetLocal(workerId)] = STAGE_NONE;
+    graph->StageIds[stage] = WORKER_ID_INVALID;
+    for (int i = 0; i < graph->OutputOffsets[graph->StageCount]; i++) {
+
+        if (graph->Outputs[i] == workerId) {
+
+            graph->Outputs[i] = WORKER_ID_INVALID;
+        }
+    }
+    LogPrint(ELogSeverityLevel_Warning, "Stage %d of graph '%s' terminated - edges into it disconnected", \
+        stage, graph->Name);
+}
+
+static inline const SGraph * FetchCurrentStage(int * stage) {
+
+    if (unlikely(g_currentWorker.Context == NULL)) {
+
+        /* Not called from a worker */
+        return NULL;
+    }
+
+    u16 stageOf = s_graphTable->StageOf[WorkerIdGetLocal(g_currentWorker.WorkerId)];
+    if (unlikely(stageOf == STAGE_NONE)) {
+
+        return NULL;
+    }
+
+    *stage = stageOf & 0xFF;
+    return &s_graphTable->Graphs[stageOf >> 8];
+}
+
+static void DestroyCompletionMessage(TMessage completion) {
+
+    if (completion != MESSAGE_INVALID) {
+
+        DestroyMessage(completion);
+    }
+}
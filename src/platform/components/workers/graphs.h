@@ -0,0 +1,11 @@
+
+#ifndef PLATFORM_COMPONENTS_WORKERS_GRAPHS_H
+#define PLATFORM_COMPONENTS_WORKERS_GRAPHS_H
+
+#include <menabrea/graphs.h>
+
+void GraphsInit(void);
+void GraphsTeardown(void);
+void NoteStageTerminated(TWorkerId workerId);
+
+#endif /* PLATFORM_COMPONENTS_WORKERS_GRAPHS_H */
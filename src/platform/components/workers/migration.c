@@ -0,0 +1,260 @@
+#include <workers/migration.h>
+#include <workers/completion_daemon.h>
+#include <workers/worker_table.h>
+#include <workers/fusion.h>
+#include <messaging/message.h>
+#include <overload/overload.h>
+#include <cores/queue_groups.h>
+#include <menabrea/workers.h>
+#include <menabrea/cores.h>
+#include <menabrea/exception.h>
+#include <menabrea/log.h>
+#include <event_machine.h>
+
+#define STAGED_MESSAGES_BURST  16
+
+/* Migrating a worker takes three steps:
+ *   1. SetWorkerCoreMask creates the target queue in the group of the new core mask and an unscheduled
+ *      staging queue. Under the worker table entry lock it redirects the senders to the staging queue
+ *      and sends a marker event to the source queue - the last event the source queue will ever get.
+ *   2. When the worker receives the marker, it has processed everything sent to the source queue.
+ *      HandOverWorkerQueue moves the staged messages to the target queue in order, switches the
+ *      senders over to the target queue and detaches the source queue from the EO.
+ *   3. Once the source queue has been detached, the completion daemon deletes it and releases its
+ *      queue group, which ends the migration. */
+
+static void AbortMigration(SWorkerContext * context);
+
+int SetWorkerCoreMask(TWorkerId workerId, TCoreMask coreMask) {
+
+    if (unlikely(WorkerIdGetNode(workerId) != GetOwnNodeId() || WorkerIdGetLocal(workerId) >= MAX_WORKER_COUNT)) {
+
+        RaiseException(EExceptionFatality_NonFatal, "Attempted to migrate invalid or remote worker 0x%x", \
+            workerId);
+        return -1;
+    }
+
+    /* Allocate the marker up front - it later doubles as the notification to the completion daemon */
+    em_event_t marker = em_alloc(sizeof(SDaemonNotification), EM_EVENT_TYPE_SW, EM_POOL_DEFAULT);
+    if (unlikely(marker == EM_EVENT_UNDEF)) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to allocate a marker event when migrating worker 0x%x", \
+            __FUNCTION__, workerId);
+        return -1;
+    }
+    SDaemonNotification * notification = (SDaemonNotification *) em_event_pointer(marker);
+    notification->Request = EDaemonRequest_CompleteMigration;
+    notification->WorkerId = workerId;
+
+    char maskString[CORE_MASK_STRING_LEN];
+    LockWorkerTableEntry(workerId);
+    SWorkerContext * context = FetchWorkerContext(workerId);
+    SWorkerRoute * route = FetchWorkerRoute(workerId);
+
+    if (unlikely(route->State != EWorkerState_Active || context->WorkerId != workerId \
+        || context->Migration.InProgress || context->TerminationRequested)) {
+
+        EWorkerState state = route->State;
+        bool migrating = context->Migration.InProgress;
+        UnlockWorkerTableEntry(workerId);
+        em_free(marker);
+        LogPrint(ELogSeverityLevel_Warning, "%s(): Cannot migrate worker 0x%x (state: %d, migration in progress: %d)", \
+            __FUNCTION__, workerId, state, migrating);
+        return -1;
+    }
+
+    if (CoreMaskEqual(coreMask, context->CoreMask)) {
+
+        /* Nothing to do */
+        UnlockWorkerTableEntry(workerId);
+        em_free(marker);
+        return 0;
+    }
+
+    if (unlikely((context->UserLocalInit != NULL || context->UserLocalExit != NULL) \
+        && !CoreMaskIsSubset(coreMask, context->HostMask))) {
+
+        UnlockWorkerTableEntry(workerId);
+        em_free(marker);
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Worker 0x%x has per-core callbacks and cannot be moved outside of its original core mask (requested: %s)", \
+            workerId, CoreMaskToString(coreMask, maskString, sizeof(maskString)));
+        return -1;
+    }
+
+    SWorkerMigration * migration = &context->Migration;
+    em_queue_group_t queueGroup = AcquireQueueGroup(coreMask);
+    if (unlikely(queueGroup == EM_QUEUE_GROUP_UNDEF)) {
+
+        UnlockWorkerTableEntry(workerId);
+        em_free(marker);
+        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to get queue group for worker 0x%x (core mask: %s)", \
+            __FUNCTION__, workerId, CoreMaskToString(coreMask, maskString, sizeof(maskString)));
+        return -1;
+    }
+
+    migration->TargetQueue = em_queue_create(
+        context->Name,
+        context->Parallel ? EM_QUEUE_TYPE_PARALLEL : EM_QUEUE_TYPE_ATOMIC,
+        EM_QUEUE_PRIO_NORMAL,
+        queueGroup,
+        NULL
+    );
+    /* Messages sent while the worker drains its source queue are parked in an unscheduled queue */
+    migration->StagingQueue = em_queue_create(
+        context->Name,
+        EM_QUEUE_TYPE_UNSCHEDULED,
+        EM_QUEUE_PRIO_UNDEF,
+        EM_QUEUE_GROUP_UNDEF,
+        NULL
+    );
+    migration->SourceQueue = route->Queue;
+    migration->SourceMask = context->CoreMask;
+    migration->TargetMask = coreMask;
+    migration->Marker = marker;
+
+    if (unlikely(migration->TargetQueue == EM_QUEUE_UNDEF || migration->StagingQueue == EM_QUEUE_UNDEF)) {
+
+        AbortMigration(context);
+        UnlockWorkerTableEntry(workerId);
+        em_free(marker);
+        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to create queues for worker 0x%x", \
+            __FUNCTION__, workerId);
+        return -1;
+    }
+
+    /* Mark the migration in progress before sending the marker so that the worker recognizes it */
+    migration->InProgress = true;
+    if (unlikely(EM_OK != em_send(marker, migration->SourceQueue))) {
+
+        AbortMigration(context);
+        UnlockWorkerTableEntry(workerId);
+        em_free(marker);
+        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to send the marker to worker 0x%x", \
+            __FUNCTION__, workerId);
+        return -1;
+    }
+
+    /* Senders hold the lock, so no message can be sent to the source queue after the marker */
+    route->Queue = migration->StagingQueue;
+    /* Nothing is sent to the target queue before the marker is received, so it is enabled in time */
+    AssertTrue(EM_OK == em_eo_add_queue(context->Eo, migration->TargetQueue, 0, NULL));
+    UnlockWorkerTableEntry(workerId);
+
+    LogPrint(ELogSeverityLevel_Info, "Migrating worker 0x%x to cores %s...", \
+        workerId, CoreMaskToString(coreMask, maskString, sizeof(maskString)));
+
+    return 0;
+}
+
+void HandOverWorkerQueue(SWorkerContext * context) {
+
+    TWorkerId workerId = context->WorkerId;
+    int messagesDropped = 0;
+
+    LockWorkerTableEntry(workerId);
+    SWorkerMigration * migration = &context->Migration;
+    em_event_t marker = migration->Marker;
+    /* Forget the handle before the event is freed and possibly reused */
+    migration->Marker = EM_EVENT_UNDEF;
+
+    /* Move the messages staged in the meantime, preserving their order */
+    em_event_t staged[STAGED_MESSAGES_BURST];
+    int count;
+    while ((count = em_queue_dequeue_multi(migration->StagingQueue, staged, STAGED_MESSAGES_BURST)) > 0) {
+
+        int sent = em_send_multi(staged, count, migration->TargetQueue);
+        sent = sent > 0 ? sent : 0;
+        for (int i = sent; i < count; i++) {
+
+            /* We are still the owners of the message and must return it to the system */
+            DestroyMessage(staged[i]);
+            messagesDropped++;
+        }
+    }
+    /* Messages dropped will never be received */
+    NoteMessagesQueued(FetchWorkerRoute(workerId), -messagesDropped);
+
+    /* Let the senders use the target queue directly */
+    FetchWorkerRoute(workerId)->Queue = migration->TargetQueue;
+    context->CoreMask = migration->TargetMask;
+    AssertTrue(EM_OK == em_queue_delete(migration->StagingQueue));
+    migration->StagingQueue = EM_QUEUE_UNDEF;
+
+    /* Detach the source queue asynchronously - removing it synchronously from the worker's
+     * own receive function is not allowed */
+    em_notif_t notif = {
+        .event = marker,
+        .queue = GetCompletionDaemonQueue(),
+        .egroup = EM_EVENT_GROUP_UNDEF
+    };
+    AssertTrue(EM_OK == em_eo_remove_queue(context->Eo, migration->SourceQueue, 1, &notif));
+    UnlockWorkerTableEntry(workerId);
+
+    if (unlikely(messagesDropped)) {
+
+        /* The messages had been accounted for as delivered */
+        NoteMessagesConsumed(messagesDropped);
+        LogPrint(ELogSeverityLevel_Error, "Failed to move %d message(s) to the new queue of worker 0x%x", \
+            messagesDropped, workerId);
+    }
+}
+
+void CompleteWorkerMigration(TWorkerId workerId) {
+
+    char maskString[CORE_MASK_STRING_LEN];
+    LockWorkerTableEntry(workerId);
+    SWorkerContext * context = FetchWorkerContext(workerId);
+    SWorkerMigration * migration = &context->Migration;
+
+    /* Termination is deferred while the migration is in progress */
+    AssertTrue(FetchWorkerRoute(workerId)->State == EWorkerState_Active);
+    AssertTrue(migration->InProgress);
+
+    /* Nothing can have been sent to the source queue after the marker, so it is empty */
+    AssertTrue(EM_OK == em_queue_delete(migration->SourceQueue));
+    ReleaseQueueGroup(migration->SourceMask);
+    migration->SourceQueue = EM_QUEUE_UNDEF;
+    migration->TargetQueue = EM_QUEUE_UNDEF;
+    migration->InProgress = false;
+    (void) CoreMaskToString(context->CoreMask, maskString, sizeof(maskString));
+
+    if (!context->TerminationRequested) {
+
+        UnlockWorkerTableEntry(workerId);
+        LogPrint(ELogSeverityLevel_Info, "Migrated worker 0x%x to cores %s", workerId, maskString);
+
+    } else {
+
+        /* Termination requested during the migration and now pending. Note that we
+         * cannot call TerminateWorker because we hold the lock. */
+        MarkTeardownInProgress(workerId);
+        /* Stop the EO - context will be released in the EO stop callback */
+        em_notif_t * notif = &context->TerminationNotif;
+        AssertTrue(EM_OK == em_eo_stop(context->Eo, notif->event != EM_EVENT_UNDEF ? 1 : 0, notif));
+        UnlockWorkerTableEntry(workerId);
+
+        LogPrint(ELogSeverityLevel_Info, "Termination of worker 0x%x requested during migration and now in progress", \
+            workerId);
+    }
+}
+
+static void AbortMigration(SWorkerContext * context) {
+
+    SWorkerMigration * migration = &context->Migration;
+    if (migration->TargetQueue != EM_QUEUE_UNDEF) {
+
+        AssertTrue(EM_OK == em_queue_delete(migration->TargetQueue));
+    }
+    if (migration->StagingQueue != EM_QUEUE_UNDEF) {
+
+        AssertTrue(EM_OK == em_queue_delete(migration->StagingQueue));
+    }
+    ReleaseQueueGroup(migration->TargetMask);
+
+    migration->InProgress = false;
+    migration->Marker = EM_EVENT_UNDEF;
+    migration->SourceQueue = EM_QUEUE_UNDEF;
+    migration->StagingQueue = EM_QUEUE_UNDEF;
+    migration->TargetQueue = EM_QUEUE_UNDEF;
+}
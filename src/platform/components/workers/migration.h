@@ -0,0 +1,32 @@
+
+#ifndef PLATFORM_COMPONENTS_WORKERS_MIGRATION_H
+#define PLATFORM_COMPONENTS_WORKERS_MIGRATION_H
+
+#include <workers/worker_table.h>
+#include <menabrea/common.h>
+#include <event_machine.h>
+
+/**
+ * @brief Check if an event received by a worker is the marker of a pending migration
+ * @param context Worker context
+ * @param event Event received
+ * @return True if all messages sent to the worker's source queue have been received
+ */
+static inline bool IsMigrationMarker(const SWorkerContext * context, em_event_t event) {
+
+    return unlikely(context->Migration.InProgress) && event == context->Migration.Marker;
+}
+
+/**
+ * @brief Switch the worker over to the target queue once the marker has been received
+ * @param context Worker context
+ */
+void HandOverWorkerQueue(SWorkerContext * context);
+
+/**
+ * @brief Delete the source queue once detached from the worker's EO and complete the migration
+ * @param workerId Worker ID
+ */
+void CompleteWorkerMigration(TWorkerId workerId);
+
+#endif /* PLATFORM_COMPONENTS_WORKERS_MIGRATION_H */
@@ -0,0 +1,396 @@
+#include <workers/pools.h>
+#include <workers/worker_table.h>
+#include <menabrea/pools.h>
+#include <menabrea/log.h>
+#include <menabrea/exception.h>
+#include <menabrea/common.h>
+#include <event_machine.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SHARD_NONE  ( (u16) 0xFFFF )
+
+typedef struct SWorkerPool {
+    /* Lock guarding the pool's configuration and shard slots - not held by the senders */
+    TSpinlock Lock;
+    bool InUse;
+    bool Resizing;
+    /* Number of shards published to the senders */
+    TAtomic32 Shards;
+    TWorkerId ShardIds[MAX_WORKER_POOL_SHARDS];
+    SWorkerConfig Template;
+    char Name[MAX_WORKER_NAME_LEN];
+    /* Pad size to a multiple of cache line size */
+    void * _pad[0] ENV_CACHE_LINE_ALIGNED;
+} SWorkerPool;
+
+typedef struct SWorkerPoolTable {
+    /* Lock serializing pool deployment and termination */
+    TSpinlock Lock;
+    /* Pool and shard index of each local worker (pool in the upper byte) or SHARD_NONE */
+    u16 ShardOf[MAX_WORKER_COUNT];
+    void * _pad[0] ENV_CACHE_LINE_ALIGNED;
+    SWorkerPool Pools[MAX_WORKER_POOL_COUNT];
+} SWorkerPoolTable;
+
+static int ResizePool(SWorkerPool * pool, int shards);
+static int DeployShard(SWorkerPool * pool, int shard);
+static inline SWorkerPool * FetchPool(TWorkerPoolId poolId);
+static inline int JumpConsistentHash(u64 key, int buckets);
+
+static SWorkerPoolTable * s_poolTable = NULL;
+
+void WorkerPoolsInit(void) {
+
+    s_poolTable = (SWorkerPoolTable *) env_shared_malloc(sizeof(SWorkerPoolTable));
+    AssertTrue(s_poolTable != NULL);
+    SpinlockInit(&s_poolTable->Lock);
+    for (TWorkerId i = 0; i < MAX_WORKER_COUNT; i++) {
+
+        s_poolTable->ShardOf[i] = SHARD_NONE;
+    }
+    for (TWorkerPoolId i = 0; i < MAX_WORKER_POOL_COUNT; i++) {
+
+        SWorkerPool * pool = &s_poolTable->Pools[i];
+        SpinlockInit(&pool->Lock);
+        Atomic32Init(&pool->Shards);
+        pool->InUse = false;
+        pool->Resizing = false;
+    }
+}
+
+void WorkerPoolsTeardown(void) {
+
+    /* Any shards left behind are terminated along with the other workers */
+    env_shared_free(s_poolTable);
+    s_poolTable = NULL;
+}
+
+void NoteShardTerminated(TWorkerId workerId) {
+
+    if (unlikely(s_poolTable == NULL)) {
+
+        return;
+    }
+
+    u16 shardOf = s_poolTable->ShardOf[WorkerIdGetLocal(workerId)];
+    if (likely(shardOf == SHARD_NONE)) {
+
+        /* Not a shard */
+        return;
+    }
+    s_poolTable->ShardOf[WorkerIdGetLocal(workerId)] = SHARD_NONE;
+
+    SWorkerPool * pool = &s_poolTable->Pools[shardOf >> 8];
+    int shard = shardOf & 0xFF;
+    SpinlockAcquire(&pool->Lock);
+    if (unlikely(pool->ShardIds[shard] == workerId)) {
+
+        /* Shard terminated outside of the pool's control (e.g. by itself) - stop routing to its ID,
+         * which may soon be reused, but keep the slot so that the other keys stay put */
+        pool->ShardIds[shard] = WORKER_ID_INVALID;
+        LogPrint(ELogSeverityLevel_Warning, "Shard %d of worker pool '%s' terminated - keys mapped to it are dropped until the pool is resized", \
+            shard, pool->Name);
+    }
+    SpinlockRelease(&pool->Lock);
+}
+
+TWorkerPoolId DeployWorkerPool(const SWorkerPoolConfig * config) {
+
+    if (unlikely(config == NULL || config->Shard.Name == NULL)) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Passed NULL pointer for worker pool config or name");
+        return WORKER_POOL_ID_INVALID;
+    }
+
+    if (unlikely(config->Shards < 0 || config->Shards > MAX_WORKER_POOL_SHARDS)) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Invalid number of shards %d for worker pool '%s' (maximum: %d)", \
+            config->Shards, config->Shard.Name, MAX_WORKER_POOL_SHARDS);
+        return WORKER_POOL_ID_INVALID;
+    }
+
+    if (unlikely(config->Shard.WorkerId != WORKER_ID_INVALID || config->Shard.Parallel)) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Shards of worker pool '%s' must be atomic and use dynamic worker IDs", \
+            config->Shard.Name);
+        return WORKER_POOL_ID_INVALID;
+    }
+
+    /* Find a free slot */
+    SpinlockAcquire(&s_poolTable->Lock);
+    TWorkerPoolId poolId = 0;
+    while (poolId < MAX_WORKER_POOL_COUNT && s_poolTable->Pools[poolId].InUse) {
+
+        poolId++;
+    }
+
+    if (unlikely(poolId == MAX_WORKER_POOL_COUNT)) {
+
+        SpinlockRelease(&s_poolTable->Lock);
+        LogPrint(ELogSeverityLevel_Error, "%s(): No free slot for worker pool '%s'", \
+            __FUNCTION__, config->Shard.Name);
+        return WORKER_POOL_ID_INVALID;
+    }
+
+    SWorkerPool * pool = &s_poolTable->Pools[poolId];
+    pool->InUse = true;
+    /* Keep the pool to ourselves until the initial shards are deployed */
+    pool->Resizing = true;
+    Atomic32Set(&pool->Shards, 0);
+    pool->Template = config->Shard;
+    /* Copy the name and ensure proper NULL-termination (see strncpy manpage) */
+    (void) strncpy(pool->Name, config->Shard.Name, sizeof(pool->Name) - 1);
+    pool->Name[sizeof(pool->Name) - 1] = '\0';
+    pool->Template.Name = pool->Name;
+    SpinlockRelease(&s_poolTable->Lock);
+
+    /* Deploy the shards without holding any locks - user init code is run synchronously */
+    if (unlikely(0 != ResizePool(pool, config->Shards))) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to deploy the shards of worker pool '%s'", \
+            __FUNCTION__, pool->Name);
+        (void) ResizePool(pool, 0);
+        SpinlockAcquire(&s_poolTable->Lock);
+        pool->Resizing = false;
+        pool->InUse = false;
+        SpinlockRelease(&s_poolTable->Lock);
+        return WORKER_POOL_ID_INVALID;
+    }
+
+    SpinlockAcquire(&pool->Lock);
+    pool->Resizing = false;
+    SpinlockRelease(&pool->Lock);
+
+    LogPrint(ELogSeverityLevel_Info, "Deployed worker pool '%s' (id: %d) with %d shard(s)", \
+        pool->Name, poolId, config->Shards);
+    return poolId;
+}
+
+void TerminateWorkerPool(TWorkerPoolId poolId) {
+
+    SWorkerPool * pool = FetchPool(poolId);
+    if (unlikely(pool == NULL)) {
+
+        RaiseException(EExceptionFatality_NonFatal, "Attempted to terminate invalid worker pool %d", poolId);
+        return;
+    }
+
+    SpinlockAcquire(&pool->Lock);
+    if (unlikely(pool->Resizing)) {
+
+        SpinlockRelease(&pool->Lock);
+        LogPrint(ELogSeverityLevel_Warning, "%s(): Worker pool %d is being resized or terminated", \
+            __FUNCTION__, poolId);
+        return;
+    }
+    pool->Resizing = true;
+    SpinlockRelease(&pool->Lock);
+
+    LogPrint(ELogSeverityLevel_Info, "Terminating worker pool '%s' (id: %d)...", pool->Name, poolId);
+    (void) ResizePool(pool, 0);
+
+    SpinlockAcquire(&s_poolTable->Lock);
+    pool->Resizing = false;
+    pool->InUse = false;
+    SpinlockRelease(&s_poolTable->Lock);
+}
+
+int ResizeWorkerPool(TWorkerPoolId poolId, int shards) {
+
+    SWorkerPool * pool = FetchPool(poolId);
+    if (unlikely(pool == NULL || shards < 0 || shards > MAX_WORKER_POOL_SHARDS)) {
+
+        RaiseException(EExceptionFatality_NonFatal, "Invalid worker pool %d or number of shards %d", \
+            poolId, shards);
+        return -1;
+    }
+
+    SpinlockAcquire(&pool->Lock);
+    if (unlikely(pool->Resizing)) {
+
+        SpinlockRelease(&pool->Lock);
+        LogPrint(ELogSeverityLevel_Warning, "%s(): Worker pool %d is already being resized or terminated", \
+            __FUNCTION__, poolId);
+        return -1;
+    }
+    pool->Resizing = true;
+    SpinlockRelease(&pool->Lock);
+
+    int shardsBefore = (int) Atomic32Get(&pool->Shards);
+    int status = ResizePool(pool, shards);
+    LogPrint(ELogSeverityLevel_Info, "Resized worker pool '%s' (id: %d) from %d to %d shard(s)", \
+        pool->Name, poolId, shardsBefore, (int) Atomic32Get(&pool->Shards));
+
+    SpinlockAcquire(&pool->Lock);
+    pool->Resizing = false;
+    SpinlockRelease(&pool->Lock);
+
+    return status;
+}
+
+int GetWorkerPoolSize(TWorkerPoolId poolId) {
+
+    SWorkerPool * pool = FetchPool(poolId);
+    return pool != NULL ? (int) Atomic32Get(&pool->Shards) : -1;
+}
+
+TWorkerId GetWorkerPoolShard(TWorkerPoolId poolId, int shard) {
+
+    SWorkerPool * pool = FetchPool(poolId);
+    if (unlikely(pool == NULL || shard < 0 || shard >= (int) Atomic32Get(&pool->Shards))) {
+
+        return WORKER_ID_INVALID;
+    }
+
+    return pool->ShardIds[shard];
+}
+
+int GetWorkerPoolStatistics(TWorkerPoolId poolId, int shard, SWorkerStatistics * statistics) {
+
+    TWorkerId workerId = GetWorkerPoolShard(poolId, shard);
+    if (unlikely(workerId == WORKER_ID_INVALID)) {
+
+        return -1;
+    }
+
+    return GetWorkerStatistics(workerId, statistics);
+}
+
+void SendMessageKeyed(TMessage message, TWorkerPoolId poolId, u64 key) {
+
+    SWorkerPool * pool = FetchPool(poolId);
+    if (unlikely(pool == NULL)) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Invalid worker pool %d for message 0x%x. Message not sent!", \
+            poolId, GetMessageId(message));
+        DestroyMessage(message);
+        return;
+    }
+
+    /* Shards are published only once deployed and unpublished before being terminated,
+     * so the senders need not take the lock */
+    int shards = (int) Atomic32Get(&pool->Shards);
+    if (unlikely(shards == 0)) {
+
+        LogPrint(ELogSeverityLevel_Warning, "Failed to send message 0x%x to worker pool %d - no shards deployed", \
+            GetMessageId(message), poolId);
+        DestroyMessage(message);
+        return;
+    }
+
+    TWorkerId shardId = pool->ShardIds[JumpConsistentHash(key, shards)];
+    if (unlikely(shardId == WORKER_ID_INVALID)) {
+
+        LogPrint(ELogSeverityLevel_Warning, "Failed to send message 0x%x to worker pool %d - shard terminated", \
+            GetMessageId(message), poolId);
+        DestroyMessage(message);
+        return;
+    }
+
+    SendMessage(message, shardId);
+}
+
+static int ResizePool(SWorkerPool * pool, int shards) {
+
+    /* The caller has set the resizing flag - we are the only one changing the number of shards,
+     * but the slots may still be cleared concurrently by shards terminating themselves */
+    int current = (int) Atomic32Get(&pool->Shards);
+
+    /* Remove shards from the end, unpublishing each one before terminating it */
+    while (current > shards) {
+
+        current--;
+        Atomic32Set(&pool->Shards, current);
+        SpinlockAcquire(&pool->Lock);
+        TWorkerId workerId = pool->ShardIds[current];
+        pool->ShardIds[current] = WORKER_ID_INVALID;
+        SpinlockRelease(&pool->Lock);
+        if (workerId != WORKER_ID_INVALID) {
+
+            TerminateWorker(workerId);
+        }
+    }
+
+    /* Replace the shards that have terminated on their own */
+    for (int shard = 0; shard < current; shard++) {
+
+        if (pool->ShardIds[shard] == WORKER_ID_INVALID && unlikely(0 != DeployShard(pool, shard))) {
+
+            return -1;
+        }
+    }
+
+    /* Add shards at the end, publishing each one once deployed */
+    while (current < shards) {
+
+        if (unlikely(0 != DeployShard(pool, current))) {
+
+            return -1;
+        }
+        current++;
+        Atomic32Set(&pool->Shards, current);
+    }
+
+    return 0;
+}
+
+static int DeployShard(SWorkerPool * pool, int shard) {
+
+    char shardName[MAX_WORKER_NAME_LEN];
+    (void) snprintf(shardName, sizeof(shardName), "%s_%d", pool->Name, shard);
+    SWorkerConfig shardConfig = pool->Template;
+    shardConfig.Name = shardName;
+
+    TWorkerId workerId = DeployWorker(&shardConfig);
+    if (unlikely(workerId == WORKER_ID_INVALID)) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to deploy shard %d of worker pool '%s'", \
+            __FUNCTION__, shard, pool->Name);
+        return -1;
+    }
+
+    /* Messages sent before the shard's deployment completes are buffered by the platform */
+    s_poolTable->ShardOf[WorkerIdGetLocal(workerId)] = (u16) (((pool - s_poolTable->Pools) << 8) | shard);
+    SpinlockAcquire(&pool->Lock);
+    pool->ShardIds[shard] = workerId;
+    SpinlockRelease(&pool->Lock);
+    return 0;
+}
+
+static inline SWorkerPool * FetchPool(TWorkerPoolId poolId) {
+
+    if (unlikely(poolId >= MAX_WORKER_POOL_COUNT || !s_poolTable->Pools[poolId].InUse)) {
+
+        return NULL;
+    }
+
+    return &s_poolTable->Pools[poolId];
+}
+
+static inline int JumpConsistentHash(u64 key, int buckets) {
+
+    /* Lamping and Veach's jump consistent hash - growing the number of buckets from n to n + 1
+     * only moves 1/(n + 1) of the keys, all of them to the new bucket, and needs no lookup table.
+     * Mix the key first (SplitMix64 finalizer) so that small sequential keys spread evenly. */
+    key ^= key >> 30;
+    key *= 0xBF58476D1CE4E5B9ULL;
+    key ^= key >> 27;
+    key *= 0x94D049BB133111EBULL;
+    key ^= key >> 31;
+
+    i64 bucket = -1;
+    i64 jump = 0;
+    while (jump < buckets) {
+
+        bucket = jump;
+        key = key * 2862933555777941757ULL + 1;
+        jump = (i64) ((bucket + 1) * ((double) (1LL << 31) / (double) ((key >> 33) + 1)));
+    }
+
+    return (int) bucket;
+}
@@ -0,0 +1,11 @@
+
+#ifndef PLATFORM_COMPONENTS_WORKERS_POOLS_H
+#define PLATFORM_COMPONENTS_WORKERS_POOLS_H
+
+#include <menabrea/pools.h>
+
+void WorkerPoolsInit(void);
+void WorkerPoolsTeardown(void);
+void NoteShardTerminated(TWorkerId workerId);
+
+#endif /* PLATFORM_COMPONENTS_WORKERS_POOLS_H */
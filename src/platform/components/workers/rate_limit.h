@@ -0,0 +1,58 @@
+
+#ifndef PLATFORM_COMPONENTS_WORKERS_RATE_LIMIT_H
+#define PLATFORM_COMPONENTS_WORKERS_RATE_LIMIT_H
+
+#include <menabrea/common.h>
+#include <odp_api.h>
+
+/* Token bucket limiting the rate at which messages are delivered to a worker. Tokens are
+ * scaled by the number of nanoseconds in a second, so that refilling the bucket for an
+ * elapsed time takes a single multiplication by the rate. */
+typedef struct SRateLimiter {
+    u64 Rate;        /* Messages per second or zero if unlimited */
+    u64 Capacity;    /* Burst size (scaled) */
+    u64 Tokens;      /* Tokens available (scaled) */
+    u64 LastRefill;  /* Global time of the last refill in nanoseconds */
+} SRateLimiter;
+
+/**
+ * @brief Set up a rate limiter with a full bucket
+ * @param limiter Rate limiter
+ * @param rate Sustained rate in messages per second or zero to disable the limiter
+ * @param burst Maximum number of messages admitted at once (treated as one if zero)
+ */
+static inline void RateLimiterInit(SRateLimiter * limiter, u32 rate, u32 burst) {
+
+    limiter->Rate = rate;
+    limiter->Capacity = (u64) (burst > 0 ? burst : 1) * ODP_TIME_SEC_IN_NS;
+    limiter->Tokens = limiter->Capacity;
+    limiter->LastRefill = rate > 0 ? odp_time_global_ns() : 0;
+}
+
+/**
+ * @brief Take tokens for a burst of messages
+ * @param limiter Rate limiter (synchronized by the caller)
+ * @param count Number of messages
+ * @return Number of messages admitted, counting from the start of the burst
+ */
+static inline int RateLimiterAdmit(SRateLimiter * limiter, int count) {
+
+    if (likely(limiter->Rate == 0)) {
+
+        return count;
+    }
+
+    u64 now = odp_time_global_ns();
+    u64 elapsed = now > limiter->LastRefill ? now - limiter->LastRefill : 0;
+    u64 deficit = limiter->Capacity - limiter->Tokens;
+    /* Compare before multiplying to rule out an overflow after a long idle period */
+    limiter->Tokens = elapsed > deficit / limiter->Rate ? limiter->Capacity : limiter->Tokens + elapsed * limiter->Rate;
+    limiter->LastRefill = now;
+
+    u64 available = limiter->Tokens / ODP_TIME_SEC_IN_NS;
+    int admitted = available < (u64) count ? (int) available : count;
+    limiter->Tokens -= (u64) admitted * ODP_TIME_SEC_IN_NS;
+    return admitted;
+}
+
+#endif /* PLATFORM_COMPONENTS_WORKERS_RATE_LIMIT_H */
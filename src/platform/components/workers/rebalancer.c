@@ -0,0 +1,148 @@
+#include <workers/rebalancer.h>
+#include <workers/worker_table.h>
+#include <overload/overload.h>
+#include <menabrea/workers.h>
+#include <menabrea/input.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+#include <menabrea/exception.h>
+#include <event_machine.h>
+#include <odp_api.h>
+#include <stdlib.h>
+
+#define REBALANCING_PERIOD_NS  ODP_TIME_SEC_IN_NS
+/* Minimum utilisation gap in percent between the busiest and the idlest core for a worker to be moved */
+#define REBALANCING_MIN_GAP    20
+
+static void RebalancingPoll(void * arg);
+static TWorkerId PickWorkerToMove(int busiestCore, int idlestCore, u32 gap, u64 elapsed);
+static inline TCoreMask ShiftCoreMask(const SWorkerContext * context, int from, int to);
+
+/* Time each worker spent in its body on each core at the previous pass - used on the shared core only */
+static u64 * s_handlerTimeSnapshot = NULL;
+static u64 s_lastPass = 0;
+
+void RebalancerInit(void) {
+
+    if (unlikely(!IsOverloadManagerEnabled())) {
+
+        /* Core utilisation would always read zero - nothing to rebalance on */
+        LogPrint(ELogSeverityLevel_Warning, "%s(): Worker rebalancing requires the overload manager, rebalancing disabled", \
+            __FUNCTION__);
+        return;
+    }
+
+    /* Private to each process, but only ever touched on the shared core */
+    s_handlerTimeSnapshot = calloc(MAX_WORKER_COUNT * em_core_count(), sizeof(u64));
+    AssertTrue(s_handlerTimeSnapshot != NULL);
+    RegisterInputPolling(RebalancingPoll, NULL, GetSharedCoreMask());
+    LogPrint(ELogSeverityLevel_Info, "Worker rebalancing enabled");
+}
+
+void RebalancerTeardown(void) {
+
+    free(s_handlerTimeSnapshot);
+    s_handlerTimeSnapshot = NULL;
+}
+
+static void RebalancingPoll(void * arg) {
+
+    (void) arg;
+
+    u64 now = odp_time_local_ns();
+    u64 elapsed = now - s_lastPass;
+    if (likely(elapsed < REBALANCING_PERIOD_NS) || unlikely(s_handlerTimeSnapshot == NULL)) {
+
+        return;
+    }
+    s_lastPass = now;
+
+    /* Find the busiest and the idlest core as published by the overload manager */
+    int busiestCore = 0;
+    int idlestCore = 0;
+    u32 maxUtilisation = GetCoreUtilisation(0);
+    u32 minUtilisation = maxUtilisation;
+    for (int core = 1; core < em_core_count(); core++) {
+
+        u32 utilisation = GetCoreUtilisation(core);
+        if (utilisation > maxUtilisation) {
+
+            maxUtilisation = utilisation;
+            busiestCore = core;
+
+        } else if (utilisation < minUtilisation) {
+
+            minUtilisation = utilisation;
+            idlestCore = core;
+        }
+    }
+
+    u32 gap = maxUtilisation - minUtilisation;
+    /* Pick the worker even if the load is balanced to keep the snapshot up to date */
+    TWorkerId workerId = PickWorkerToMove(busiestCore, idlestCore, gap, elapsed);
+    if (gap < REBALANCING_MIN_GAP || workerId == WORKER_ID_INVALID) {
+
+        return;
+    }
+
+    TCoreMask coreMask = ShiftCoreMask(FetchWorkerContext(workerId), busiestCore, idlestCore);
+    LogPrint(ELogSeverityLevel_Info, "Moving worker 0x%x off core %d (utilisation: %u%%) onto core %d (utilisation: %u%%)", \
+        workerId, busiestCore, maxUtilisation, idlestCore, minUtilisation);
+    /* The worker may have been terminated or migrated in the meantime - try again next period */
+    (void) SetWorkerCoreMask(workerId, coreMask);
+}
+
+static TWorkerId PickWorkerToMove(int busiestCore, int idlestCore, u32 gap, u64 elapsed) {
+
+    int cores = em_core_count();
+    TWorkerId candidate = WORKER_ID_INVALID;
+    /* Ideally move half the gap, moving more than the whole gap would only swap the cores' roles */
+    u32 bestDistance = gap / 2;
+
+    for (TWorkerId i = 0; i < MAX_WORKER_COUNT; i++) {
+
+        /* Read the context without locking - SetWorkerCoreMask revalidates the state */
+        SWorkerContext * context = FetchWorkerContext(i);
+        u64 * snapshot = &s_handlerTimeSnapshot[i * cores];
+        u64 handlerTime = context->Statistics[busiestCore].Counters.HandlerTimeNs;
+        /* Counters are reset when a worker ID is reused */
+        u64 busyNs = handlerTime >= snapshot[busiestCore] ? handlerTime - snapshot[busiestCore] : handlerTime;
+        for (int core = 0; core < cores; core++) {
+
+            snapshot[core] = context->Statistics[core].Counters.HandlerTimeNs;
+        }
+
+        if (FetchWorkerRoute(i)->State != EWorkerState_Active || !context->AutoRebalance || context->Migration.InProgress \
+            || !CoreMaskContains(context->CoreMask, busiestCore) || CoreMaskContains(context->CoreMask, idlestCore)) {
+
+            continue;
+        }
+
+        bool hasLocalCallbacks = context->UserLocalInit != NULL || context->UserLocalExit != NULL;
+        if (hasLocalCallbacks && !CoreMaskIsSubset(ShiftCoreMask(context, busiestCore, idlestCore), context->HostMask)) {
+
+            /* Per-core callbacks never ran on the idlest core */
+            continue;
+        }
+
+        u32 share = (u32) (busyNs * 100 / elapsed);
+        if (share == 0 || share >= gap) {
+
+            continue;
+        }
+
+        u32 distance = share > gap / 2 ? share - gap / 2 : gap / 2 - share;
+        if (distance <= bestDistance) {
+
+            bestDistance = distance;
+            candidate = context->WorkerId;
+        }
+    }
+
+    return candidate;
+}
+
+static inline TCoreMask ShiftCoreMask(const SWorkerContext * context, int from, int to) {
+
+    return CoreMaskAdd(CoreMaskRemove(context->CoreMask, from), to);
+}
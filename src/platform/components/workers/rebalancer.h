@@ -0,0 +1,8 @@
+
+#ifndef PLATFORM_COMPONENTS_WORKERS_REBALANCER_H
+#define PLATFORM_COMPONENTS_WORKERS_REBALANCER_H
+
+void RebalancerInit(void);
+void RebalancerTeardown(void);
+
+#endif /* PLATFORM_COMPONENTS_WORKERS_REBALANCER_H */
@@ -1,15 +1,33 @@
 #include <workers/setup.h>
 #include <workers/worker_table.h>
 #include <workers/completion_daemon.h>
+#include <workers/pools.h>
+#include <workers/graphs.h>
+#include <workers/rebalancer.h>
+#include <workers/watchdog.h>
 
 void WorkersInit(SWorkersConfig * config) {
 
-    WorkerTableInit(config->NodeId);
+    WorkerTableInit(config->NodeId, config->MaxWorkers);
     DeployCompletionDaemon();
+    WorkerPoolsInit();
+    GraphsInit();
+    if (config->Rebalancing) {
+
+        RebalancerInit();
+    }
+    if (config->WatchdogBudgetUs > 0) {
+
+        WatchdogInit(config->WatchdogBudgetUs, config->WatchdogAction);
+    }
 }
 
 void WorkersTeardown(void) {
 
+    WatchdogTeardown();
+    RebalancerTeardown();
+    GraphsTeardown();
+    WorkerPoolsTeardown();
     CompletionDaemonTeardown();
     WorkerTableTeardown();
 }
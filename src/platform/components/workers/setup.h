@@ -2,11 +2,16 @@
 #ifndef PLATFORM_COMPONENTS_WORKERS_SETUP_H
 #define PLATFORM_COMPONENTS_WORKERS_SETUP_H
 
+#include <workers/watchdog.h>
 #include <menabrea/workers.h>
 #include <event_machine.h>
 
 typedef struct SWorkersConfig {
     TWorkerId NodeId;
+    bool Rebalancing;                /* Move workers off busy cores automatically */
+    u32 MaxWorkers;                  /* Number of workers deployable at a time (0 for the whole ID space) */
+    u32 WatchdogBudgetUs;            /* Time a worker body may run before being reported (0 to disable the watchdog) */
+    EWatchdogAction WatchdogAction;  /* What to do about the bodies overrunning the budget */
 } SWorkersConfig;
 
 void WorkersInit(SWorkersConfig * config);
@@ -0,0 +1,99 @@
+#include <menabrea/workers.h>
+#include <workers/worker_table.h>
+#include <menabrea/log.h>
+#include <menabrea/common.h>
+#include <event_machine.h>
+#include <string.h>
+
+static bool FetchActiveLocalWorker(TWorkerId workerId, SWorkerContext ** context);
+static void AccumulateStatistics(SWorkerStatistics * total, const SWorkerStatistics * core);
+
+int GetWorkerStatistics(TWorkerId workerId, SWorkerStatistics * statistics) {
+
+    SWorkerContext * context;
+    if (unlikely(!FetchActiveLocalWorker(workerId, &context))) {
+
+        return -1;
+    }
+
+    (void) memset(statistics, 0, sizeof(SWorkerStatistics));
+    for (int i = 0; i < em_core_count(); i++) {
+
+        AccumulateStatistics(statistics, &context->Statistics[i].Counters);
+    }
+    /* Expired and shed messages are also dropped on the RX path, outside any dispatch, so they are counted per worker,
+     * much like the overruns reported by the watchdog from the shared core */
+    statistics->MessagesExpired = Atomic32Get(&context->ExpiredMessages);
+    statistics->MessagesShed = Atomic32Get(&context->ShedMessages);
+    statistics->HandlerOverruns = Atomic32Get(&context->HandlerOverruns);
+    return 0;
+}
+
+int GetWorkerCoreStatistics(TWorkerId workerId, int core, SWorkerStatistics * statistics) {
+
+    SWorkerContext * context;
+    if (unlikely(core < 0 || core >= em_core_count() || !FetchActiveLocalWorker(workerId, &context))) {
+
+        return -1;
+    }
+
+    (void) memcpy(statistics, &context->Statistics[core].Counters, sizeof(SWorkerStatistics));
+    return 0;
+}
+
+void DumpWorkerStatistics(void) {
+
+    LogPrint(ELogSeverityLevel_Info, "Worker statistics:");
+
+    for (TWorkerId i = 0; i < MAX_WORKER_COUNT; i++) {
+
+        TWorkerId workerId = MakeWorkerId(GetOwnNodeId(), i);
+        SWorkerStatistics total;
+        if (0 != GetWorkerStatistics(workerId, &total)) {
+
+            continue;
+        }
+
+        SWorkerContext * context = FetchWorkerContext(workerId);
+        u64 averageNs = total.HandlerInvocations > 0 ? total.HandlerTimeNs / total.HandlerInvocations : 0;
+        LogPrint(ELogSeverityLevel_Info, \
+            "  0x%x ('%s'): rx %lu (%lu B), tx %lu (%lu B), expired %lu, shed %lu, calls %lu, time %lu ns (avg: %lu ns, max: %lu ns), overruns %lu", \
+            workerId, context->Name, total.MessagesReceived, total.BytesReceived, total.MessagesSent, \
+            total.BytesSent, total.MessagesExpired, total.MessagesShed, total.HandlerInvocations, total.HandlerTimeNs, averageNs, \
+            total.MaxHandlerTimeNs, total.HandlerOverruns);
+
+        /* Break the load down by core to help size the core mask */
+        for (int core = 0; core < em_core_count(); core++) {
+
+            const SWorkerStatistics * counters = &context->Statistics[core].Counters;
+            if (counters->HandlerInvocations > 0) {
+
+                LogPrint(ELogSeverityLevel_Info, "    core %d: calls %lu, time %lu ns", \
+                    core, counters->HandlerInvocations, counters->HandlerTimeNs);
+            }
+        }
+    }
+}
+
+static bool FetchActiveLocalWorker(TWorkerId workerId, SWorkerContext ** context) {
+
+    if (workerId == WORKER_ID_INVALID || WorkerIdGetNode(workerId) != GetOwnNodeId() || WorkerIdGetLocal(workerId) >= MAX_WORKER_COUNT) {
+
+        return false;
+    }
+
+    *context = FetchWorkerContext(workerId);
+    /* Read the state without locking - a worker terminating concurrently may report stale counters at worst */
+    return FetchWorkerRoute(workerId)->State == EWorkerState_Active && (*context)->WorkerId == workerId;
+}
+
+static void AccumulateStatistics(SWorkerStatistics * total, const SWorkerStatistics * core) {
+
+    total->MessagesReceived += core->MessagesReceived;
+    total->MessagesSent += core->MessagesSent;
+    total->BytesReceived += core->BytesReceived;
+    total->BytesSent += core->BytesSent;
+    total->HandlerInvocations += core->HandlerInvocations;
+    total->HandlerTimeNs += core->HandlerTimeNs;
+    total->MaxHandlerTimeNs = core->MaxHandlerTimeNs > total->MaxHandlerTimeNs ? core->MaxHandlerTimeNs : total->MaxHandlerTimeNs;
+}
@@ -0,0 +1,214 @@
+#include <workers/watchdog.h>
+#include <workers/worker_table.h>
+#include <exception/signal_handlers.h>
+#include <exception/callstack.h>
+#include <menabrea/input.h>
+#include <menabrea/cores.h>
+#include <menabrea/log.h>
+#include <menabrea/exception.h>
+#include <event_machine.h>
+#include <odp_api.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+
+/* Check the handlers several times per budget so that overruns are reported on time */
+#define WATCHDOG_CHECKS_PER_BUDGET  4
+
+typedef struct SWatchdogSlot {
+    /* Start of the handler running on the core in global time or 0 if none is running */
+    env_atomic64_t StartNs;
+    /* Worker ID, message ID and the handler's budget in microseconds, from the most significant bits */
+    env_atomic64_t Handler;
+    /* Dispatcher process of the core */
+    pid_t Pid;
+    /* Start of the last handler reported - used by the monitor only */
+    u64 ReportedNs;
+    /* Pad size to a multiple of cache line size */
+    void * _pad[0] ENV_CACHE_LINE_ALIGNED;
+} SWatchdogSlot;
+
+static void WatchdogPoll(void * arg);
+static void ReportOverrun(int core, TWorkerId workerId, TMessageId messageId, u64 elapsedNs, u64 budgetNs);
+static bool CallstackListener(int signo, const siginfo_t * siginfo);
+
+/* Slots of all the cores in shared memory or NULL if the watchdog is disabled */
+static SWatchdogSlot * s_slots = NULL;
+/* Node-wide budget, used for the workers without one of their own */
+static u32 s_budgetUs = 0;
+static EWatchdogAction s_action = EWatchdogAction_Log;
+/* Time of the previous check - used on the shared core only */
+static u64 s_lastCheck = 0;
+
+void WatchdogInit(u32 budgetUs, EWatchdogAction action) {
+
+    s_slots = (SWatchdogSlot *) env_shared_malloc(em_core_count() * sizeof(SWatchdogSlot));
+    AssertTrue(s_slots != NULL);
+    for (int core = 0; core < em_core_count(); core++) {
+
+        env_atomic64_init(&s_slots[core].StartNs);
+        env_atomic64_init(&s_slots[core].Handler);
+        s_slots[core].Pid = 0;
+        s_slots[core].ReportedNs = 0;
+    }
+    s_budgetUs = budgetUs;
+    s_action = action;
+
+    if (action == EWatchdogAction_Callstack) {
+
+        /* Print the call stack of the dispatcher when poked by the monitor */
+        PrepareCallstack();
+        ListenForSignal(SIGUSR2, CallstackListener);
+    }
+    /* Note that a handler stuck on the shared core also stalls the monitor itself and that the
+     * handlers with budgets below the node-wide one are checked just as often */
+    RegisterInputPolling(WatchdogPoll, NULL, GetSharedCoreMask());
+    LogPrint(ELogSeverityLevel_Info, "Handler watchdog enabled (budget: %u us)", budgetUs);
+}
+
+void WatchdogLocalInit(void) {
+
+    if (s_slots != NULL) {
+
+        s_slots[em_core_id()].Pid = getpid();
+    }
+}
+
+void WatchdogTeardown(void) {
+
+    if (s_slots != NULL) {
+
+        env_shared_free(s_slots);
+        s_slots = NULL;
+    }
+}
+
+void WatchdogHandlerStart(TWorkerId workerId, TMessageId messageId, u32 budgetUs, SWatchdogFrame * previous) {
+
+    if (likely(s_slots == NULL)) {
+
+        return;
+    }
+
+    SWatchdogSlot * slot = &s_slots[em_core_id()];
+    /* Handlers may nest when messages are delivered inline */
+    previous->StartNs = env_atomic64_get(&slot->StartNs);
+    previous->Handler = env_atomic64_get(&slot->Handler);
+    if (unlikely(previous->StartNs != 0)) {
+
+        /* Stop timing the outer handler first, so that the monitor never pairs its start with the inner budget */
+        env_atomic64_set(&slot->StartNs, 0);
+    }
+    /* Publish the handler along with its budget before its start time, which the monitor reads first */
+    budgetUs = budgetUs > 0 ? budgetUs : s_budgetUs;
+    env_atomic64_set(&slot->Handler, ((u64) workerId << 48) | ((u64) messageId << 32) | budgetUs);
+    env_atomic64_set(&slot->StartNs, odp_time_global_ns());
+}
+
+void WatchdogHandlerEnd(const SWatchdogFrame * previous) {
+
+    if (likely(s_slots == NULL)) {
+
+        return;
+    }
+
+    SWatchdogSlot * slot = &s_slots[em_core_id()];
+    /* Resume timing the outer handler, if any, from its original start once its budget is back in place */
+    env_atomic64_set(&slot->StartNs, 0);
+    env_atomic64_set(&slot->Handler, previous->Handler);
+    if (unlikely(previous->StartNs != 0)) {
+
+        env_atomic64_set(&slot->StartNs, previous->StartNs);
+    }
+}
+
+static void WatchdogPoll(void * arg) {
+
+    (void) arg;
+
+    u64 now = odp_time_global_ns();
+    if (likely(now - s_lastCheck < (u64) s_budgetUs * ODP_TIME_USEC_IN_NS / WATCHDOG_CHECKS_PER_BUDGET) \
+        || unlikely(s_slots == NULL)) {
+
+        return;
+    }
+    s_lastCheck = now;
+
+    for (int core = 0; core < em_core_count(); core++) {
+
+        SWatchdogSlot * slot = &s_slots[core];
+        u64 startNs = env_atomic64_get(&slot->StartNs);
+        if (startNs == 0 || startNs == slot->ReportedNs || now < startNs) {
+
+            /* Core idle or handler already reported */
+            continue;
+        }
+
+        u64 handler = env_atomic64_get(&slot->Handler);
+        if (env_atomic64_get(&slot->StartNs) != startNs) {
+
+            /* Handler returned in the meantime */
+            continue;
+        }
+
+        u64 budgetNs = (handler & 0xFFFFFFFF) * ODP_TIME_USEC_IN_NS;
+        if (now - startNs <= budgetNs) {
+
+            /* Handler within budget */
+            continue;
+        }
+
+        /* Report each overrunning handler once */
+        slot->ReportedNs = startNs;
+        ReportOverrun(core, (TWorkerId) (handler >> 48), (TMessageId) ((handler >> 32) & 0xFFFF), now - startNs, budgetNs);
+    }
+}
+
+static void ReportOverrun(int core, TWorkerId workerId, TMessageId messageId, u64 elapsedNs, u64 budgetNs) {
+
+    u64 elapsedUs = elapsedNs / ODP_TIME_USEC_IN_NS;
+    u64 budgetUs = budgetNs / ODP_TIME_USEC_IN_NS;
+    /* The handler may have returned since and the worker terminated, its context going to another worker */
+    LockWorkerTableEntry(workerId);
+    SWorkerContext * context = FetchWorkerContext(workerId);
+    if (likely(context->WorkerId == workerId)) {
+
+        Atomic32Inc(&context->HandlerOverruns);
+    }
+    UnlockWorkerTableEntry(workerId);
+    if (s_action == EWatchdogAction_Exception) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Handler of worker 0x%x has been processing message 0x%x on core %d for %lu us (budget: %lu us)", \
+            workerId, messageId, core, elapsedUs, budgetUs);
+        return;
+    }
+
+    LogPrint(ELogSeverityLevel_Warning, \
+        "Handler of worker 0x%x has been processing message 0x%x on core %d for %lu us (budget: %lu us)", \
+        workerId, messageId, core, elapsedUs, budgetUs);
+
+    if (s_action == EWatchdogAction_Callstack && s_slots[core].Pid != 0) {
+
+        /* The handler may have returned by the time the signal is delivered */
+        (void) kill(s_slots[core].Pid, SIGUSR2);
+    }
+}
+
+static bool CallstackListener(int signo, const siginfo_t * siginfo) {
+
+    (void) signo;
+    (void) siginfo;
+
+    /* The dispatcher is interrupted at an arbitrary point, possibly holding the logger's or the allocator's
+     * locks, so stick to async-signal-safe calls and write straight to stderr, where the logs go too */
+    static const char header[] = "========== CALL STACK (requested by the handler watchdog) ==========\n";
+    static const char footer[] = "====================================================================\n";
+    int savedErrno = errno;
+    (void) write(STDERR_FILENO, header, sizeof(header) - 1);
+    WriteCallstack(STDERR_FILENO);
+    (void) write(STDERR_FILENO, footer, sizeof(footer) - 1);
+    errno = savedErrno;
+    /* Signal handled, keep running */
+    return true;
+}
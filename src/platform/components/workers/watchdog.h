@@ -0,0 +1,26 @@
+
+#ifndef PLATFORM_COMPONENTS_WORKERS_WATCHDOG_H
+#define PLATFORM_COMPONENTS_WORKERS_WATCHDOG_H
+
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+
+typedef enum EWatchdogAction {
+    EWatchdogAction_Log,        /* Only log the handler overrunning its budget */
+    EWatchdogAction_Exception,  /* Raise a non-fatal exception */
+    EWatchdogAction_Callstack   /* Have the stuck dispatcher print its call stack */
+} EWatchdogAction;
+
+/* Handler running on the current core before the one started, restored when the latter returns */
+typedef struct SWatchdogFrame {
+    u64 StartNs;
+    u64 Handler;
+} SWatchdogFrame;
+
+void WatchdogInit(u32 budgetUs, EWatchdogAction action);
+void WatchdogLocalInit(void);
+void WatchdogTeardown(void);
+void WatchdogHandlerStart(TWorkerId workerId, TMessageId messageId, u32 budgetUs, SWatchdogFrame * previous);
+void WatchdogHandlerEnd(const SWatchdogFrame * previous);
+
+#endif /* PLATFORM_COMPONENTS_WORKERS_WATCHDOG_H */
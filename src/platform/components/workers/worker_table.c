@@ -1,5 +1,6 @@
 
 #include <workers/worker_table.h>
+#include <memory/id_pool.h>
 #include <menabrea/workers.h>
 #include <menabrea/log.h>
 #include <menabrea/exception.h>
@@ -9,57 +10,101 @@
 static void ResetContext(SWorkerContext * context);
 static inline TWorkerId AllocateDynamicLocalId(void);
 static inline void ReleaseDynamicLocalId(TWorkerId localId);
-
-typedef struct SDynamicIdFifo {
-    TSpinlock Lock;
-    u32 GetIndex;
-    u32 PutIndex;
-    u32 FreeIds;
-    TWorkerId IdPool[DYNAMIC_WORKER_IDS_COUNT];
-} SDynamicIdFifo;
-
-static SDynamicIdFifo * s_idFifo;
-static SWorkerContext * s_workerTable[MAX_WORKER_COUNT];
+static inline SWorkerContext * AllocateContext(void);
+static inline void ReleaseContext(SWorkerContext * context);
+static SWorkerContext * BindContext(TWorkerId localId);
+
+static SIdPool * s_idPool;
+/* Indices of the free contexts */
+static SIdPool * s_contextPool;
+static SWorkerRoute * s_routeTable;
+static void * s_contextTable;
+static size_t s_contextSize;
+/* Shared by all inactive entries so that lockless readers never see a NULL context */
+static SWorkerContext * s_vacantContext;
 static TWorkerId s_ownNodeId = WORKER_ID_INVALID;
 static bool s_allowAllocations;
 
-void WorkerTableInit(TWorkerId nodeId) {
+void WorkerTableInit(TWorkerId nodeId, u32 capacity) {
 
     s_ownNodeId = nodeId;
     LogPrint(ELogSeverityLevel_Info, "Node ID set to 0x%x", s_ownNodeId);
 
+    /* Worker IDs are 16-bit wide, so the ID space bounds the capacity */
+    if (capacity == 0 || capacity > MAX_WORKER_COUNT) {
+
+        capacity = MAX_WORKER_COUNT;
+    }
+
     int cores = em_core_count();
+    size_t idPoolSize = IdPoolFootprint(DYNAMIC_WORKER_IDS_COUNT);
+    /* The routing entries cover the whole ID space, but take a single cache line each */
+    size_t routeTableSize = MAX_WORKER_COUNT * sizeof(SWorkerRoute);
+    size_t contextPoolSize = IdPoolFootprint(capacity);
     /* Take into account per-core application private data - align with cache line */
     size_t entrySize = ENV_CACHE_LINE_SIZE_ROUNDUP(sizeof(SWorkerContext) + cores * sizeof(void *));
-    size_t tableSize = entrySize * MAX_WORKER_COUNT;
-    size_t idFifoSize = ENV_CACHE_LINE_SIZE_ROUNDUP(sizeof(SDynamicIdFifo));
-    size_t totalAllocationSize = idFifoSize + tableSize;
+    /* One extra context stands in for the inactive entries */
+    size_t tableSize = entrySize * (capacity + 1);
+    /* Keep the statistics out of the context so that the cores do not write to the cache lines read in the dispatch path */
+    size_t statisticsEntrySize = cores * sizeof(SWorkerCoreStatistics);
+    size_t statisticsSize = statisticsEntrySize * (capacity + 1);
+    size_t totalAllocationSize = idPoolSize + routeTableSize + contextPoolSize + tableSize + statisticsSize;
     LogPrint(ELogSeverityLevel_Info, \
-        "Creating worker table in shared memory - max workers: %d, entry size: %ld, table size: %ld, ID fifo size: %ld, total: %ld...", \
-        MAX_WORKER_COUNT, entrySize, tableSize, idFifoSize, totalAllocationSize);
+        "Creating worker table in shared memory - max workers: %u, entry size: %ld, table size: %ld, route table size: %ld, ID pool size: %ld, statistics size: %ld, total: %ld...", \
+        capacity, entrySize, tableSize, routeTableSize, idPoolSize, statisticsSize, totalAllocationSize);
 
     /* Do one big allocation and then set up the pointers to reference parts of it */
     void * startAddr = env_shared_malloc(totalAllocationSize);
     AssertTrue(startAddr != NULL);
 
-    /* Initialize the dynamic ID FIFO */
-    s_idFifo = (SDynamicIdFifo *) startAddr;
-    s_idFifo->GetIndex = 0;
-    s_idFifo->PutIndex = 0;
-    s_idFifo->FreeIds = DYNAMIC_WORKER_IDS_COUNT;
-    SpinlockInit(&s_idFifo->Lock);
+    /* Initialize the dynamic ID pool */
+    s_idPool = IdPoolInit(startAddr, DYNAMIC_WORKER_IDS_COUNT);
     for (TWorkerId i = 0; i < DYNAMIC_WORKER_IDS_COUNT; i++) {
 
-        s_idFifo->IdPool[i] = WORKER_ID_DYNAMIC_BASE + i;
+        IdPoolPut(s_idPool, WORKER_ID_DYNAMIC_BASE + i);
     }
 
-    void * tableBase = (u8 *) startAddr + idFifoSize;
-    /* Set up the pointers and initialize the table entries */
+    s_routeTable = (SWorkerRoute *)((u8 *) startAddr + idPoolSize);
+    s_contextPool = IdPoolInit((u8 *) s_routeTable + routeTableSize, capacity);
+    void * tableBase = (u8 *) s_contextPool + contextPoolSize;
+    s_contextTable = tableBase;
+    s_contextSize = entrySize;
+    void * statisticsBase = (u8 *) tableBase + tableSize;
+
+    /* Set up the pointers and initialize the contexts */
+    for (u32 i = 0; i <= capacity; i++) {
+
+        SWorkerContext * context = (SWorkerContext *)((u8 *) tableBase + i * entrySize);
+        context->Statistics = (SWorkerCoreStatistics *)((u8 *) statisticsBase + i * statisticsEntrySize);
+        Atomic32Init(&context->ExpiredMessages);
+        Atomic32Init(&context->ShedMessages);
+        Atomic32Init(&context->ThrottledMessages);
+        Atomic32Init(&context->HandlerOverruns);
+        Atomic32Init(&context->QueuedMessages);
+        Atomic32Init(&context->InlineOwner);
+        Atomic32Init(&context->InlineInvocations);
+        SpinlockInit(&context->ContinuationLock);
+        ResetContext(context);
+        if (i < capacity) {
+
+            IdPoolPut(s_contextPool, i);
+
+        } else {
+
+            s_vacantContext = context;
+        }
+    }
+
+    /* Initialize the routing entries */
     for (TWorkerId i = 0; i < MAX_WORKER_COUNT; i++) {
 
-        s_workerTable[i] = (SWorkerContext *)((u8*) tableBase + i * entrySize);
-        SpinlockInit(&s_workerTable[i]->Lock);
-        ResetContext(s_workerTable[i]);
+        SpinlockInit(&s_routeTable[i].Lock);
+        s_routeTable[i].State = EWorkerState_Inactive;
+        s_routeTable[i].SheddingLevel = EOverloadLevel_Normal;
+        s_routeTable[i].InlineDelivery = false;
+        s_routeTable[i].RateLimited = false;
+        s_routeTable[i].Queue = EM_QUEUE_UNDEF;
+        s_routeTable[i].Context = s_vacantContext;
     }
 
     /* Worker deployment henceforth possible */
@@ -69,12 +114,12 @@ void WorkerTableInit(TWorkerId nodeId) {
 void WorkerTableTeardown(void) {
 
     /* Recover the start address of the shared memory */
-    void * startAddr = s_idFifo;
-    for (TWorkerId i = 0; i < MAX_WORKER_COUNT; i++) {
-
-        /* Unset all the pointers */
-        s_workerTable[i] = NULL;
-    }
+    void * startAddr = s_idPool;
+    /* Unset all the pointers */
+    s_routeTable = NULL;
+    s_contextPool = NULL;
+    s_contextTable = NULL;
+    s_vacantContext = NULL;
     /* Free the shared memory */
     env_shared_free(startAddr);
 }
@@ -102,12 +147,16 @@ SWorkerContext * ReserveWorkerContext(TWorkerId workerId) {
         }
 
         LockWorkerTableEntry(dynamicId);
-        /* Assert consistency between the worker table and the dynamic ID FIFO */
-        AssertTrue(s_workerTable[dynamicId]->State == EWorkerState_Inactive);
-        s_workerTable[dynamicId]->State = EWorkerState_Deploying;
-        s_workerTable[dynamicId]->WorkerId = MakeWorkerId(GetOwnNodeId(), dynamicId);
+        /* Assert consistency between the worker table and the dynamic ID pool */
+        AssertTrue(s_routeTable[dynamicId].State == EWorkerState_Inactive);
+        SWorkerContext * context = BindContext(dynamicId);
         UnlockWorkerTableEntry(dynamicId);
-        return s_workerTable[dynamicId];
+        if (unlikely(context == NULL)) {
+
+            LogPrint(ELogSeverityLevel_Critical, "No free worker contexts found!");
+            ReleaseDynamicLocalId(dynamicId);
+        }
+        return context;
 
     } else {
 
@@ -129,9 +178,9 @@ SWorkerContext * ReserveWorkerContext(TWorkerId workerId) {
         }
 
         LockWorkerTableEntry(workerId);
-        if (s_workerTable[localId]->State != EWorkerState_Inactive) {
+        if (s_routeTable[localId].State != EWorkerState_Inactive) {
 
-            EWorkerState state = s_workerTable[localId]->State;
+            EWorkerState state = s_routeTable[localId].State;
             UnlockWorkerTableEntry(workerId);
             RaiseException(EExceptionFatality_NonFatal, \
                 "Attempted to register worker with static ID 0x%x twice. Current worker in state: %d", \
@@ -139,10 +188,13 @@ SWorkerContext * ReserveWorkerContext(TWorkerId workerId) {
             return NULL;
         }
         /* Reserve the entry */
-        s_workerTable[localId]->State = EWorkerState_Deploying;
-        s_workerTable[localId]->WorkerId = MakeWorkerId(GetOwnNodeId(), localId);
+        SWorkerContext * context = BindContext(localId);
         UnlockWorkerTableEntry(workerId);
-        return s_workerTable[localId];
+        if (unlikely(context == NULL)) {
+
+            LogPrint(ELogSeverityLevel_Critical, "No free worker contexts found!");
+        }
+        return context;
     }
 }
 
@@ -151,11 +203,20 @@ void ReleaseWorkerContext(TWorkerId workerId) {
     LockWorkerTableEntry(workerId);
     TWorkerId localId = WorkerIdGetLocal(workerId);
     AssertTrue(localId < MAX_WORKER_COUNT);
+    SWorkerRoute * route = &s_routeTable[localId];
     /* Assert the state is either EWorkerState_Terminating or
      * EWorkerState_Deploying - releasing active workers is
      * not allowed to prevent any race conditions */
-    AssertTrue(s_workerTable[localId]->State != EWorkerState_Active);
-    ResetContext(s_workerTable[localId]);
+    AssertTrue(route->State != EWorkerState_Active);
+    AssertTrue(route->Context != s_vacantContext);
+    ResetContext(route->Context);
+    ReleaseContext(route->Context);
+    route->Context = s_vacantContext;
+    route->State = EWorkerState_Inactive;
+    route->SheddingLevel = EOverloadLevel_Normal;
+    route->InlineDelivery = false;
+    route->RateLimited = false;
+    route->Queue = EM_QUEUE_UNDEF;
     if (localId >= WORKER_ID_DYNAMIC_BASE) {
         /* Recycle dynamic local ID */
         ReleaseDynamicLocalId(localId);
@@ -165,50 +226,45 @@ void ReleaseWorkerContext(TWorkerId workerId) {
 
 SWorkerContext * FetchWorkerContext(TWorkerId workerId) {
 
+    return FetchWorkerRoute(workerId)->Context;
+}
+
+SWorkerRoute * FetchWorkerRoute(TWorkerId workerId) {
+
     /* Use the local part to index the table */
     TWorkerId localId = WorkerIdGetLocal(workerId);
     AssertTrue(localId < MAX_WORKER_COUNT);
-    return s_workerTable[localId];
+    return &s_routeTable[localId];
 }
 
 void MarkDeploymentSuccessful(TWorkerId workerId) {
 
     /* Caller must ensure synchronization */
 
-    /* Use the local part to index the table */
-    TWorkerId localId = WorkerIdGetLocal(workerId);
-    AssertTrue(localId < MAX_WORKER_COUNT);
+    SWorkerRoute * route = FetchWorkerRoute(workerId);
     /* Assert deployment in progress */
-    AssertTrue(s_workerTable[localId]->State == EWorkerState_Deploying);
-    s_workerTable[localId]->State = EWorkerState_Active;
+    AssertTrue(route->State == EWorkerState_Deploying);
+    route->State = EWorkerState_Active;
 }
 
 void MarkTeardownInProgress(TWorkerId workerId) {
 
     /* Caller must ensure synchronization */
 
-    /* Use the local part to index the table */
-    TWorkerId localId = WorkerIdGetLocal(workerId);
-    AssertTrue(localId < MAX_WORKER_COUNT);
+    SWorkerRoute * route = FetchWorkerRoute(workerId);
     /* Assert worker active */
-    AssertTrue(s_workerTable[localId]->State == EWorkerState_Active);
-    s_workerTable[localId]->State = EWorkerState_Terminating;
+    AssertTrue(route->State == EWorkerState_Active);
+    route->State = EWorkerState_Terminating;
 }
 
 void LockWorkerTableEntry(TWorkerId workerId) {
 
-    /* Use the local part to index the table */
-    TWorkerId localId = WorkerIdGetLocal(workerId);
-    AssertTrue(localId < MAX_WORKER_COUNT);
-    SpinlockAcquire(&s_workerTable[localId]->Lock);
+    SpinlockAcquire(&FetchWorkerRoute(workerId)->Lock);
 }
 
 void UnlockWorkerTableEntry(TWorkerId workerId) {
 
-    /* Use the local part to index the table */
-    TWorkerId localId = WorkerIdGetLocal(workerId);
-    AssertTrue(localId < MAX_WORKER_COUNT);
-    SpinlockRelease(&s_workerTable[localId]->Lock);
+    SpinlockRelease(&FetchWorkerRoute(workerId)->Lock);
 }
 
 TWorkerId GetOwnNodeId(void) {
@@ -226,29 +282,52 @@ void DisableWorkerDeployment(void) {
 
 static void ResetContext(SWorkerContext * context) {
 
-    /* Reset the state */
-    context->State = EWorkerState_Inactive;
     /* Clear user callbacks */
     context->UserInit = NULL;
     context->UserLocalInit = NULL;
     context->UserLocalExit = NULL;
     context->UserExit = NULL;
     context->WorkerBody = NULL;
+    context->WorkerMultiBody = NULL;
 
     /* Clear internal data */
     (void) memset(context->Name, 0, sizeof(context->Name));
-    context->CoreMask = 0;
+    context->CoreMask = CoreMaskEmpty();
+    context->HostMask = CoreMaskEmpty();
     context->Parallel = false;
-    context->Queue = EM_QUEUE_UNDEF;
+    context->CoalesceSends = false;
+    context->Captured = false;
+    context->NoEarlyExit = false;
+    context->AutoRebalance = false;
+    context->InlineDelivery = false;
+    context->HandlerBudgetUs = 0;
     context->Eo = EM_EO_UNDEF;
     context->WorkerId = WORKER_ID_INVALID;
     context->TerminationRequested = false;
-
-    /* Clear application private data */
+    context->TerminationNotif.event = EM_EVENT_UNDEF;
+    context->TerminationNotif.queue = EM_QUEUE_UNDEF;
+    context->TerminationNotif.egroup = EM_EVENT_GROUP_UNDEF;
+    Atomic32Set(&context->ExpiredMessages, 0);
+    Atomic32Set(&context->ShedMessages, 0);
+    Atomic32Set(&context->ThrottledMessages, 0);
+    Atomic32Set(&context->HandlerOverruns, 0);
+    RateLimiterInit(&context->RateLimiter, 0, 0);
+    Atomic32Set(&context->QueuedMessages, 0);
+    Atomic32Set(&context->InlineOwner, 0);
+    Atomic32Set(&context->InlineInvocations, 0);
+    context->Migration.InProgress = false;
+    context->Migration.Marker = EM_EVENT_UNDEF;
+    context->Migration.SourceQueue = EM_QUEUE_UNDEF;
+    context->Migration.StagingQueue = EM_QUEUE_UNDEF;
+    context->Migration.TargetQueue = EM_QUEUE_UNDEF;
+    context->Continuations = NULL;
+
+    /* Clear application private data and the statistics */
     context->SharedData = NULL;
     for (int i = 0; i < em_core_count(); i++) {
 
         context->LocalData[i] = NULL;
+        (void) memset(&context->Statistics[i].Counters, 0, sizeof(context->Statistics[i].Counters));
     }
 
     /* Clear event buffer */
@@ -260,29 +339,52 @@ static void ResetContext(SWorkerContext * context) {
 
 static inline TWorkerId AllocateDynamicLocalId(void) {
 
-    TWorkerId id = WORKER_ID_INVALID;
-    SpinlockAcquire(&s_idFifo->Lock);
-    if (s_idFifo->FreeIds > 0) {
-
-        AssertTrue(s_idFifo->IdPool[s_idFifo->GetIndex] != WORKER_ID_INVALID);
-        id = s_idFifo->IdPool[s_idFifo->GetIndex];
-        /* Explicitly poison the allocated entry to detect any errors */
-        s_idFifo->IdPool[s_idFifo->GetIndex] = WORKER_ID_INVALID;
-        /* Move the allocation index */
-        s_idFifo->GetIndex = (s_idFifo->GetIndex + 1) % DYNAMIC_WORKER_IDS_COUNT;
-        s_idFifo->FreeIds--;
+    u32 id;
+    if (unlikely(!IdPoolTake(s_idPool, &id))) {
+
+        return WORKER_ID_INVALID;
     }
-    SpinlockRelease(&s_idFifo->Lock);
-    return id;
+
+    AssertTrue(id >= WORKER_ID_DYNAMIC_BASE && id < MAX_WORKER_COUNT);
+    return (TWorkerId) id;
 }
 
 static inline void ReleaseDynamicLocalId(TWorkerId localId) {
 
     AssertTrue(0 == WorkerIdGetNode(localId));
-    SpinlockAcquire(&s_idFifo->Lock);
-    AssertTrue(s_idFifo->IdPool[s_idFifo->PutIndex] == WORKER_ID_INVALID);
-    s_idFifo->IdPool[s_idFifo->PutIndex] = localId;
-    s_idFifo->PutIndex = (s_idFifo->PutIndex + 1) % DYNAMIC_WORKER_IDS_COUNT;
-    s_idFifo->FreeIds++;
-    SpinlockRelease(&s_idFifo->Lock);
+    /* IDs are recycled in FIFO order so that they are reused as late as possible */
+    IdPoolPut(s_idPool, localId);
+}
+
+static inline SWorkerContext * AllocateContext(void) {
+
+    u32 index;
+    if (unlikely(!IdPoolTake(s_contextPool, &index))) {
+
+        return NULL;
+    }
+
+    return (SWorkerContext *)((u8 *) s_contextTable + index * s_contextSize);
+}
+
+static inline void ReleaseContext(SWorkerContext * context) {
+
+    u32 index = (u32) (((u8 *) context - (u8 *) s_contextTable) / s_contextSize);
+    IdPoolPut(s_contextPool, index);
+}
+
+static SWorkerContext * BindContext(TWorkerId localId) {
+
+    /* Caller must hold the entry lock */
+
+    SWorkerContext * context = AllocateContext();
+    if (unlikely(context == NULL)) {
+
+        return NULL;
+    }
+
+    context->WorkerId = MakeWorkerId(GetOwnNodeId(), localId);
+    s_routeTable[localId].Context = context;
+    s_routeTable[localId].State = EWorkerState_Deploying;
+    return context;
 }
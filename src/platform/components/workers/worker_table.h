@@ -4,6 +4,7 @@
 
 #include <menabrea/common.h>
 #include <menabrea/workers.h>
+#include <workers/rate_limit.h>
 #include <event_machine.h>
 
 #define MAX_WORKER_NAME_LEN    EM_EO_NAME_LEN  /**< Maximum length of the worker's name */
@@ -16,35 +17,95 @@ typedef enum EWorkerState {
     EWorkerState_Terminating
 } EWorkerState;
 
+typedef struct SWorkerCoreStatistics {
+    /* Only ever written by the owning core */
+    SWorkerStatistics Counters;
+    /* Pad size to a multiple of cache line size */
+    void * _pad[0] ENV_CACHE_LINE_ALIGNED;
+} SWorkerCoreStatistics;
+
+typedef struct SWorkerMigration {
+    bool InProgress;
+    em_event_t Marker;         /* Last event sent to the source queue */
+    em_queue_t SourceQueue;
+    em_queue_t StagingQueue;   /* Unscheduled queue holding the messages sent until the marker is received */
+    em_queue_t TargetQueue;
+    TCoreMask SourceMask;
+    TCoreMask TargetMask;
+} SWorkerMigration;
+
+struct SContinuation;
+
 typedef struct SWorkerContext {
     TUserInitCallback UserInit;
     TUserLocalInitCallback UserLocalInit;
     TUserLocalExitCallback UserLocalExit;
     TUserExitCallback UserExit;
     TUserHandlerCallback WorkerBody;
+    TWorkerMultiBody WorkerMultiBody;
     TMessage MessageBuffer[MESSAGE_BUFFER_LENGTH];
     char Name[MAX_WORKER_NAME_LEN];
-    int CoreMask;
+    TCoreMask CoreMask;
+    TCoreMask HostMask;
     bool Parallel;
+    bool CoalesceSends;
+    bool Captured;
+    bool NoEarlyExit;
+    bool AutoRebalance;
+    bool InlineDelivery;
     bool TerminationRequested;
-    EWorkerState State;
+    u32 HandlerBudgetUs;          /* Handler watchdog budget or 0 for the node-wide one */
+    em_notif_t TerminationNotif;  /* Sent once a deferred termination completes (event undefined if none) */
     TWorkerId WorkerId;
-    em_queue_t Queue;
     em_eo_t Eo;
-    TSpinlock Lock;
+    TAtomic32 ExpiredMessages;
+    TAtomic32 ShedMessages;
+    TAtomic32 ThrottledMessages;
+    TAtomic32 HandlerOverruns;    /* Handler calls reported by the watchdog */
+    SRateLimiter RateLimiter;     /* Guarded by the worker table entry lock */
+    /* Used by workers with inline delivery enabled only */
+    TAtomic32 QueuedMessages;     /* Messages enqueued and not yet processed - inline delivery must not overtake them */
+    TAtomic32 InlineOwner;        /* Set while an atomic worker's body runs, be it dispatched by EM or invoked inline */
+    TAtomic32 InlineInvocations;  /* Bodies being run inline - the context must not be released before they return */
+    SWorkerMigration Migration;
+    TSpinlock ContinuationLock;
+    struct SContinuation * Continuations;  /* Pending continuations in the order of the calls to AwaitMessage */
+    SWorkerCoreStatistics * Statistics;
     void * SharedData;
     void * LocalData[0];
 } SWorkerContext;
 
-void WorkerTableInit(TWorkerId nodeId);
+/* Fields read when routing a message to the worker, kept apart from the rest of the context
+ * in an array indexed by the local worker ID - one entry per cache line, since the lock is taken
+ * on every send and must not bounce the entries of neighbouring workers between the cores */
+typedef struct SWorkerRoute {
+    TSpinlock Lock;
+    EWorkerState State;
+    EOverloadLevel SheddingLevel;
+    bool InlineDelivery;
+    bool RateLimited;             /* Rate limiter in the context to be consulted on delivery */
+    em_queue_t Queue;
+    SWorkerContext * Context;     /* Placeholder context with no worker if the entry is inactive */
+    /* Pad size to a multiple of cache line size */
+    void * _pad[0] ENV_CACHE_LINE_ALIGNED;
+} SWorkerRoute;
+
+void WorkerTableInit(TWorkerId nodeId, u32 capacity);
 void WorkerTableTeardown(void);
 SWorkerContext * ReserveWorkerContext(TWorkerId workerId);
 void ReleaseWorkerContext(TWorkerId workerId);
 SWorkerContext * FetchWorkerContext(TWorkerId workerId);
+SWorkerRoute * FetchWorkerRoute(TWorkerId workerId);
 void MarkDeploymentSuccessful(TWorkerId workerId);
 void MarkTeardownInProgress(TWorkerId workerId);
 void LockWorkerTableEntry(TWorkerId workerId);
 void UnlockWorkerTableEntry(TWorkerId workerId);
 void DisableWorkerDeployment(void);
 
+static inline SWorkerContext * GetCurrentWorkerContext(void) {
+
+    /* NULL outside of worker callbacks, e.g. in platform-internal EOs */
+    return (SWorkerContext *) g_currentWorker.Context;
+}
+
 #endif /* PLATFORM_COMPONENTS_WORKERS_WORKER_TABLE_H */
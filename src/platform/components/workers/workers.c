@@ -2,11 +2,23 @@
 #include <menabrea/workers.h>
 #include <workers/worker_table.h>
 #include <workers/completion_daemon.h>
+#include <workers/migration.h>
+#include <workers/fusion.h>
+#include <workers/continuations.h>
+#include <workers/pools.h>
+#include <workers/graphs.h>
+#include <workers/watchdog.h>
+#include <messaging/local/coalescing.h>
+#include <messaging/message.h>
+#include <capture/capture.h>
+#include <overload/overload.h>
 #include <cores/queue_groups.h>
 #include <menabrea/exception.h>
 #include <menabrea/log.h>
 #include <menabrea/common.h>
 #include <event_machine.h>
+#include <odp_api.h>
+#include <stdlib.h>
 #include <string.h>
 #include <setjmp.h>
 
@@ -15,6 +27,22 @@ static em_status_t WorkerEoLocalStart(void * eoCtx, em_eo_t eo);
 static em_status_t WorkerEoStop(void * eoCtx, em_eo_t eo);
 static em_status_t WorkerEoLocalStop(void * eoCtx, em_eo_t eo);
 static void WorkerEoReceive(void * eoCtx, em_event_t event, em_event_type_t type, em_queue_t queue, void * qCtx);
+static void WorkerEoReceiveMulti(void * eoCtx, em_event_t events[], int num, em_queue_t queue, void * qCtx);
+static inline bool AcceptMessage(SWorkerContext * context, SWorkerStatistics * statistics, TMessage message);
+static bool DivertToContinuation(SWorkerContext * context, SWorkerStatistics * statistics, TMessage message);
+static void InvokeWorkerBody(SWorkerContext * context, SWorkerStatistics * statistics, TMessage messages[], int count, SContinuation * continuation);
+static inline void CallWorkerBody(SWorkerContext * context, TMessage messages[], int count, SContinuation * continuation);
+static inline SCurrentWorker EnterWorkerContext(SWorkerContext * context);
+static inline void LeaveWorkerContext(const SCurrentWorker * previous);
+static inline void ClaimAtomicBody(SWorkerContext * context);
+static inline void ReleaseAtomicBody(SWorkerContext * context, int consumed);
+static bool IsWorkerConfigValid(const SWorkerConfig * config);
+static TWorkerId StartWorkerDeployment(const SWorkerConfig * config, em_event_t notifEvent, em_event_group_t eventGroup);
+static bool RequestTermination(TWorkerId workerId, const em_notif_t * notif, EWorkerState * state, char * workerName);
+static em_event_t * AllocateBatchNotifications(int count);
+static void FreeBatchNotifications(em_event_t notifEvents[], int count);
+static void DiscardNotification(em_event_t notifEvent, em_event_group_t eventGroup);
+static void DestroyCompletionMessage(TMessage completion);
 
 typedef enum ECurrentEoCallback {
     ECurrentEoCallback_Start,
@@ -24,146 +52,97 @@ typedef enum ECurrentEoCallback {
     ECurrentEoCallback_Receive
 } ECurrentEoCallback;
 
+SCurrentWorker g_currentWorker = {
+    .Context = NULL,
+    .SharedData = NULL,
+    .LocalData = NULL,
+    .WorkerId = WORKER_ID_INVALID
+};
+
 static ECurrentEoCallback s_currentEoCallback;
-static jmp_buf s_jumpPad;
+/* Landing pad of the innermost worker callback or NULL if no non-local return is possible */
+static jmp_buf * s_jumpPad = NULL;
+/* Number of worker bodies currently invoked inline on the current core */
+static int s_inlineDepth = 0;
 
 TWorkerId DeployWorker(const SWorkerConfig * config) {
 
-    if (unlikely(config == NULL)) {
+    if (unlikely(!IsWorkerConfigValid(config))) {
 
-        RaiseException(EExceptionFatality_NonFatal, \
-            "Passed NULL pointer for worker config");
         return WORKER_ID_INVALID;
     }
 
-    if (unlikely(config->Name == NULL)) {
+    /* Create the notification event */
+    em_event_t notifEvent = em_alloc(sizeof(SDaemonNotification), EM_EVENT_TYPE_SW, EM_POOL_DEFAULT);
+    if (unlikely(notifEvent == EM_EVENT_UNDEF)) {
 
-        RaiseException(EExceptionFatality_NonFatal, \
-            "Passed NULL pointer for worker name");
+        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to allocate a notification event when deploying worker '%s'", \
+            __FUNCTION__, config->Name);
         return WORKER_ID_INVALID;
     }
 
-    if (unlikely(config->WorkerBody == NULL)) {
-
-        RaiseException(EExceptionFatality_NonFatal, \
-            "Passed NULL pointer for body function of worker '%s'", \
-            config->Name);
-        return WORKER_ID_INVALID;
-    }
+    return StartWorkerDeployment(config, notifEvent, EM_EVENT_GROUP_UNDEF);
+}
 
-    LogPrint(ELogSeverityLevel_Debug, "Deploying %s worker '%s'...", \
-        config->Parallel ? "parallel" : "atomic", config->Name);
+int DeployWorkers(const SWorkerConfig configs[], TWorkerId workerIds[], int count, TMessage completion, TWorkerId receiver) {
 
-    /* Reserve the context */
-    SWorkerContext * context = ReserveWorkerContext(config->WorkerId);
-    if (unlikely(context == NULL)) {
+    if (unlikely(configs == NULL || workerIds == NULL || count < 0)) {
 
-        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to reserve context for worker '%s'", \
-            __FUNCTION__, config->Name);
-        return WORKER_ID_INVALID;
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Invalid batch of %d worker(s) to deploy (configs: %p, worker IDs: %p)", \
+            count, configs, workerIds);
+        DestroyCompletionMessage(completion);
+        return -1;
     }
-    context->UserInit = config->UserInit;
-    context->UserLocalInit = config->UserLocalInit;
-    context->UserLocalExit = config->UserLocalExit;
-    context->UserExit = config->UserExit;
-    context->WorkerBody = config->WorkerBody;
-    /* Use the shared data field to pass the init argument to save space */
-    context->SharedData = config->InitArg;
-    /* Copy the name and ensure proper NULL-termination (see strncpy manpage) */
-    (void) strncpy(context->Name, config->Name, sizeof(context->Name) - 1);
-    context->Name[sizeof(context->Name) - 1] = '\0';
-    context->CoreMask = config->CoreMask;
-    context->Parallel = config->Parallel;
-
-    /* Create the notification event */
-    em_event_t notifEvent = em_alloc(sizeof(TWorkerId), EM_EVENT_TYPE_SW, EM_POOL_DEFAULT);
-    if (unlikely(notifEvent == EM_EVENT_UNDEF)) {
 
-        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to allocate a notification event when deploying worker '%s'", \
-            __FUNCTION__, context->Name);
-        ReleaseWorkerContext(context->WorkerId);
-        return WORKER_ID_INVALID;
-    }
+    LogPrint(ELogSeverityLevel_Debug, "Deploying a batch of %d worker(s)...", count);
 
-    /* Set the worker ID as payload of the notification event */
-    TWorkerId * notifPayload = (TWorkerId *) em_event_pointer(notifEvent);
-    *notifPayload = context->WorkerId;
+    /* Allocate all notifications up front - once the event group has been applied,
+     * each worker must account for exactly one event sent in the group */
+    em_event_t * notifEvents = AllocateBatchNotifications(count);
+    if (unlikely(notifEvents == NULL)) {
 
-    /* Create the EO */
-    em_eo_t eo = em_eo_create(
-        context->Name,
-        WorkerEoStart,
-        WorkerEoLocalStart,
-        WorkerEoStop,
-        WorkerEoLocalStop,
-        WorkerEoReceive,
-        context
-    );
+        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to allocate notification events for a batch of %d worker(s)", \
+            __FUNCTION__, count);
+        DestroyCompletionMessage(completion);
+        return -1;
+    }
 
-    if (unlikely(eo == EM_EO_UNDEF)) {
+    em_event_group_t eventGroup = CreateCompletionGroup(count, completion, receiver);
+    if (unlikely(eventGroup == EM_EVENT_GROUP_UNDEF && completion != MESSAGE_INVALID)) {
 
-        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to create execution object for worker '%s'", \
-            __FUNCTION__, context->Name);
-        em_free(notifEvent);
-        ReleaseWorkerContext(context->WorkerId);
-        return WORKER_ID_INVALID;
+        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to set up completion notification for a batch of %d worker(s)", \
+            __FUNCTION__, count);
+        FreeBatchNotifications(notifEvents, count);
+        DestroyCompletionMessage(completion);
+        return -1;
     }
 
-    /* Create the queue */
-    em_queue_t queue = em_queue_create(
-        context->Name,
-        context->Parallel ? EM_QUEUE_TYPE_PARALLEL : EM_QUEUE_TYPE_ATOMIC,
-        EM_QUEUE_PRIO_NORMAL,
-        MapCoreMaskToQueueGroup(context->CoreMask),
-        NULL
-    );
-
-    if (unlikely(queue == EM_QUEUE_UNDEF)) {
+    int deployed = 0;
+    for (int i = 0; i < count; i++) {
 
-        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to create queue for worker '%s'", \
-            __FUNCTION__, context->Name);
-        em_free(notifEvent);
-        ReleaseWorkerContext(context->WorkerId);
-        (void) em_eo_delete(eo);
-        return WORKER_ID_INVALID;
-    }
+        if (likely(IsWorkerConfigValid(&configs[i]))) {
 
-    AssertTrue(EM_OK == em_eo_add_queue(eo, queue, 0, NULL));
+            /* The notification event is consumed whether the deployment starts or not */
+            workerIds[i] = StartWorkerDeployment(&configs[i], notifEvents[i], eventGroup);
 
-    context->Eo = eo;
-    context->Queue = queue;
+        } else {
 
-    /* Prepare a notification that will be delivered to the completion daemon
-     * once EO initialization completes on all cores */
-    em_notif_t notif = {
-        .event = notifEvent,
-        .queue = GetCompletionDaemonQueue(),
-        .egroup = EM_EVENT_GROUP_UNDEF
-    };
+            DiscardNotification(notifEvents[i], eventGroup);
+            workerIds[i] = WORKER_ID_INVALID;
+        }
 
-    /* Start the EO */
-    if (unlikely(EM_OK != em_eo_start(eo, NULL, NULL, 1, &notif))) {
+        if (workerIds[i] != WORKER_ID_INVALID) {
 
-        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to start the EO of worker '%s' (queue: %" PRI_QUEUE ", eo: %" PRI_EO ")", \
-            __FUNCTION__, context->Name, context->Queue, context->Eo);
-        em_free(notifEvent);
-        ReleaseWorkerContext(context->WorkerId);
-        /* Starting from EM-ODP v1.2.3 em_eo_delete() should remove all the remaining queues and
-         * delete them before deleting the actual EO */
-        (void) em_eo_delete(eo);
-        return WORKER_ID_INVALID;
+            deployed++;
+        }
     }
 
-    /* If we are here, then global init succeeded and note that local (per-core) inits
-     * cannot fail. Sending messages to the worker's EM queue will not be possible,
-     * however, until all local inits complete. The platform shall buffer any messages
-     * sent from now on and when the last local init completes, the platform daemon
-     * shall flush this buffer. */
+    free(notifEvents);
 
-    LogPrint(ELogSeverityLevel_Debug, "Worker '%s' deploying with ID 0x%x...", \
-        config->Name, context->WorkerId);
+    LogPrint(ELogSeverityLevel_Debug, "Deployment of %d out of %d worker(s) in progress", deployed, count);
 
-    return context->WorkerId;
+    return deployed;
 }
 
 void TerminateWorker(TWorkerId workerId) {
@@ -180,140 +159,118 @@ void TerminateWorker(TWorkerId workerId) {
     LogPrint(ELogSeverityLevel_Info, "Terminating worker 0x%x...", realId);
 
     char workerName[MAX_WORKER_NAME_LEN];
-    LockWorkerTableEntry(realId);
-    SWorkerContext * context = FetchWorkerContext(realId);
-
-    EWorkerState state = context->State;
-    switch (state) {
-    case EWorkerState_Active:
-
-        /* Worker active, can terminate it immediately */
-
-        /* Sanity-check internal consistency */
-        AssertTrue(realId == context->WorkerId);
+    EWorkerState state;
+    (void) RequestTermination(realId, NULL, &state, workerName);
+
+    if (state != EWorkerState_Active && state != EWorkerState_Deploying && WORKER_ID_INVALID == workerId) {
+
+        /* That being said, when the current worker is being terminated, we handle a race
+         * condition for the application, where the worker (parallel) calls TerminateWorker
+         * on two cores at the same time. By handling this case we ensure that calling
+         * TerminateWorker(WORKER_ID_INVALID) always interrupts execution of user code.
+         * The assertion below is an internal sanity check: if the worker is executing in
+         * the first place, and is in invalid state for termination, then it must be in
+         * state EWorkerState_Terminating. */
+        AssertTrue(EWorkerState_Terminating == state);
+
+        if (s_currentEoCallback == ECurrentEoCallback_LocalStop || s_currentEoCallback == ECurrentEoCallback_Stop) {
+
+            /* Tried terminating self in user exit code (local or global). Either way this
+             * is an error. So as to honour the promise that TerminateWorker(WORKER_ID_INVALID)
+             * never returns to user code, our hand is forced to raise a hard exception here. */
+            RaiseException(EExceptionFatality_Fatal, \
+                "Tried terminating self (0x%x, '%s') in user exit code (current EO callback: %d)", \
+                realId, workerName, s_currentEoCallback);
+        }
+    }
 
-        /* Mark the worker as terminating - the context will be released in the
-         * EO stop callback */
-        MarkTeardownInProgress(realId);
-        AssertTrue(EM_OK == em_eo_stop(context->Eo, 0, NULL));
-        UnlockWorkerTableEntry(realId);
-        break;
+    /* If terminating current worker we want to break out of the user code and do
+     * a non-local goto straight back into platform code */
+    if (WORKER_ID_INVALID == workerId) {
 
-    case EWorkerState_Deploying:
+        if (unlikely(s_jumpPad == NULL)) {
 
-        /* Worker deployment still in progress. Defer termination to the platform
-         * daemon. */
+            /* Either the worker promised never to terminate itself from the body or this is exit code,
+             * in which case we have handled the error above already */
+            RaiseException(EExceptionFatality_Fatal, \
+                "Worker 0x%x ('%s') tried terminating self despite having been deployed with NoEarlyExit set", \
+                realId, GetCurrentWorkerContext()->Name);
+        }
 
-        /* Sanity-check internal consistency */
-        AssertTrue(realId == context->WorkerId);
+        /* Terminating self, break out of the worker body/init immediately. */
+        longjmp(*s_jumpPad, 1);
+    }
+}
 
-        if (!context->TerminationRequested) {
+int TerminateWorkers(const TWorkerId workerIds[], int count, TMessage completion, TWorkerId receiver) {
 
-            context->TerminationRequested = true;
-            UnlockWorkerTableEntry(realId);
+    if (unlikely(workerIds == NULL || count < 0)) {
 
-        } else {
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Invalid batch of %d worker(s) to terminate (worker IDs: %p)", \
+            count, workerIds);
+        DestroyCompletionMessage(completion);
+        return -1;
+    }
 
-            UnlockWorkerTableEntry(realId);
-            /* Termination requested flag was already set */
-            LogPrint(ELogSeverityLevel_Warning, "%s(): Worker 0x%x's termination already requested", \
-                __FUNCTION__, realId);
-        }
-        break;
+    LogPrint(ELogSeverityLevel_Info, "Terminating a batch of %d worker(s)...", count);
 
-    default:
+    /* Notifications are only needed to report the completion */
+    em_event_t * notifEvents = NULL;
+    em_event_group_t eventGroup = EM_EVENT_GROUP_UNDEF;
+    if (completion != MESSAGE_INVALID) {
 
-        /* Worker in invalid state */
+        notifEvents = AllocateBatchNotifications(count);
+        eventGroup = notifEvents != NULL ? CreateCompletionGroup(count, completion, receiver) : EM_EVENT_GROUP_UNDEF;
+        if (unlikely(eventGroup == EM_EVENT_GROUP_UNDEF)) {
 
-        /* Copy the name before releasing the lock */
-        (void) strcpy(workerName, context->Name);
-        UnlockWorkerTableEntry(realId);
+            LogPrint(ELogSeverityLevel_Error, "%s(): Failed to set up completion notification for a batch of %d worker(s)", \
+                __FUNCTION__, count);
+            if (notifEvents != NULL) {
 
-        /* Always issue a warning since this is always a failure in application design to
-         * call TerminateWorker twice (or a bug if called for a bad worker ID altogether) */
-        LogPrint(ELogSeverityLevel_Warning, "%s(): Worker 0x%x ('%s') in invalid state: %d", \
-            __FUNCTION__, realId, workerName, state);
-
-        if (WORKER_ID_INVALID == workerId) {
-
-            /* That being said, when the current worker is being terminated, we handle a race
-             * condition for the application, where the worker (parallel) calls TerminateWorker
-             * on two cores at the same time. By handling this case we ensure that calling
-             * TerminateWorker(WORKER_ID_INVALID) always interrupts execution of user code.
-             * The assertion below is an internal sanity check: if the worker is executing in
-             * the first place, and is in invalid state for termination, then it must be in
-             * state EWorkerState_Terminating. */
-            AssertTrue(EWorkerState_Terminating == state);
-
-            if (s_currentEoCallback == ECurrentEoCallback_LocalStop || s_currentEoCallback == ECurrentEoCallback_Stop) {
-
-                /* Tried terminating self in user exit code (local or global). Either way this
-                 * is an error. So as to honour the promise that TerminateWorker(WORKER_ID_INVALID)
-                 * never returns to user code, our hand is forced to raise a hard exception here. */
-                RaiseException(EExceptionFatality_Fatal, \
-                    "Tried terminating self (0x%x, '%s') in user exit code (current EO callback: %d)", \
-                    realId, workerName, s_currentEoCallback);
+                FreeBatchNotifications(notifEvents, count);
             }
+            DestroyCompletionMessage(completion);
+            return -1;
         }
-        break;
     }
 
-    /* If terminating current worker we want to break out of the user code and do
-     * a non-local goto straight back into platform code */
-    if (WORKER_ID_INVALID == workerId) {
+    int terminating = 0;
+    for (int i = 0; i < count; i++) {
 
-        /* Terminating self, break out of the worker body/init immediately. */
-        longjmp(s_jumpPad, 1);
-    }
-}
+        em_notif_t notif = {
+            .event = notifEvents != NULL ? notifEvents[i] : EM_EVENT_UNDEF,
+            .queue = GetCompletionDaemonQueue(),
+            .egroup = eventGroup
+        };
 
-void * GetSharedData(void) {
+        char workerName[MAX_WORKER_NAME_LEN];
+        EWorkerState state;
+        bool requested = false;
+        if (unlikely(WorkerIdGetNode(workerIds[i]) != GetOwnNodeId())) {
 
-    em_eo_t self = em_eo_current();
-    /* Do not allow calling this function from a non-EO context */
-    AssertTrue(self != EM_EO_UNDEF);
-    SWorkerContext * context = (SWorkerContext *) em_eo_get_context(self);
-    return context->SharedData;
-}
+            RaiseException(EExceptionFatality_NonFatal, "Attempted to terminate remote worker 0x%x", \
+                workerIds[i]);
 
-void SetSharedData(void * data) {
+        } else {
 
-    em_eo_t self = em_eo_current();
-    /* Do not allow calling this function from a non-EO context */
-    AssertTrue(self != EM_EO_UNDEF);
-    SWorkerContext * context = (SWorkerContext *) em_eo_get_context(self);
-    context->SharedData = data;
-}
+            /* Unlike TerminateWorker, never break out of the caller's code, even if it is among the workers */
+            requested = RequestTermination(workerIds[i], notifEvents != NULL ? &notif : NULL, &state, workerName);
+        }
 
-void * GetLocalData(void) {
+        if (likely(requested)) {
 
-    em_eo_t self = em_eo_current();
-    /* Do not allow calling this function from a non-EO context */
-    AssertTrue(self != EM_EO_UNDEF);
-    SWorkerContext * context = (SWorkerContext *) em_eo_get_context(self);
-    int core = em_core_id();
-    /* Return data local to the current core */
-    return context->LocalData[core];
-}
+            terminating++;
 
-void SetLocalData(void * data) {
+        } else if (notifEvents != NULL) {
 
-    em_eo_t self = em_eo_current();
-    /* Do not allow calling this function from a non-EO context */
-    AssertTrue(self != EM_EO_UNDEF);
-    SWorkerContext * context = (SWorkerContext *) em_eo_get_context(self);
-    int core = em_core_id();
-    /* Set data local to the current core */
-    context->LocalData[core] = data;
-}
+            DiscardNotification(notifEvents[i], eventGroup);
+        }
+    }
 
-TWorkerId GetOwnWorkerId(void) {
+    free(notifEvents);
 
-    em_eo_t self = em_eo_current();
-    /* Do not allow calling this function from a non-EO context */
-    AssertTrue(self != EM_EO_UNDEF);
-    SWorkerContext * context = (SWorkerContext *) em_eo_get_context(self);
-    return context->WorkerId;
+    return terminating;
 }
 
 TWorkerId FindLocalWorker(const char * name) {
@@ -339,10 +296,9 @@ TWorkerId FindLocalWorker(const char * name) {
 
 void EndAtomicContext(void) {
 
-    em_eo_t self = em_eo_current();
+    SWorkerContext * context = GetCurrentWorkerContext();
     /* Do not allow calling this function from a non-EO context */
-    AssertTrue(self != EM_EO_UNDEF);
-    SWorkerContext * context = (SWorkerContext *) em_eo_get_context(self);
+    AssertTrue(context != NULL);
 
     /* Check if parallel worker, i.e. one with a parallel queue associated with
      * them. If not (i.e. queue is of type EM_QUEUE_TYPE_ATOMIC) then we can
@@ -361,14 +317,82 @@ void TerminateAllWorkers(void) {
 
     for (TWorkerId i = 0; i < MAX_WORKER_COUNT; i++) {
 
-        SWorkerContext * context = FetchWorkerContext(i);
-        if (context->State == EWorkerState_Active) {
+        if (FetchWorkerRoute(i)->State == EWorkerState_Active) {
 
             TerminateWorker(MakeWorkerId(GetOwnNodeId(), i));
         }
     }
 }
 
+bool TryDeliverInline(TWorkerId receiver, TMessage message) {
+
+    /* Only fuse with the sender's body - other contexts (e.g. EO start callbacks, input polling)
+     * must not run worker bodies */
+    if (s_inlineDepth >= MAX_INLINE_DEPTH || s_currentEoCallback != ECurrentEoCallback_Receive \
+        || GetCurrentWorkerContext() == NULL) {
+
+        return false;
+    }
+
+    SWorkerRoute * route = FetchWorkerRoute(receiver);
+    if (likely(!route->InlineDelivery) || unlikely(ShouldShedTraffic(route->SheddingLevel))) {
+
+        /* Leave the shedding to the regular path */
+        return false;
+    }
+
+    LockWorkerTableEntry(receiver);
+    SWorkerContext * context = route->Context;
+    if (unlikely(route->State != EWorkerState_Active || context->WorkerId != receiver \
+        || context->Migration.InProgress || !CoreMaskContains(context->CoreMask, em_core_id()))) {
+
+        UnlockWorkerTableEntry(receiver);
+        return false;
+    }
+
+    if (!context->Parallel) {
+
+        /* Never overtake messages already enqueued and never run concurrently with the body
+         * dispatched by EM (or invoked inline on another core) */
+        if (Atomic32Get(&context->QueuedMessages) != 0 || !Atomic32CmpSet(&context->InlineOwner, 0, 1)) {
+
+            UnlockWorkerTableEntry(receiver);
+            return false;
+        }
+    }
+
+    if (unlikely(route->RateLimited) && 0 == RateLimiterAdmit(&context->RateLimiter, 1)) {
+
+        /* Over the rate limit - let the regular path drop the message */
+        if (!context->Parallel) {
+
+            Atomic32Set(&context->InlineOwner, 0);
+        }
+        UnlockWorkerTableEntry(receiver);
+        return false;
+    }
+    /* Keep the context from being released until the body returns */
+    Atomic32Inc(&context->InlineInvocations);
+    UnlockWorkerTableEntry(receiver);
+
+    /* The sender's core updates its own statistics entry as with regular delivery */
+    SWorkerStatistics * statistics = &context->Statistics[em_core_id()].Counters;
+    s_inlineDepth++;
+    if (likely(AcceptMessage(context, statistics, message)) && !DivertToContinuation(context, statistics, message)) {
+
+        InvokeWorkerBody(context, statistics, &message, 1, NULL);
+    }
+    s_inlineDepth--;
+
+    if (!context->Parallel) {
+
+        Atomic32Set(&context->InlineOwner, 0);
+    }
+    Atomic32Dec(&context->InlineInvocations);
+
+    return true;
+}
+
 static em_status_t WorkerEoStart(void * eoCtx, em_eo_t eo, const em_eo_conf_t * conf) {
 
     SWorkerContext * context = (SWorkerContext *) eoCtx;
@@ -383,10 +407,17 @@ static em_status_t WorkerEoStart(void * eoCtx, em_eo_t eo, const em_eo_conf_t *
     /* No user code has been run yet, we can safely clear the shared data field */
     context->SharedData = NULL;
 
+    em_status_t status = EM_OK;
     if (context->UserInit) {
 
+        /* The worker may be deployed from another worker's callback, so save the state of the caller */
+        SCurrentWorker previous = EnterWorkerContext(context);
+        jmp_buf * previousJumpPad = s_jumpPad;
+        jmp_buf jumpPad;
+        s_jumpPad = &jumpPad;
+
         /* Prepare for a non-local return in case the worker chooses to terminate */
-        if (0 == setjmp(s_jumpPad)) {
+        if (0 == setjmp(jumpPad)) {
 
             /* Call user-provided initialization function */
             int userStatus = context->UserInit(initArg);
@@ -396,7 +427,7 @@ static em_status_t WorkerEoStart(void * eoCtx, em_eo_t eo, const em_eo_conf_t *
                     "User's global initialization function for worker 0x%x ('%s') failed (return value: %d)", \
                     context->WorkerId, context->Name, userStatus);
                 /* Return error, resources will be cleaned up in the 'DeployWorker' function */
-                return EM_ERROR;
+                status = EM_ERROR;
             }
 
         } else {
@@ -404,9 +435,12 @@ static em_status_t WorkerEoStart(void * eoCtx, em_eo_t eo, const em_eo_conf_t *
             LogPrint(ELogSeverityLevel_Debug, "Worker 0x%x ('%s') jumped back to %s", \
                 context->WorkerId, context->Name, __FUNCTION__);
         }
+
+        s_jumpPad = previousJumpPad;
+        LeaveWorkerContext(&previous);
     }
 
-    return EM_OK;
+    return status;
 }
 
 static em_status_t WorkerEoLocalStart(void * eoCtx, em_eo_t eo) {
@@ -419,12 +453,17 @@ static em_status_t WorkerEoLocalStart(void * eoCtx, em_eo_t eo) {
     /* Check if the worker has been deployed to the current core - only
      * run user-defined init callback on the relevant cores that will
      * host/run the worker */
-    int isHostToWorker = (1 << core) & context->CoreMask;
+    bool isHostToWorker = CoreMaskContains(context->HostMask, core);
 
     if (isHostToWorker && context->UserLocalInit) {
 
+        SCurrentWorker previous = EnterWorkerContext(context);
+        jmp_buf * previousJumpPad = s_jumpPad;
+        jmp_buf jumpPad;
+        s_jumpPad = &jumpPad;
+
         /* Prepare for a non-local return in case the worker chooses to terminate */
-        if (0 == setjmp(s_jumpPad)) {
+        if (0 == setjmp(jumpPad)) {
 
             /* Run user-defined initialization function. Note that this will be run on
              * different cores in different processes so we rely here on the fact that the
@@ -437,6 +476,9 @@ static em_status_t WorkerEoLocalStart(void * eoCtx, em_eo_t eo) {
             LogPrint(ELogSeverityLevel_Debug, "Worker 0x%x ('%s') jumped back to %s", \
                 context->WorkerId, context->Name, __FUNCTION__);
         }
+
+        s_jumpPad = previousJumpPad;
+        LeaveWorkerContext(&previous);
     }
 
     return EM_OK;
@@ -448,16 +490,64 @@ static em_status_t WorkerEoStop(void * eoCtx, em_eo_t eo) {
 
     s_currentEoCallback = ECurrentEoCallback_Stop;
 
+    u32 expiredMessages = Atomic32Get(&context->ExpiredMessages);
+    if (expiredMessages > 0) {
+
+        LogPrint(ELogSeverityLevel_Info, "Worker 0x%x ('%s') had %u expired message(s) dropped", \
+            context->WorkerId, context->Name, expiredMessages);
+    }
+
+    u32 shedMessages = Atomic32Get(&context->ShedMessages);
+    if (shedMessages > 0) {
+
+        LogPrint(ELogSeverityLevel_Info, "Worker 0x%x ('%s') had %u message(s) shed under overload", \
+            context->WorkerId, context->Name, shedMessages);
+    }
+
+    int cancelled = CancelContinuations(context);
+    if (cancelled > 0) {
+
+        LogPrint(ELogSeverityLevel_Info, "Worker 0x%x ('%s') had %d pending continuation(s) discarded", \
+            context->WorkerId, context->Name, cancelled);
+    }
+
+    u32 throttledMessages = Atomic32Get(&context->ThrottledMessages);
+    if (throttledMessages > 0) {
+
+        LogPrint(ELogSeverityLevel_Info, "Worker 0x%x ('%s') had %u message(s) dropped over its rate limit", \
+            context->WorkerId, context->Name, throttledMessages);
+    }
+
+    /* Save the core mask before the context is released */
+    TCoreMask coreMask = context->CoreMask;
+
+    while (unlikely(Atomic32Get(&context->InlineInvocations) > 0)) {
+
+        /* A sender on another core admitted just before termination was requested
+         * is still running the body inline - wait for it to return */
+    }
+
     if (context->UserExit) {
 
+        /* No landing pad - terminating self in exit code is an error */
+        SCurrentWorker previous = EnterWorkerContext(context);
+        jmp_buf * previousJumpPad = s_jumpPad;
+        s_jumpPad = NULL;
         context->UserExit();
+        s_jumpPad = previousJumpPad;
+        LeaveWorkerContext(&previous);
     }
 
+    /* Unmap the worker from its pool or graph, if any, before its ID can be reused */
+    NoteShardTerminated(context->WorkerId);
+    NoteStageTerminated(context->WorkerId);
     ReleaseWorkerContext(context->WorkerId);
 
     /* Starting from EM-ODP v1.2.3 em_eo_delete() should remove all the remaining queues and
      * delete them before deleting the actual EO */
     AssertTrue(EM_OK == em_eo_delete(eo));
+    /* The worker's queue is gone, the group may be deleted if no longer used */
+    ReleaseQueueGroup(coreMask);
 
     return EM_OK;
 }
@@ -471,16 +561,22 @@ static em_status_t WorkerEoLocalStop(void * eoCtx, em_eo_t eo) {
     int core = em_core_id();
     /* Check if the worker has been deployed to the current core - only
      * run user-defined exit callback on the relevant cores that used to
-     * host/run the worker */
-    int isHostToWorker = (1 << core) & context->CoreMask;
+     * host/run the worker (see SetWorkerCoreMask) */
+    bool isHostToWorker = CoreMaskContains(context->HostMask, core);
 
     if (isHostToWorker && context->UserLocalExit) {
 
+        /* No landing pad - terminating self in exit code is an error */
+        SCurrentWorker previous = EnterWorkerContext(context);
+        jmp_buf * previousJumpPad = s_jumpPad;
+        s_jumpPad = NULL;
         /* Run user-defined teardown function. Note that this will be run on
          * different cores in different processes so we rely here on the fact that the
          * address spaces look the same, i.e. the user library is loaded before
          * the fork. */
         context->UserLocalExit(core);
+        s_jumpPad = previousJumpPad;
+        LeaveWorkerContext(&previous);
     }
 
     return EM_OK;
@@ -496,20 +592,571 @@ static void WorkerEoReceive(void * eoCtx, em_event_t event, em_event_type_t type
     (void) queue;
     (void) qCtx;
 
-    /* Prepare for a non-local return in case the worker chooses to terminate */
-    if (0 == setjmp(s_jumpPad)) {
-        /* TODO: If this turns out to be too much overhead consider adding a flag in the worker context to denote that
-         * the worker may never terminate on its own (we could then raise an exception in TerminateWorker on violation of
-         * this promise on behalf of the user, and skip setting the landing pad here) */
+    if (unlikely(IsMigrationMarker(context, event))) {
+
+        /* All messages sent to the worker's previous queue have been received */
+        HandOverWorkerQueue(context);
+        return;
+    }
 
-        /* TODO: Add statistics/profiling here (under spinlock as the worker may be parallel) */
-        AssertTrue(context->WorkerBody != NULL);
-        /* Pass the event to the user-provided handler */
-        context->WorkerBody(event);
+    /* Message no longer queued up */
+    NoteMessagesConsumed(1);
 
-    } else {
+    /* Each core only ever updates its own statistics entry */
+    SWorkerStatistics * statistics = &context->Statistics[em_core_id()].Counters;
+    ClaimAtomicBody(context);
+    if (likely(AcceptMessage(context, statistics, event)) && !DivertToContinuation(context, statistics, event)) {
+
+        InvokeWorkerBody(context, statistics, &event, 1, NULL);
+    }
+    ReleaseAtomicBody(context, 1);
+}
+
+static void WorkerEoReceiveMulti(void * eoCtx, em_event_t events[], int num, em_queue_t queue, void * qCtx) {
+
+    SWorkerContext * context = (SWorkerContext *) eoCtx;
+
+    s_currentEoCallback = ECurrentEoCallback_Receive;
+
+    (void) queue;
+    (void) qCtx;
+
+    /* Each core only ever updates its own statistics entry */
+    SWorkerStatistics * statistics = &context->Statistics[em_core_id()].Counters;
+    ClaimAtomicBody(context);
+    /* Compact the array in place, skipping the messages dropped */
+    int accepted = 0;
+    bool markerReceived = false;
+    for (int i = 0; i < num; i++) {
+
+        if (unlikely(IsMigrationMarker(context, events[i]))) {
+
+            markerReceived = true;
+
+        } else if (likely(AcceptMessage(context, statistics, events[i])) \
+            && !DivertToContinuation(context, statistics, events[i])) {
+
+            /* Continuations are resumed one by one, ahead of the batch */
+            events[accepted++] = events[i];
+        }
+    }
+
+    /* Messages no longer queued up */
+    NoteMessagesConsumed(markerReceived ? num - 1 : num);
+
+    if (likely(accepted > 0)) {
+
+        InvokeWorkerBody(context, statistics, events, accepted, NULL);
+    }
+    ReleaseAtomicBody(context, markerReceived ? num - 1 : num);
+
+    if (unlikely(markerReceived)) {
+
+        /* Only hand the queue over once the messages received along with the marker
+         * have been processed, lest they race with the ones staged */
+        HandOverWorkerQueue(context);
+    }
+}
+
+static inline bool AcceptMessage(SWorkerContext * context, SWorkerStatistics * statistics, TMessage message) {
+
+    statistics->MessagesReceived++;
+    statistics->BytesReceived += GetMessageData(message)->Header.PayloadSize;
+
+    if (unlikely(context->Captured)) {
+
+        /* Record the message as delivered, before any filtering */
+        CaptureMessage(message);
+    }
+
+    if (IsDeadlineExpired(GetMessageData(message)->Header.Deadline)) {
+
+        /* Message stale, do not waste the worker's time on it */
+        Atomic32Inc(&context->ExpiredMessages);
+        DestroyMessage(message);
+        return false;
+    }
+
+    return true;
+}
+
+static bool DivertToContinuation(SWorkerContext * context, SWorkerStatistics * statistics, TMessage message) {
+
+    /* Stale timeouts may arrive after the last continuation has been resumed */
+    if (likely(!HasPendingContinuations(context)) && likely(GetMessageId(message) != CONTINUATION_TIMEOUT_MESSAGE_ID)) {
+
+        return false;
+    }
+
+    SContinuation * continuation = TakeContinuation(context, &message);
+    if (continuation != NULL) {
+
+        /* Resume the continuation in place of the body */
+        InvokeWorkerBody(context, statistics, &message, 1, continuation);
+        ReleaseContinuation(continuation);
+        return true;
+    }
+
+    /* Message for the body unless it was a stale timeout */
+    return message == MESSAGE_INVALID;
+}
+
+static void InvokeWorkerBody(SWorkerContext * context, SWorkerStatistics * statistics, TMessage messages[], int count, SContinuation * continuation) {
+
+    if (context->CoalesceSends) {
+
+        /* Stage local messages sent by the worker body and enqueue them in bulk
+         * once the body returns */
+        BeginSendCoalescing();
+    }
+
+    /* Receive callbacks do not nest, but an EO start callback may be running further up the stack */
+    SCurrentWorker previous = EnterWorkerContext(context);
+    jmp_buf * previousJumpPad = s_jumpPad;
+
+    /* Let the watchdog know what the core is busy with - timeouts of continuations carry no message */
+    SWatchdogFrame watchdogFrame;
+    WatchdogHandlerStart(context->WorkerId, \
+        messages[0] != MESSAGE_INVALID ? GetMessageId(messages[0]) : CONTINUATION_TIMEOUT_MESSAGE_ID, \
+        context->HandlerBudgetUs, &watchdogFrame);
+    u64 handlerStart = odp_time_local_ns();
+    if (context->NoEarlyExit) {
+
+        /* The worker promised never to terminate itself from the body - skip
+         * the setjmp (TerminateWorker enforces the promise) */
+        s_jumpPad = NULL;
+        CallWorkerBody(context, messages, count, continuation);
+
+    } else {
+
+        jmp_buf jumpPad;
+        s_jumpPad = &jumpPad;
+        /* Prepare for a non-local return in case the worker chooses to terminate */
+        if (0 == setjmp(jumpPad)) {
+
+            CallWorkerBody(context, messages, count, continuation);
+
+        } else {
+
+            LogPrint(ELogSeverityLevel_Debug, "Worker 0x%x ('%s') jumped back to %s", \
+                context->WorkerId, context->Name, __FUNCTION__);
+        }
+    }
+
+    /* Account for the body also if it terminated itself */
+    u64 handlerTime = odp_time_local_ns() - handlerStart;
+    WatchdogHandlerEnd(&watchdogFrame);
+    statistics->HandlerInvocations++;
+    statistics->HandlerTimeNs += handlerTime;
+    if (unlikely(handlerTime > statistics->MaxHandlerTimeNs)) {
+
+        statistics->MaxHandlerTimeNs = handlerTime;
+    }
+
+    s_jumpPad = previousJumpPad;
+    LeaveWorkerContext(&previous);
+
+    if (context->CoalesceSends) {
+
+        /* Flush the messages staged during the body (also if it terminated itself
+         * midway - messages sent before the call to TerminateWorker must still go out) */
+        EndSendCoalescing();
+    }
+}
+
+static inline void CallWorkerBody(SWorkerContext * context, TMessage messages[], int count, SContinuation * continuation) {
+
+    /* Pass the message(s) to the user-provided handler */
+    if (continuation != NULL) {
+
+        continuation->Callback(messages[0], continuation->Frame);
+
+    } else if (context->WorkerMultiBody != NULL) {
+
+        context->WorkerMultiBody(messages, count);
+
+    } else {
+
+        context->WorkerBody(messages[0]);
+    }
+}
+
+static inline SCurrentWorker EnterWorkerContext(SWorkerContext * context) {
+
+    /* Cache the worker for the accessors so that they need not look up the current EO */
+    SCurrentWorker previous = g_currentWorker;
+    g_currentWorker.Context = context;
+    g_currentWorker.SharedData = &context->SharedData;
+    g_currentWorker.LocalData = &context->LocalData[em_core_id()];
+    g_currentWorker.WorkerId = context->WorkerId;
+    return previous;
+}
+
+static inline void LeaveWorkerContext(const SCurrentWorker * previous) {
+
+    g_currentWorker = *previous;
+}
+
+static inline void ClaimAtomicBody(SWorkerContext * context) {
+
+    if (unlikely(context->InlineDelivery) && !context->Parallel) {
+
+        /* A sender may be running the body inline on another core - wait for it to
+         * return to preserve the atomicity of the worker */
+        while (!Atomic32CmpSet(&context->InlineOwner, 0, 1)) {
+
+            /* Inline invocations are short and never wait on the dispatcher */
+        }
+    }
+}
+
+static inline void ReleaseAtomicBody(SWorkerContext * context, int consumed) {
+
+    if (unlikely(context->InlineDelivery)) {
+
+        /* Let the senders deliver inline again once the queue has drained */
+        Atomic32Sub(&context->QueuedMessages, consumed);
+        if (!context->Parallel) {
+
+            Atomic32Set(&context->InlineOwner, 0);
+        }
+    }
+}
+
+static bool IsWorkerConfigValid(const SWorkerConfig * config) {
+
+    if (unlikely(config == NULL)) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Passed NULL pointer for worker config");
+        return false;
+    }
+
+    if (unlikely(config->Name == NULL)) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Passed NULL pointer for worker name");
+        return false;
+    }
+
+    if (unlikely(config->WorkerBody == NULL && config->WorkerMultiBody == NULL)) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Passed NULL pointer for body function of worker '%s'", \
+            config->Name);
+        return false;
+    }
+
+    if (unlikely(config->WorkerBody != NULL && config->WorkerMultiBody != NULL)) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Passed both single and multi-message body functions for worker '%s'", \
+            config->Name);
+        return false;
+    }
+
+    if (unlikely(config->MaxBatchSize < 0)) {
+
+        RaiseException(EExceptionFatality_NonFatal, \
+            "Invalid maximum batch size %d for worker '%s'", \
+            config->MaxBatchSize, config->Name);
+        return false;
+    }
+
+    return true;
+}
+
+static TWorkerId StartWorkerDeployment(const SWorkerConfig * config, em_event_t notifEvent, em_event_group_t eventGroup) {
+
+    LogPrint(ELogSeverityLevel_Debug, "Deploying %s worker '%s'...", \
+        config->Parallel ? "parallel" : "atomic", config->Name);
+
+    /* Reserve the context */
+    SWorkerContext * context = ReserveWorkerContext(config->WorkerId);
+    if (unlikely(context == NULL)) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to reserve context for worker '%s'", \
+            __FUNCTION__, config->Name);
+        DiscardNotification(notifEvent, eventGroup);
+        return WORKER_ID_INVALID;
+    }
+    context->UserInit = config->UserInit;
+    context->UserLocalInit = config->UserLocalInit;
+    context->UserLocalExit = config->UserLocalExit;
+    context->UserExit = config->UserExit;
+    context->WorkerBody = config->WorkerBody;
+    context->WorkerMultiBody = config->WorkerMultiBody;
+    /* Use the shared data field to pass the init argument to save space */
+    context->SharedData = config->InitArg;
+    /* Copy the name and ensure proper NULL-termination (see strncpy manpage) */
+    (void) strncpy(context->Name, config->Name, sizeof(context->Name) - 1);
+    context->Name[sizeof(context->Name) - 1] = '\0';
+    context->CoreMask = config->CoreMask;
+    /* Local inits run on these cores only, even if the worker is later migrated */
+    context->HostMask = config->CoreMask;
+    context->Parallel = config->Parallel;
+    context->CoalesceSends = config->CoalesceSends;
+    context->Captured = IsWorkerCaptured(context->Name);
+    context->NoEarlyExit = config->NoEarlyExit;
+    context->AutoRebalance = config->AutoRebalance;
+    context->InlineDelivery = config->InlineDelivery;
+    context->HandlerBudgetUs = config->HandlerBudgetUs;
+    RateLimiterInit(&context->RateLimiter, config->RateLimit, config->RateBurst);
+
+    /* Set the worker ID as payload of the notification event */
+    SDaemonNotification * notifPayload = (SDaemonNotification *) em_event_pointer(notifEvent);
+    notifPayload->Request = EDaemonRequest_CompleteDeployment;
+    notifPayload->WorkerId = context->WorkerId;
+
+    /* Create the EO */
+    em_eo_t eo;
+    if (context->WorkerMultiBody != NULL) {
+
+        /* Let EM pass multiple events to the receive function at once */
+        em_eo_multircv_param_t eoParams;
+        em_eo_multircv_param_init(&eoParams);
+        eoParams.start = WorkerEoStart;
+        eoParams.local_start = WorkerEoLocalStart;
+        eoParams.stop = WorkerEoStop;
+        eoParams.local_stop = WorkerEoLocalStop;
+        eoParams.receive_multi = WorkerEoReceiveMulti;
+        eoParams.eo_ctx = context;
+        if (config->MaxBatchSize > 0) {
+
+            /* Otherwise keep the EM default */
+            eoParams.max_events = config->MaxBatchSize;
+        }
+        eo = em_eo_create_multircv(context->Name, &eoParams);
+
+    } else {
+
+        eo = em_eo_create(
+            context->Name,
+            WorkerEoStart,
+            WorkerEoLocalStart,
+            WorkerEoStop,
+            WorkerEoLocalStop,
+            WorkerEoReceive,
+            context
+        );
+    }
+
+    if (unlikely(eo == EM_EO_UNDEF)) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to create execution object for worker '%s'", \
+            __FUNCTION__, context->Name);
+        DiscardNotification(notifEvent, eventGroup);
+        ReleaseWorkerContext(context->WorkerId);
+        return WORKER_ID_INVALID;
+    }
+
+    /* Get the queue group for the core mask, creating it on first use */
+    em_queue_group_t queueGroup = AcquireQueueGroup(config->CoreMask);
+    if (unlikely(queueGroup == EM_QUEUE_GROUP_UNDEF)) {
+
+        char maskString[CORE_MASK_STRING_LEN];
+        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to get queue group for worker '%s' (core mask: %s)", \
+            __FUNCTION__, context->Name, CoreMaskToString(config->CoreMask, maskString, sizeof(maskString)));
+        DiscardNotification(notifEvent, eventGroup);
+        ReleaseWorkerContext(context->WorkerId);
+        (void) em_eo_delete(eo);
+        return WORKER_ID_INVALID;
+    }
+
+    /* Create the queue */
+    em_queue_t queue = em_queue_create(
+        context->Name,
+        context->Parallel ? EM_QUEUE_TYPE_PARALLEL : EM_QUEUE_TYPE_ATOMIC,
+        EM_QUEUE_PRIO_NORMAL,
+        queueGroup,
+        NULL
+    );
+
+    if (unlikely(queue == EM_QUEUE_UNDEF)) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to create queue for worker '%s'", \
+            __FUNCTION__, context->Name);
+        DiscardNotification(notifEvent, eventGroup);
+        ReleaseWorkerContext(context->WorkerId);
+        (void) em_eo_delete(eo);
+        ReleaseQueueGroup(config->CoreMask);
+        return WORKER_ID_INVALID;
+    }
+
+    AssertTrue(EM_OK == em_eo_add_queue(eo, queue, 0, NULL));
+
+    /* Not routed to until the deployment completes, no need to lock the entry */
+    SWorkerRoute * route = FetchWorkerRoute(context->WorkerId);
+    route->SheddingLevel = config->SheddingLevel;
+    route->InlineDelivery = config->InlineDelivery;
+    route->RateLimited = config->RateLimit > 0;
+    route->Queue = queue;
+    context->Eo = eo;
+
+    /* Prepare a notification that will be delivered to the completion daemon
+     * once EO initialization completes on all cores */
+    em_notif_t notif = {
+        .event = notifEvent,
+        .queue = GetCompletionDaemonQueue(),
+        .egroup = eventGroup
+    };
+
+    /* Start the EO */
+    if (unlikely(EM_OK != em_eo_start(eo, NULL, NULL, 1, &notif))) {
+
+        LogPrint(ELogSeverityLevel_Error, "%s(): Failed to start the EO of worker '%s' (queue: %" PRI_QUEUE ", eo: %" PRI_EO ")", \
+            __FUNCTION__, context->Name, queue, context->Eo);
+        DiscardNotification(notifEvent, eventGroup);
+        ReleaseWorkerContext(context->WorkerId);
+        /* Starting from EM-ODP v1.2.3 em_eo_delete() should remove all the remaining queues and
+         * delete them before deleting the actual EO */
+        (void) em_eo_delete(eo);
+        ReleaseQueueGroup(config->CoreMask);
+        return WORKER_ID_INVALID;
+    }
+
+    /* If we are here, then global init succeeded and note that local (per-core) inits
+     * cannot fail. Sending messages to the worker's EM queue will not be possible,
+     * however, until all local inits complete. The platform shall buffer any messages
+     * sent from now on and when the last local init completes, the platform daemon
+     * shall flush this buffer. */
+
+    LogPrint(ELogSeverityLevel_Debug, "Worker '%s' deploying with ID 0x%x...", \
+        config->Name, context->WorkerId);
+
+    return context->WorkerId;
+}
+
+static bool RequestTermination(TWorkerId workerId, const em_notif_t * notif, EWorkerState * state, char * workerName) {
+
+    bool requested = false;
+    LockWorkerTableEntry(workerId);
+    SWorkerContext * context = FetchWorkerContext(workerId);
+
+    *state = FetchWorkerRoute(workerId)->State;
+    switch (*state) {
+    case EWorkerState_Active:
+
+        /* Worker active, can terminate it immediately */
+
+        /* Sanity-check internal consistency */
+        AssertTrue(workerId == context->WorkerId);
+
+        if (likely(!context->Migration.InProgress)) {
+
+            /* Mark the worker as terminating - the context will be released in the
+             * EO stop callback */
+            MarkTeardownInProgress(workerId);
+            AssertTrue(EM_OK == em_eo_stop(context->Eo, notif != NULL ? 1 : 0, notif));
+            requested = true;
+            break;
+        }
+
+        /* Worker being moved between queues. Defer termination to the platform
+         * daemon, which completes the migration. */
+        /* fall through */
+
+    case EWorkerState_Deploying:
+
+        /* Worker deployment still in progress. Defer termination to the platform
+         * daemon. */
+
+        /* Sanity-check internal consistency */
+        AssertTrue(workerId == context->WorkerId);
+
+        if (!context->TerminationRequested) {
+
+            context->TerminationRequested = true;
+            if (notif != NULL) {
+
+                /* The daemon shall pass the notification on when stopping the EO */
+                context->TerminationNotif = *notif;
+            }
+            requested = true;
+        }
+        break;
+
+    default:
+
+        /* Worker in invalid state */
+
+        /* Copy the name before releasing the lock */
+        (void) strcpy(workerName, context->Name);
+        UnlockWorkerTableEntry(workerId);
+
+        /* Always issue a warning since this is always a failure in application design to
+         * call TerminateWorker twice (or a bug if called for a bad worker ID altogether) */
+        LogPrint(ELogSeverityLevel_Warning, "%s(): Worker 0x%x ('%s') in invalid state: %d", \
+            __FUNCTION__, workerId, workerName, *state);
+        return false;
+    }
+
+    UnlockWorkerTableEntry(workerId);
+
+    if (unlikely(!requested)) {
+
+        /* Termination requested flag was already set */
+        LogPrint(ELogSeverityLevel_Warning, "%s(): Worker 0x%x's termination already requested", \
+            __FUNCTION__, workerId);
+    }
+
+    return requested;
+}
+
+static em_event_t * AllocateBatchNotifications(int count) {
+
+    em_event_t * notifEvents = malloc((count > 0 ? count : 1) * sizeof(em_event_t));
+    if (unlikely(notifEvents == NULL)) {
+
+        return NULL;
+    }
+
+    int allocated = count > 0 ? em_alloc_multi(notifEvents, count, sizeof(SDaemonNotification), EM_EVENT_TYPE_SW, EM_POOL_DEFAULT) : 0;
+    allocated = allocated > 0 ? allocated : 0;
+    if (unlikely(allocated < count)) {
+
+        FreeBatchNotifications(notifEvents, allocated);
+        return NULL;
+    }
+
+    for (int i = 0; i < count; i++) {
+
+        /* Only count towards the completion of the batch unless set otherwise */
+        SDaemonNotification * notifPayload = (SDaemonNotification *) em_event_pointer(notifEvents[i]);
+        notifPayload->Request = EDaemonRequest_None;
+        notifPayload->WorkerId = WORKER_ID_INVALID;
+    }
+
+    return notifEvents;
+}
+
+static void FreeBatchNotifications(em_event_t notifEvents[], int count) {
+
+    if (count > 0) {
+
+        em_free_multi(notifEvents, count);
+    }
+    free(notifEvents);
+}
+
+static void DiscardNotification(em_event_t notifEvent, em_event_group_t eventGroup) {
+
+    if (eventGroup == EM_EVENT_GROUP_UNDEF) {
+
+        em_free(notifEvent);
+        return;
+    }
+
+    /* Still count the worker towards the completion of its batch */
+    SDaemonNotification * notifPayload = (SDaemonNotification *) em_event_pointer(notifEvent);
+    notifPayload->Request = EDaemonRequest_None;
+    AssertTrue(EM_OK == em_send_group(notifEvent, GetCompletionDaemonQueue(), eventGroup));
+}
+
+static void DestroyCompletionMessage(TMessage completion) {
+
+    if (completion != MESSAGE_INVALID) {
 
-        LogPrint(ELogSeverityLevel_Debug, "Worker 0x%x ('%s') jumped back to %s", \
-            context->WorkerId, context->Name, __FUNCTION__);
+        DestroyMessage(completion);
     }
 }
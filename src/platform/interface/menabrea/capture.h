@@ -0,0 +1,39 @@
+#ifndef PLATFORM_INTERFACE_MENABREA_CAPTURE_H
+#define PLATFORM_INTERFACE_MENABREA_CAPTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+
+/**
+ * @brief Write out the messages captured on the current core so far
+ * @note Captured messages are normally written out in batches from the input poll, so the capture files may
+ *       lag behind the traffic. This function does nothing if capture has not been enabled in the platform config.
+ * @warning This function blocks on file I/O and is meant for tools and tests rather than for the fast path
+ */
+void FlushCapture(void);
+
+/**
+ * @brief Replay previously captured messages on the current node
+ * @param path Path of the capture files (without the .<core> suffix)
+ * @param speed Speed factor relative to the original timing or zero to replay as fast as possible
+ * @param completion Message sent once all the messages have been injected or MESSAGE_INVALID if not needed
+ * @param receiver Worker ID of the recipient of the completion message
+ * @return 0 on success, -1 if a replay is already in progress or no valid capture file has been found
+ * @note The messages are retargeted to the workers with the same local IDs on the current node, so captures
+ *       of workers with dynamic IDs are only meaningful as long as the IDs have not been reused
+ * @note After a call to this function, the ownership of the completion message is relinquished and the
+ *       platform is responsible for the message delivery or destruction
+ * @warning This function can only be called on the shared core, where the messages are injected
+ * @see FlushCapture
+ */
+int ReplayCapture(const char * path, double speed, TMessage completion, TWorkerId receiver);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLATFORM_INTERFACE_MENABREA_CAPTURE_H */
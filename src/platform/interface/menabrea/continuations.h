@@ -0,0 +1,49 @@
+
+#ifndef PLATFORM_INTERFACE_MENABREA_CONTINUATIONS_H
+#define PLATFORM_INTERFACE_MENABREA_CONTINUATIONS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <menabrea/common.h>
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+
+#define CONTINUATION_TIMEOUT_NONE        0                        /**< Wait for the message indefinitely */
+#define CONTINUATION_TIMEOUT_MESSAGE_ID  ( (TMessageId) 0xFFFF )  /**< Message ID reserved by the platform for continuation timeouts */
+
+/**
+ * @brief Continuation resumed in place of the worker body
+ * @param message Message awaited or MESSAGE_INVALID if the wait timed out
+ * @param frame State saved by the worker when it started waiting
+ * @note The continuation owns the message, but not the frame, which is released by the platform
+ *       when the continuation returns
+ */
+typedef void (* TContinuation)(TMessage message, void * frame);
+
+/**
+ * @brief Resume the current worker with a continuation instead of its body once a given message arrives
+ * @param messageId ID of the message awaited
+ * @param sender Worker ID of the sender of the message awaited or WORKER_ID_INVALID to accept any sender
+ * @param timeout Time in microseconds after which the continuation is resumed without a message or
+ *                CONTINUATION_TIMEOUT_NONE to wait indefinitely
+ * @param continuation Function to be called with the message awaited
+ * @param frameSize Size of the state to be carried over to the continuation
+ * @return Pointer to a frame of frameSize bytes to be filled in by the caller or NULL on failure
+ * @note The worker does not block - the call returns immediately and the worker body keeps receiving other
+ *       messages in the meantime. The first message matching a pending continuation is passed to that
+ *       continuation rather than to the body. Continuations are matched in the order of the calls.
+ * @note Fill in the frame before sending the request the reply to which is awaited, since for parallel
+ *       workers the continuation may be resumed on another core as soon as the reply arrives
+ * @note Frames are taken from the runtime memory pool. Timeouts use a platform timer for each wait.
+ * @note Pending continuations are discarded when the worker terminates
+ * @warning Must be called from a worker body or a continuation
+ */
+void * AwaitMessage(TMessageId messageId, TWorkerId sender, u32 timeout, TContinuation continuation, u32 frameSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLATFORM_INTERFACE_MENABREA_CONTINUATIONS_H */
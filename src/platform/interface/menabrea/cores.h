@@ -1,4 +1,3 @@
-
 #ifndef PLATFORM_INTERFACE_MENABREA_CORES_H
 #define PLATFORM_INTERFACE_MENABREA_CORES_H
 
@@ -6,6 +5,15 @@
 extern "C" {
 #endif
 
+#include <menabrea/common.h>
+#include <event_machine.h>
+
+typedef em_core_mask_t TCoreMask;                              /**< Set of cores */
+#define CORE_MASK_STRING_LEN  ( 2 * sizeof(TCoreMask) + 3 )    /**< Buffer size sufficient for the string representation of any core mask */
+
+ODP_STATIC_ASSERT(sizeof(TCoreMask) * 8 >= 256, \
+    "TCoreMask must be able to hold at least 256 cores");
+
 /**
  * @brief Return the total number of cores available in the system
  * @return Number of cores
@@ -22,7 +30,7 @@ int GetCurrentCore(void);
  * @brief Return the core mask corresponding to the current core
  * @return Mask of the current core
  */
-int GetCurrentCoreMask(void);
+TCoreMask GetCurrentCoreMask(void);
 
 /**
  * @brief Return a core mask corresponding to the shared core (suitable for non-critical applications)
@@ -30,7 +38,7 @@ int GetCurrentCoreMask(void);
  * @note Platform operates on the assumption that one physical core is shared between EM-ODP
  *       and other Linux processes, while the rest are isolated (e.g. via kernel command-line)
  */
-int GetSharedCoreMask(void);
+TCoreMask GetSharedCoreMask(void);
 
 /**
  * @brief Return a core mask corresponding to isolated cores only (suitable for high-performance low-latency applications)
@@ -38,15 +46,194 @@ int GetSharedCoreMask(void);
  * @note Platform operates on the assumption that one physical core is shared between EM-ODP
  *       and other Linux processes, while the rest are isolated (e.g. via kernel command-line)
  */
-int GetIsolatedCoresMask(void);
+TCoreMask GetIsolatedCoresMask(void);
+
+/**
+ * @brief Return an empty core mask
+ * @return Empty core mask
+ */
+static inline TCoreMask CoreMaskEmpty(void) {
+
+    TCoreMask mask;
+    em_core_mask_zero(&mask);
+    return mask;
+}
+
+/**
+ * @brief Return a core mask with a single core set
+ * @param core Zero-based core index
+ * @return Mask of the given core
+ */
+static inline TCoreMask CoreMaskOf(int core) {
+
+    TCoreMask mask;
+    em_core_mask_zero(&mask);
+    em_core_mask_set(core, &mask);
+    return mask;
+}
+
+/**
+ * @brief Convert a bitfield of the first 64 cores to a core mask
+ * @param bits Bitfield where bit n corresponds to core n
+ * @return Core mask
+ */
+static inline TCoreMask CoreMaskFromBits(u64 bits) {
+
+    TCoreMask mask;
+    em_core_mask_zero(&mask);
+    em_core_mask_set_bits(&bits, 1, &mask);
+    return mask;
+}
+
+/**
+ * @brief Add a core to a core mask
+ * @param mask Core mask
+ * @param core Zero-based core index
+ * @return Mask with the core set
+ */
+static inline TCoreMask CoreMaskAdd(TCoreMask mask, int core) {
+
+    em_core_mask_set(core, &mask);
+    return mask;
+}
+
+/**
+ * @brief Remove a core from a core mask
+ * @param mask Core mask
+ * @param core Zero-based core index
+ * @return Mask with the core cleared
+ */
+static inline TCoreMask CoreMaskRemove(TCoreMask mask, int core) {
+
+    em_core_mask_clr(core, &mask);
+    return mask;
+}
+
+/**
+ * @brief Compute the union of two core masks
+ * @param first First core mask
+ * @param second Second core mask
+ * @return Mask of cores set in either of the masks
+ */
+static inline TCoreMask CoreMaskUnion(TCoreMask first, TCoreMask second) {
+
+    TCoreMask result;
+    em_core_mask_or(&result, &first, &second);
+    return result;
+}
+
+/**
+ * @brief Compute the intersection of two core masks
+ * @param first First core mask
+ * @param second Second core mask
+ * @return Mask of cores set in both masks
+ */
+static inline TCoreMask CoreMaskIntersection(TCoreMask first, TCoreMask second) {
+
+    TCoreMask result;
+    em_core_mask_and(&result, &first, &second);
+    return result;
+}
+
+/**
+ * @brief Compute the difference of two core masks
+ * @param first Core mask to subtract from
+ * @param second Core mask to subtract
+ * @return Mask of cores set in the first mask, but not in the second one
+ */
+static inline TCoreMask CoreMaskDifference(TCoreMask first, TCoreMask second) {
+
+    TCoreMask common;
+    TCoreMask result;
+    em_core_mask_and(&common, &first, &second);
+    em_core_mask_xor(&result, &first, &common);
+    return result;
+}
+
+/**
+ * @brief Check if a core belongs to a core mask
+ * @param mask Core mask
+ * @param core Zero-based core index
+ * @return True if the core is set in the mask, false otherwise
+ */
+static inline bool CoreMaskContains(TCoreMask mask, int core) {
+
+    return em_core_mask_isset(core, &mask) != 0;
+}
+
+/**
+ * @brief Check if a core mask is empty
+ * @param mask Core mask
+ * @return True if no core is set in the mask, false otherwise
+ */
+static inline bool CoreMaskIsEmpty(TCoreMask mask) {
+
+    return em_core_mask_iszero(&mask) != 0;
+}
+
+/**
+ * @brief Check if two core masks are equal
+ * @param first First core mask
+ * @param second Second core mask
+ * @return True if the masks have the same cores set, false otherwise
+ */
+static inline bool CoreMaskEqual(TCoreMask first, TCoreMask second) {
+
+    return em_core_mask_equal(&first, &second) != 0;
+}
+
+/**
+ * @brief Check if one core mask is a subset of another
+ * @param subset Core mask to check
+ * @param mask Core mask to check against
+ * @return True if all the cores set in the subset are also set in the mask, false otherwise
+ */
+static inline bool CoreMaskIsSubset(TCoreMask subset, TCoreMask mask) {
+
+    return CoreMaskIsEmpty(CoreMaskDifference(subset, mask));
+}
+
+/**
+ * @brief Count the cores in a core mask
+ * @param mask Core mask
+ * @return Number of cores set in the mask
+ */
+static inline int CoreMaskCount(TCoreMask mask) {
+
+    return em_core_mask_count(&mask);
+}
+
+/**
+ * @brief Find the lowest-numbered core in a core mask
+ * @param mask Core mask
+ * @return Zero-based index of the first core set in the mask or -1 if the mask is empty
+ */
+static inline int CoreMaskFirst(TCoreMask mask) {
+
+    return em_core_mask_idx(1, &mask);
+}
+
+/**
+ * @brief Format a core mask as a hexadecimal string
+ * @param mask Core mask
+ * @param buffer Output buffer, preferably of size CORE_MASK_STRING_LEN
+ * @param size Size of the output buffer
+ * @return The output buffer
+ * @see CORE_MASK_STRING_LEN
+ */
+static inline const char * CoreMaskToString(TCoreMask mask, char * buffer, int size) {
+
+    em_core_mask_tostr(buffer, size, &mask);
+    return buffer;
+}
 
 /**
  * @brief Return a core mask corresponding to all cores of the system
  * @return Mask of all cores
  */
-static inline int GetAllCoresMask(void) {
+static inline TCoreMask GetAllCoresMask(void) {
 
-    return GetSharedCoreMask() | GetIsolatedCoresMask();
+    return CoreMaskUnion(GetSharedCoreMask(), GetIsolatedCoresMask());
 }
 
 #ifdef __cplusplus
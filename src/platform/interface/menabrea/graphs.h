@@ -0,0 +1,122 @@
+#ifndef PLATFORM_INTERFACE_MENABREA_GRAPHS_H
+#define PLATFORM_INTERFACE_MENABREA_GRAPHS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <menabrea/common.h>
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+
+typedef u16 TGraphId;                               /**< Dataflow graph identifier */
+#define GRAPH_ID_INVALID   ( (TGraphId) 0xFFFF )    /**< Magic value used to indicate graph deployment failure */
+#define MAX_GRAPH_COUNT    32                       /**< Maximum number of dataflow graphs supported by the platform */
+#define MAX_GRAPH_STAGES   64                       /**< Maximum number of stages of a single graph */
+#define MAX_GRAPH_EDGES    128                      /**< Maximum number of edges of a single graph */
+
+/* Assert consistency between constants at compile time */
+ODP_STATIC_ASSERT(GRAPH_ID_INVALID > MAX_GRAPH_COUNT, \
+    "GRAPH_ID_INVALID must be outside the MAX_GRAPH_COUNT range");
+ODP_STATIC_ASSERT(MAX_GRAPH_STAGES <= 256 && MAX_GRAPH_COUNT <= 256, \
+    "Graph and stage indices must fit in a byte each");
+
+/**
+ * @brief Stage of a dataflow graph
+ * @see SGraphConfig
+ */
+typedef struct SGraphStage {
+    SWorkerConfig Worker;  /**< Configuration of the worker running the stage - the Parallel flag selects between a parallel and an atomic queue and an empty core mask requests automatic placement */
+    u32 Cost;              /**< Relative cost of processing a message by the stage, used for automatic placement (0 is treated as 1) */
+    int Cores;             /**< Number of cores a parallel stage is spread over when placed automatically (0 is treated as 1, atomic stages always get a single core) */
+} SGraphStage;
+
+/**
+ * @brief Edge of a dataflow graph
+ * @note The edges leaving a stage become its outputs, numbered in the order in which they appear in the config
+ * @see SGraphConfig, GetStageOutput
+ */
+typedef struct SGraphEdge {
+    int From;  /**< Index of the stage sending messages */
+    int To;    /**< Index of the stage receiving messages */
+} SGraphEdge;
+
+/**
+ * @brief Configuration used during graph deployment
+ * @see DeployGraph
+ */
+typedef struct SGraphConfig {
+    const char * Name;          /**< Human-readable name */
+    const SGraphStage * Stages; /**< Array of stages */
+    int StageCount;             /**< Number of stages */
+    const SGraphEdge * Edges;   /**< Array of edges */
+    int EdgeCount;              /**< Number of edges */
+} SGraphConfig;
+
+/**
+ * @brief Deploy all the stages of a dataflow graph and connect them
+ * @param config Graph configuration
+ * @return Graph ID on success, GRAPH_ID_INVALID on failure, in which case no stage is left deployed
+ * @note Stages without a core mask are placed onto the least loaded cores, visiting them from the most to
+ *       the least costly. The cost of the stages with an explicit core mask is accounted for as well.
+ * @note The edges are resolved to worker IDs once all the workers have been deployed, so the outputs are
+ *       not available yet in UserInit and UserLocalInit, nor to the messages a stage handles before this
+ *       function returns (e.g. ones sent to it from the init code)
+ * @note This function should not be called in exit code (local and global alike)
+ * @see GetGraphStage, GetStageOutput, TerminateGraph
+ */
+TGraphId DeployGraph(const SGraphConfig * config);
+
+/**
+ * @brief Terminate all the stages of a graph and release the graph ID
+ * @param graphId Graph ID
+ * @param completion Message sent once all the stages have been torn down or MESSAGE_INVALID if not needed
+ * @param receiver Worker ID of the recipient of the completion message
+ * @return Number of stages whose termination has been requested or -1 if the graph ID is invalid
+ * @note The outputs are disconnected before the stages are terminated, so that messages still being
+ *       processed by the graph are dropped rather than sent to the workers being torn down
+ * @note After a call to this function, the ownership of the completion message is relinquished and the
+ *       platform is responsible for the message delivery or destruction
+ * @see TerminateWorkers
+ */
+int TerminateGraph(TGraphId graphId, TMessage completion, TWorkerId receiver);
+
+/**
+ * @brief Get the worker ID of a graph's stage, e.g. to feed messages into the graph
+ * @param graphId Graph ID
+ * @param stage Stage index
+ * @return Worker ID or WORKER_ID_INVALID if the graph ID or the stage index is invalid, if the graph is still
+ *         being deployed or if the stage has terminated on its own
+ * @note A stage terminating on its own is disconnected from the graph, so messages sent along the edges
+ *       into it are dropped
+ */
+TWorkerId GetGraphStage(TGraphId graphId, int stage);
+
+/**
+ * @brief Get the number of outputs of the current worker's stage
+ * @return Number of outputs or -1 if the current worker is not a stage of any graph
+ */
+int GetStageOutputCount(void);
+
+/**
+ * @brief Get the worker ID connected to an output of the current worker's stage
+ * @param output Output index
+ * @return Worker ID or WORKER_ID_INVALID if the current worker is not a stage of any graph or the output is invalid
+ */
+TWorkerId GetStageOutput(int output);
+
+/**
+ * @brief Send a message along an output of the current worker's stage
+ * @param message Message handle
+ * @param output Output index
+ * @note After a call to this function, the ownership of the message is relinquished and the
+ *       platform is responsible for the message delivery or destruction
+ * @note Messages sent along an invalid output or after the graph has been terminated are dropped
+ */
+void SendMessageToOutput(TMessage message, int output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLATFORM_INTERFACE_MENABREA_GRAPHS_H */
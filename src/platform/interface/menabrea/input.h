@@ -6,6 +6,8 @@
 extern "C" {
 #endif
 
+#include <menabrea/cores.h>
+
 /**
  * @brief Callback executed periodically in the dispatch loop
  * @note This function will be called only on cores on which input polling was registered
@@ -25,7 +27,7 @@ typedef void (*TInputPollCallback)(void * arg);
  *          must be cautious of passing pointers to core-private data as callback arguments
  * @see TInputPollCallback
  */
-void RegisterInputPolling(TInputPollCallback callback, void * callbackArgument, int coreMask);
+void RegisterInputPolling(TInputPollCallback callback, void * callbackArgument, TCoreMask coreMask);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,194 @@
+
+#ifndef PLATFORM_INTERFACE_MENABREA_MESSAGES_HH
+#define PLATFORM_INTERFACE_MENABREA_MESSAGES_HH
+
+#include <menabrea/messaging.h>
+#include <type_traits>
+#include <utility>
+
+/* Header-only C++ layer over menabrea/messaging.h. Message types are declared once, together
+ * with their IDs, and messages are owned by move-only handles which destroy them when they go
+ * out of scope unless sent. Everything is resolved at compile time and inlined down to the
+ * C API calls - no virtual calls or allocations are involved. */
+
+/* Note that TerminateWorker(WORKER_ID_INVALID) returns from the worker body non-locally (via longjmp),
+ * skipping the destructors of any objects on the stack, handles included - the messages they own leak
+ * and the behaviour is undefined as far as C++ is concerned. Bodies using these handles should be
+ * deployed with the NoEarlyExit flag set (and terminate themselves with TerminateWorker(GetOwnWorkerId())
+ * instead) or confine the handles to a nested scope which ends before the call. */
+
+namespace Messages {
+
+/**
+ * @brief Definition of a message type, binding a message ID to a payload layout
+ * @tparam ID Message ID
+ * @tparam PayloadType Type of the payload (may end in a flexible array member)
+ * @note Declare message types as aliases, e.g. using Ping = Messages::Definition<0x1234, PingPayload>;
+ */
+template <TMessageId ID, typename PayloadType>
+struct Definition {
+    static_assert(std::is_trivially_copyable_v<PayloadType>, "Message payloads are copied bitwise and must be trivially copyable");
+    static constexpr TMessageId Id = ID;
+    using Payload = PayloadType;
+};
+
+/**
+ * @brief Owning handle of a message of any type
+ * @warning The destructor does not run if the worker terminates itself with TerminateWorker(WORKER_ID_INVALID)
+ *          while the handle is in scope - see the note at the top of this file
+ */
+class Handle {
+public:
+    Handle(void) noexcept : Raw(MESSAGE_INVALID) {}
+    /* Take ownership of a raw message, e.g. one passed to a worker body */
+    explicit Handle(TMessage message) noexcept : Raw(message) {}
+    Handle(Handle && other) noexcept : Raw(other.Release()) {}
+    Handle(const Handle &) = delete;
+    Handle & operator=(const Handle &) = delete;
+    Handle & operator=(Handle && other) noexcept { this->Reset(other.Release()); return *this; }
+    ~Handle(void) { this->Reset(); }
+
+    explicit operator bool(void) const noexcept { return this->Raw != MESSAGE_INVALID; }
+    TMessage Get(void) const noexcept { return this->Raw; }
+    TMessageId GetId(void) const { return GetMessageId(this->Raw); }
+    TWorkerId GetSender(void) const { return GetMessageSender(this->Raw); }
+    u32 GetPayloadSize(void) const { return GetMessagePayloadSize(this->Raw); }
+
+    /* Give up ownership, e.g. to pass the message to the C API */
+    TMessage Release(void) noexcept { TMessage message = this->Raw; this->Raw = MESSAGE_INVALID; return message; }
+
+    void Reset(TMessage message = MESSAGE_INVALID) {
+
+        if (this->Raw != MESSAGE_INVALID) {
+
+            DestroyMessage(this->Raw);
+        }
+        this->Raw = message;
+    }
+
+    /* Send the message, relinquishing ownership */
+    void Send(TWorkerId receiver) && { SendMessage(this->Release(), receiver); }
+
+private:
+    TMessage Raw;
+};
+
+/**
+ * @brief Owning handle of a message of a given type
+ * @tparam Def Message type definition
+ */
+template <typename Def>
+class Message : public Handle {
+public:
+    using Definition = Def;
+    using Payload = typename Def::Payload;
+
+    Message(void) noexcept = default;
+    Message(Message && other) noexcept = default;
+    Message & operator=(Message && other) noexcept = default;
+
+    /**
+     * @brief Create a message
+     * @param extraSize Size of the data following the payload structure (its flexible array member, if any)
+     * @return Message handle, invalid on failure
+     */
+    static Message Create(u32 extraSize = 0) {
+
+        return Message(CreateMessage(Def::Id, sizeof(Payload) + extraSize));
+    }
+
+    /**
+     * @brief Take ownership of a raw message if it is of this type
+     * @param message Raw message handle
+     * @return Message handle, invalid if the ID or the size does not match (the raw message is then left untouched)
+     */
+    static Message Cast(TMessage message) {
+
+        return Matches(message) ? Message(message) : Message();
+    }
+
+    /**
+     * @brief Check if a raw message is of this type
+     * @param message Raw message handle
+     * @return True if both the ID and the size match
+     */
+    static bool Matches(TMessage message) {
+
+        return GetMessageId(message) == Def::Id && GetMessagePayloadSize(message) >= sizeof(Payload);
+    }
+
+    Payload * operator->(void) const { return static_cast<Payload *>(GetMessagePayload(this->Get())); }
+    Payload & operator*(void) const { return *this->operator->(); }
+
+private:
+    explicit Message(TMessage message) noexcept : Handle(message) {}
+
+    template <typename... Defs, typename Visitor>
+    friend void Dispatch(TMessage message, Visitor && visitor);
+};
+
+/**
+ * @brief Combine lambdas into a single visitor for Dispatch
+ * @note Usage: Dispatch<Ping, Pong>(message, Handlers {
+ *           [](Message<Ping> && ping) { ... },
+ *           [](Message<Pong> && pong) { ... },
+ *           [](Handle && other) { ... }
+ *       });
+ */
+template <typename... Callables>
+struct Handlers : Callables... {
+    using Callables::operator()...;
+};
+
+template <typename... Callables>
+Handlers(Callables...) -> Handlers<Callables...>;
+
+namespace Detail {
+
+template <typename... Defs>
+constexpr bool AreIdsUnique(void) {
+
+    constexpr TMessageId ids[] = { Defs::Id... };
+    for (unsigned i = 0; i < sizeof...(Defs); i++) {
+
+        for (unsigned j = i + 1; j < sizeof...(Defs); j++) {
+
+            if (ids[i] == ids[j]) {
+
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+}
+
+/**
+ * @brief Pass a raw message to the visitor's overload for its type
+ * @tparam Defs Message types handled
+ * @param message Raw message handle (ownership is transferred to the visitor)
+ * @param visitor Callable with an overload taking Message<Def> && for each of the types and one taking
+ *                Handle && for messages of other types or of invalid sizes
+ * @note The types are matched by a chain of comparisons on the message ID generated at compile time,
+ *       which the compiler is free to turn into a jump table
+ */
+template <typename... Defs, typename Visitor>
+inline void Dispatch(TMessage message, Visitor && visitor) {
+
+    static_assert(sizeof...(Defs) > 0, "No message types to dispatch on");
+    static_assert(Detail::AreIdsUnique<Defs...>(), "Message types dispatched on must have distinct IDs");
+
+    TMessageId id = GetMessageId(message);
+    u32 size = GetMessagePayloadSize(message);
+    bool handled = ((id == Defs::Id && size >= sizeof(typename Defs::Payload) \
+        ? (visitor(Message<Defs>(message)), true) : false) || ...);
+    if (!handled) {
+
+        visitor(Handle(message));
+    }
+}
+
+}
+
+#endif /* PLATFORM_INTERFACE_MENABREA_MESSAGES_HH */
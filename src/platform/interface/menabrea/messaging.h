@@ -8,7 +8,11 @@ extern "C" {
 
 #include <menabrea/workers.h>
 
-typedef u16 TMessageId;  /**< Message identifier type */
+typedef u16 TMessageId;                                 /**< Message identifier type */
+typedef em_event_group_t TMessageGroup;                 /**< Opaque handle of a group of messages whose consumption is tracked */
+#define MESSAGE_GROUP_INVALID     EM_EVENT_GROUP_UNDEF  /**< Magic value used to indicate message group creation failure */
+#define MAX_MESSAGE_TIME_TO_LIVE  ( (u32) 0x7FFFFFFF )  /**< Maximum time-to-live of a message in microseconds */
+#define MAX_MESSAGE_ATTACHMENTS   4                     /**< Maximum number of runtime memory buffers attached to a single message */
 
 /**
  * @brief Create a message
@@ -53,9 +57,61 @@ TMessageId GetMessageId(TMessage message);
  */
 TWorkerId GetMessageSender(TMessage message);
 
+/**
+ * @brief Set time-to-live of a message
+ * @param message Message handle
+ * @param ttl Time in microseconds from now after which the message expires or zero to clear the deadline
+ * @note Expired messages are dropped by the platform before being passed to the receiver, also on the
+ *       receiving node in the case of internode messages (it is assumed the nodes' clocks are synchronized,
+ *       otherwise the clock skew affects the effective time-to-live of internode messages)
+ * @see MAX_MESSAGE_TIME_TO_LIVE
+ */
+void SetMessageTimeToLive(TMessage message, u32 ttl);
+
+/**
+ * @brief Check if a message has expired
+ * @param message Message handle
+ * @return True if the message had its time-to-live set and it has elapsed, false otherwise
+ * @see SetMessageTimeToLive
+ */
+bool IsMessageExpired(TMessage message);
+
+/**
+ * @brief Attach runtime memory to a message
+ * @param message Message handle
+ * @param ptr Pointer to a memory buffer previously returned from GetRuntimeMemory
+ * @return 0 on success, -1 on failure (in which case the caller retains the reference)
+ * @note On success the caller's reference is transferred to the message and released when the message is
+ *       destroyed. Call RefRuntimeMemory beforehand to keep accessing the buffer after sending the message.
+ * @note Attachments are only passed by reference between workers on the same node. Messages with
+ *       attachments cannot be sent to other nodes.
+ * @see GetRuntimeMemory, RefRuntimeMemory, MAX_MESSAGE_ATTACHMENTS
+ */
+int AttachRuntimeMemory(TMessage message, void * ptr);
+
+/**
+ * @brief Get the number of runtime memory buffers attached to a message
+ * @param message Message handle
+ * @return Number of attachments
+ * @see AttachRuntimeMemory
+ */
+u32 GetMessageAttachmentCount(TMessage message);
+
+/**
+ * @brief Access runtime memory attached to a message
+ * @param message Message handle
+ * @param index Index of the attachment (in the order of the AttachRuntimeMemory calls)
+ * @return Pointer to the memory buffer or NULL if index is out of range
+ * @note The buffer is only guaranteed to remain valid until the message is destroyed. Call RefRuntimeMemory
+ *       to keep it longer, e.g. when forwarding it in another message.
+ * @see AttachRuntimeMemory, RefRuntimeMemory
+ */
+void * GetMessageAttachment(TMessage message, u32 index);
+
 /**
  * @brief Destroy a message
  * @param message Message handle
+ * @note Any runtime memory attached to the message is put
  * @warning The message handle must not be used after a call to this function
  */
 void DestroyMessage(TMessage message);
@@ -66,9 +122,39 @@ void DestroyMessage(TMessage message);
  * @param receiver Receiver's worker ID
  * @note After a call to this function, the ownership of the message is relinquished and the
  *       platform is responsible for the message delivery or destruction
+ * @note If the receiver has inline delivery enabled and may run on the current core, its body
+ *       may be invoked before this function returns (see SWorkerConfig::InlineDelivery)
  */
 void SendMessage(TMessage message, TWorkerId receiver);
 
+/**
+ * @brief Create a group of messages and request a notification once all of them have been consumed
+ * @param count Number of messages that will be sent in the group
+ * @param completion Message sent once the receivers of all the messages in the group have returned
+ *                   from their bodies
+ * @param receiver Worker ID of the recipient of the completion message
+ * @return Group handle or MESSAGE_GROUP_INVALID on failure
+ * @note Exactly count messages must be sent in the group using SendMessageInGroup. If count is zero, the
+ *       completion message is sent immediately and the handle must not be used.
+ * @note After a call to this function, the ownership of the completion message is relinquished and the
+ *       platform is responsible for the message delivery or destruction. The group is released once the
+ *       completion message has been sent.
+ * @see SendMessageInGroup
+ */
+TMessageGroup CreateMessageGroup(int count, TMessage completion, TWorkerId receiver);
+
+/**
+ * @brief Send a message to a worker as part of a group
+ * @param message Message handle
+ * @param receiver Receiver's worker ID
+ * @param group Group handle returned from CreateMessageGroup
+ * @note Messages which cannot be tracked until consumed, i.e. ones sent to remote workers, to workers still
+ *       being deployed or migrated, or dropped by the platform, count as consumed as soon as they are sent
+ * @note Messages sent in a group are never coalesced or delivered inline
+ * @see CreateMessageGroup, SendMessage
+ */
+void SendMessageInGroup(TMessage message, TWorkerId receiver, TMessageGroup group);
+
 #ifdef __cplusplus
 }
 #endif
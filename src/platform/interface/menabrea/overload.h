@@ -0,0 +1,34 @@
+
+#ifndef PLATFORM_INTERFACE_MENABREA_OVERLOAD_H
+#define PLATFORM_INTERFACE_MENABREA_OVERLOAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Node load level as published by the overload manager
+ */
+typedef enum EOverloadLevel {
+    EOverloadLevel_Normal = 0,  /**< Node keeps up with the traffic */
+    EOverloadLevel_Elevated,    /**< Node busy - producers should consider deferring nonessential work */
+    EOverloadLevel_High,        /**< Node close to saturation - producers should throttle */
+    EOverloadLevel_Critical,    /**< Node saturated - ingress should only admit essential traffic */
+    EOverloadLevel_Count        /**< Number of load levels */
+} EOverloadLevel;
+
+/**
+ * @brief Get the current load level of the node
+ * @return Load level
+ * @note The level is derived from the core utilisation, the event pool fill levels, and the number of messages
+ *       queued up for the workers, and is reevaluated periodically. It is always EOverloadLevel_Normal if the
+ *       overload manager has not been enabled in the platform config.
+ * @note This function is cheap enough to be called for every message, e.g. in input poll callbacks
+ */
+EOverloadLevel GetOverloadLevel(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLATFORM_INTERFACE_MENABREA_OVERLOAD_H */
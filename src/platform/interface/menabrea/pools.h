@@ -0,0 +1,104 @@
+
+#ifndef PLATFORM_INTERFACE_MENABREA_POOLS_H
+#define PLATFORM_INTERFACE_MENABREA_POOLS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <menabrea/common.h>
+#include <menabrea/workers.h>
+#include <menabrea/messaging.h>
+
+typedef u16 TWorkerPoolId;                                 /**< Worker pool identifier */
+#define WORKER_POOL_ID_INVALID  ( (TWorkerPoolId) 0xFFFF )  /**< Magic value used to indicate pool deployment failure */
+#define MAX_WORKER_POOL_COUNT   64                          /**< Maximum number of worker pools supported by the platform */
+#define MAX_WORKER_POOL_SHARDS  64                          /**< Maximum number of workers backing a single pool */
+
+/* Assert consistency between constants at compile time */
+ODP_STATIC_ASSERT(WORKER_POOL_ID_INVALID > MAX_WORKER_POOL_COUNT, \
+    "WORKER_POOL_ID_INVALID must be outside the MAX_WORKER_POOL_COUNT range");
+
+/**
+ * @brief Configuration used during worker pool deployment
+ * @see DeployWorkerPool
+ */
+typedef struct SWorkerPoolConfig {
+    SWorkerConfig Shard;  /**< Configuration of each worker backing the pool - the name is used as prefix of the shards' names, the worker ID must be WORKER_ID_INVALID and the shards must not be parallel */
+    int Shards;           /**< Initial number of shards */
+} SWorkerPoolConfig;
+
+/**
+ * @brief Deploy a pool of atomic workers sharing the load by key
+ * @param config Pool configuration
+ * @return Pool ID on success, WORKER_POOL_ID_INVALID on failure
+ * @note The init argument of the shards is passed to each of them and may be used on any core,
+ *       since pools can be resized from anywhere
+ * @note This function should not be called in exit code (local and global alike)
+ * @see SendMessageKeyed, WORKER_POOL_ID_INVALID
+ */
+TWorkerPoolId DeployWorkerPool(const SWorkerPoolConfig * config);
+
+/**
+ * @brief Terminate all the workers of a pool and release the pool ID
+ * @param poolId Pool ID
+ */
+void TerminateWorkerPool(TWorkerPoolId poolId);
+
+/**
+ * @brief Change the number of workers backing a pool
+ * @param poolId Pool ID
+ * @param shards New number of shards
+ * @return 0 on success, -1 on failure, in which case the pool may have been resized only partially
+ * @note Shards are added and removed at the end, which only remaps the keys of the shards removed or,
+ *       when growing, the share of the keys taken over by the new shards. The platform does not
+ *       move any per-key state kept by the workers.
+ * @note Shards that have terminated on their own are replaced by the call, so resizing a pool to its
+ *       current size restores any such shards
+ * @warning Messages sent concurrently to a shard being removed may be dropped
+ */
+int ResizeWorkerPool(TWorkerPoolId poolId, int shards);
+
+/**
+ * @brief Get the current number of workers backing a pool
+ * @param poolId Pool ID
+ * @return Number of shards or -1 if the pool ID is invalid
+ */
+int GetWorkerPoolSize(TWorkerPoolId poolId);
+
+/**
+ * @brief Get the worker ID of a pool's shard
+ * @param poolId Pool ID
+ * @param shard Shard index
+ * @return Worker ID or WORKER_ID_INVALID if the pool ID or the shard index is invalid
+ */
+TWorkerId GetWorkerPoolShard(TWorkerPoolId poolId, int shard);
+
+/**
+ * @brief Get statistics of a pool's shard aggregated over all cores
+ * @param poolId Pool ID
+ * @param shard Shard index
+ * @param statistics Output buffer for the statistics
+ * @return 0 on success, -1 if the pool ID or the shard index is invalid
+ * @see GetWorkerStatistics
+ */
+int GetWorkerPoolStatistics(TWorkerPoolId poolId, int shard, SWorkerStatistics * statistics);
+
+/**
+ * @brief Send a message to the worker of a pool responsible for a given key
+ * @param message Message handle
+ * @param poolId Pool ID
+ * @param key Key identifying the state the message pertains to
+ * @note Messages with the same key are always delivered to the same shard as long as the pool is not
+ *       resized, so they are processed atomically and in order
+ * @note Messages mapped to a shard that has terminated on its own are dropped until the pool is resized
+ * @note After a call to this function, the ownership of the message is relinquished and the
+ *       platform is responsible for the message delivery or destruction
+ */
+void SendMessageKeyed(TMessage message, TWorkerPoolId poolId, u64 key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PLATFORM_INTERFACE_MENABREA_POOLS_H */
@@ -7,6 +7,9 @@ extern "C" {
 #endif
 
 #include <menabrea/common.h>
+#include <menabrea/cores.h>
+#include <menabrea/exception.h>
+#include <menabrea/overload.h>
 #include <event_machine.h>
 
 typedef u16 TWorkerId;                                                         /**< Worker identifier type */
@@ -109,6 +112,13 @@ typedef void (* TUserExitCallback)(void);
  */
 typedef void (* TUserHandlerCallback)(TMessage message);
 
+/**
+ * @brief Worker body receiving messages in batches
+ * @note This function will get called with one or more messages sent to the worker. The worker takes
+ *       ownership of all the messages in the array, but not of the array itself.
+ */
+typedef void (* TWorkerMultiBody)(TMessage messages[], int count);
+
 /**
  * @brief Configuration used during worker deployment
  * @see DeployWorker
@@ -117,13 +127,23 @@ typedef struct SWorkerConfig {
     const char * Name;                     /**< Human-readable name */
     void * InitArg;                        /**< Private argument passed to the UserInit function if any provided */
     TWorkerId WorkerId;                    /**< Worker identifier */
-    int CoreMask;                          /**< Mask of cores on which the worker is eligible to run */
+    TCoreMask CoreMask;                    /**< Mask of cores on which the worker is eligible to run */
     bool Parallel;                         /**< Flag denoting whether the worker can be run in parallel on multiple cores at the same time */
+    bool CoalesceSends;                    /**< Flag denoting whether local messages sent from the worker body should be enqueued in bulk when the body returns */
+    EOverloadLevel SheddingLevel;          /**< Node load level from which messages to the worker are dropped if traffic shedding is enabled (EOverloadLevel_Normal to never shed) */
+    bool NoEarlyExit;                      /**< Promise that the worker body never terminates the worker itself, which spares the platform preparing a non-local return for every message */
+    bool AutoRebalance;                    /**< Allow the platform to move the worker between cores following their utilisation if worker rebalancing is enabled */
+    bool InlineDelivery;                   /**< Allow senders running on one of the worker's cores to invoke the body directly instead of enqueuing the message (atomicity and message order are preserved, nesting is bounded) */
+    u32 RateLimit;                         /**< Maximum sustained rate in messages per second at which messages are delivered to the worker, messages in excess being dropped (0 for no limit) */
+    u32 RateBurst;                         /**< Number of messages delivered at once above the sustained rate (used with a nonzero RateLimit, 0 is treated as 1) */
+    u32 HandlerBudgetUs;                   /**< Time in microseconds a single call to the worker body may take before the handler watchdog reports it (0 for the node-wide budget, ignored if the watchdog is disabled) */
     TUserInitCallback UserInit;            /**< User-provided global initialization function */
     TUserLocalInitCallback UserLocalInit;  /**< User-provided per-core initialization function */
     TUserLocalExitCallback UserLocalExit;  /**< User-provided per-core teardown function */
     TUserExitCallback UserExit;            /**< User-provided global teardown function */
     TUserHandlerCallback WorkerBody;       /**< Worker body */
+    TWorkerMultiBody WorkerMultiBody;      /**< Worker body receiving messages in batches (use instead of WorkerBody) */
+    int MaxBatchSize;                      /**< Maximum number of messages passed to WorkerMultiBody at once (0 to use the default) */
 } SWorkerConfig;
 
 /**
@@ -135,6 +155,24 @@ typedef struct SWorkerConfig {
  */
 TWorkerId DeployWorker(const SWorkerConfig * config);
 
+/**
+ * @brief Deploy multiple workers at once
+ * @param configs Array of worker configurations
+ * @param workerIds Output array of worker IDs, WORKER_ID_INVALID for each worker whose deployment failed
+ * @param count Number of workers to deploy
+ * @param completion Message sent once all the workers have completed their deployment or MESSAGE_INVALID if not needed
+ * @param receiver Worker ID of the recipient of the completion message
+ * @return Number of workers whose deployment is in progress or -1 if the batch could not be processed at all
+ * @note Unlike separate calls to DeployWorker, all the EOs are started without waiting for each other and
+ *       the caller is notified of completion once, after the last worker has become active (or has had its
+ *       deployment fail)
+ * @note After a call to this function, the ownership of the completion message is relinquished and the
+ *       platform is responsible for the message delivery or destruction
+ * @note This function should not be called in exit code (local and global alike)
+ * @see DeployWorker, TerminateWorkers
+ */
+int DeployWorkers(const SWorkerConfig configs[], TWorkerId workerIds[], int count, TMessage completion, TWorkerId receiver);
+
 /**
  * @brief Deploy a simple worker that can be only be run atomically on a single core at a time
  * @param name Human-readable name (optional)
@@ -145,7 +183,7 @@ TWorkerId DeployWorker(const SWorkerConfig * config);
  * @note This function should not be called in exit code (local and global alike)
  * @see WORKER_ID_INVALID
  */
-static inline TWorkerId DeploySimpleWorker(const char * name, TWorkerId id, int coreMask, TUserHandlerCallback body) {
+static inline TWorkerId DeploySimpleWorker(const char * name, TWorkerId id, TCoreMask coreMask, TUserHandlerCallback body) {
 
     SWorkerConfig config = {
         .Name = name,
@@ -167,7 +205,7 @@ static inline TWorkerId DeploySimpleWorker(const char * name, TWorkerId id, int
  * @note This function should not be called in exit code (local and global alike)
  * @see WORKER_ID_INVALID
  */
-static inline TWorkerId DeploySimpleParallelWorker(const char * name, TWorkerId id, int coreMask, TUserHandlerCallback body) {
+static inline TWorkerId DeploySimpleParallelWorker(const char * name, TWorkerId id, TCoreMask coreMask, TUserHandlerCallback body) {
 
     SWorkerConfig config = {
         .Name = name,
@@ -188,17 +226,72 @@ static inline TWorkerId DeploySimpleParallelWorker(const char * name, TWorkerId
  *       called in UserLocalInit, in which case the worker does not need to be parallel).
  * @warning Calling this function with argument WORKER_ID_INVALID in the context of UserLocalExit or UserExit
  *          is an error and the function raises a hard exception to prevent returning
- * @see WORKER_ID_INVALID
+ * @warning The same applies to calling this function with argument WORKER_ID_INVALID in the worker body of workers
+ *          deployed with the NoEarlyExit flag set
+ * @see WORKER_ID_INVALID, SWorkerConfig
  */
 void TerminateWorker(TWorkerId workerId);
 
+/**
+ * @brief Terminate multiple workers at once
+ * @param workerIds Array of worker IDs
+ * @param count Number of workers to terminate
+ * @param completion Message sent once all the workers have been torn down or MESSAGE_INVALID if not needed
+ * @param receiver Worker ID of the recipient of the completion message
+ * @return Number of workers whose termination has been requested or -1 if the batch could not be processed at all
+ * @note Unlike TerminateWorker(WORKER_ID_INVALID), this function always returns, even if the current worker is
+ *       among the ones terminated
+ * @note After a call to this function, the ownership of the completion message is relinquished and the
+ *       platform is responsible for the message delivery or destruction
+ * @see TerminateWorker, DeployWorkers
+ */
+int TerminateWorkers(const TWorkerId workerIds[], int count, TMessage completion, TWorkerId receiver);
+
+/**
+ * @brief Move a local worker to a different set of cores
+ * @param workerId Worker ID
+ * @param coreMask New mask of cores on which the worker is eligible to run
+ * @return 0 on success, -1 on failure
+ * @note The migration completes asynchronously. Messages sent to the worker in the meantime are neither lost
+ *       nor reordered. The worker keeps its ID and an atomic worker is never run on two cores at once.
+ * @note Only one migration of a given worker can be in progress at a time and termination of a worker being
+ *       migrated is deferred until the migration completes
+ * @warning UserLocalInit and UserLocalExit only ever run on the cores from the core mask the worker was deployed
+ *          with, so a worker providing either can only be moved to a subset of these cores
+ * @see SWorkerConfig
+ */
+int SetWorkerCoreMask(TWorkerId workerId, TCoreMask coreMask);
+
+/**
+ * @brief Worker being run on the current core
+ * @warning Do not use this directly, use the accessors below instead
+ */
+typedef struct SCurrentWorker {
+    void * Context;      /**< Platform-internal worker context or NULL outside of worker callbacks */
+    void ** SharedData;  /**< Location of the worker's shared data */
+    void ** LocalData;   /**< Location of the worker's data private to the current core */
+    TWorkerId WorkerId;  /**< Worker ID */
+} SCurrentWorker;
+
+/**
+ * @brief Worker being run on the current core, set by the platform on entry to each worker callback
+ * @note Each core runs in a separate process, so this variable is private to the core
+ * @warning Do not use this directly, use the accessors below instead
+ */
+extern SCurrentWorker g_currentWorker;
+
 /**
  * @brief Access worker's shared private context data
  * @return Current worker's shared data handle (same for all cores)
  * @note Different cores correspond to different virtual address spaces so a pointer valid on one core
  *       need not be valid on another
  */
-void * GetSharedData(void);
+static inline void * GetSharedData(void) {
+
+    /* Do not allow calling this function from a non-EO context */
+    AssertTrue(g_currentWorker.Context != NULL);
+    return *g_currentWorker.SharedData;
+}
 
 /**
  * @brief Set worker's shared private context data
@@ -206,25 +299,45 @@ void * GetSharedData(void);
  * @note Different cores correspond to different virtual address spaces so a pointer valid on one core
  *       need not be valid on another
  */
-void SetSharedData(void * data);
+static inline void SetSharedData(void * data) {
+
+    /* Do not allow calling this function from a non-EO context */
+    AssertTrue(g_currentWorker.Context != NULL);
+    *g_currentWorker.SharedData = data;
+}
 
 /**
  * @brief Access worker's per-core private context data
  * @return Current worker's private data handle (unique per core)
  */
-void * GetLocalData(void);
+static inline void * GetLocalData(void) {
+
+    /* Do not allow calling this function from a non-EO context */
+    AssertTrue(g_currentWorker.Context != NULL);
+    return *g_currentWorker.LocalData;
+}
 
 /**
  * @brief Set worker's private context data on the current core
  * @param data Private local data
  */
-void SetLocalData(void * data);
+static inline void SetLocalData(void * data) {
+
+    /* Do not allow calling this function from a non-EO context */
+    AssertTrue(g_currentWorker.Context != NULL);
+    *g_currentWorker.LocalData = data;
+}
 
 /**
  * @brief Get own worker ID
  * @return Current worker's worker ID
  */
-TWorkerId GetOwnWorkerId(void);
+static inline TWorkerId GetOwnWorkerId(void) {
+
+    /* Do not allow calling this function from a non-EO context */
+    AssertTrue(g_currentWorker.Context != NULL);
+    return g_currentWorker.WorkerId;
+}
 
 /**
  * @brief Find a local worker based on name
@@ -239,6 +352,48 @@ TWorkerId FindLocalWorker(const char * name);
  */
 void EndAtomicContext(void);
 
+/**
+ * @brief Runtime statistics of a worker
+ * @see GetWorkerStatistics
+ */
+typedef struct SWorkerStatistics {
+    u64 MessagesReceived;    /**< Number of messages delivered to the worker (including expired ones) */
+    u64 MessagesSent;        /**< Number of messages sent by the worker */
+    u64 BytesReceived;       /**< Total payload size of the messages received */
+    u64 BytesSent;           /**< Total payload size of the messages sent */
+    u64 HandlerInvocations;  /**< Number of calls to the worker body */
+    u64 HandlerTimeNs;       /**< Cumulative time spent in the worker body in nanoseconds */
+    u64 MaxHandlerTimeNs;    /**< Longest single call to the worker body in nanoseconds */
+    u64 MessagesExpired;     /**< Number of messages dropped on expiry before reaching the worker body (counted per worker, not per core) */
+    u64 MessagesShed;        /**< Number of messages shed by the overload manager (counted per worker, not per core) */
+    u64 HandlerOverruns;     /**< Number of calls to the worker body reported by the handler watchdog (counted per worker, not per core) */
+} SWorkerStatistics;
+
+/**
+ * @brief Get statistics of a local worker aggregated over all cores
+ * @param workerId Worker ID
+ * @param statistics Output buffer for the statistics
+ * @return 0 on success, -1 if the worker is not deployed on the current node
+ * @note The counters are updated without synchronization by the cores running the worker, so
+ *       the snapshot returned may lag behind the messages currently being processed
+ */
+int GetWorkerStatistics(TWorkerId workerId, SWorkerStatistics * statistics);
+
+/**
+ * @brief Get statistics of a local worker on a given core
+ * @param workerId Worker ID
+ * @param core Core index
+ * @param statistics Output buffer for the statistics
+ * @return 0 on success, -1 if the worker is not deployed on the current node or the core is invalid
+ * @see GetWorkerStatistics
+ */
+int GetWorkerCoreStatistics(TWorkerId workerId, int core, SWorkerStatistics * statistics);
+
+/**
+ * @brief Log the statistics of all the active workers on the current node
+ */
+void DumpWorkerStatistics(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -39,10 +39,30 @@ def format_command_line(config: Dict[str, Any]) -> List[str]:
     command_line.append("--nodeId")
     command_line.append(f"{node_id}")
 
+    # Accept either a single interface or a list of them
     network_if = config["network_if"]
+    if isinstance(network_if, list):
+        network_if = ",".join(network_if)
     command_line.append("--netIf")
     command_line.append(f"{network_if}")
 
+    # Policy for spreading internode traffic across multiple interfaces
+    network_policy = config.get("network_policy")
+    if network_policy:
+        command_line.append("--netPolicy")
+        command_line.append(f"{network_policy}")
+
+    # Optionally keep the native MAC addresses and resolve the peers at runtime
+    network_addressing = config.get("network_addressing")
+    if network_addressing:
+        command_line.append("--netAddressing")
+        command_line.append(f"{network_addressing}")
+
+    peer_table = config.get("peer_table")
+    if peer_table:
+        command_line.append("--peerTable")
+        command_line.append(f"{peer_table}")
+
     # Configure the default event pool used by EM
     command_line.append("--defaultPoolConfig")
     command_line.append(serialize_pool_config(config["pools"]["default"]))
@@ -55,10 +75,59 @@ def format_command_line(config: Dict[str, Any]) -> List[str]:
     command_line.append("--memoryPoolConfig")
     command_line.append(serialize_pool_config(config["pools"]["memory"]))
 
+    # Optionally size the worker table below the whole worker ID space to save shared memory
+    max_workers = config.get("max_workers")
+    if max_workers:
+        command_line.append("--maxWorkers")
+        command_line.append(f"{max_workers}")
+
+    # Optionally report worker bodies running for longer than the budget
+    watchdog = config.get("watchdog")
+    if watchdog:
+        command_line.append("--watchdogBudget")
+        command_line.append(f"{watchdog['budget_us']}")
+        # One of 'log', 'exception' or 'callstack'
+        command_line.append("--watchdogAction")
+        command_line.append(f"{watchdog.get('action', 'log')}")
+
     pktio_bufs = config["pktio_bufs_kilo"] * 1024
     command_line.append("--pktioBufs")
     command_line.append(f"{pktio_bufs}")
 
+    # Optionally capture messages delivered to selected workers
+    capture = config.get("capture")
+    if capture:
+        command_line.append("--captureFile")
+        command_line.append(f"{capture['file']}")
+        command_line.append("--captureWorkers")
+        command_line.append(",".join(capture["workers"]))
+
+    # Optionally replay a previous capture
+    replay = config.get("replay")
+    if replay:
+        command_line.append("--replayFile")
+        command_line.append(f"{replay['file']}")
+        # Speed factor relative to the original timing, zero meaning as fast as possible
+        speed = replay.get("speed", 1.0)
+        command_line.append("--replaySpeed")
+        command_line.append(f"{speed}")
+
+    # Optionally monitor the node load and degrade gracefully under overload
+    overload = config.get("overload")
+    if overload:
+        thresholds = [
+            f"{metric}=" + ":".join(str(value) for value in overload[metric])
+            for metric in ("cpu", "pool", "backlog") if metric in overload
+        ]
+        command_line.append("--overloadThresholds")
+        # Pass an empty list to keep the defaults
+        command_line.append(",".join(thresholds))
+        if overload.get("shedding", False):
+            command_line.append("--overloadShedding")
+        # Move workers off busy cores following the utilisation measured by the overload manager
+        if overload.get("rebalance_workers", False):
+            command_line.append("--rebalanceWorkers")
+
     return command_line
 
 def serialize_pool_config(pool_config: Dict[str, int]) -> str: